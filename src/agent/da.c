@@ -29,6 +29,7 @@
 #include "da_time.h"
 #include "da_listener.h"
 #include "da_stats.h"
+#include "da_worker.h"
 #include <sys/utsname.h>
 #include <sched.h>
 #include "../rule/rule.h"
@@ -82,9 +83,10 @@ static struct option long_options[] = {
 		{ "pid-file", required_argument, NULL, 'p' },
 		{ "mbuf-size", required_argument, NULL, 'm' },
 		{ "cpu-affinity", required_argument, NULL, 'a' },
+		{ "threads", required_argument, NULL, 'T' },
 		{ NULL, 0, NULL, 0 } };
 
-static char short_options[] = "hVtdDv:o:c:p:m:a:";
+static char short_options[] = "hVtdDv:o:c:p:m:a:T:";
 
 static int da_daemonize(int dump_core) {
 	int status;
@@ -208,6 +210,7 @@ static void set_default_options(struct instance *dai) {
 	dai->argv = NULL;
 	dai->stats_interval = STATS_INTERVAL;
 	dai->cpumask = -1;
+	dai->nworker = 1;
 }
 
 static int get_options(int argc, char **argv, struct instance *dai) {
@@ -296,6 +299,15 @@ static int get_options(int argc, char **argv, struct instance *dai) {
 			}
 			dai->cpumask = value;
 			break;
+		case 'T':
+			value = da_atoi(optarg, strlen(optarg));
+			if (value <= 0 || value > WORKER_MAX) {
+				write_stderr("dtcagent: threads must be between 1 and %d",
+						WORKER_MAX);
+				return -1;
+			}
+			dai->nworker = value;
+			break;
 		case '?':
 			switch (optopt) {
 			case 'o':
@@ -307,6 +319,7 @@ static int get_options(int argc, char **argv, struct instance *dai) {
 
 			case 'm':
 			case 'v':
+			case 'T':
 				write_stderr("dtcagent: option -%c requires a number", optopt);
 				break;
 
@@ -333,6 +346,7 @@ static void show_usage(void) {
 	write_stderr(
 			"Usage: dtcagent [-?hVdDt] [-v verbosity level] [-o output file]" CRLF
 			"                  [-c conf file] [-p pid file] [-m mbuf size] [-a cpu affinity]" CRLF
+			"                  [-T threads]" CRLF
 			"");
 	write_stderr(
 			"Options:" CRLF
@@ -350,6 +364,7 @@ static void show_usage(void) {
 			"  -p, --pid-file=S       		: set pid file (default: off)" CRLF
 			"  -m, --mbuf-size=N      		: set size of mbuf chunk in bytes (default: 16384 bytes)" CRLF
 			"  -a, --bind-cpu-mask=S        : set processor bind cpu(default: no bind)" CRLF
+			"  -T, --threads=N              : set event loop threads (default: 1)" CRLF
 			"");
 
 }
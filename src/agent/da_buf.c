@@ -24,7 +24,7 @@
 #include "da_string.h"
 
 static size_t mbuf_offset; /* mbuf offset in chunk (const) */
-struct pool_head *pool2_buf = NULL;
+__thread struct pool_head *pool2_buf = NULL;
 
 int mbuf_init(struct instance *ins) {
 	pool2_buf = create_pool("mbuf", ins->mbuf_chunk_size, MEM_F_SHARED);
@@ -26,7 +26,6 @@
 #include "da_conn.h"
 #include "da_stats.h"
 #include "da_time.h"
-#include "da_top_percentile.h"
 
 void client_ref(struct conn *conn, void *owner) {
 	ASSERT((conn->type & FRONTWORK) && conn->owner==NULL);
@@ -116,8 +115,7 @@ void client_close(struct context *ctx, struct conn *conn) {
 		{
 			int64_t elaspe_time = now_us - msg->start_ts;
 			stats_pool_incr_by(ctx, conn->owner, pool_elaspe_time, elaspe_time);
-			top_percentile_report(ctx, conn->owner, elaspe_time, 1, RT_SHARDING);
-			top_percentile_report(ctx, conn->owner, elaspe_time, 1, RT_ALL);
+			stats_pool_latency(ctx, conn->owner, msg->layer, elaspe_time);
 		}
 
 		if (msg->done) {			
@@ -134,8 +132,7 @@ void client_close(struct context *ctx, struct conn *conn) {
 		int64_t elaspe_time = now_us - msg->start_ts;
 		/* count the elapse time */
 		stats_pool_incr_by(ctx, conn->owner, pool_elaspe_time, elaspe_time);
-		top_percentile_report(ctx, conn->owner, elaspe_time, 1, RT_SHARDING);
-		top_percentile_report(ctx, conn->owner, elaspe_time, 1, RT_ALL);
+		stats_pool_latency(ctx, conn->owner, msg->layer, elaspe_time);
 
 		conn->dequeue_outq(ctx, conn, msg);
 		req_put(msg);
@@ -147,15 +144,14 @@ void client_close(struct context *ctx, struct conn *conn) {
 
 		ASSERT(msg->request);
 
-		req_put(msg);
-
 		/* count the elapse time */
 		int64_t elaspe_time = now_us - msg->start_ts;
 		stats_pool_incr_by(ctx, conn->owner, pool_elaspe_time, elaspe_time);
-		top_percentile_report(ctx, conn->owner, elaspe_time, 1, RT_SHARDING);
-		top_percentile_report(ctx, conn->owner, elaspe_time, 1, RT_ALL);
+		stats_pool_latency(ctx, conn->owner, msg->layer, elaspe_time);
 		log_debug("close s %d discarding req %"PRIu64" len %"PRIu32" "
 		                  "in error", conn->fd, msg->id, msg->mlen);
+
+		req_put(msg);
 	}
 
 	conn->unref(conn);
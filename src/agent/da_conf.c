@@ -24,7 +24,7 @@
 #include "da_log.h"
 #include "da_conf.h"
 #include "da_util.h"
-#include "da_top_percentile.h"
+#include "my/my_rcache.h"
 
 #define DEFINE_ACTION(_hash, _name) string(#_name),
 static struct string hash_strings[] = {
@@ -55,6 +55,8 @@ static struct command conf_commands[] = {
 		{ string("TopPercentileEnable"), conf_set_bool, offsetof(struct conf_pool, top_percentile_enable) },
 		{ string("TopPercentileDomain"), conf_set_string, offsetof(struct conf_pool, top_percentile_domain) },
 		{ string("TopPercentilePort"), conf_set_num, offsetof(struct conf_pool, top_percentile_port) },
+		{ string("ResultCacheTTL"), conf_set_num, offsetof(struct conf_pool, result_cache_ttl) },
+		{ string("ResultCacheSize"), conf_set_num, offsetof(struct conf_pool, result_cache_size) },
 		//For Sharding 
 		{ string("ShardingReplicaEnable"), conf_set_bool, offsetof(struct conf_server, replica_enable) },
 		{ string("ShardingName"), conf_set_string, offsetof(struct conf_server, name) },
@@ -89,6 +91,8 @@ static char *svrpool_elem[] = {
 		"TopPercentileEnable",
 		"TopPercentileDomain",
 		"TopPercentilePort",
+		"ResultCacheTTL",
+		"ResultCacheSize",
 		};
 
 static char *server_elem[] = {
@@ -252,15 +256,14 @@ int conf_server_each_transform(void *elem, void *data) {
 		cachei->ns_conn_q = 0;
 		cachei->nerr = 0;
 		cachei->failure_num = 0;
+		cachei->last_failure_ms = 0;
 		cachei->num = 0;
+		cachei->inflight = 0;
+		cachei->latency_us = 0;
+		cachei->latency_stat = 0;
 		TAILQ_INIT(&cachei->s_conn_q);
 	}
 	
-	
-	s->high_prty_idx = 0;
-	s->high_prty_cnt = 0;
-	s->low_prty_idx = 0;
-	s->low_prty_cnt = 0;
 
 	log_debug("transform to server %"PRIu32" '%.*s'", s->idx, s->name.len,
 			s->name.data);
@@ -299,6 +302,8 @@ static int conf_pool_init(struct conf_pool *cp, struct string *name) {
 	cp->auto_remove_replica = CONF_UNSET_NUM;
 	cp->top_percentile_enable = CONF_UNSET_NUM;
 	cp->top_percentile_port = CONF_UNSET_NUM;
+	cp->result_cache_ttl = CONF_UNSET_NUM;
+	cp->result_cache_size = CONF_UNSET_NUM;
 
 	string_init(&cp->idc);
 	cp->valid = 0;
@@ -371,6 +376,7 @@ int conf_pool_each_transform(void *elem, void *data) {
 	sp->ncontinuum = 0;
 	sp->nserver_continuum = 0;
 	sp->continuum = NULL;
+	sp->rcache = NULL;
 
 	string_copy(&sp->name, cp->name.data, cp->name.len);
 	string_copy(&sp->accesskey, cp->accesskey.data, cp->accesskey.len);
@@ -398,22 +404,13 @@ int conf_pool_each_transform(void *elem, void *data) {
 	sp->auto_remove_replica = cp->auto_remove_replica;
 
 	sp->top_percentile_enable = cp->top_percentile_enable;
-	sp->top_percentile_fd = set_remote_fd();
-	sp->top_percentile_addr_len = set_remote_config((char *)cp->top_percentile_domain.data, (uint16_t)cp->top_percentile_port, &sp->top_percentile_addr);
-	if(0 == sp->top_percentile_addr_len)
-		sp->top_percentile_addr_len = sizeof(sp->top_percentile_addr);
-	else
-		sp->top_percentile_addr_len = 0;
-	sp->top_percentile_param = malloc(sizeof(struct remote_param) * ((int8_t)RT_MAX - 1));
-	if(sp->top_percentile_param)
-	{
-		char szBid[16];
-		snprintf(szBid, 9, "%s", sp->accesskey.data);
-		uint64_t uBid = (uint64_t)(atoi(szBid));
-		uint64_t uIP = (uint64_t)(ntohl(inet_addr(cp->localip)));
-		uint64_t uConstValue = 1;
-		set_remote_param((uBid << 32) | uIP, (uConstValue << 32) | sp->port, RT_SHARDING, sp->top_percentile_param);
-		set_remote_param(uBid, 1, RT_ALL, sp->top_percentile_param);
+
+	if (cp->result_cache_ttl > 0) {
+		sp->rcache = my_rcache_create(cp->result_cache_ttl,
+				(size_t) cp->result_cache_size * 1024);
+		if (sp->rcache == NULL) {
+			return -1;
+		}
 	}
 
 	status = server_init(&sp->server, &cp->server, sp);
@@ -955,6 +952,17 @@ static int conf_validate_pool(struct conf *cf, struct conf_pool *cp) {
 		cp->top_percentile_port = CONF_DEFAULT_TOP_PERCENTILE_PORT;
 	}
 
+	if (cp->result_cache_ttl == CONF_UNSET_NUM) {
+		cp->result_cache_ttl = CONF_DEFAULT_RESULT_CACHE_TTL;
+	}
+
+	if (cp->result_cache_size == CONF_UNSET_NUM) {
+		cp->result_cache_size = CONF_DEFAULT_RESULT_CACHE_SIZE;
+	} else if (cp->result_cache_size <= 0) {
+		log_error("conf: directive \"ResultCacheSize\" must be positive");
+		return -1;
+	}
+
 	if (cp->server_connections == CONF_UNSET_NUM) {
 		cp->server_connections = CONF_DEFAULT_SERVER_CONNECTIONS;
 	} else if (cp->server_connections == 0) {
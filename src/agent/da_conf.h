@@ -44,6 +44,8 @@
 #define CONF_DEFAULT_TOP_PERCENTILE_ENABLE 1
 #define CONF_DEFAULT_TOP_PERCENTILE_DOMAIN "127.0.0.1"
 #define CONF_DEFAULT_TOP_PERCENTILE_PORT 20020
+#define CONF_DEFAULT_RESULT_CACHE_TTL 0 /* in msec, 0:off */
+#define CONF_DEFAULT_RESULT_CACHE_SIZE 4096 /* in KB */
 #define CONF_DEFAULT_LOG_SWITCH 0 /*1:on, 0:off*/
 #define CONF_DEFAULT_REMOTE_LOG_SWITCH 1 /*1:on, 0:off*/
 #define CONF_DEFAULT_REMOTE_LOG_IP "127.0.0.1"
@@ -94,9 +96,11 @@ struct conf_pool {
 	int instance_report;
 	int auto_remove_replica;
 
-	int top_percentile_enable; /*tp99 性能指标开启状态*/
-	struct string top_percentile_domain; /*tp99 性能指标上报服务器地址*/
-	int top_percentile_port; /*tp99 性能指标上报服务器端口*/
+	int top_percentile_enable; /*tp99 延时直方图开启状态*/
+	struct string top_percentile_domain; /*不再使用, 兼容旧配置*/
+	int top_percentile_port; /*不再使用, 兼容旧配置*/
+	int result_cache_ttl; /*结果缓存有效期(毫秒), 0表示关闭*/
+	int result_cache_size; /*结果缓存容量(KB)*/
 
 	char localip[16]; /*本地IP，放在此位置*/
 	unsigned valid : 1; /* valid? */
@@ -26,12 +26,14 @@
 #include "da_array.h"
 #include "da_errno.h"
 #include "da_time.h"
+#include "da_atomic.h"
+#include "my/my_stmt.h"
 
-static uint64_t ntotal_conn; /* total # connections counter from start */
-static uint32_t ncurr_conn; /* current # connections */
-static uint32_t ncurr_cconn; /* current # client connections */
+static __thread uint64_t ntotal_conn; /* total # connections counter from start */
+static __thread uint32_t ncurr_conn; /* current # connections */
+static atomic_t ncurr_cconn; /* current # client connections, all workers */
 
-struct pool_head *pool2_conn = NULL;
+__thread struct pool_head *pool2_conn = NULL;
 
 int conn_init() {
 	pool2_conn = create_pool("conn", sizeof(struct conn), MEM_F_SHARED);
@@ -100,6 +102,7 @@ static struct conn *_conn_get() {
 	c->writecached=0;
 	c->isvalid = 0;
 	memset(c->dbname, 0, 250);
+	c->stmts = NULL;
 
 	ntotal_conn++;
 	ncurr_conn++;
@@ -112,7 +115,8 @@ void conn_put(struct conn *c) {
 	}
 	ncurr_conn--;
 	if (c->type & FRONTWORK) {
-		ncurr_cconn--;
+		atomic_dec(&ncurr_cconn);
+		my_stmt_deinit(c);
 	}
 	pool_free(pool2_conn, c);
 }
@@ -163,7 +167,7 @@ struct conn *get_client_conn(void *pool) {
 	c->dequeue_inq = req_client_dequeue_imsgq;
 
 	c->ref(c, pool);
-	ncurr_cconn++;
+	atomic_inc(&ncurr_cconn);
 	return c;
 }
 
@@ -203,7 +207,7 @@ uint32_t get_ncurr_conn() {
 	return ncurr_conn;
 }
 uint32_t get_ncurr_cconn() {
-	return ncurr_cconn;
+	return atomic_read(&ncurr_cconn);
 }
 
 /*
@@ -83,6 +83,7 @@ struct conn {
   uint32_t flag;   /*epool flag*/
   conn_stage_t stage; /* authorization stage */
   char dbname[250]; /* use db info */
+  struct array *stmts; /* prepared statements, index is id - 1 */
 
   struct rbtree msg_tree; /*tree for message search*/
   struct rbnode msg_rbs;  /*sentinel for msg_tree	*/
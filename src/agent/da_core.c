@@ -27,11 +27,12 @@
 #include "da_time.h"
 #include "da_signal.h"
 #include "da_stats.h"
+#include "da_worker.h"
 
-static enum core_status inst_status = NORMAL;
+static volatile enum core_status inst_status = NORMAL;
 static uint32_t ctx_id; /* context generation */
-int write_send_queue_len = 0;
-struct conn **wait_send_queue; /*conn*/
+__thread int write_send_queue_len = 0;
+__thread struct conn **wait_send_queue; /*conn*/
 
 void cache_send_event(struct conn *conn) {
 	struct context * ctx = conn_to_ctx(conn);
@@ -57,7 +58,9 @@ static int core_calc_connections(struct context *ctx) {
 	}
 
 	ctx->max_nfd = (uint32_t) limit.rlim_cur;
-	ctx->max_ncconn = ctx->max_nfd - ctx->max_nsconn - RESERVED_FDS;
+	/* every worker thread has its own server connections */
+	ctx->max_ncconn = ctx->max_nfd - ctx->max_nsconn * ctx->nworker
+			- RESERVED_FDS;
 	log_debug(
 			"max fds %"PRIu32" max client conns %"PRIu32" " "max server conns %"PRIu32"",
 			ctx->max_nfd, ctx->max_ncconn, ctx->max_nsconn);
@@ -83,6 +86,8 @@ static struct context *core_ctx_create(struct instance *dai) {
 	ctx->max_ncconn = 0;
 	ctx->max_nsconn = 0;
 	ctx->sum_nconn = 0;
+	ctx->master = NULL;
+	ctx->nworker = dai->nworker > 0 ? dai->nworker : 1;
 
 	/* parse and create configuration */
 	ctx->cf = conf_create(dai->conf_filename);
@@ -174,6 +179,89 @@ static struct context *core_ctx_create(struct instance *dai) {
 	return ctx;
 }
 
+/*
+ * context of worker thread, shares configuration and listening sockets
+ * with main context, owns its server pools, connections and stats
+ */
+static struct context *core_worker_ctx_create(struct context *master) {
+	int status;
+	struct context *ctx;
+
+	ctx = malloc(sizeof(*ctx));
+	if (ctx == NULL) {
+		return NULL;
+	}
+	ctx->id = master->id;
+	ctx->cf = master->cf;
+	ctx->evb = NULL;
+	array_null(&ctx->pool);
+	/* wake up in time to see stop of main thread */
+	ctx->max_timeout = MIN(master->max_timeout, MAX_DELAY_MS);
+	ctx->timeout = ctx->max_timeout;
+	ctx->max_nfd = master->max_nfd;
+	ctx->max_ncconn = master->max_ncconn;
+	ctx->max_nsconn = 0;
+	ctx->sum_nconn = 0;
+	ctx->master = master;
+	ctx->nworker = master->nworker;
+
+	status = server_pool_init(&ctx->pool, &ctx->cf->pool, ctx);
+	if (status != 0) {
+		free(ctx);
+		return NULL;
+	}
+
+	ctx->stats = stats_create_worker(master->stats, &ctx->pool);
+	if (ctx->stats == NULL) {
+		server_pool_deinit(&ctx->pool);
+		free(ctx);
+		return NULL;
+	}
+
+	ctx->evb = event_base_create(EVENT_SIZE, &core_core);
+	if (ctx->evb == NULL) {
+		stats_destroy(ctx->stats);
+		server_pool_deinit(&ctx->pool);
+		free(ctx);
+		return NULL;
+	}
+
+	status = server_pool_preconnect(ctx);
+	if (status != 0) {
+		server_pool_disconnect(ctx);
+		event_base_destroy(ctx->evb);
+		stats_destroy(ctx->stats);
+		server_pool_deinit(&ctx->pool);
+		free(ctx);
+		return NULL;
+	}
+
+	status = listener_init(ctx);
+	if (status != 0) {
+		server_pool_disconnect(ctx);
+		event_base_destroy(ctx->evb);
+		stats_destroy(ctx->stats);
+		server_pool_deinit(&ctx->pool);
+		free(ctx);
+		return NULL;
+	}
+
+	wait_send_queue = malloc(ctx->sum_nconn*sizeof(struct conn *));
+	if(NULL == wait_send_queue) {
+		listener_deinit(ctx);
+		server_pool_disconnect(ctx);
+		event_base_destroy(ctx->evb);
+		stats_destroy(ctx->stats);
+		server_pool_deinit(&ctx->pool);
+		free(ctx);
+		return NULL;
+	}
+
+	log_debug("created worker ctx %p id %"PRIu32"", ctx, ctx->id);
+
+	return ctx;
+}
+
 struct context *core_start(struct instance *dai) {
 	struct context *ctx;
 
@@ -184,6 +272,35 @@ struct context *core_start(struct instance *dai) {
 	ctx = core_ctx_create(dai);
 	if (ctx != NULL) {
 		dai->ctx = ctx;
+		if (worker_init(dai) == 0) {
+			return ctx;
+		}
+		core_stop(ctx);
+		dai->ctx = NULL;
+		return NULL;
+	}
+
+	conn_deinit();
+	msg_deinit();
+	mbuf_deinit();
+
+	return NULL;
+}
+
+/*
+ * called in the worker thread, pools of mbuf, msg and conn are
+ * thread local
+ */
+struct context *core_worker_start(struct instance *dai,
+		struct context *master) {
+	struct context *ctx;
+
+	mbuf_init(dai);
+	msg_init();
+	conn_init();
+
+	ctx = core_worker_ctx_create(master);
+	if (ctx != NULL) {
 		return ctx;
 	}
 
@@ -201,18 +318,29 @@ static void core_ctx_destroy(struct context *ctx) {
 	event_base_destroy(ctx->evb);
 	stats_destroy(ctx->stats);
 	server_pool_deinit(&ctx->pool);
-	conf_destroy(ctx->cf);
+	if (ctx->master == NULL) {
+		conf_destroy(ctx->cf);
+	}
 	free(wait_send_queue);
 	free(ctx);
 }
 
 void core_stop(struct context *dai) {
+	/* workers share configuration of main context */
+	worker_deinit();
 	core_ctx_destroy(dai);
 	conn_deinit();
 	msg_deinit();
 	mbuf_deinit();
 }
 
+void core_worker_stop(struct context *ctx) {
+	core_ctx_destroy(ctx);
+	conn_deinit();
+	msg_deinit();
+	mbuf_deinit();
+}
+
 static int core_recv(struct context *ctx, struct conn *conn) {
 	int status;
 	status = conn->recv(ctx, conn);
@@ -394,6 +522,9 @@ static void core_timeout(struct context *ctx) {
 		//    stats_pool_incr_by(ctx, conn->owner, pool_elaspe_time, now_us - msg->start_ts);
 		//}
 
+		/* a timeout counts as a response as slow as the wait */
+		instance_latency_update(ctx, conn->owner, now_us - msg->start_ts);
+
 		//reclaim time out msg
 		if(!msg->sending)
 			reclaim_timeout_msg(ctx, msg);
@@ -431,7 +562,10 @@ static void process_cached_write_event(struct context *ctx) {
 
 int core_loop(struct context *ctx) {
 	int nsd;
-	signal_process_queue();
+	/* signals are handled by main thread only */
+	if (ctx->master == NULL) {
+		signal_process_queue();
+	}
 
 	nsd = event_wait(ctx->evb, ctx->timeout);
 	if (nsd < 0) {
@@ -61,6 +61,9 @@ struct context {
   uint32_t max_nsconn; /* max # server connections */
 
   uint32_t sum_nconn; /* client connections and server connections sum*/
+
+  struct context *master; /* context of main thread, NULL for itself */
+  uint32_t nworker;       /* # event loop threads, including main thread */
 };
 
 struct instance {
@@ -76,6 +79,7 @@ struct instance {
   char *pid_filename;               /* pid filename */
   unsigned pidfile : 1;             /* pid file created? */
   int cpumask;                      /*cpu mask for run*/
+  int nworker;                      /* # event loop threads */
   char **argv;                      /* argv of main() */
 };
 
@@ -95,6 +99,9 @@ struct context *core_start(struct instance *dai);
 void core_stop(struct context *ctx);
 int core_loop(struct context *ctx);
 
+struct context *core_worker_start(struct instance *dai, struct context *master);
+void core_worker_stop(struct context *ctx);
+
 int core_exec_new_binary(struct instance *dai);
 int core_inherited_socket(char *listen_address);
 void core_cleanup_inherited_socket(void);
@@ -152,29 +152,40 @@ static int listener_inherited_listen(struct context *ctx, struct conn *l)
 	struct server_pool *pool = l->owner;
 	ASSERT(p->proxy);
 
-	fd = core_inherited_socket(da_unresolve_addr(l->addr, l->addrlen));
-	if (fd > 0) {
+	if (ctx->master != NULL) {
+		/* worker thread accepts on the listening socket of main context */
+		struct server_pool *mp = array_get(&ctx->master->pool, pool->idx);
+		if (mp->listener == NULL || mp->listener->fd < 0) {
+			log_error("no listener of addr '%.*s' to share",
+				  pool->addrstr.len, pool->addrstr.data);
+			return -1;
+		}
+		fd = fcntl(mp->listener->fd, F_DUPFD_CLOEXEC, 0);
+		if (fd < 0) {
+			log_error("dup listener %d failed: %s",
+				  mp->listener->fd, strerror(errno));
+			return -1;
+		}
 		l->fd = fd;
 	} else {
-		status = listener_listen(ctx, l);
-		if (status != 0) {
-			return status;
+		fd = core_inherited_socket(
+			da_unresolve_addr(l->addr, l->addrlen));
+		if (fd > 0) {
+			l->fd = fd;
+		} else {
+			status = listener_listen(ctx, l);
+			if (status != 0) {
+				return status;
+			}
 		}
 	}
-	status = event_add_conn(ctx->evb, l);
+	status = event_add_listener(ctx->evb, l);
 	if (status < 0) {
 		log_error("event add conn p %d on addr '%.*s' failed: %s",
 			  l->fd, pool->addrstr.len, pool->addrstr.data,
 			  strerror(errno));
 		return -1;
 	}
-	status = event_del_out(ctx->evb, l);
-	if (status < 0) {
-		log_error("event del out p %d on addr '%.*s' failed: %s", l->fd,
-			  pool->addrstr.len, pool->addrstr.data,
-			  strerror(errno));
-		return -1;
-	}
 	return 0;
 }
 
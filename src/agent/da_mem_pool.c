@@ -19,7 +19,16 @@
 
 char mem_poison_byte = 0;
 
-static struct pool_circqh pools = CIRCLEQ_HEAD_INITIALIZER(pools);
+/*
+ * pools are private to the worker thread that created them,
+ * a thread local head can't be statically initialized
+ */
+static __thread struct pool_circqh pools;
+
+static inline void pools_init(void) {
+	if (pools.cqh_first == NULL)
+		CIRCLEQ_INIT(&pools);
+}
 
 struct pool_head *create_pool(char *name, unsigned int size, unsigned int flags) {
 
@@ -39,6 +48,7 @@ struct pool_head *create_pool(char *name, unsigned int size, unsigned int flags)
 	start = NULL;
 	pool = NULL;
 
+	pools_init();
 	CIRCLEQ_FOREACH(entry,&pools,pool_circqe)
 	{
 		if (entry->size == size) {
@@ -114,13 +124,14 @@ void pool_flush(struct pool_head *pool) {
 }
 
 void pool_gc() {
-	static int recurse;
+	static __thread int recurse;
 	struct pool_head *entry;
 
 	//预防重复调用
 	if (recurse++)
 		goto out;
 
+	pools_init();
 	CIRCLEQ_FOREACH(entry,&pools,pool_circqe)
 	{
 		void *temp, *next;
@@ -158,6 +169,7 @@ void dump_pools(void) {
 	int nbpools;
 
 	allocated = used = nbpools = 0;
+	pools_init();
 	log_error("Dumping pools usage. Use SIGQUIT to flush them.");
 	CIRCLEQ_FOREACH(entry, &pools, pool_circqe) {
 			log_error("  - Pool %s (%d bytes) : %d allocated (%u bytes), %d used, %d users%s\n",
@@ -24,6 +24,7 @@
 #include "da_protocal.h"
 #include "da_request.h"
 #include "my/my_parse.h"
+#include "my/my_fragment.h"
 #include "my/my_comm.h"
 #include "da_core.h"
 #include "limits.h"
@@ -40,11 +41,11 @@
 #define NC_IOV_MAX IOV_MAX
 #endif
 
-static uint64_t msg_id; /* message id counter */
-static uint64_t frag_id; /* fragment id counter */
-static struct rbtree tmo_rbt; /* timeout rbtree */
-static struct rbnode tmo_rbs; /* timeout rbtree sentinel */
-struct pool_head *pool2_msg = NULL;
+static __thread uint64_t msg_id; /* message id counter */
+static __thread uint64_t frag_id; /* fragment id counter */
+static __thread struct rbtree tmo_rbt; /* timeout rbtree */
+static __thread struct rbnode tmo_rbs; /* timeout rbtree sentinel */
+__thread struct pool_head *pool2_msg = NULL;
 
 #define DEFINE_ACTION(_name) string(#_name),
 static struct string msg_type_strings[] = {
@@ -169,6 +170,7 @@ static struct msg *_msg_get() {
 	m->request = 0;
 	m->start_ts = 0;
 	m->swallow = 0;
+	m->keylist = 0;
 	rbtree_node_init(&m->tmo_rbe);
 	m->cmd = MSG_NOP;
 	m->serialnr = 0;
@@ -216,6 +218,10 @@ static struct msg *_msg_get() {
 
 	m->pkt_nr = 0;
 	m->ismysql = 0;
+	m->command = COM_SLEEP;
+	m->admin = CMD_NOP;
+	m->layer = 0;
+	m->wslot = -1;
 
 	return m;
 }
@@ -236,7 +242,7 @@ struct msg *msg_get(struct conn *conn, bool request) {
 		msg->parser = my_parse_rsp;
 	}
 	msg->fragment = my_fragment;
-	msg->coalesce = dtc_coalesce;
+	msg->coalesce = my_coalesce;
 	msg->start_ts = now_us;
 
 	log_debug("get msg %p", msg);
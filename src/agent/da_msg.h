@@ -154,6 +154,7 @@ struct msg {
 	enum enum_agent_admin admin;
 	uint8_t layer;
 	int ismysql;
+	int wslot; /* result cache write stamp slot of the key, -1 if none */
 	union COM_DATA data;
 
 	int err; /* errno on error? */
@@ -163,6 +164,7 @@ struct msg {
 	unsigned done : 1; /* done? */
 	unsigned fdone : 1; /* all fragments are done? */
 	unsigned swallow : 1; /* swallow response? */
+	unsigned keylist : 1; /* keys from key IN (...), even a single one */
 
 	unsigned cli_inq : 1; /*msg in client in msgq*/
 	unsigned cli_outq : 1; /*msg in client out msgq*/
@@ -30,6 +30,7 @@
 #include "my/my_net_send.h"
 #include "my/my_parse.h"
 #include "my/my_comm.h"
+#include "my/my_rcache.h"
 
 #define LAYER3_DEF "layer3"
 
@@ -225,6 +226,7 @@ void req_server_enqueue_imsgq(struct context *ctx, struct conn *conn,
 	msg->sev_inq = 1;
 	//TODO
 	ci = conn->owner;
+	ci->inflight++;
 	stats_server_incr(ctx, ci, server_in_queue);
 }
 
@@ -239,6 +241,7 @@ void req_server_dequeue_imsgq(struct context *ctx, struct conn *conn,
 	//TODO
 	struct cache_instance *ci;
 	ci = conn->owner;
+	ci->inflight--;
 	stats_server_decr(ctx, ci, server_in_queue);
 }
 
@@ -261,6 +264,7 @@ void req_server_en_msgtree(struct context *ctx, struct conn *conn,
 	msg->sev_msgtree = 1;
 	//TODO
 	ci = conn->owner;
+	ci->inflight++;
 	stats_server_incr(ctx, ci, server_in_tree);
 }
 
@@ -286,6 +290,7 @@ void req_server_de_msgtree(struct context *ctx, struct conn *conn,
 	//TODO
 	struct cache_instance *ci;
 	ci = conn->owner;
+	ci->inflight--;
 	stats_server_decr(ctx, ci, server_in_tree);
 }
 
@@ -345,6 +350,25 @@ int dtc_header_add(struct msg *msg, enum enum_agent_admin admin, char* dbname)
 	dtc_header.packet_len = mbuf_length(mbuf) + sizeof(dtc_header) + dtc_header.dbname_len;
 	dtc_header.layer = msg->layer;
 
+	/* a bound statement may span mbufs, the header goes in front of them */
+	if (msg->command == COM_STMT_EXECUTE &&
+	    STAILQ_FIRST(&msg->buf_q) != mbuf) {
+		struct mbuf *b;
+		uint32_t len = 0;
+
+		STAILQ_FOREACH(b, &msg->buf_q, next) {
+			len += mbuf_length(b);
+		}
+		dtc_header.packet_len = len + sizeof(dtc_header) + dtc_header.dbname_len;
+		mbuf_copy(new_buf, (uint8_t*)&dtc_header, sizeof(dtc_header));
+		if(dbname && strlen(dbname) > 0)
+			mbuf_copy(new_buf, dbname, dtc_header.dbname_len);
+		STAILQ_INSERT_HEAD(&msg->buf_q, new_buf, next);
+		msg->mlen = dtc_header.packet_len;
+		log_debug("msg->mlen:%d over %d bytes of mbufs", msg->mlen, len);
+		return 0;
+	}
+
 	mbuf_copy(new_buf, (uint8_t*)&dtc_header, sizeof(dtc_header));
 	if(dbname && strlen(dbname) > 0)
 		mbuf_copy(new_buf, dbname, dtc_header.dbname_len);
@@ -411,6 +435,11 @@ void req_process(struct context *ctx, struct conn *c_conn, struct msg *msg)
 	int oper = my_do_command(msg);
 	switch (oper) {
 	case NEXT_FORWARD:
+		if (my_rcache_req(ctx, c_conn, msg) == 0) {
+			log_debug("RSP CACHED. msg id: %lu", msg->id);
+			req_make_loopback(ctx, c_conn, msg);
+			break;
+		}
 		dtc_header_add(msg, CMD_NOP, c_conn->dbname);
 		log_debug(
 			"FORWARD. msg len: %d, msg id: %lu",
@@ -441,6 +470,15 @@ void req_process(struct context *ctx, struct conn *c_conn, struct msg *msg)
 			return;
 		req_make_loopback(ctx, c_conn, msg);
 		break;
+	case NEXT_RSP_STMT_PREPARE:
+		if (net_send_stmt_prepare_ok(msg, c_conn) < 0)
+			return;
+		req_make_loopback(ctx, c_conn, msg);
+		break;
+	case NEXT_RSP_NONE:
+		log_debug("NO RSP. msg id: %lu", msg->id);
+		req_put(msg);
+		break;
 	default:
 		log_error("my_do_command operation error:%d", oper);
 	}
@@ -635,8 +673,6 @@ void req_recv_done(struct context *ctx, struct conn *conn, struct msg *msg,
 		return;
 	}
 
-	ASSERT(TAILQ_EMPTY(&frag_msgq));
-
 	/* if no fragment happened */
 	if (TAILQ_EMPTY(&frag_msgq)) {
 		req_process(ctx, conn, msg);
@@ -644,7 +680,6 @@ void req_recv_done(struct context *ctx, struct conn *conn, struct msg *msg,
 		return;
 	}
 
-#if 0 // Not be supported multi req now.
 	/*
 	 * insert msg into client in queue,it can
 	 * be free when client close connection,set done
@@ -656,13 +691,12 @@ void req_recv_done(struct context *ctx, struct conn *conn, struct msg *msg,
 		tmsg = TAILQ_NEXT(sub_msg, o_tqe);
 		log_debug("req forward msg %"PRIu64"", sub_msg->id);
 		TAILQ_REMOVE(&frag_msgq, sub_msg, o_tqe);
+		dtc_header_add(sub_msg, CMD_NOP, conn->dbname);
 		req_forward(ctx, conn, sub_msg);
 	}
 
-	
 	ASSERT(TAILQ_EMPTY(&frag_msgq));
 
-#endif
 	log_debug("req_recv_done leave.");
 	return;
 }
@@ -24,10 +24,11 @@
 #include "da_util.h"
 #include "da_event.h"
 #include "da_core.h"
+#include "da_server.h"
 #include "da_stats.h"
 #include "da_time.h"
-#include "da_top_percentile.h"
 #include "my/my_comm.h"
+#include "my/my_rcache.h"
 
 void rsp_put(struct msg *msg) {
 	ASSERT(!msg->request);
@@ -198,6 +199,7 @@ void rsp_recv_done(struct context *ctx, struct conn *conn, struct msg *msg,
 					msg->id, msg->peerid);
 	//set req and rsp
 	req = (struct msg *) tarnode->data;
+	instance_latency_update(ctx, conn->owner, now_us - req->start_ts);
 	c_conn = req->owner;
 	req->peer = msg;
 	req->peerid = msg->id;
@@ -241,14 +243,16 @@ void rsp_recv_done(struct context *ctx, struct conn *conn, struct msg *msg,
 		req->frag_owner->nfrag_done++;
 	}
 
+	//each fragment rsp carries its own header
+	if(msg->admin == CMD_NOP && msg->ismysql == 0)
+		dtc_header_remove(msg);
+
 	if (req_done(c_conn, req)) {
 		log_debug("msg is done , rsp msg id: %"PRIu64"",req->id);
 		
 		switch(msg->admin)
 		{
 			case CMD_NOP:
-				if(msg->ismysql == 0)
-					dtc_header_remove(msg);
 				rsp_forward(ctx, c_conn, req);
 				break;
 			default:
@@ -334,6 +338,10 @@ void rsp_forward(struct context *ctx, struct conn *c_conn, struct msg *msg) {
 	{
 		stats_pool_incr(ctx, c_conn->owner, coalesce_error);
 	}
+	else
+	{
+		my_rcache_rsp(ctx, c_conn, req);
+	}
 	log_debug("req peer mlen:%d",req->peer->mlen);
 	c_conn->dequeue_inq(ctx, c_conn, req);
 	if(c_conn->writecached == 0 && c_conn->connected == 1)
@@ -426,8 +434,7 @@ void rsp_send_done(struct context *ctx, struct conn *conn, struct msg *msg)
 	 tv_update_date(0,1);
 	 uint64_t elaspe_time = now_us - pmsg->start_ts;
 	 stats_pool_incr_by(ctx, conn->owner, pool_elaspe_time, elaspe_time);
-	 top_percentile_report(ctx, conn->owner, elaspe_time, msg->resultcode, RT_SHARDING);
-	 top_percentile_report(ctx, conn->owner, elaspe_time, msg->resultcode, RT_ALL);
+	 stats_pool_latency(ctx, conn->owner, pmsg->layer, elaspe_time);
 	 log_debug("send rsp %"PRIu64", peer id: %"PRIu64", len %"PRIu32", len %"PRIu32", type %d on " "c %d success use %"PRIu64"us",
 	 				msg->id, pmsg->id, msg->mlen, pmsg->mlen, msg->cmd, conn->fd,now_us - pmsg->start_ts);
 	 req_put(pmsg);
@@ -14,6 +14,7 @@
 * limitations under the License.
 */
 #include <inttypes.h>
+#include <stdlib.h>
 #include "da_server.h"
 #include "da_hashkit.h"
 #include "da_errno.h"
@@ -25,6 +26,7 @@
 #include "da_conf.h"
 #include "da_stats.h"
 #include "da_time.h"
+#include "my/my_rcache.h"
 
 static int keep_alive = 1;   // 开启keepalive属性. 缺省值: 0(关闭)  
 static int keep_idle = 5;   // 如果在60秒内没有任何数据交互,则进行探测. 缺省值:7200(s)  
@@ -260,58 +262,88 @@ static struct conn *instance_conn(struct cache_instance *ins){
 	return conn;
 }
 
-struct cache_instance *get_instance_from_array(struct array replica_array, uint16_t *array_idx, uint16_t *cnt)
+/*
+ * instance takes requests unless all of its connections failed, a failed
+ * one is tried again after a backoff doubling with each failure
+ */
+static int instance_available(struct cache_instance *ci)
 {
-	int i, idx = 0,w,t;
-	int nreplica = array_n(&replica_array);
-	struct cache_instance *ci = NULL;
-	if (nreplica != 0)
-	{
-		for (i = 0; i < nreplica + 1; i++) {
-			idx = (i + (*array_idx) + nreplica) % nreplica;
-			ci = array_get(&replica_array, idx);
-			w = ci->weight;
-			if ((*cnt) < w && ci->nerr < ci->ns_conn_q) {
-				(*cnt)++;
-				*array_idx = idx;
-				//printf("FFF i :%.*s nerr%d failtime%d  \n", ci->pname.len, ci->pname.data, ci->nerr, ci->failure_num);
-				return ci;
-			}
-			else if (ci->nerr >= ci->ns_conn_q && ci->failure_num < FAIL_TIME_LIMIT) {
-				t = 1;
-				t = t << ci->failure_num;
-				t = t * 1000;
-				printf("i :%.*s now_ms%"PRIu64" failtime%"PRIu64"  t%d \n", ci->pname.len, ci->pname.data, now_ms, ci->last_failure_ms, t);
-				if ((now_ms - ci->last_failure_ms) > t) {
-					(*cnt) = 0;
-					(*array_idx) = idx + 1;
-				
-					ci->nerr = 0;
-					return ci;
-				}
-				else {
-					(*cnt) = 0;
-					continue;
-				}
+	uint64_t t;
 
-			}
-			else {
-				(*cnt) = 0;
-				continue;
-			}
+	if (ci->nerr < ci->ns_conn_q)
+		return 1;
+	if (ci->failure_num >= FAIL_TIME_LIMIT)
+		return 0;
+	t = (1ULL << ci->failure_num) * 1000;
+	return now_ms - ci->last_failure_ms > t;
+}
 
-		}
-		(*array_idx) = idx;
+static struct cache_instance *instance_nth_available(struct array *a,
+						     uint32_t k)
+{
+	uint32_t i;
+	struct cache_instance *ci;
+
+	for (i = 0; i < array_n(a); i++) {
+		ci = array_get(a, i);
+		if (instance_available(ci) && k-- == 0)
+			return ci;
 	}
+	return NULL;
+}
+
+/*
+ * expected wait of a new request, lower is better. an instance with no
+ * response yet is tried first so that it gets a latency.
+ */
+static uint64_t instance_cost(struct cache_instance *ci)
+{
+	return (uint64_t)(ci->latency_us + 1) * (ci->inflight + 1);
+}
+
+/*
+ * power of two choices: cost of two random available instances is
+ * compared, the faster one is taken. cheap like round robin, but load
+ * moves away from a slow or busy replica.
+ */
+static struct cache_instance *get_instance_from_array(struct array *a)
+{
+	static __thread uint32_t seed;
+	struct cache_instance *ci, *other;
+	uint32_t i, n = 0, k1, k2;
+
+	for (i = 0; i < array_n(a); i++) {
+		if (instance_available(array_get(a, i)))
+			n++;
+	}
+	if (n == 0)
+		return NULL;
+
+	if (seed == 0)
+		seed = (uint32_t)now_us | 1;
+	k1 = rand_r(&seed) % n;
+	ci = instance_nth_available(a, k1);
+	if (n > 1) {
+		k2 = rand_r(&seed) % (n - 1);
+		other = instance_nth_available(a, k2 < k1 ? k2 : k2 + 1);
+		if (instance_cost(other) < instance_cost(ci))
+			ci = other;
+	}
+
+	log_debug("pick '%.*s' latency %"PRId64" us inflight %"PRIu32"",
+		  ci->pname.len, ci->pname.data, ci->latency_us, ci->inflight);
+	/* probe a failed instance again */
+	if (ci->nerr >= ci->ns_conn_q)
+		ci->nerr = 0;
 	return ci;
 }
 
 static struct cache_instance *get_instance_from_server(struct server *server) {
 	struct cache_instance *ci = NULL;
-	ci = get_instance_from_array(server->high_ptry_ins,&server->high_prty_idx, &server->high_prty_cnt);
+	ci = get_instance_from_array(&server->high_ptry_ins);
 	if (ci == NULL)
 	{
-		ci = get_instance_from_array(server->low_prty_ins, &server->low_prty_idx, &server->low_prty_cnt);
+		ci = get_instance_from_array(&server->low_prty_ins);
 	}
 	return ci;
 }
@@ -899,12 +931,12 @@ void server_pool_deinit(struct array *server_pool) {
 		string_deinit(&sp->addrstr);
 		string_deinit(&sp->accesskey);
 		string_deinit(&sp->module_idc);
+
+		my_rcache_destroy(sp->rcache);
+		sp->rcache = NULL;
 		
 		server_deinit(&sp->server);
 
-		if(sp->top_percentile_param)
-			free(sp->top_percentile_param);
-
 		log_debug("deinit pool %"PRIu32" '%.*s'", sp->idx, sp->name.len,
 				sp->name.data);
 	}
@@ -959,3 +991,25 @@ int incr_instance_failure_time(struct cache_instance *ci)
 	
 }
 
+/*
+ * fold the response time of a request into the instance ewma, weight of
+ * a new sample is 1/8 as in tcp srtt
+ */
+void instance_latency_update(struct context *ctx, struct cache_instance *ci,
+			     int64_t us)
+{
+	int64_t share;
+
+	if (us < 0)
+		return;
+	if (ci->latency_us == 0)
+		ci->latency_us = us > 0 ? us : 1;
+	else
+		ci->latency_us += (us - ci->latency_us) / 8;
+
+	/* gauges of the event loops are summed, each adds its average share */
+	share = ci->latency_us / ctx->nworker;
+	stats_server_incr_by(ctx, ci, server_latency_us,
+			     share - ci->latency_stat);
+	ci->latency_stat = share;
+}
@@ -47,15 +47,14 @@ struct cache_instance {
   uint64_t last_failure_ms; /*cahche the failure time*/
   uint16_t failure_num;     /*cache failure time*/
   int num;
+  uint32_t inflight;        /* # requests queued or sent, not answered */
+  int64_t latency_us;       /* ewma of response time, 0 if none yet */
+  int64_t latency_stat;     /* share of latency_us in server stats */
 };
 
 struct server {
   uint32_t idx;              /* server index */
   struct server_pool *owner; /* owner pool */
-  uint16_t high_prty_idx;
-  uint16_t high_prty_cnt;
-  uint16_t low_prty_idx;
-  uint16_t low_prty_cnt;
   struct string name; /* name (ref in conf_server) */
   int weight;
   int replica_enable;
@@ -97,11 +96,8 @@ struct server_pool {
   int instance_report;
   int auto_remove_replica;
 
-  int top_percentile_enable;
-  int top_percentile_fd;
-  struct sockaddr_in top_percentile_addr;
-  int top_percentile_addr_len;
-  struct remote_param *top_percentile_param;
+  int top_percentile_enable; /* record latency histograms */
+  struct my_rcache *rcache;  /* hot read results, NULL if disabled */
 };
 
 uint32_t server_pool_idx(struct server_pool *pool, uint8_t *key,
@@ -128,4 +124,6 @@ struct conn *server_pool_conn(struct context *ctx, struct server_pool *pool,
                               struct msg *msg);
 int incr_instance_failure_time(struct cache_instance *ci);
 int decr_instance_failure_time(struct msg *msg);
+void instance_latency_update(struct context *ctx, struct cache_instance *ci,
+                             int64_t us);
 #endif /* DA_SERVER_H_ */
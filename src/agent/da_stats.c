@@ -52,6 +52,11 @@ static struct stats_desc stats_server_desc[] = {
 STATS_SERVER_CODEC( DEFINE_ACTION ) };
 #undef DEFINE_ACTION
 
+#define DEFINE_ACTION(_name, _desc) { .type = STATS_INVALID, .name = #_name, .desc = _desc },
+static struct stats_desc stats_latency_desc[] = {
+STATS_LATENCY_CODEC( DEFINE_ACTION ) };
+#undef DEFINE_ACTION
+
 /* wake lock for lock timeout*/
 static pthread_mutex_t wakeLock;
 
@@ -71,6 +76,73 @@ void stats_describe(void) {
 		write_stderr("  %-20s\"%s\"", stats_server_desc[i].name,
 				stats_server_desc[i].desc);
 	}
+
+	write_stderr("");
+
+	write_stderr("latency stats (count p50 p99 p999 max in us):");
+	for (i = 0; i < NELEMS(stats_latency_desc); i++) {
+		write_stderr("  %-20s\"%s\"", stats_latency_desc[i].name,
+				stats_latency_desc[i].desc);
+	}
+}
+
+static uint32_t stats_latency_bucket(uint64_t us) {
+	int e;
+
+	if (us < STATS_LATENCY_SUB) {
+		return (uint32_t) us;
+	}
+	e = 63 - __builtin_clzll(us);
+	if (e >= STATS_LATENCY_MAX_BITS) {
+		return STATS_LATENCY_NBUCKET - 1;
+	}
+	return (e - STATS_LATENCY_SUB_BITS + 1) * STATS_LATENCY_SUB
+			+ ((us >> (e - STATS_LATENCY_SUB_BITS)) & (STATS_LATENCY_SUB - 1));
+}
+
+/* highest value falls into bucket i */
+static uint64_t stats_latency_value(uint32_t i) {
+	uint32_t g = i / STATS_LATENCY_SUB;
+	uint32_t shift;
+
+	if (g == 0) {
+		return i;
+	}
+	shift = g - 1;
+	return (((uint64_t) (STATS_LATENCY_SUB + i % STATS_LATENCY_SUB) + 1)
+			<< shift) - 1;
+}
+
+/* value at rank of permille q */
+static uint64_t stats_latency_percentile(struct stats_latency *sl, int q) {
+	uint64_t rank, seen = 0;
+	uint32_t i;
+
+	if (sl->count == 0) {
+		return 0;
+	}
+	rank = (sl->count * q + 999) / 1000;
+	for (i = 0; i < STATS_LATENCY_NBUCKET; i++) {
+		seen += sl->bucket[i];
+		if (seen >= rank) {
+			break;
+		}
+	}
+	return MIN(stats_latency_value(i), sl->max);
+}
+
+static void stats_latency_merge(struct stats_latency *sum,
+		struct stats_latency *sl) {
+	uint32_t i;
+
+	if (sl->count == 0) {
+		return;
+	}
+	for (i = 0; i < STATS_LATENCY_NBUCKET; i++) {
+		sum->bucket[i] += sl->bucket[i];
+	}
+	sum->count += sl->count;
+	sum->max = MAX(sum->max, sl->max);
 }
 
 static void stats_metric_init(struct stats_metric *stm) {
@@ -115,6 +187,8 @@ static void stats_pool_reset(struct array *stats_pool) {
 		uint32_t j, nserver;
 
 		stats_metric_reset(&stp->metric);
+		memset(stp->latency, 0,
+				STATS_LATENCY_NTYPE * sizeof(struct stats_latency));
 
 		nserver = array_n(&stp->server);
 		
@@ -133,11 +207,11 @@ static void stats_aggregate_item(struct stats_file_item *item_list,
 		stm = array_get(shadow_metric, i);
 		switch (item_list[i].type) {
 		case STATS_COUNTER:
-			item_list[i].stat_once = stm->value.counter;
+			item_list[i].stat_once += stm->value.counter;
 			item_list[i].stat_all += stm->value.counter;
 			break;
 		case STATS_GAUGE:
-			item_list[i].stat_once = stm->value.counter;
+			item_list[i].stat_once += stm->value.counter;
 			item_list[i].stat_all += stm->value.counter;
 			break;
 		case STATS_TIMESTAMP:
@@ -172,33 +246,28 @@ static void stats_aggregate_reset(struct stats_file_item *item_list,
 		}
 	}
 }
-static void stats_aggregate(struct stats *st) {
-	uint32_t i;
-	if (st->aggregate == 0) {
-		//log_debug("skip aggregate of shadow %p  as generator is slow",
-		//		st->shadow.elem);
-		for (i = 0; i < array_n(&st->aggregator); i++) {
-			uint32_t j;
-			struct stats_file_pool *stfp;
-			stfp = array_get(&st->aggregator, i);
-			stats_aggregate_reset(stfp->pool_item_list,
-					stfp->phead->poolfields);
-			for (j = 0; j < array_n(&stfp->stats_file_servers); j++) {
-				struct stats_file_server *stfs;
-				stfs = array_get(&stfp->stats_file_servers, j);
-				stats_aggregate_reset(stfs->server_item_list,
-						stfs->shead->serverfields);
-			}
-		}
-		return;
+static void stats_aggregate_begin(struct stats_file_item *item_list,
+		int list_size) {
+	int i;
+	for (i = 0; i < list_size; i++) {
+		if (item_list[i].type == STATS_COUNTER
+				|| item_list[i].type == STATS_GAUGE)
+			item_list[i].stat_once = 0;
 	}
+}
+
+/*
+ * add shadow (b) of one worker into sum (c)
+ */
+static void stats_aggregate_shadow(struct stats *st, struct stats *ws) {
+	uint32_t i;
 
 	for (i = 0; i < array_n(&st->aggregator); i++) {
 		uint32_t j;
 		struct stats_file_pool *stfp;
 		struct stats_pool *stp;
 
-		stp = array_get(&st->shadow, i);
+		stp = array_get(&ws->shadow, i);
 		stfp = array_get(&st->aggregator, i);
 		stats_aggregate_item(stfp->pool_item_list, &stp->metric,
 				stfp->phead->poolfields);
@@ -212,13 +281,80 @@ static void stats_aggregate(struct stats *st) {
 			stats_aggregate_item(stfs->server_item_list, &sts->metric,
 					stfs->shead->serverfields);
 		}
+
+		for (j = 0; j < STATS_LATENCY_NTYPE; j++) {
+			stats_latency_merge(&stfp->latency_sum[j], &stp->latency[j]);
+		}
 	}
 	/*
 	 * Reset shadow (b) stats before giving it back to generator to keep
 	 * stats addition idempotent
 	 */
-	stats_pool_reset(&st->shadow);
-	st->aggregate = 0;
+	stats_pool_reset(&ws->shadow);
+	ws->aggregate = 0;
+}
+
+static void stats_aggregate(struct stats *st) {
+	uint32_t i;
+	struct stats *ws;
+	int aggregate = 0;
+
+	pthread_mutex_lock(&st->lock);
+	for (ws = st; ws != NULL; ws = ws->next) {
+		aggregate |= ws->aggregate;
+	}
+
+	for (i = 0; i < array_n(&st->aggregator); i++) {
+		uint32_t j;
+		struct stats_file_pool *stfp;
+		stfp = array_get(&st->aggregator, i);
+		if (aggregate == 0) {
+			//log_debug("skip aggregate of shadow %p  as generator is slow",
+			//		st->shadow.elem);
+			stats_aggregate_reset(stfp->pool_item_list,
+					stfp->phead->poolfields);
+		} else {
+			stats_aggregate_begin(stfp->pool_item_list,
+					stfp->phead->poolfields);
+		}
+		for (j = 0; j < array_n(&stfp->stats_file_servers); j++) {
+			struct stats_file_server *stfs;
+			stfs = array_get(&stfp->stats_file_servers, j);
+			if (aggregate == 0) {
+				stats_aggregate_reset(stfs->server_item_list,
+						stfs->shead->serverfields);
+			} else {
+				stats_aggregate_begin(stfs->server_item_list,
+						stfs->shead->serverfields);
+			}
+		}
+	}
+
+	/* every worker thread swaps its own shadow, merge them all */
+	for (ws = st; aggregate && ws != NULL; ws = ws->next) {
+		if (ws->aggregate) {
+			stats_aggregate_shadow(st, ws);
+		}
+	}
+
+	/* percentiles of the interval, histograms are not kept in the file */
+	for (i = 0; i < array_n(&st->aggregator); i++) {
+		uint32_t j;
+		struct stats_file_pool *stfp = array_get(&st->aggregator, i);
+
+		for (j = 0; j < STATS_LATENCY_NTYPE; j++) {
+			struct stats_latency *sl = &stfp->latency_sum[j];
+			struct stats_file_latency *sfl = &stfp->latency_list[j];
+
+			sfl->count = sl->count;
+			sfl->p50 = stats_latency_percentile(sl, 500);
+			sfl->p99 = stats_latency_percentile(sl, 990);
+			sfl->p999 = stats_latency_percentile(sl, 999);
+			sfl->max = sl->max;
+			memset(sl, 0, sizeof(*sl));
+		}
+	}
+	pthread_mutex_unlock(&st->lock);
 	return;
 }
 
@@ -392,7 +528,8 @@ static int stats_file_mount(struct array *_map_items, struct array *server_pool)
 				+ ninstance
 						* (sizeof(struct stats_file_server_head)
 								+ STATS_SERVER_NFIELD
-										* sizeof(struct stats_file_item));
+										* sizeof(struct stats_file_item))
+				+ STATS_LATENCY_NTYPE * sizeof(struct stats_file_latency);
 		da_snprintf(mi->filename, 256, "%s_%s_%d", STATS_FILE, sp->name.data,
 				pid);
 		mi->_map_size = size;
@@ -456,6 +593,13 @@ static int stats_file_mount(struct array *_map_items, struct array *server_pool)
 				}
 			}
 		}
+		for (j = 0; j < STATS_LATENCY_NTYPE; j++) {
+			struct stats_file_latency *sfl = (struct stats_file_latency *) pos;
+			memset(sfl, 0, sizeof(*sfl));
+			da_strncpy(sfl->name, stats_latency_desc[j].name,
+					sizeof(sfl->name));
+			pos += sizeof(struct stats_file_latency);
+		}
 	}
 	return 0;
 }
@@ -511,6 +655,13 @@ static int stats_aggregator_map(struct array *_map_items,
 			temp += sizeof(struct stats_file_item) * stfs->shead->serverfields;
 		}
 
+		stfp->latency_list = (struct stats_file_latency *) temp;
+		stfp->latency_sum = calloc(STATS_LATENCY_NTYPE,
+				sizeof(struct stats_latency));
+		if (stfp->latency_sum == NULL) {
+			log_error("alloc latency histogram error, lack of memory");
+			return -1;
+		}
 	}
 	return 0;
 }
@@ -518,7 +669,8 @@ static int stats_aggregator_map(struct array *_map_items,
 static int stats_aggregator_unmap(struct array *aggregator) {
 	int i;
 	for (i = 0; i < array_n(aggregator); i++) {
-		array_pop(aggregator);
+		struct stats_file_pool *stfp = array_pop(aggregator);
+		free(stfp->latency_sum);
 	}
 	array_deinit(aggregator);
 	return 0;
@@ -661,6 +813,11 @@ static int stats_pool_init(struct stats_pool *stp, struct server_pool *sp) {
 	array_null(&stp->metric);
 	array_null(&stp->server);
 
+	stp->latency = calloc(STATS_LATENCY_NTYPE, sizeof(struct stats_latency));
+	if (stp->latency == NULL) {
+		return -1;
+	}
+
 	status = stats_pool_metric_init(&stp->metric);
 	if (status != 0) {
 		return status;
@@ -716,6 +873,7 @@ static void stats_pool_unmap(struct array *stats_pool) {
 		struct stats_pool *stp = array_pop(stats_pool);
 		stats_metric_deinit(&stp->metric);
 		stats_server_unmap(&stp->server);
+		free(stp->latency);
 	}
 	array_deinit(stats_pool);
 
@@ -739,6 +897,9 @@ struct stats *stats_create(int stats_interval, char * localip, struct array *ser
 	st->tid = (pthread_t) -1;
 	st->updated = 0;
 	st->aggregate = 0;
+	st->master = NULL;
+	st->next = NULL;
+	pthread_mutex_init(&st->lock, NULL);
 	strncpy(st->localip, localip, sizeof(st->localip));
 
 	status = stats_pool_map(&st->current, server_pool);
@@ -772,7 +933,82 @@ struct stats *stats_create(int stats_interval, char * localip, struct array *ser
 	return NULL;
 }
 
+/*
+ * stats of a worker thread, only current and shadow are owned by the
+ * worker, the aggregator of master merges its shadow into the stats file
+ */
+struct stats *stats_create_worker(struct stats *master,
+		struct array *server_pool) {
+	int status;
+	struct stats *st;
+
+	st = malloc(sizeof(*st));
+	if (st == NULL) {
+		return NULL;
+	}
+	array_null(&st->current);
+	array_null(&st->shadow);
+	array_null(&st->_map_items);
+	array_null(&st->aggregator);
+
+	st->interval = master->interval;
+	st->start_ts = now_ms;
+	st->tid = (pthread_t) -1;
+	st->updated = 0;
+	st->aggregate = 0;
+	st->master = master;
+	st->next = NULL;
+	pthread_mutex_init(&st->lock, NULL);
+	strncpy(st->localip, master->localip, sizeof(st->localip));
+
+	status = stats_pool_map(&st->current, server_pool);
+	if (status != 0) {
+		goto error;
+	}
+
+	status = stats_pool_map(&st->shadow, server_pool);
+	if (status != 0) {
+		goto error;
+	}
+
+	pthread_mutex_lock(&master->lock);
+	st->next = master->next;
+	master->next = st;
+	pthread_mutex_unlock(&master->lock);
+
+	return st;
+
+	error: stats_pool_unmap(&st->shadow);
+	stats_pool_unmap(&st->current);
+	pthread_mutex_destroy(&st->lock);
+	free(st);
+	return NULL;
+}
+
+static void stats_destroy_worker(struct stats *st) {
+	struct stats *master = st->master;
+	struct stats **pp;
+
+	pthread_mutex_lock(&master->lock);
+	for (pp = &master->next; *pp != NULL; pp = &(*pp)->next) {
+		if (*pp == st) {
+			*pp = st->next;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&master->lock);
+
+	stats_pool_unmap(&st->shadow);
+	stats_pool_unmap(&st->current);
+	pthread_mutex_destroy(&st->lock);
+	free(st);
+}
+
 void stats_destroy(struct stats *st) {
+	if (st->master != NULL) {
+		stats_destroy_worker(st);
+		return;
+	}
 	stats_stop_aggregator(st);
 	stats_aggregator_unmap(&st->aggregator);
 	stats_file_unmount(&st->_map_items);
@@ -891,6 +1127,37 @@ void _stats_pool_set_ts(struct context *ctx, struct server_pool *pool,
 			stm->value.timestamp);
 }
 
+/*
+ * request done in us, histograms of current (a) are owned by the event
+ * loop thread like the counters
+ */
+void _stats_pool_latency(struct context *ctx, struct server_pool *pool,
+		int layer, int64_t us) {
+	struct stats *st;
+	struct stats_pool *stp;
+	struct stats_latency *sl;
+
+	if (!pool->top_percentile_enable) {
+		return;
+	}
+	if (layer <= STATS_LATENCY_local || layer >= STATS_LATENCY_NTYPE) {
+		layer = STATS_LATENCY_local;
+	}
+	if (us < 0) {
+		us = 0;
+	}
+
+	st = ctx->stats;
+	stp = array_get(&st->current, pool->idx);
+	sl = &stp->latency[layer];
+	sl->bucket[stats_latency_bucket((uint64_t) us)]++;
+	sl->count++;
+	if ((uint64_t) us > sl->max) {
+		sl->max = us;
+	}
+	st->updated = 1;
+}
+
 static struct stats_metric *
 stats_server_to_metric(struct context *ctx, struct cache_instance *ins,
 		stats_server_field_t fidx) {
@@ -19,6 +19,7 @@
 
 #include "da_array.h"
 #include "da_string.h"
+#include <pthread.h>
 
 struct event_base;
 struct server_pool;
@@ -57,7 +58,13 @@ typedef void (*event_stats_cb_t)(void *, int);
   ACTION(pool_logic_hit, STATS_COUNTER, "# pool logic hit times")              \
   ACTION(pool_elaspe_time, STATS_COUNTER, "# pool elapse time(us)")            \
   ACTION(pool_package_split, STATS_COUNTER, "# pool package split times")      \
-  ACTION(pool_request_get_keys, STATS_COUNTER, "# pool get request key count")
+  ACTION(pool_request_get_keys, STATS_COUNTER, "# pool get request key count") \
+  ACTION(pool_shape_hit, STATS_COUNTER, "# pool sql shape cache hit times")     \
+  ACTION(pool_shape_miss, STATS_COUNTER, "# pool sql shape cache miss times")   \
+  ACTION(pool_result_hit, STATS_COUNTER, "# pool result cache hit times")      \
+  ACTION(pool_result_miss, STATS_COUNTER, "# pool result cache miss times")    \
+  ACTION(pool_result_entries, STATS_GAUGE, "# pool result cache entries")      \
+  ACTION(pool_result_bytes, STATS_GAUGE, "  pool result cache bytes")
 
 #define STATS_SERVER_CODEC(ACTION)                                             \
   /* server behavior */                                                        \
@@ -71,7 +78,26 @@ typedef void (*event_stats_cb_t)(void *, int);
   ACTION(server_response_bytes, STATS_COUNTER, "server total response bytes")  \
   ACTION(server_request_error, STATS_COUNTER, "# server requests error")       \
   ACTION(server_in_queue, STATS_GAUGE, "# requests in incoming queue")         \
-  ACTION(server_in_tree, STATS_GAUGE, "# requests in backwork search tree")
+  ACTION(server_in_tree, STATS_GAUGE, "# requests in backwork search tree")    \
+  ACTION(server_latency_us, STATS_GAUGE, "response time ewma in us")
+
+/* request latency by route layer, index is msg layer */
+#define STATS_LATENCY_CODEC(ACTION)                                            \
+  ACTION(local, "answered by agent")                                           \
+  ACTION(cache, "L1, dtc cache")                                               \
+  ACTION(hot, "L2, hot database")                                              \
+  ACTION(full, "L3, full database")
+
+/*
+ * log-linear buckets, 2^STATS_LATENCY_SUB_BITS buckets per power of two,
+ * relative error of a percentile is below 1/16. values in us, the last
+ * bucket holds everything from 2^STATS_LATENCY_MAX_BITS us.
+ */
+#define STATS_LATENCY_SUB_BITS 4
+#define STATS_LATENCY_SUB (1 << STATS_LATENCY_SUB_BITS)
+#define STATS_LATENCY_MAX_BITS 40
+#define STATS_LATENCY_NBUCKET                                                  \
+  ((STATS_LATENCY_MAX_BITS - STATS_LATENCY_SUB_BITS + 1) * STATS_LATENCY_SUB)
 
 typedef enum stats_type {
   STATS_INVALID,
@@ -107,15 +133,32 @@ struct stats_file_item {
   uint64_t stat_all;
 };
 
+struct stats_file_latency {
+  char name[16];
+  uint64_t count; /* requests of the last interval */
+  uint64_t p50;   /* in us */
+  uint64_t p99;
+  uint64_t p999;
+  uint64_t max;
+};
+
 struct stats_file_server {
   struct stats_file_server_head *shead;
   struct stats_file_item *server_item_list;
 };
 
+struct stats_latency {
+  uint64_t count;
+  uint64_t max;
+  uint64_t bucket[STATS_LATENCY_NBUCKET];
+};
+
 struct stats_file_pool {
   struct stats_file_pool_head *phead;
   struct stats_file_item *pool_item_list;
   struct array stats_file_servers;
+  struct stats_file_latency *latency_list; /* after the servers */
+  struct stats_latency *latency_sum;       /* workers merged */
 };
 
 struct stats_metric {
@@ -138,6 +181,7 @@ struct stats_pool {
   struct string name;  /* pool name (ref) */
   struct array metric; /* stats_metric[] for pool codec */
   struct array server; /* stats_server[] */
+  struct stats_latency *latency; /* stats_latency[STATS_LATENCY_NTYPE] */
   int main_report;
   int instance_report;
 };
@@ -153,6 +197,9 @@ struct stats {
   char localip[16];        /* ip address of this machine */
   volatile int aggregate;  /* shadow (b) aggregate? */
   volatile int updated;    /* current (a) updated? */
+  pthread_mutex_t lock;    /* protect worker list */
+  struct stats *master;    /* stats owning the aggregator, NULL for itself */
+  struct stats *next;      /* worker stats merged by the aggregator */
 };
 
 #define DEFINE_ACTION(_name, _type, _desc) STATS_POOL_##_name,
@@ -167,6 +214,12 @@ typedef enum stats_server_field {
 } stats_server_field_t;
 #undef DEFINE_ACTION
 
+#define DEFINE_ACTION(_name, _desc) STATS_LATENCY_##_name,
+typedef enum stats_latency_type {
+  STATS_LATENCY_CODEC(DEFINE_ACTION) STATS_LATENCY_NTYPE
+} stats_latency_type_t;
+#undef DEFINE_ACTION
+
 /* struct for report data to monitor centor*/
 struct _ReportParam {
   uint32_t uCType;
@@ -260,6 +313,11 @@ enum {
     _stats_server_set_ts(_ctx, _server, STATS_SERVER_##_name, _val);           \
   } while (0)
 
+#define stats_pool_latency(_ctx, _pool, _layer, _us)                           \
+  do {                                                                         \
+    _stats_pool_latency(_ctx, _pool, _layer, _us);                             \
+  } while (0)
+
 #else
 
 #define stats_pool_incr(_ctx, _pool, _name)
@@ -278,6 +336,8 @@ enum {
 
 #define stats_server_decr_by(_ctx, _server, _name, _val)
 
+#define stats_pool_latency(_ctx, _pool, _layer, _us)
+
 #endif
 
 #define stats_enabled DA_STATS
@@ -294,6 +354,8 @@ void _stats_pool_decr_by(struct context *ctx, struct server_pool *pool,
                          stats_pool_field_t fidx, int64_t val);
 void _stats_pool_set_ts(struct context *ctx, struct server_pool *pool,
                         stats_pool_field_t fidx, int64_t val);
+void _stats_pool_latency(struct context *ctx, struct server_pool *pool,
+                         int layer, int64_t us);
 
 void _stats_server_incr(struct context *ctx, struct cache_instance *ins,
                         stats_server_field_t fidx);
@@ -308,6 +370,8 @@ void _stats_server_set_ts(struct context *ctx, struct cache_instance *ins,
 
 struct stats *stats_create(int stats_interval, char *localip,
                            struct array *server_pool);
+struct stats *stats_create_worker(struct stats *master,
+                                  struct array *server_pool);
 void stats_destroy(struct stats *stats);
 void stats_swap(struct stats *stats);
 
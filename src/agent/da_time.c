@@ -16,18 +16,19 @@
 
 #include "da_time.h"
 
-uint32_t   curr_sec_ms;     /* millisecond of current second (0..999) */
-uint32_t   ms_left_scaled;  /* milliseconds left for current second (0..2^32-1) */
-uint64_t   now_ms;          /* internal date in milliseconds (may wrap) */
-uint64_t   now_us;          /* internal date in us (may wrap) */
-uint32_t   samp_time;       /* total elapsed time over current sample */
-uint32_t   idle_time;       /* total idle time over current sample */
-uint32_t   idle_pct;        /* idle to total ratio over last sample (percent) */
-struct timeval now;             /* internal date is a monotonic function of real clock */
-struct timeval date;            /* the real current date */
-struct timeval start_date;      /* the process's start date */
-struct timeval before_poll;     /* system date before calling poll() */
-struct timeval after_poll;      /* system date after leaving poll() */
+/* every worker thread keeps its own clock, updated by its event loop */
+__thread uint32_t   curr_sec_ms;     /* millisecond of current second (0..999) */
+__thread uint32_t   ms_left_scaled;  /* milliseconds left for current second (0..2^32-1) */
+__thread uint64_t   now_ms;          /* internal date in milliseconds (may wrap) */
+__thread uint64_t   now_us;          /* internal date in us (may wrap) */
+__thread uint32_t   samp_time;       /* total elapsed time over current sample */
+__thread uint32_t   idle_time;       /* total idle time over current sample */
+__thread uint32_t   idle_pct;        /* idle to total ratio over last sample (percent) */
+__thread struct timeval now;             /* internal date is a monotonic function of real clock */
+__thread struct timeval date;            /* the real current date */
+__thread struct timeval start_date;      /* the process's start date */
+__thread struct timeval before_poll;     /* system date before calling poll() */
+__thread struct timeval after_poll;      /* system date after leaving poll() */
 
 /*
  * adds <ms> ms to <from>, set the result to <tv> and returns a pointer <tv>
@@ -164,7 +165,7 @@ REGPRM2 int _tv_isgt(const struct timeval *tv1, const struct timeval *tv2)
  */
 REGPRM2 void tv_update_date(int max_wait, int interrupted)
 {
-	static struct timeval tv_offset; /* warning: signed offset! */
+	static __thread struct timeval tv_offset; /* warning: signed offset! */
 	struct timeval adjusted, deadline;
 
 	gettimeofday(&date, NULL);
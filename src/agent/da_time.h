@@ -45,22 +45,22 @@
   (((new) < 0) ? (old) : (((old) < 0 || (new) < (old)) ? (new) : (old)))
 #define SETNOW(a) (*a = now)
 
-extern uint32_t curr_sec_ms; /* millisecond of current second (0..999) */
-extern uint32_t
+extern __thread uint32_t curr_sec_ms; /* millisecond of current second (0..999) */
+extern __thread uint32_t
     ms_left_scaled; /* milliseconds left for current second (0..2^32-1) */
-extern uint32_t
+extern __thread uint32_t
     curr_sec_ms_scaled;    /* millisecond of current second (0..2^32-1) */
-extern uint64_t now_ms;    /* internal date in milliseconds (may wrap) */
-extern uint64_t now_us;    /* internal date in us (may wrap) */
-extern uint32_t samp_time; /* total elapsed time over current sample */
-extern uint32_t idle_time; /* total idle time over current sample */
-extern uint32_t idle_pct;  /* idle to total ratio over last sample (percent) */
-extern struct timeval
+extern __thread uint64_t now_ms;    /* internal date in milliseconds (may wrap) */
+extern __thread uint64_t now_us;    /* internal date in us (may wrap) */
+extern __thread uint32_t samp_time; /* total elapsed time over current sample */
+extern __thread uint32_t idle_time; /* total idle time over current sample */
+extern __thread uint32_t idle_pct;  /* idle to total ratio over last sample (percent) */
+extern __thread struct timeval
     now; /* internal date is a monotonic function of real clock */
-extern struct timeval date;        /* the real current date */
-extern struct timeval start_date;  /* the process's start date */
-extern struct timeval before_poll; /* system date before calling poll() */
-extern struct timeval after_poll;  /* system date after leaving poll() */
+extern __thread struct timeval date;        /* the real current date */
+extern __thread struct timeval start_date;  /* the process's start date */
+extern __thread struct timeval before_poll; /* system date before calling poll() */
+extern __thread struct timeval after_poll;  /* system date after leaving poll() */
 
 /**** exported functions *************************************************/
 /*
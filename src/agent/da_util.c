@@ -256,7 +256,7 @@ int _da_atoi(uint8_t *line, size_t n) {
  */
 char *
 da_unresolve_peer_desc(int sd) {
-	static struct sockinfo si;
+	static __thread struct sockinfo si;
 	struct sockaddr *addr;
 	socklen_t addrlen;
 	int status;
@@ -372,8 +372,8 @@ int da_resolve(struct string *name, int port, struct sockinfo *si) {
 }
 
 char *da_unresolve_addr(struct sockaddr *addr, socklen_t addrlen) {
-	static char unresolve[NI_MAXHOST + NI_MAXSERV];
-	static char host[NI_MAXHOST], service[NI_MAXSERV];
+	static __thread char unresolve[NI_MAXHOST + NI_MAXSERV];
+	static __thread char host[NI_MAXHOST], service[NI_MAXSERV];
 	int status;
 
 	status = getnameinfo(addr, addrlen, host, sizeof(host), service,
@@ -395,7 +395,7 @@ char *da_unresolve_addr(struct sockaddr *addr, socklen_t addrlen) {
  */
 char *da_unresolve_desc(int sd)
 {
-    static struct sockinfo si;
+    static __thread struct sockinfo si;
     struct sockaddr *addr;
     socklen_t addrlen;
     int status;
@@ -0,0 +1,158 @@
+/*
+ * Copyright [2021] JD.com, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <signal.h>
+#include <sched.h>
+#include <unistd.h>
+#include "da_worker.h"
+#include "da_core.h"
+#include "da_listener.h"
+#include "da_log.h"
+#include "da_time.h"
+
+static struct worker *workers;
+static int nworkers;
+static volatile int worker_quit;
+
+static void worker_set_affinity(struct worker *w) {
+	cpu_set_t set;
+	long ncpu;
+	int cpu;
+
+	/* main thread is bound to cpumask, workers follow it */
+	ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+	if (ncpu <= 0) {
+		return;
+	}
+	cpu = (w->dai->cpumask + w->idx) % ncpu;
+
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0) {
+		log_error("set cpu affinity of worker %d failed", w->idx);
+	}
+}
+
+static void *worker_loop(void *arg) {
+	struct worker *w = arg;
+	struct context *ctx;
+	sigset_t set;
+	int closed = 0;
+
+	/* signals are delivered to main thread */
+	sigfillset(&set);
+	pthread_sigmask(SIG_BLOCK, &set, NULL);
+
+	tv_update_date(-1, -1);
+	_set_remote_log_fd_();
+	if (w->dai->cpumask != -1) {
+		worker_set_affinity(w);
+	}
+
+	ctx = core_worker_start(w->dai, w->dai->ctx);
+	w->ctx = ctx;
+	w->status = ctx == NULL ? -1 : 0;
+	sem_post(&w->ready);
+	if (ctx == NULL) {
+		return NULL;
+	}
+
+	log_info("worker %d started", w->idx);
+	tv_update_date(0, 1);
+
+	while (!worker_quit) {
+		if (core_loop(ctx) != 0) {
+			break;
+		}
+		/* new binary takes over listening sockets on reload */
+		if (!closed && core_getinst_status() == EXITING) {
+			listener_deinit(ctx);
+			closed = 1;
+		}
+	}
+
+	core_worker_stop(ctx);
+	w->ctx = NULL;
+	log_info("worker %d stopped", w->idx);
+	return NULL;
+}
+
+/*
+ * start nworker - 1 event loop threads, main thread runs the first loop
+ */
+int worker_init(struct instance *dai) {
+	int i, status;
+
+	if (dai->nworker <= 1) {
+		return 0;
+	}
+
+	workers = calloc(dai->nworker - 1, sizeof(struct worker));
+	if (workers == NULL) {
+		log_error("alloc %d workers failed", dai->nworker - 1);
+		return -1;
+	}
+	worker_quit = 0;
+
+	for (i = 0; i < dai->nworker - 1; i++) {
+		struct worker *w = &workers[i];
+
+		w->idx = i + 1;
+		w->dai = dai;
+		w->ctx = NULL;
+		w->status = -1;
+		sem_init(&w->ready, 0, 0);
+
+		status = pthread_create(&w->tid, NULL, worker_loop, w);
+		if (status != 0) {
+			log_error("create worker %d failed: %s", w->idx,
+					strerror(status));
+			sem_destroy(&w->ready);
+			worker_deinit();
+			return -1;
+		}
+		nworkers++;
+
+		while (sem_wait(&w->ready) != 0 && errno == EINTR)
+			;
+		if (w->status != 0) {
+			log_error("init worker %d failed", w->idx);
+			worker_deinit();
+			return -1;
+		}
+	}
+
+	log_info("%d event loop threads running", dai->nworker);
+	return 0;
+}
+
+void worker_deinit(void) {
+	int i;
+
+	if (workers == NULL) {
+		return;
+	}
+
+	worker_quit = 1;
+	for (i = 0; i < nworkers; i++) {
+		pthread_join(workers[i].tid, NULL);
+		sem_destroy(&workers[i].ready);
+	}
+
+	free(workers);
+	workers = NULL;
+	nworkers = 0;
+}
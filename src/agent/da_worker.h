@@ -0,0 +1,45 @@
+/*
+ * Copyright [2021] JD.com, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DA_WORKER_H_
+#define DA_WORKER_H_
+
+#include <pthread.h>
+#include <semaphore.h>
+
+struct instance;
+struct context;
+
+#define WORKER_MAX 64
+
+/*
+ * 多线程模式下，主线程之外的事件循环线程。
+ * 每个线程拥有自己的epoll、客户端连接、后端连接池、msg/mbuf内存池和统计，
+ * 共享主线程的配置和监听socket，由内核在各线程间分配新连接。
+ */
+struct worker {
+	int idx;                 /* worker index, main thread is 0 */
+	pthread_t tid;           /* thread id */
+	struct instance *dai;    /* instance */
+	struct context *ctx;     /* context owned by this thread */
+	sem_t ready;             /* posted after context created */
+	int status;              /* init status */
+};
+
+int worker_init(struct instance *dai);
+void worker_deinit(void);
+
+#endif /* DA_WORKER_H_ */
@@ -186,6 +186,39 @@ int event_add_conn(struct event_base *evb, struct conn *c) {
 	return status;
 }
 
+/*
+ * listening socket is shared by all worker threads, wake up only one of
+ * them for a new connection
+ */
+int event_add_listener(struct event_base *evb, struct conn *c) {
+
+	ASSERT(evb != NULL);
+	ASSERT(c != NULL);
+	ASSERT(c->fd > 0);
+
+	int status;
+	struct epoll_event event;
+	int ep = evb->ep;
+	ASSERT(ep > 0);
+
+	event.events = (uint32_t) (EPOLLIN | EPOLLET | EPOLLEXCLUSIVE);
+	event.data.ptr = c;
+
+	status = epoll_ctl(ep, EPOLL_CTL_ADD, c->fd, &event);
+	if (status < 0 && errno == EINVAL) {
+		/* kernel before 4.5 */
+		event.events = (uint32_t) (EPOLLIN | EPOLLET);
+		status = epoll_ctl(ep, EPOLL_CTL_ADD, c->fd, &event);
+	}
+	if (status < 0) {
+		log_error("epoll ctl on e %d sd %d failed: %s", ep, c->fd,
+				strerror(errno));
+	} else {
+		c->flag |= RECV_ACTIVE;
+	}
+	return status;
+}
+
 int event_del_conn(struct event_base *evb, struct conn *c) {
 
 	ASSERT(evb != NULL);
@@ -26,6 +26,10 @@
 
 #define EVENT_SIZE 1024
 
+#ifndef EPOLLEXCLUSIVE
+#define EPOLLEXCLUSIVE (1u << 28)
+#endif
+
 #define EVENT_READ 0x0000ff
 #define EVENT_WRITE 0x00ff00
 #define EVENT_ERR 0xff0000
@@ -48,6 +52,7 @@ int event_del_in(struct event_base *evb, struct conn *c);
 int event_add_out(struct event_base *evb, struct conn *c);
 int event_del_out(struct event_base *evb, struct conn *c);
 int event_add_conn(struct event_base *evb, struct conn *c);
+int event_add_listener(struct event_base *evb, struct conn *c);
 int event_del_conn(struct event_base *evb, struct conn *c);
 int event_wait(struct event_base *evb, int timeout);
 
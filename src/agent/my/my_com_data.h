@@ -69,6 +69,9 @@ struct COM_STMT_EXECUTE_DATA {
 	unsigned long open_cursor;
 	unsigned long parameter_count;
 	unsigned char has_new_types;
+	/** null bitmap, types and values, points into the request packet */
+	const unsigned char *params;
+	unsigned long params_length;
 };
 
 struct COM_STMT_FETCH_DATA {
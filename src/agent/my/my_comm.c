@@ -27,3 +27,60 @@
 #include "../da_core.h"
 
 
+
+/* append n bytes to the tail of q, taking new mbufs as needed */
+int my_buf_put(struct buf_stqh *q, const uint8_t *p, size_t n)
+{
+	struct mbuf *m = STAILQ_LAST(q, mbuf, next);
+
+	while (n > 0) {
+		size_t len;
+		if (m == NULL || mbuf_full(m)) {
+			m = mbuf_get();
+			if (m == NULL)
+				return -1;
+			mbuf_insert(q, m);
+		}
+		len = MIN(n, mbuf_size(m));
+		mbuf_copy(m, (uint8_t *)p, len);
+		p += len;
+		n -= len;
+	}
+	return 0;
+}
+
+/* append one mysql packet with sequence id seq */
+int my_packet_put(struct buf_stqh *q, const uint8_t *payload, uint32_t len,
+		  uint8_t seq)
+{
+	uint8_t header[MYSQL_HEADER_SIZE];
+
+	if (len >= MAX_PACKET_LENGTH)
+		return -1;
+	int_conv_3(header, len);
+	header[3] = seq;
+	if (my_buf_put(q, header, sizeof(header)) < 0)
+		return -1;
+	return my_buf_put(q, payload, len);
+}
+
+/* copy of the bytes in q in one piece, to be freed by the caller */
+uint8_t *my_buf_dup(struct buf_stqh *q, uint32_t *len)
+{
+	struct mbuf *b;
+	uint8_t *p;
+	uint32_t total = 0, off = 0;
+
+	STAILQ_FOREACH(b, q, next) {
+		total += mbuf_length(b);
+	}
+	p = malloc(total + 1);
+	if (p == NULL)
+		return NULL;
+	STAILQ_FOREACH(b, q, next) {
+		memcpy(p + off, b->pos, mbuf_length(b));
+		off += mbuf_length(b);
+	}
+	*len = total;
+	return p;
+}
@@ -22,6 +22,8 @@
 #include <sys/types.h>
 #include "my_inttypes.h"
 
+struct buf_stqh;
+
 /*
 MYSQL Protocol Definition, See more detail: 
   https://dev.mysql.com/doc/dev/mysql-server/latest/page_protocol_basic_packets.html#sect_protocol_basic_packets_packet
@@ -35,7 +37,8 @@ enum enum_agent_admin {
 	CMD_NOP = 0,
 	CMD_KEY_DEFINE,
 	CMD_SQL_PASS_OK,
-	CMD_SQL_PASS_NULL
+	CMD_SQL_PASS_NULL,
+	CMD_SQL_PASS_ERROR
 };
 
 struct DTC_HEADER_V2 {
@@ -51,7 +54,9 @@ enum AGENT_NEXT_OPERATION {
 	NEXT_FORWARD = 0,
 	NEXT_RSP_OK,
 	NEXT_RSP_ERROR,
-	NEXT_RSP_NULL
+	NEXT_RSP_NULL,
+	NEXT_RSP_STMT_PREPARE,
+	NEXT_RSP_NONE
 };
 
 static inline int32 int_trans_3(const uchar *A)
@@ -90,4 +95,9 @@ static inline uint32 uint_conv_4(const uchar *A)
 	return ret;
 }
 
+int my_buf_put(struct buf_stqh *q, const uint8_t *p, size_t n);
+int my_packet_put(struct buf_stqh *q, const uint8_t *payload, uint32_t len,
+		  uint8_t seq);
+uint8_t *my_buf_dup(struct buf_stqh *q, uint32_t *len);
+
 #endif /* _MY_COMM_H */
@@ -0,0 +1,230 @@
+/*
+* Copyright [2021] JD.com, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <inttypes.h>
+#include <string.h>
+#include "da_protocal.h"
+#include "../da_msg.h"
+#include "../da_conn.h"
+#include "../da_request.h"
+#include "../da_buf.h"
+#include "../da_util.h"
+#include "../da_errno.h"
+#include "../da_core.h"
+#include "my_comm.h"
+#include "my_command.h"
+#include "my_parse.h"
+#include "my_stmt.h"
+#include "my_merge.h"
+#include "my_fragment.h"
+
+/*
+ * dtc takes a single key = literal per request, so key IN (...) becomes
+ * one such query per distinct key, each routed to the backend of its key.
+ * the rows come back as one resultset, see my_coalesce_rows().
+ */
+int my_fragment_keys(struct msg *r, const int *idx, struct msg_tqh *frag_msgq)
+{
+	struct mbuf *b = STAILQ_FIRST(&r->buf_q), *m;
+	struct my_key_list kl;
+	struct msg *sub;
+	uint32_t i, j, koff, len, n = r->keyCount;
+
+	/* keys point into the only mbuf of the request */
+	if (b == NULL || STAILQ_NEXT(b, next) != NULL ||
+	    mbuf_length(b) < MYSQL_HEADER_SIZE)
+		goto error;
+	len = MYSQL_HEADER_SIZE + uint_trans_3(b->pos);
+	if (len > mbuf_length(b))
+		goto error;
+	if (my_key_list_init(&kl, b->pos, len, r->keys[0].start,
+			     r->keys[n - 1].end) < 0) {
+		log_error("msg %" PRIu64 " key list not found", r->id);
+		goto error;
+	}
+
+	r->frag_id = msg_gen_frag_id();
+	r->frag_owner = r;
+	r->nfrag = 0;
+
+	for (i = 0; i < n; i++) {
+		/* a key listed twice is queried once */
+		for (j = 0; j < i; j++) {
+			if (r->keys[j].end - r->keys[j].start ==
+				    r->keys[i].end - r->keys[i].start &&
+			    memcmp(r->keys[j].start, r->keys[i].start,
+				   r->keys[i].end - r->keys[i].start) == 0)
+				break;
+		}
+		if (j < i)
+			continue;
+
+		sub = msg_get(r->owner, true);
+		if (sub == NULL)
+			goto error;
+		m = mbuf_get();
+		if (m == NULL) {
+			req_put(sub);
+			goto error;
+		}
+		mbuf_insert(&sub->buf_q, m);
+		TAILQ_INSERT_TAIL(frag_msgq, sub, o_tqe);
+		/* the query on one key is shorter than the list */
+		if (mbuf_size(m) < len)
+			goto error;
+
+		m->last += my_key_list_query(&kl, r->keys[i].start,
+					     r->keys[i].end, m->last, &koff);
+		sub->keys[0].start = m->pos + koff;
+		sub->keys[0].end =
+			sub->keys[0].start + (r->keys[i].end - r->keys[i].start);
+		sub->keyCount = 1;
+		sub->mlen = mbuf_length(m);
+
+		sub->frag_id = r->frag_id;
+		sub->frag_owner = r;
+		sub->idx = idx[i];
+		sub->cmd = r->cmd;
+		sub->command = COM_QUERY;
+		sub->admin = CMD_NOP;
+		sub->layer = r->layer;
+		sub->keytype = r->keytype;
+		sub->pkt_nr = r->pkt_nr;
+		r->nfrag++;
+		log_debug("msg %" PRIu64 " fragment %" PRIu64 " to idx %d",
+			  r->id, sub->id, sub->idx);
+	}
+	return 0;
+
+error:
+	while (!TAILQ_EMPTY(frag_msgq)) {
+		sub = TAILQ_FIRST(frag_msgq);
+		TAILQ_REMOVE(frag_msgq, sub, o_tqe);
+		req_put(sub);
+	}
+	r->frag_id = 0;
+	r->frag_owner = NULL;
+	r->nfrag = 0;
+	r->err = MSG_FRAGMENT_ERR;
+	return -1;
+}
+
+static void rs_replace(struct msg *rsp, struct buf_stqh *out)
+{
+	struct mbuf *b;
+
+	while (!STAILQ_EMPTY(&rsp->buf_q)) {
+		b = STAILQ_FIRST(&rsp->buf_q);
+		mbuf_remove(&rsp->buf_q, b);
+		mbuf_put(b);
+	}
+	rsp->mlen = 0;
+	while (!STAILQ_EMPTY(out)) {
+		b = STAILQ_FIRST(out);
+		mbuf_remove(out, b);
+		mbuf_insert(&rsp->buf_q, b);
+		rsp->mlen += mbuf_length(b);
+	}
+}
+
+/*
+ * merge the responses of all fragments into the peer stolen from one of
+ * them. an error or any response other than a resultset goes to the
+ * client as is, a failed merge as an error packet.
+ */
+static int my_coalesce_rows(struct msg *r)
+{
+	struct conn *c = r->owner;
+	struct context *ctx = conn_to_ctx(c);
+	struct msg *cmsg, *nmsg, *rsp;
+	struct msg *frag[MY_ROUTE_KEY_MAX];
+	uint8_t *raw[MY_ROUTE_KEY_MAX];
+	uint32_t len[MY_ROUTE_KEY_MAX];
+	struct buf_stqh out;
+	struct mbuf *b;
+	uint64_t id = r->frag_id;
+	uint32_t i, n = 0, pick = 0;
+	int status = 0;
+
+	STAILQ_INIT(&out);
+	for (cmsg = TAILQ_NEXT(r, c_i_tqe); cmsg != NULL && cmsg->frag_id == id;
+	     cmsg = TAILQ_NEXT(cmsg, c_i_tqe)) {
+		ASSERT(cmsg->peer != NULL && n < MY_ROUTE_KEY_MAX);
+		frag[n] = cmsg;
+		raw[n] = my_buf_dup(&cmsg->peer->buf_q, &len[n]);
+		if (raw[n++] == NULL)
+			status = -1;
+	}
+	ASSERT(n == r->nfrag);
+	if (status == 0)
+		status = my_rs_merge(raw, len, n, &out, &pick);
+
+	/* steal the peer */
+	rsp = frag[pick]->peer;
+	frag[pick]->peer = NULL;
+	frag[pick]->peerid = 0;
+	r->peer = rsp;
+	r->peerid = rsp->id;
+	rsp->peer = r;
+	rsp->peerid = r->id;
+	if (status == 0) {
+		rs_replace(rsp, &out);
+	} else if (status < 0) {
+		log_error("msg %" PRIu64 " merge of %u fragments failed", r->id,
+			  n);
+		my_rs_error(&rsp->buf_q, r->pkt_nr + 1);
+		rsp->mlen = 0;
+		STAILQ_FOREACH(b, &rsp->buf_q, next) {
+			rsp->mlen += mbuf_length(b);
+		}
+	} else {
+		log_debug("fragment %" PRIu64 " of msg %" PRIu64
+			  " is not a resultset",
+			  frag[pick]->id, r->id);
+		status = 0;
+	}
+
+	for (i = 0; i < n; i++)
+		free(raw[i]);
+	for (cmsg = TAILQ_NEXT(r, c_i_tqe); cmsg != NULL && cmsg->frag_id == id;
+	     cmsg = nmsg) {
+		nmsg = TAILQ_NEXT(cmsg, c_i_tqe);
+		c->dequeue_inq(ctx, c, cmsg);
+		req_put(cmsg);
+	}
+	log_debug("msg %" PRIu64 " coalesce %u fragments, rsp len %u", r->id,
+		  r->nfrag, rsp->mlen);
+	return status;
+}
+
+int my_coalesce(struct msg *r)
+{
+	int status = 0;
+
+	ASSERT(r->request == 1);
+	ASSERT(r->done == 1);
+	ASSERT(r->swallow == 0);
+
+	if (r->frag_id != 0)
+		status = my_coalesce_rows(r);
+
+	/* executed as text query, reply in binary protocol */
+	if (r->command == COM_STMT_EXECUTE && my_stmt_rsp_binary(r->peer) < 0) {
+		log_error("stmt rsp to binary error, msg id: %" PRIu64 "",
+			  r->peer->id);
+		status = -1;
+	}
+	return status;
+}
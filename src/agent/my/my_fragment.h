@@ -0,0 +1,31 @@
+/*
+ * Copyright [2021] JD.com, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _MY_FRAGMENT_H_
+#define _MY_FRAGMENT_H_
+
+struct msg;
+struct msg_tqh;
+
+/*
+ * 多key请求(key IN (...))拆分。dtc每个请求只接受一个key，
+ * 每个key改写为一个key = 值的子请求，按key路由并发转发，
+ * 各子请求的结果集在回包时合并为一个。
+ */
+int my_fragment_keys(struct msg *r, const int *idx, struct msg_tqh *frag_msgq);
+int my_coalesce(struct msg *r);
+
+#endif /* _MY_FRAGMENT_H_ */
@@ -0,0 +1,263 @@
+/*
+ * Copyright [2021] JD.com, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "../da_buf.h"
+#include "../da_log.h"
+#include "my_comm.h"
+#include "my_merge.h"
+
+/* text resultset of one fragment, offsets into raw */
+struct frag_rs {
+	uint8_t *raw;
+	uint32_t len;
+	uint32_t ncol;
+	uint32_t head; /* column count, definitions and eof end here */
+	uint32_t rows; /* rows end here, the final eof follows */
+	uint32_t tail; /* end of the final eof */
+};
+
+static inline bool is_word_byte(uint8_t c)
+{
+	return isalnum(c) || c == '_' || c == '$' || c >= 0x80;
+}
+
+/* widen a key literal to its quotes, if quoted */
+static void key_literal(const uint8_t *lo, const uint8_t *hi,
+			const uint8_t **start, const uint8_t **end)
+{
+	const uint8_t *s = *start, *e = *end;
+
+	if (s > lo && e < hi && (s[-1] == '\'' || s[-1] == '"') &&
+	    *e == s[-1]) {
+		*start = s - 1;
+		*end = e + 1;
+	}
+}
+
+int my_key_list_init(struct my_key_list *kl, const uint8_t *pkt, uint32_t len,
+		     const uint8_t *first, const uint8_t *last)
+{
+	const uint8_t *lo = pkt + MYSQL_HEADER_SIZE, *hi = pkt + len;
+	const uint8_t *open = first, *close = last;
+
+	if (first < lo || last > hi || first > last)
+		return -1;
+	/* the quotes of the first and the last literal */
+	if (open > lo && (open[-1] == '\'' || open[-1] == '"'))
+		open--;
+	if (close < hi && (*close == '\'' || *close == '"'))
+		close++;
+
+	/* ... IN ( */
+	while (open > lo && isspace(open[-1]))
+		open--;
+	if (open <= lo || open[-1] != '(')
+		return -1;
+	for (open--; open > lo && isspace(open[-1]); open--)
+		;
+	if (open - lo < 3 || toupper(open[-1]) != 'N' ||
+	    toupper(open[-2]) != 'I' || is_word_byte(open[-3]))
+		return -1;
+
+	/* ) */
+	while (close < hi && isspace(*close))
+		close++;
+	if (close == hi || *close != ')')
+		return -1;
+
+	kl->pkt = pkt;
+	kl->len = len;
+	kl->in = open - 2 - pkt;
+	kl->close = close + 1 - pkt;
+	return 0;
+}
+
+uint32_t my_key_list_query(const struct my_key_list *kl, const uint8_t *start,
+			   const uint8_t *end, uint8_t *out, uint32_t *koff)
+{
+	const uint8_t *s = start, *e = end;
+	uint32_t n = kl->in;
+
+	key_literal(kl->pkt + MYSQL_HEADER_SIZE, kl->pkt + kl->len, &s, &e);
+	memcpy(out, kl->pkt, n);
+	memcpy(out + n, "= ", 2);
+	n += 2;
+	*koff = n + (start - s);
+	memcpy(out + n, s, e - s);
+	n += e - s;
+	memcpy(out + n, kl->pkt + kl->close, kl->len - kl->close);
+	n += kl->len - kl->close;
+	int_conv_3(out, n - MYSQL_HEADER_SIZE);
+	return n;
+}
+
+/* payload of the packet at off, NULL if truncated */
+static uint8_t *rs_packet(const struct frag_rs *rs, uint32_t off,
+			  uint32_t *len)
+{
+	if (off + MYSQL_HEADER_SIZE > rs->len)
+		return NULL;
+	*len = uint_trans_3(rs->raw + off);
+	if (*len == 0 || *len > rs->len - off - MYSQL_HEADER_SIZE)
+		return NULL;
+	return rs->raw + off + MYSQL_HEADER_SIZE;
+}
+
+static inline bool rs_eof(const uint8_t *p, uint32_t len)
+{
+	return *p == 0xfe && len < 9;
+}
+
+/*
+ * locate column header, rows and final eof of a response.
+ * return 0 on resultset, 1 on ok, error or anything to be sent as is,
+ * -1 if malformed.
+ */
+static int rs_scan(struct frag_rs *rs)
+{
+	uint32_t off, len, i;
+	uint8_t *p;
+
+	p = rs_packet(rs, 0, &len);
+	if (p == NULL)
+		return -1;
+	if (*p == 0x00 || *p == 0xff || *p == 0xfb || rs_eof(p, len))
+		return 1;
+	if (*p < 0xfb)
+		rs->ncol = *p;
+	else if (*p == 0xfc && len >= 3)
+		rs->ncol = p[1] | (p[2] << 8);
+	else
+		return -1;
+
+	off = MYSQL_HEADER_SIZE + len;
+	for (i = 0; i < rs->ncol; i++) {
+		if (rs_packet(rs, off, &len) == NULL)
+			return -1;
+		off += MYSQL_HEADER_SIZE + len;
+	}
+	p = rs_packet(rs, off, &len);
+	if (p == NULL)
+		return -1;
+	/* no eof after definitions if the last packet is the final one */
+	if (rs_eof(p, len) && off + MYSQL_HEADER_SIZE + len < rs->len)
+		off += MYSQL_HEADER_SIZE + len;
+	rs->head = off;
+
+	for (;;) {
+		p = rs_packet(rs, off, &len);
+		if (p == NULL)
+			return -1;
+		if (rs_eof(p, len) || *p == 0xff)
+			break;
+		off += MYSQL_HEADER_SIZE + len;
+	}
+	rs->rows = off;
+	rs->tail = off + MYSQL_HEADER_SIZE + len;
+	return *p == 0xff ? 1 : 0;
+}
+
+static int rs_copy(struct buf_stqh *out, const struct frag_rs *rs,
+		   uint32_t from, uint32_t to, uint8_t *seq)
+{
+	uint32_t off, len;
+	uint8_t *p;
+
+	for (off = from; off < to; off += MYSQL_HEADER_SIZE + len) {
+		p = rs_packet(rs, off, &len);
+		if (p == NULL || my_packet_put(out, p, len, (*seq)++) < 0)
+			return -1;
+	}
+	return 0;
+}
+
+static void rs_free(struct buf_stqh *q)
+{
+	struct mbuf *b;
+
+	while (!STAILQ_EMPTY(q)) {
+		b = STAILQ_FIRST(q);
+		mbuf_remove(q, b);
+		mbuf_put(b);
+	}
+}
+
+int my_rs_merge(uint8_t *const *raw, const uint32_t *len, uint32_t n,
+		struct buf_stqh *out, uint32_t *pick)
+{
+	struct frag_rs *rs;
+	uint32_t i;
+	uint8_t seq;
+	int ret = 0;
+
+	if (n == 0)
+		return -1;
+	rs = calloc(n, sizeof(*rs));
+	if (rs == NULL)
+		return -1;
+	for (i = 0; i < n && ret == 0; i++) {
+		rs[i].raw = raw[i];
+		rs[i].len = len[i];
+		ret = rs_scan(&rs[i]);
+		if (ret > 0)
+			*pick = i;
+		else if (ret == 0 && rs[i].ncol != rs[0].ncol) {
+			log_error("fragment %u has %u columns, %u expected", i,
+				  rs[i].ncol, rs[0].ncol);
+			ret = -1;
+		}
+	}
+	if (ret != 0)
+		goto done;
+
+	seq = rs[0].raw[3];
+	if (rs_copy(out, &rs[0], 0, rs[0].head, &seq) < 0)
+		goto error;
+	for (i = 0; i < n; i++) {
+		if (rs_copy(out, &rs[i], rs[i].head, rs[i].rows, &seq) < 0)
+			goto error;
+	}
+	if (rs_copy(out, &rs[n - 1], rs[n - 1].rows, rs[n - 1].tail, &seq) < 0)
+		goto error;
+	goto done;
+
+error:
+	rs_free(out);
+	ret = -1;
+done:
+	free(rs);
+	return ret;
+}
+
+int my_rs_error(struct buf_stqh *q, uint8_t seq)
+{
+	static const char err[] = "\xff\x51\x04#HY000merge of fragment "
+				  "results failed";
+	struct mbuf *first = STAILQ_FIRST(q), *b;
+
+	if (first != NULL) {
+		while ((b = STAILQ_NEXT(first, next)) != NULL) {
+			mbuf_remove(q, b);
+			mbuf_put(b);
+		}
+		mbuf_rewind(first);
+	}
+	return my_packet_put(q, (const uint8_t *)err, sizeof(err) - 1, seq);
+}
@@ -0,0 +1,56 @@
+/*
+ * Copyright [2021] JD.com, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _MY_MERGE_H_
+#define _MY_MERGE_H_
+#include <stdint.h>
+
+struct buf_stqh;
+
+/*
+ * key IN (...) of a query packet, offsets from the packet start.
+ * dtc takes one key per request, so every key of the list is sent as
+ * its own "key = literal" query and the resultsets are merged back.
+ */
+struct my_key_list {
+	const uint8_t *pkt; /* query packet, header included */
+	uint32_t len;       /* packet length, header included */
+	uint32_t in;        /* the IN keyword */
+	uint32_t close;     /* one past the closing parenthesis */
+};
+
+/* first and last point into pkt, at the first and last key literal */
+int my_key_list_init(struct my_key_list *kl, const uint8_t *pkt, uint32_t len,
+		     const uint8_t *first, const uint8_t *last);
+/*
+ * write the packet of the query on key [start, end) to out, which holds
+ * kl->len bytes. return its length, koff is the key offset in out.
+ */
+uint32_t my_key_list_query(const struct my_key_list *kl, const uint8_t *start,
+			   const uint8_t *end, uint8_t *out, uint32_t *koff);
+
+/*
+ * append the text resultsets raw[0..n) to out as one: the header of the
+ * first, the rows of all, the final eof of the last.
+ * return 0 if merged, 1 if raw[*pick] is an ok, error or anything else
+ * to be sent as is, -1 if malformed or no memory.
+ */
+int my_rs_merge(uint8_t *const *raw, const uint32_t *len, uint32_t n,
+		struct buf_stqh *out, uint32_t *pick);
+/* replace the bytes in q by an error packet, reusing the first mbuf */
+int my_rs_error(struct buf_stqh *q, uint8_t seq);
+
+#endif /* _MY_MERGE_H_ */
@@ -23,10 +23,12 @@
 #include "../da_buf.h"
 #include "../da_util.h"
 #include "my_net_write.h"
+#include "my_net_send.h"
 #include "../da_errno.h"
 #include "../da_time.h"
 #include "../da_core.h"
 #include "my_comm.h"
+#include "my_stmt.h"
 
 const char* req_string = "select dtctables";
 
@@ -150,6 +152,44 @@ int net_send_ok(struct msg *smsg, struct conn *c_conn) {
 }
 
 
+int net_send_stmt_prepare_ok(struct msg *smsg, struct conn *c_conn) {
+	struct msg* dmsg = NULL;
+	struct my_stmt *stmt;
+	uint8_t pkt_nr = smsg->pkt_nr;
+	stmt = my_stmt_get(c_conn, smsg->data.com_stmt_execute.stmt_id);
+	if(stmt == NULL)
+	{
+		log_error("stmt %lu not found on c %d.",
+			smsg->data.com_stmt_execute.stmt_id, c_conn->fd);
+		return net_send_error(smsg, c_conn);
+	}
+	dmsg = msg_get(c_conn, false);
+	if(dmsg == NULL)
+	{
+		log_error("get new msg error.");
+		c_conn->error = 1;
+		c_conn->err = CONN_MSG_GET_ERR;
+		return -1;
+	}
+
+	log_debug("net send stmt prepare ok pkt nr:%d", pkt_nr);
+	if(my_stmt_rsp_prepare(dmsg, stmt, &pkt_nr) < 0)
+	{
+		msg_put(dmsg);
+		c_conn->error = 1;
+		c_conn->err = CONN_MSG_GET_ERR;
+		return -2;
+	}
+
+	dmsg->pkt_nr = pkt_nr;
+
+	log_debug("dmsg len:%d", dmsg->mlen);
+	dmsg->peer = smsg;
+	smsg->peer = dmsg;
+
+	return 0;
+}
+
 int net_send_error(struct msg *smsg, struct conn *c_conn) {
 	uint8_t buf[MYSQL_ERRMSG_SIZE+10] = {0xff, 0x0, 0x0, 0x30, 0x30, 0x30, 0x30, 0x30, 0x20};
 	uint8_t *pos, *start;
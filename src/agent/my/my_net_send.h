@@ -30,6 +30,7 @@ MYSQL Protocol Definition, See more detail:
 
 int net_send_ok(struct msg *smsg, struct conn *c_conn);
 int net_send_error(struct msg *smsg, struct conn *c_conn);
+int net_send_stmt_prepare_ok(struct msg *smsg, struct conn *c_conn);
 int net_send_switch(struct msg *smsg, struct conn *c_conn);
 int net_send_server_greeting(struct conn* c, struct msg *smsg);
 
@@ -26,10 +26,14 @@
 #include "../da_server.h"
 #include "../da_time.h"
 #include "../da_core.h"
+#include "../da_stats.h"
 #include "my_comm.h"
 #include "my_command.h"
 #include "my_parse.h"
 #include "my_protocol_classic.h"
+#include "my_stmt.h"
+#include "my_sql_token.h"
+#include "my_fragment.h"
 
 // Forward declaration for functions used before defined
 int my_get_command(uint8_t *input_raw_packet, uint32_t input_packet_length,
@@ -127,7 +131,9 @@ void my_parse_req(struct msg *r)
 
 				r->command = command;
 				r->keyCount = 1;
-				r->cmd = MSG_REQ_SVRADMIN;
+				/* L1 reads may go to a replica */
+				if (r->cmd != MSG_REQ_GET)
+					r->cmd = MSG_REQ_SVRADMIN;
 			}
 		}
 		else if (r->owner->stage == CONN_STAGE_LOGGING_IN) 
@@ -359,18 +365,36 @@ int my_do_command(struct msg *msg)
 		rc = NEXT_RSP_OK;
 		break;
 	}
-	case COM_STMT_EXECUTE:
-	case COM_STMT_FETCH:
+	case COM_STMT_PREPARE: {
+		if (msg->admin == CMD_SQL_PASS_ERROR)
+			rc = NEXT_RSP_ERROR;
+		else
+			rc = NEXT_RSP_STMT_PREPARE;
+		break;
+	}
 	case COM_STMT_SEND_LONG_DATA:
-	case COM_STMT_PREPARE:
-	case COM_STMT_CLOSE:
+	case COM_STMT_CLOSE: {
+		/* no response */
+		rc = NEXT_RSP_NONE;
+		break;
+	}
 	case COM_STMT_RESET: {
+		if (msg->admin == CMD_SQL_PASS_ERROR)
+			rc = NEXT_RSP_ERROR;
+		else
+			rc = NEXT_RSP_OK;
+		break;
+	}
+	case COM_STMT_FETCH: {
 		rc = NEXT_RSP_ERROR;
 		break;
 	}
+	case COM_STMT_EXECUTE:
 	case COM_QUERY: {
 		log_debug("COM_QUERY, admin: %d", msg->admin);
-		if (msg->admin == CMD_SQL_PASS_OK)
+		if (msg->admin == CMD_SQL_PASS_ERROR)
+			rc = NEXT_RSP_ERROR;
+		else if (msg->admin == CMD_SQL_PASS_OK)
 			rc = NEXT_RSP_OK;
 		else if (msg->admin == CMD_SQL_PASS_NULL)
 			rc = NEXT_RSP_NULL;
@@ -482,15 +506,68 @@ decode_value_error:
 	return -1;
 }
 
-static uint64_t randomHashSeed = 1;
+static __thread uint64_t randomHashSeed = 1;
 
-int my_fragment(struct msg *r, uint32_t ncontinuum, struct msg_tqh *frag_msgq)
+/* backend of one key */
+static int my_key_idx(struct msg *r, struct keypos *kpos, int *idx)
 {
 	int status, i;
-	struct keypos *temp_kpos;
 	CValue val;
+
+	switch (r->keytype) {
+	case Signed:
+	case Unsigned: {
+		status = dtc_decode_value(Unsigned, kpos->end - kpos->start,
+					  kpos->start, &val);
+		if (status < 0) {
+			log_error("decode value:%d", status);
+			return -1;
+		}
+		log_debug("val.u64:%lu", val.u64);
+		*idx = msg_backend_idx(r, (uint8_t *)&val.u64,
+				       sizeof(uint64_t));
+		log_debug("r->idx:%d", *idx);
+		break;
+	}
+	case String: {
+		int len = kpos->end - kpos->start;
+		char temp[len + 1];
+		*temp = len;
+		for (i = 1; i < len + 1; i++) {
+			temp[i] = lower((char)(kpos->start)[i - 1]);
+		}
+		*idx = msg_backend_idx(r, (uint8_t *)temp, len + 1);
+		log_debug(
+			"debug,len :%d the packet key is %u   '%s' the hash key(r->idx): %d ",
+			len, *temp, temp + 1, *idx);
+		break;
+	}
+	case Binary: {
+		int len = kpos->end - kpos->start;
+		char temp[len + 1];
+		*temp = len;
+		memcpy(temp + 1, kpos->start, len);
+		*idx = msg_backend_idx(r, (uint8_t *)temp, len + 1);
+		log_debug(
+			"debug,len :%d the packet key is %u   '%s' the hash key(r->idx): %d ",
+			len, *temp, temp + 1, *idx);
+		break;
+	}
+	}
+	return 0;
+}
+
+int my_fragment(struct msg *r, uint32_t ncontinuum, struct msg_tqh *frag_msgq)
+{
+	int idx[MY_ROUTE_KEY_MAX];
+	uint32_t i;
 	log_debug("key count:%lu, cmd:%d", r->keyCount, r->cmd);
 
+	if (r->command == COM_STMT_EXECUTE && r->admin == CMD_NOP &&
+	    my_stmt_execute(r) < 0) {
+		r->admin = CMD_SQL_PASS_ERROR;
+	}
+
 	if (r->cmd == MSG_NOP || r->admin != CMD_NOP) {
 		uint64_t randomkey = randomHashSeed++;
 		r->idx = msg_backend_idx(r, (uint8_t *)&randomkey,
@@ -509,97 +586,24 @@ int my_fragment(struct msg *r, uint32_t ncontinuum, struct msg_tqh *frag_msgq)
 			r->err = MSG_NOKEY_ERR;
 			r->error = 1;
 			return -1;
-		} else if (r->keyCount == 1) {
-			temp_kpos = &r->keys[0];
-			switch (r->keytype) {
-			case Signed:
-			case Unsigned: {
-				status = dtc_decode_value(
-					Unsigned,
-					temp_kpos->end - temp_kpos->start,
-					temp_kpos->start, &val);
-				if (status < 0) {
-					log_error("decode value:%d", status);
-					return -1;
-				}
-				log_debug("val.u64:%lu", val.u64);
-				r->idx = msg_backend_idx(r, (uint8_t *)&val.u64,
-							 sizeof(uint64_t));
-				log_debug("r->idx:%d", r->idx);
-				break;
-			}
-			case String: {
-				int len = temp_kpos->end - temp_kpos->start;
-				char temp[len + 1];
-				*temp = len;
-				for (i = 1; i < len + 1; i++) {
-					temp[i] = lower((
-						char)(temp_kpos->start)[i - 1]);
-				}
-				r->idx = msg_backend_idx(r, (uint8_t *)temp,
-							 len + 1);
-				log_debug(
-					"debug,len :%d the packet key is %u   '%s' the hash key(r->idx): %d ",
-					len, *temp, temp + 1, r->idx);
-				break;
-			}
-			case Binary: {
-				int len = temp_kpos->end - temp_kpos->start;
-				char temp[len + 1];
-				*temp = len;
-				memcpy(temp + 1, temp_kpos->start, len);
-				r->idx = msg_backend_idx(r, (uint8_t *)temp,
-							 len + 1);
-				log_debug(
-					"debug,len :%d the packet key is %u   '%s' the hash key(r->idx): %d ",
-					len, *temp, temp + 1, r->idx);
-				break;
-			}
-			}
-
-			log_debug("return status:%d", status);
-			return status;
+		} else if (r->keyCount == 1 && !r->keylist) {
+			return my_key_idx(r, &r->keys[0], &r->idx);
 		} else {
-			if (r->cmd == MSG_REQ_GET) {
-				//status = dtc_fragment_get(r, ncontinuum, frag_msgq);
-				//GET is not supported
-				status = -1;
-			} else if (r->cmd == MSG_REQ_UPDATE) {
-				//MSET is not supported
-				status = -1;
-			} else if (r->cmd == MSG_REQ_DELETE) {
-				//MDEL is not supported
-				status = -1;
-			} else {
-				//other multi operation is not supported
-				status = -1;
+			/*
+			 * key IN (...), see my_get_route_key(). a list of one
+			 * goes this way too and is sent as key = literal.
+			 */
+			if (r->keyCount > MY_ROUTE_KEY_MAX)
+				return -1;
+			for (i = 0; i < r->keyCount; i++) {
+				if (my_key_idx(r, &r->keys[i], &idx[i]) < 0)
+					return -1;
 			}
-			return status;
+			return my_fragment_keys(r, idx, frag_msgq);
 		}
 	}
 }
 
-int _check_condition(struct string *str)
-{
-	int i;
-	char *condition = " WHERE ";
-	char *insert_char = "INSERT INTO ";
-	if (string_empty(str))
-		return -1;
-
-	for (i = 0; i < str->len; i++) {
-		if (da_strncmp(str->data + i, condition,
-			       da_strlen(condition)) == 0 &&
-		    i + da_strlen(condition) < str->len)
-			return i + da_strlen(condition);
-
-		//if(da_strncmp(str->data+i, insert_char, da_strlen(insert_char)) == 0 && i + da_strlen(insert_char) < str->len)
-		//	return i + da_strlen(insert_char);
-	}
-
-	return -2;
-}
-
 bool check_cmd_operation(struct string *str)
 {
 	int i = 0;
@@ -622,6 +626,16 @@ bool check_cmd_operation(struct string *str)
 		return false;
 }
 
+bool check_cmd_select(struct string *str)
+{
+	char *condition = "SELECT ";
+
+	if (str->len <= da_strlen(condition))
+		return false;
+
+	return da_strncmp(str->data, condition, da_strlen(condition)) == 0;
+}
+
 bool check_cmd_insert(struct string *str)
 {
 	int i = 0;
@@ -638,23 +652,230 @@ bool check_cmd_insert(struct string *str)
 		return false;
 }
 
+/*
+ * literal at token i as route key, [*start, *end) excludes quotes.
+ * return # tokens of the literal, -4 if it's not a plain literal.
+ */
+static int route_key_literal(const uint8_t *s, const struct sql_tokens *t,
+			     int i, int *start_offset, int *end_offset)
+{
+	const struct sql_token *v;
+
+	if (i >= t->n)
+		return -5;
+	v = &t->tk[i];
+	switch (v->type) {
+	case SQL_TK_NUMBER:
+	case SQL_TK_STRING:
+	case SQL_TK_WORD:
+		*start_offset = v->start;
+		*end_offset = v->end;
+		return 1;
+	case SQL_TK_PUNCT:
+		/* signed number */
+		if ((sql_token_is_char(s, v, '-') ||
+		     sql_token_is_char(s, v, '+')) && i + 1 < t->n &&
+		    t->tk[i + 1].type == SQL_TK_NUMBER &&
+		    t->tk[i + 1].start == v->end) {
+			*start_offset = v->start;
+			*end_offset = t->tk[i + 1].end;
+			return 2;
+		}
+		break;
+	}
+	return -4;
+}
+
+/*
+ * key IN (literal, ...) with the '(' at token i, one offset pair for each
+ * literal in list order.
+ */
+static int route_key_in(const uint8_t *s, const struct sql_tokens *t, int i,
+			int *start_offset, int *end_offset, int *nkey)
+{
+	int n = 0, ret;
+
+	if (i >= t->n || !sql_token_is_char(s, &t->tk[i], '('))
+		return -2;
+	for (i++;; i++) {
+		if (n == MY_ROUTE_KEY_MAX) {
+			log_error("more than %d keys in list", MY_ROUTE_KEY_MAX);
+			return -2;
+		}
+		ret = route_key_literal(s, t, i, &start_offset[n],
+					&end_offset[n]);
+		if (ret < 0)
+			return ret;
+		n++;
+		i += ret;
+		if (i >= t->n)
+			return -5;
+		if (sql_token_is_char(s, &t->tk[i], ')'))
+			break;
+		if (!sql_token_is_char(s, &t->tk[i], ','))
+			return -4;
+	}
+	*nkey = n;
+	return 0;
+}
+
+/*
+ * key = literal in the condition starting at token from, the first
+ * reference of the key decides. key IN (...) is taken when nkey is given,
+ * *keylist tells it from key = literal.
+ */
+static int route_key_where(const uint8_t *s, const struct sql_tokens *t,
+			   int from, const char *strkey, int *start_offset,
+			   int *end_offset, int *nkey, bool *keylist)
+{
+	size_t keylen = strlen(strkey);
+	int i, ret;
+
+	for (i = from; i < t->n; i++) {
+		if (keylen > 0 ? !sql_token_is(s, &t->tk[i], strkey, keylen) :
+				 (t->tk[i].type != SQL_TK_WORD &&
+				  t->tk[i].type != SQL_TK_QUOTED_ID))
+			continue;
+		if (nkey != NULL && i + 1 < t->n &&
+		    sql_token_is(s, &t->tk[i + 1], "IN", 2)) {
+			*keylist = true;
+			return route_key_in(s, t, i + 2, start_offset,
+					    end_offset, nkey);
+		}
+		if (i + 1 >= t->n || !sql_token_is_char(s, &t->tk[i + 1], '='))
+			return -2;
+		ret = route_key_literal(s, t, i + 2, start_offset, end_offset);
+		return ret < 0 ? ret : 0;
+	}
+	return -2;
+}
+
+/*
+ * rows of a key list split by backend are merged by concatenation, which
+ * only holds for a plain conjunctive select.
+ */
+static bool route_key_mergeable(const uint8_t *s, const struct sql_tokens *t)
+{
+	static const char *const words[] = { "ORDER", "GROUP", "LIMIT",
+					     "HAVING", "DISTINCT", "UNION",
+					     "OR", "NOT", "FOR", "INTO" };
+	static const char *const funcs[] = { "COUNT", "SUM", "MIN", "MAX",
+					     "AVG" };
+	size_t j;
+	int i;
+
+	if (t->n == 0 || !sql_token_is(s, &t->tk[0], "SELECT", 6))
+		return false;
+	for (i = 1; i < t->n; i++) {
+		if (t->tk[i].type != SQL_TK_WORD)
+			continue;
+		for (j = 0; j < NELEMS(words); j++) {
+			if (sql_token_is(s, &t->tk[i], words[j],
+					 strlen(words[j])))
+				return false;
+		}
+		if (i + 1 == t->n || !sql_token_is_char(s, &t->tk[i + 1], '('))
+			continue;
+		for (j = 0; j < NELEMS(funcs); j++) {
+			if (sql_token_is(s, &t->tk[i], funcs[j],
+					 strlen(funcs[j])))
+				return false;
+		}
+	}
+	return true;
+}
+
+/*
+ * INSERT INTO tbl [(col, ...)] VALUES (v, ...), the key column is the
+ * first one if no column list given. INSERT INTO tbl SET col = v, ...
+ */
+static int route_key_insert(const uint8_t *s, const struct sql_tokens *t,
+			    const char *strkey, int *start_offset,
+			    int *end_offset)
+{
+	size_t keylen = strlen(strkey);
+	int i = 3, col = 0, idx = -1, depth = 0, n;
+
+	if (t->n <= i)
+		return -3;
+	/* db.tbl */
+	while (i + 1 < t->n && sql_token_is_char(s, &t->tk[i], '.'))
+		i += 2;
+	if (i < t->n && sql_token_is(s, &t->tk[i], "SET", 3))
+		return route_key_where(s, t, i + 1, strkey, start_offset,
+				       end_offset, NULL, NULL);
+
+	if (i < t->n && sql_token_is_char(s, &t->tk[i], '(')) {
+		for (i++; i < t->n && !sql_token_is_char(s, &t->tk[i], ')');
+		     i++) {
+			if (sql_token_is_char(s, &t->tk[i], ','))
+				col++;
+			else if (idx < 0 &&
+				 sql_token_is(s, &t->tk[i], strkey, keylen))
+				idx = col;
+		}
+		if (idx < 0)
+			return -2;
+		i++;
+	} else {
+		idx = 0;
+	}
+
+	if (i + 1 >= t->n ||
+	    (!sql_token_is(s, &t->tk[i], "VALUES", 6) &&
+	     !sql_token_is(s, &t->tk[i], "VALUE", 5)) ||
+	    !sql_token_is_char(s, &t->tk[i + 1], '('))
+		return -3;
+
+	/* key of the first row routes the statement */
+	for (col = 0, i += 2; i < t->n; i++) {
+		if (col == idx && depth == 0) {
+			n = route_key_literal(s, t, i, start_offset,
+					      end_offset);
+			if (n < 0)
+				return n;
+			i += n;
+			if (i < t->n && (sql_token_is_char(s, &t->tk[i], ',') ||
+					 sql_token_is_char(s, &t->tk[i], ')')))
+				return 0;
+			return -4;
+		}
+		if (sql_token_is_char(s, &t->tk[i], '(')) {
+			depth++;
+		} else if (sql_token_is_char(s, &t->tk[i], ')')) {
+			if (depth-- == 0)
+				return -3;
+		} else if (depth == 0 && sql_token_is_char(s, &t->tk[i], ',')) {
+			col++;
+		}
+	}
+	return -3;
+}
+
 int my_get_route_key(uint8_t *sql, int sql_len, int *start_offset,
-		     int *end_offset, const char* dbsession, struct msg* r)
+		     int *end_offset, int *nkey, const char* dbsession,
+		     struct msg* r)
 {
 	int i = 0;
 	struct string str, ostr;
 	int ret = 0;
 	int layer = 0;
+	bool hit = false, keylist = false;
+	struct conn *c_conn = r->owner;
+	struct context *ctx = conn_to_ctx(c_conn);
+	struct sql_tokens tokens;
 	string_init(&str);
 	string_init(&ostr);
+	sql_tokens_init(&tokens);
 	string_copy(&str, sql, sql_len);
-	string_copy(&ostr, sql, sql_len);
 
 	if (string_empty(&str))
 		return -1;
 
-	if (!string_upper(&str))
-		return -9;
+	if (!string_upper(&str)) {
+		ret = -9;
+		goto done;
+	}
 
 	log_debug("sql: %s", str.data);
 	if(dbsession && strlen(dbsession))
@@ -665,6 +886,27 @@ int my_get_route_key(uint8_t *sql, int sql_len, int *start_offset,
 	char strkey[1024] = {0};
 	memset(strkey, 0, 1024);
 
+	*start_offset = -1;
+	*end_offset = -1;
+	*nkey = 1;
+
+	//same statement template seen before, only the key literal is located.
+	layer = rule_shape_lookup(str.data, str.len, dbsession, strkey,
+				  (int*)&r->keytype, start_offset, end_offset);
+	if (layer > 0) {
+		log_debug("shape layer: %d", layer);
+		stats_pool_incr(ctx, c_conn->owner, pool_shape_hit);
+		hit = true;
+		ret = layer;
+		goto done;
+	}
+	stats_pool_incr(ctx, c_conn->owner, pool_shape_miss);
+
+	if (string_copy(&ostr, sql, sql_len) != 0) {
+		ret = -1;
+		goto done;
+	}
+
 	//agent sql route, rule engine
 	layer = rule_sql_match(str.data, ostr.data, dbsession, strkey, (int*)&r->keytype);
 	log_debug("rule layer: %d", layer);
@@ -675,82 +917,50 @@ int my_get_route_key(uint8_t *sql, int sql_len, int *start_offset,
 		goto done;
 	}
 
-	if (check_cmd_operation(&str))
-		return -2;
+	if (check_cmd_operation(&str)) {
+		ret = -2;
+		goto done;
+	}
 
-	if (check_cmd_insert(&str))
-	{
-		if(get_statement_value(str.data, str.len, strkey, start_offset, end_offset) == 0)
-		{
-			ret = layer;
-			goto done;
-		}
+	if (sql_tokenize((uint8_t *)str.data, str.len, &tokens) < 0) {
+		ret = -2;
+		log_error("tokenize sql error");
+		goto done;
 	}
-	else
-	{
-		i = _check_condition(&str);
+
+	if (check_cmd_insert(&str)) {
+		ret = route_key_insert((uint8_t *)str.data, &tokens, strkey,
+				       start_offset, end_offset);
+	} else {
+		i = sql_token_find((uint8_t *)str.data, &tokens, 0, "WHERE", 5);
 		if (i < 0) {
 			ret = -2;
 			log_error("check condition error code:%d", i);
 			goto done;
 		}
-
-		for (; i < str.len; i++) {
-			if (str.len - i >= strlen(strkey)) {
-				log_debug(
-					"key: %s, key len:%zu, str.len:%d i:%d dtc_key_len:%zu str.data + i:%s ", strkey, strlen(strkey),
-					str.len, i, strlen(strkey), str.data + i);
-				if (da_strncmp(str.data + i, strkey, strlen(strkey)) == 0) 
-				{
-					int j;
-					for (j = i + strlen(strkey); j < str.len; j++) 
-					{
-						if (str.data[j] == '=') 
-						{
-							j++;
-							//strip space.
-							while (j < str.len && (str.data[j] == ' ' || str.data[j] == '\'' || str.data[j] == '\"'))
-							{
-								j++;
-							}
-
-							if (j < str.len) 
-							{
-								*start_offset = j;
-
-								int k = 0;
-								for (k = j; k < str.len;
-									k++) {
-									if (sql[k + 1] == ' ' || sql[k + 1] == '\'' || sql[k + 1] == '\"' || sql[k + 1] == ';' || k + 1 == str.len) 
-									{
-										*end_offset = k + 1;
-										ret = layer;
-										goto done;
-									}
-								}
-
-								ret = -4;
-								goto done;
-							} 
-							else 
-							{
-								ret = -5;
-								goto done;
-							}
-						}
-					}
-
-					ret = -2;
-					goto done;
-				}
-			}
+		ret = route_key_where((uint8_t *)str.data, &tokens, i + 1,
+				      strkey, start_offset, end_offset, nkey,
+				      &keylist);
+		if (ret == 0 && keylist &&
+		    !route_key_mergeable((uint8_t *)str.data, &tokens)) {
+			log_error("key list in a statement can't be merged");
+			ret = -2;
 		}
 	}
-
-	ret = -3;
+	if (ret == 0)
+		ret = layer;
 	goto done;
 
 done:
+	/* a key list is routed key by key, not as one template */
+	r->keylist = ret == 1 && keylist;
+	if (!hit && ret > 0 && !keylist)
+		rule_shape_store(str.data, str.len, dbsession, ret, strkey,
+				 r->keytype, *start_offset, *end_offset);
+	if (ret == 1 && check_cmd_select(&str))
+		r->cmd = MSG_REQ_GET;
+	sql_tokens_deinit(&tokens);
 	string_deinit(&str);
+	string_deinit(&ostr);
 	return ret;
 }
\ No newline at end of file
@@ -34,17 +34,34 @@ void my_parse_rsp(struct msg *r);
 int my_do_command(struct msg *msg);
 int my_fragment(struct msg *r, uint32_t ncontinuum, struct msg_tqh *frag_msgq);
 
+#define MY_ROUTE_KEY_MAX 32 /* keys of one statement, see keys in struct msg */
+
+/* start_offset and end_offset hold MY_ROUTE_KEY_MAX entries */
 int my_get_route_key(uint8_t *sql, int sql_len, int *start_offset,
-		     int *end_offset, const char* dbsession, struct msg* r);
+		     int *end_offset, int *nkey, const char* dbsession,
+		     struct msg* r);
 
 int my_get_command(uint8_t *input_raw_packet, uint32_t input_packet_length,
 		   struct msg *r, enum enum_server_command *cmd);
 
+bool check_cmd_operation(struct string *str);
+bool check_cmd_insert(struct string *str);
+bool check_cmd_select(struct string *str);
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 int rule_sql_match(const char* szsql, const char* osql, const char* dbsession, char* out_dtckey, int* out_keytype);
+int rule_stmt_plan(const char* szsql, const char* osql, const char* dbsession, char* out_dtckey, int* out_keytype);
 int get_statement_value(char* str, int len, const char* strkey, int* start_offset, int* end_offset);
+int rule_shape_lookup(const char* szsql, int len, const char* dbsession, char* out_dtckey, int* out_keytype, int* start_offset, int* end_offset);
+void rule_shape_store(const char* szsql, int len, const char* dbsession, int layer, const char* dtckey, int keytype, int start_offset, int end_offset);
+/* one column of a prepared SELECT, as in rule.h */
+typedef struct _rule_column {
+	char name[64];
+	int type;
+} rule_column;
+int rule_stmt_columns(const char* osql, const char* dbsession, rule_column* out, int max);
 #ifdef __cplusplus
 }
 #endif
@@ -2,6 +2,7 @@
 #include "my_com_data.h"
 #include "da_conn.h"
 #include "my_parse.h"
+#include "my_stmt.h"
 
 static inline char *strend(char *s)
 {
@@ -43,7 +44,8 @@ bool parse_packet(uchar *input_raw_packet, int input_packet_length,
 		break;
 	}
 	case COM_QUERY: {
-		int start_offset, end_offset;
+		int start_offset[MY_ROUTE_KEY_MAX], end_offset[MY_ROUTE_KEY_MAX];
+		int i, nkey;
 
 		uint8_t *p = input_raw_packet;
 		log_debug("len: %d", input_packet_length);
@@ -63,7 +65,8 @@ bool parse_packet(uchar *input_raw_packet, int input_packet_length,
 		log_debug("len: %d", input_packet_length);
 
 		int layer = my_get_route_key(p, input_packet_length,
-					   &start_offset, &end_offset, r->owner->dbname, r);
+					   start_offset, end_offset, &nkey,
+					   r->owner->dbname, r);
 		//if(layer <= 0 || layer > 3)
 		//	layer = 3;
 
@@ -89,10 +92,13 @@ bool parse_packet(uchar *input_raw_packet, int input_packet_length,
 			return true;
 		} else if (layer == 1) {	//forward to DTC.
 			log_debug("L1");
-			log_debug("my_get_route_key parse success. %d, %d",
-			  start_offset, end_offset);
-			r->keys[0].start = input_raw_packet + start_offset;
-			r->keys[0].end = input_raw_packet + end_offset;
+			log_debug("my_get_route_key parse success. %d keys, %d, %d",
+			  nkey, start_offset[0], end_offset[0]);
+			for (i = 0; i < nkey; i++) {
+				r->keys[i].start = input_raw_packet + start_offset[i];
+				r->keys[i].end = input_raw_packet + end_offset[i];
+			}
+			r->keyCount = nkey;
 			r->layer = layer;
 			r->admin = CMD_NOP;
 			break;
@@ -105,6 +111,50 @@ bool parse_packet(uchar *input_raw_packet, int input_packet_length,
 			return false;
 		}
 	}
+	case COM_STMT_PREPARE: {
+		log_debug("COM_STMT_PREPARE len: %d", input_packet_length);
+		r->layer = 0;
+		r->admin = CMD_SQL_PASS_OK;
+		if (my_stmt_prepare(r, input_raw_packet, input_packet_length) < 0)
+			r->admin = CMD_SQL_PASS_ERROR;
+		break;
+	}
+	case COM_STMT_EXECUTE: {
+		/* stmt_id, flags, iteration_count */
+		if (input_packet_length < 9)
+			goto malformed;
+		data->com_stmt_execute.stmt_id = uint_conv_4(input_raw_packet);
+		data->com_stmt_execute.open_cursor = input_raw_packet[4];
+		data->com_stmt_execute.params = input_raw_packet + 9;
+		data->com_stmt_execute.params_length = input_packet_length - 9;
+		log_debug("COM_STMT_EXECUTE stmt: %lu",
+			  data->com_stmt_execute.stmt_id);
+		/* bound and routed in my_fragment(), after the msg is split */
+		r->layer = 0;
+		r->admin = CMD_NOP;
+		break;
+	}
+	case COM_STMT_SEND_LONG_DATA:
+	case COM_STMT_RESET:
+	case COM_STMT_CLOSE: {
+		struct my_stmt *stmt;
+		if (input_packet_length < 4)
+			goto malformed;
+		stmt = my_stmt_get(r->owner, uint_conv_4(input_raw_packet));
+		r->layer = 0;
+		r->admin = CMD_SQL_PASS_OK;
+		if (cmd == COM_STMT_CLOSE)
+			my_stmt_close(r->owner, uint_conv_4(input_raw_packet));
+		else if (stmt == NULL)
+			r->admin = CMD_SQL_PASS_ERROR;
+		else
+			stmt->long_data = cmd == COM_STMT_SEND_LONG_DATA;
+		break;
+	}
+	case COM_STMT_FETCH:
+		r->layer = 0;
+		r->admin = CMD_SQL_PASS_ERROR;
+		break;
 	default:
 		break;
 	}
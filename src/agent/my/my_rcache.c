@@ -0,0 +1,314 @@
+/*
+* Copyright [2021] JD.com, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <inttypes.h>
+#include <ctype.h>
+#include <inttypes.h>
+#include <strings.h>
+#include "da_protocal.h"
+#include "da_atomic.h"
+#include "../da_msg.h"
+#include "../da_conn.h"
+#include "../da_server.h"
+#include "../da_buf.h"
+#include "../da_util.h"
+#include "../da_time.h"
+#include "../da_stats.h"
+#include "my_comm.h"
+#include "my_command.h"
+#include "my_rcache.h"
+
+struct rcache_entry {
+	struct rcache_entry *next; /* hash chain */
+	TAILQ_ENTRY(rcache_entry) lru;
+	uint32_t hash;
+	uint32_t wslot;   /* write stamp slot of the route key */
+	uint64_t fill_us; /* start of the request the response answers */
+	uint32_t klen;    /* db, '\0', sql */
+	uint32_t rlen;    /* response packets, follow the key */
+	uint8_t data[];
+};
+
+TAILQ_HEAD(rcache_tqh, rcache_entry);
+
+struct my_rcache {
+	struct rcache_entry *bucket[MY_RCACHE_BUCKET];
+	struct rcache_tqh lru; /* head is the most recently used */
+	uint64_t ttl_us;
+	size_t size;  /* bytes limit */
+	size_t bytes; /* bytes of all entries */
+};
+
+/* last write through the agent, in us, by route key */
+static atomic8_t wstamp[MY_RCACHE_STAMP];
+
+struct my_rcache *my_rcache_create(int ttl_ms, size_t size)
+{
+	struct my_rcache *rc;
+
+	rc = calloc(1, sizeof(*rc));
+	if (rc == NULL) {
+		log_error("no memory for result cache");
+		return NULL;
+	}
+	TAILQ_INIT(&rc->lru);
+	rc->ttl_us = (uint64_t)ttl_ms * 1000;
+	rc->size = size;
+	return rc;
+}
+
+void my_rcache_destroy(struct my_rcache *rc)
+{
+	struct rcache_entry *e;
+
+	if (rc == NULL)
+		return;
+	while ((e = TAILQ_FIRST(&rc->lru)) != NULL) {
+		TAILQ_REMOVE(&rc->lru, e, lru);
+		free(e);
+	}
+	free(rc);
+}
+
+static uint32_t rcache_fnv(uint32_t h, const uint8_t *p, uint32_t len,
+			   bool fold)
+{
+	uint32_t i;
+
+	for (i = 0; i < len; i++) {
+		h ^= fold ? (uint8_t)lower(p[i]) : p[i];
+		h *= 16777619;
+	}
+	return h;
+}
+
+/*
+ * db and statement text of a request, before or after dtc_header_add()
+ */
+static int rcache_sql(struct msg *r, bool forwarded, const uint8_t **db,
+		      uint32_t *dblen, const uint8_t **sql, uint32_t *len)
+{
+	struct mbuf *b = STAILQ_FIRST(&r->buf_q);
+	uint8_t *p;
+	uint32_t plen;
+
+	if (b == NULL || STAILQ_NEXT(b, next) != NULL)
+		return -1;
+	p = b->pos;
+	if (forwarded) {
+		struct DTC_HEADER_V2 *h = (struct DTC_HEADER_V2 *)p;
+		if (mbuf_length(b) < sizeof(*h) + h->dbname_len)
+			return -1;
+		*db = p + sizeof(*h);
+		*dblen = h->dbname_len;
+		p += sizeof(*h) + h->dbname_len;
+	} else {
+		*db = (uint8_t *)r->owner->dbname;
+		*dblen = strlen(r->owner->dbname);
+	}
+	if (p + MYSQL_HEADER_SIZE + 1 > b->last)
+		return -1;
+	plen = uint_trans_3(p);
+	if (plen < 1 || p + MYSQL_HEADER_SIZE + plen > b->last)
+		return -1;
+	*sql = p + MYSQL_HEADER_SIZE + 1;
+	*len = plen - 1;
+	return 0;
+}
+
+static bool rcache_select(const uint8_t *sql, uint32_t len)
+{
+	uint32_t i = 0;
+
+	/* no query attributes, see parse_packet() */
+	while (i < len && (sql[i] == 0x0 || sql[i] == 0x1 || sql[i] == ' ' ||
+			   sql[i] == '\t' || sql[i] == '\r' || sql[i] == '\n'))
+		i++;
+	return len - i > 6 &&
+	       strncasecmp((const char *)sql + i, "SELECT", 6) == 0 &&
+	       !isalnum(sql[i + 6]) && sql[i + 6] != '_';
+}
+
+static struct rcache_entry *rcache_find(struct my_rcache *rc, uint32_t hash,
+					const uint8_t *db, uint32_t dblen,
+					const uint8_t *sql, uint32_t len)
+{
+	struct rcache_entry *e;
+
+	for (e = rc->bucket[hash % MY_RCACHE_BUCKET]; e != NULL; e = e->next) {
+		if (e->hash == hash && e->klen == dblen + 1 + len &&
+		    memcmp(e->data, db, dblen) == 0 &&
+		    memcmp(e->data + dblen + 1, sql, len) == 0)
+			return e;
+	}
+	return NULL;
+}
+
+static void rcache_drop(struct context *ctx, struct server_pool *pool,
+			struct my_rcache *rc, struct rcache_entry *e)
+{
+	struct rcache_entry **pp = &rc->bucket[e->hash % MY_RCACHE_BUCKET];
+	size_t size = sizeof(*e) + e->klen + e->rlen;
+
+	while (*pp != e)
+		pp = &(*pp)->next;
+	*pp = e->next;
+	TAILQ_REMOVE(&rc->lru, e, lru);
+	rc->bytes -= size;
+	stats_pool_decr(ctx, pool, pool_result_entries);
+	stats_pool_decr_by(ctx, pool, pool_result_bytes, size);
+	free(e);
+}
+
+/*
+ * reads by key on dtc are looked up, writes by key stamp the key for all
+ * workers. return 0 if r is answered from the cache.
+ */
+int my_rcache_req(struct context *ctx, struct conn *c, struct msg *r)
+{
+	struct server_pool *pool = c->owner;
+	struct my_rcache *rc = pool->rcache;
+	struct rcache_entry *e;
+	struct msg *rsp;
+	const uint8_t *db, *sql;
+	uint32_t dblen, len, hash;
+
+	if (rc == NULL || r->layer != 1 || r->admin != CMD_NOP ||
+	    r->frag_id != 0 || r->keyCount != 1 || r->keylist ||
+	    (r->command != COM_QUERY && r->command != COM_STMT_EXECUTE))
+		return -1;
+
+	/* string keys are case insensitive, as in key hashing */
+	r->wslot = rcache_fnv(2166136261u, r->keys[0].start,
+			      r->keys[0].end - r->keys[0].start, true) %
+		   MY_RCACHE_STAMP;
+	/* a statement not in one piece is taken for a write */
+	if (rcache_sql(r, false, &db, &dblen, &sql, &len) < 0 ||
+	    !rcache_select(sql, len)) {
+		atomic8_set(&wstamp[r->wslot], now_us);
+		return -1;
+	}
+	if (r->command != COM_QUERY)
+		return -1;
+
+	hash = rcache_fnv(rcache_fnv(2166136261u, db, dblen, false), sql, len,
+			  false);
+	e = rcache_find(rc, hash, db, dblen, sql, len);
+	if (e != NULL && (now_us - e->fill_us > rc->ttl_us ||
+			  atomic8_read(&wstamp[e->wslot]) >=
+				  (int64_t)e->fill_us)) {
+		rcache_drop(ctx, pool, rc, e);
+		e = NULL;
+	}
+	if (e == NULL) {
+		stats_pool_incr(ctx, pool, pool_result_miss);
+		return -1;
+	}
+
+	rsp = msg_get(c, false);
+	if (rsp == NULL)
+		return -1;
+	if (my_buf_put(&rsp->buf_q, e->data + e->klen, e->rlen) < 0) {
+		msg_put(rsp);
+		return -1;
+	}
+	rsp->mlen = e->rlen;
+	rsp->peer = r;
+	r->peer = rsp;
+	/* answered by agent */
+	r->layer = 0;
+
+	TAILQ_REMOVE(&rc->lru, e, lru);
+	TAILQ_INSERT_HEAD(&rc->lru, e, lru);
+	stats_pool_incr(ctx, pool, pool_result_hit);
+	log_debug("msg %" PRIu64 " result cache hit, %u bytes", r->id,
+		  e->rlen);
+	return 0;
+}
+
+/*
+ * response of a request seen by my_rcache_req() is ready: keep a read
+ * result, stamp a write again now that it is applied.
+ */
+void my_rcache_rsp(struct context *ctx, struct conn *c, struct msg *r)
+{
+	struct server_pool *pool = c->owner;
+	struct my_rcache *rc = pool->rcache;
+	struct rcache_entry *e, *old;
+	struct msg *rsp = r->peer;
+	struct mbuf *b;
+	const uint8_t *db, *sql;
+	uint32_t dblen, len, hash, rlen = 0;
+	uint8_t *p;
+	size_t size;
+
+	if (rc == NULL || r->wslot < 0 || rsp == NULL)
+		return;
+	if (rcache_sql(r, true, &db, &dblen, &sql, &len) < 0 ||
+	    !rcache_select(sql, len)) {
+		atomic8_set(&wstamp[r->wslot], now_us);
+		return;
+	}
+
+	/* written after the request went out, the result may be stale */
+	if (r->command != COM_QUERY ||
+	    atomic8_read(&wstamp[r->wslot]) >= (int64_t)r->start_ts)
+		return;
+	STAILQ_FOREACH(b, &rsp->buf_q, next) {
+		rlen += mbuf_length(b);
+	}
+	/* resultsets only */
+	b = STAILQ_FIRST(&rsp->buf_q);
+	if (rlen > MY_RCACHE_ENTRY_MAX || rlen < MYSQL_HEADER_SIZE + 1 ||
+	    mbuf_length(b) < MYSQL_HEADER_SIZE + 1 ||
+	    b->pos[MYSQL_HEADER_SIZE] == 0xff ||
+	    b->pos[MYSQL_HEADER_SIZE] == 0x00)
+		return;
+	size = sizeof(*e) + dblen + 1 + len + rlen;
+	if (size > rc->size / 4)
+		return;
+
+	e = malloc(size);
+	if (e == NULL)
+		return;
+	memcpy(e->data, db, dblen);
+	e->data[dblen] = '\0';
+	memcpy(e->data + dblen + 1, sql, len);
+	e->klen = dblen + 1 + len;
+	p = e->data + e->klen;
+	STAILQ_FOREACH(b, &rsp->buf_q, next) {
+		memcpy(p, b->pos, mbuf_length(b));
+		p += mbuf_length(b);
+	}
+	e->rlen = rlen;
+	e->wslot = r->wslot;
+	e->fill_us = r->start_ts;
+	hash = rcache_fnv(rcache_fnv(2166136261u, db, dblen, false), sql, len,
+			  false);
+	e->hash = hash;
+
+	old = rcache_find(rc, hash, db, dblen, sql, len);
+	if (old != NULL)
+		rcache_drop(ctx, pool, rc, old);
+	while (rc->bytes + size > rc->size && !TAILQ_EMPTY(&rc->lru))
+		rcache_drop(ctx, pool, rc, TAILQ_LAST(&rc->lru, rcache_tqh));
+
+	e->next = rc->bucket[hash % MY_RCACHE_BUCKET];
+	rc->bucket[hash % MY_RCACHE_BUCKET] = e;
+	TAILQ_INSERT_HEAD(&rc->lru, e, lru);
+	rc->bytes += size;
+	stats_pool_incr(ctx, pool, pool_result_entries);
+	stats_pool_incr_by(ctx, pool, pool_result_bytes, size);
+}
@@ -0,0 +1,43 @@
+/*
+ * Copyright [2021] JD.com, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _MY_RCACHE_H_
+#define _MY_RCACHE_H_
+#include <stdint.h>
+#include <stddef.h>
+
+struct context;
+struct conn;
+struct msg;
+
+#define MY_RCACHE_BUCKET 4096 /* hash buckets of one cache */
+#define MY_RCACHE_STAMP 4096  /* write stamp slots, shared by all workers */
+#define MY_RCACHE_ENTRY_MAX (64 * 1024) /* larger responses are not kept */
+
+/*
+ * 热点key读结果缓存。
+ * 每个worker的server_pool一份，以(db, sql文本)为key保存L1 SELECT的mysql回包，
+ * 毫秒级有效期，按字节数LRU淘汰。
+ * 经过agent的写请求按路由key打写时间戳，所有worker共享，
+ * 早于写时间戳的缓存结果视为失效。
+ */
+struct my_rcache *my_rcache_create(int ttl_ms, size_t size);
+void my_rcache_destroy(struct my_rcache *rc);
+
+int my_rcache_req(struct context *ctx, struct conn *c, struct msg *r);
+void my_rcache_rsp(struct context *ctx, struct conn *c, struct msg *r);
+
+#endif /* _MY_RCACHE_H_ */
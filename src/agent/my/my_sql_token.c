@@ -0,0 +1,305 @@
+/*
+ * Copyright [2021] JD.com, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+#include "my_sql_token.h"
+
+static inline bool is_word_byte(uint8_t c)
+{
+	return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+	       (c >= '0' && c <= '9') || c == '_' || c == '$' || c >= 0x80;
+}
+
+static inline bool is_space_byte(uint8_t c)
+{
+	return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' ||
+	       c == '\v';
+}
+
+/*
+ * word bytes are compared 16 or 32 at a time, bit i of the mask is set
+ * when byte i ends the run
+ */
+#ifdef __AVX2__
+static inline uint32_t word_stop_mask32(const uint8_t *p)
+{
+	__m256i v = _mm256_loadu_si256((const __m256i *)p);
+	__m256i lo = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+	__m256i letter = _mm256_and_si256(
+		_mm256_cmpgt_epi8(lo, _mm256_set1_epi8('a' - 1)),
+		_mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), lo));
+	__m256i digit = _mm256_and_si256(
+		_mm256_cmpgt_epi8(v, _mm256_set1_epi8('0' - 1)),
+		_mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), v));
+	__m256i other = _mm256_or_si256(
+		_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('_')),
+				_mm256_cmpeq_epi8(v, _mm256_set1_epi8('$'))),
+		_mm256_cmpgt_epi8(_mm256_setzero_si256(), v));
+	__m256i word = _mm256_or_si256(_mm256_or_si256(letter, digit), other);
+
+	return ~(uint32_t)_mm256_movemask_epi8(word);
+}
+
+static inline uint32_t quote_stop_mask32(const uint8_t *p, uint8_t q)
+{
+	__m256i v = _mm256_loadu_si256((const __m256i *)p);
+
+	return (uint32_t)_mm256_movemask_epi8(
+		_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(q)),
+				_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\'))));
+}
+#endif
+
+#ifdef __SSE2__
+static inline uint32_t word_stop_mask16(const uint8_t *p)
+{
+	__m128i v = _mm_loadu_si128((const __m128i *)p);
+	__m128i lo = _mm_or_si128(v, _mm_set1_epi8(0x20));
+	__m128i letter =
+		_mm_and_si128(_mm_cmpgt_epi8(lo, _mm_set1_epi8('a' - 1)),
+			      _mm_cmplt_epi8(lo, _mm_set1_epi8('z' + 1)));
+	__m128i digit =
+		_mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('0' - 1)),
+			      _mm_cmplt_epi8(v, _mm_set1_epi8('9' + 1)));
+	__m128i other = _mm_or_si128(
+		_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('_')),
+			     _mm_cmpeq_epi8(v, _mm_set1_epi8('$'))),
+		_mm_cmplt_epi8(v, _mm_setzero_si128()));
+	__m128i word = _mm_or_si128(_mm_or_si128(letter, digit), other);
+
+	return ~(uint32_t)_mm_movemask_epi8(word) & 0xffff;
+}
+
+static inline uint32_t quote_stop_mask16(const uint8_t *p, uint8_t q)
+{
+	__m128i v = _mm_loadu_si128((const __m128i *)p);
+
+	return (uint32_t)_mm_movemask_epi8(
+		_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(q)),
+			     _mm_cmpeq_epi8(v, _mm_set1_epi8('\\'))));
+}
+#endif
+
+/* first byte at or after i which is not part of a word */
+static int scan_word(const uint8_t *s, int i, int len)
+{
+#ifdef __AVX2__
+	for (; i + 32 <= len; i += 32) {
+		uint32_t m = word_stop_mask32(s + i);
+		if (m)
+			return i + __builtin_ctz(m);
+	}
+#endif
+#ifdef __SSE2__
+	for (; i + 16 <= len; i += 16) {
+		uint32_t m = word_stop_mask16(s + i);
+		if (m)
+			return i + __builtin_ctz(m);
+	}
+#endif
+	while (i < len && is_word_byte(s[i]))
+		i++;
+	return i;
+}
+
+/* first quote q or backslash at or after i */
+static int scan_quote(const uint8_t *s, int i, int len, uint8_t q)
+{
+#ifdef __AVX2__
+	for (; i + 32 <= len; i += 32) {
+		uint32_t m = quote_stop_mask32(s + i, q);
+		if (m)
+			return i + __builtin_ctz(m);
+	}
+#endif
+#ifdef __SSE2__
+	for (; i + 16 <= len; i += 16) {
+		uint32_t m = quote_stop_mask16(s + i, q);
+		if (m)
+			return i + __builtin_ctz(m);
+	}
+#endif
+	while (i < len && s[i] != q && s[i] != '\\')
+		i++;
+	return i;
+}
+
+void sql_tokens_init(struct sql_tokens *t)
+{
+	t->tk = t->local;
+	t->n = 0;
+	t->cap = SQL_TOKEN_LOCAL;
+}
+
+void sql_tokens_deinit(struct sql_tokens *t)
+{
+	if (t->tk != t->local)
+		free(t->tk);
+	sql_tokens_init(t);
+}
+
+static int token_push(struct sql_tokens *t, uint8_t type, int start, int end)
+{
+	struct sql_token *tk;
+
+	if (t->n == t->cap) {
+		int cap = t->cap * 2;
+		if (t->tk == t->local) {
+			tk = malloc(cap * sizeof(*tk));
+			if (tk != NULL)
+				memcpy(tk, t->local, t->n * sizeof(*tk));
+		} else {
+			tk = realloc(t->tk, cap * sizeof(*tk));
+		}
+		if (tk == NULL)
+			return -1;
+		t->tk = tk;
+		t->cap = cap;
+	}
+
+	tk = &t->tk[t->n++];
+	tk->type = type;
+	tk->start = start;
+	tk->end = end;
+	return 0;
+}
+
+/*
+ * split the statement into tokens, comments and blanks are dropped.
+ * return -1 on unterminated quote or no memory.
+ */
+int sql_tokenize(const uint8_t *s, int len, struct sql_tokens *t)
+{
+	int i = 0, j;
+
+	t->n = 0;
+	while (i < len) {
+		uint8_t c = s[i];
+
+		if (is_space_byte(c)) {
+			i++;
+			continue;
+		}
+
+		if (c == '\'' || c == '"') {
+			j = i + 1;
+			for (;;) {
+				j = scan_quote(s, j, len, c);
+				if (j >= len)
+					return -1;
+				if (s[j] == '\\') {
+					j += 2;
+					continue;
+				}
+				if (j + 1 < len && s[j + 1] == c) {
+					j += 2;
+					continue;
+				}
+				break;
+			}
+			if (token_push(t, SQL_TK_STRING, i + 1, j) < 0)
+				return -1;
+			i = j + 1;
+		} else if (c == '`') {
+			const uint8_t *p = memchr(s + i + 1, '`', len - i - 1);
+			if (p == NULL)
+				return -1;
+			j = p - s;
+			if (token_push(t, SQL_TK_QUOTED_ID, i + 1, j) < 0)
+				return -1;
+			i = j + 1;
+		} else if (c >= '0' && c <= '9') {
+			j = scan_word(s, i + 1, len);
+			/* 1.5, 1.5E10 */
+			while (j + 1 < len && s[j] == '.' && s[j + 1] >= '0' &&
+			       s[j + 1] <= '9')
+				j = scan_word(s, j + 1, len);
+			if (token_push(t, SQL_TK_NUMBER, i, j) < 0)
+				return -1;
+			i = j;
+		} else if (is_word_byte(c)) {
+			j = scan_word(s, i + 1, len);
+			if (token_push(t, SQL_TK_WORD, i, j) < 0)
+				return -1;
+			i = j;
+		} else if (c == '/' && i + 1 < len && s[i + 1] == '*') {
+			for (j = i + 2; j + 1 < len; j++) {
+				if (s[j] == '*' && s[j + 1] == '/')
+					break;
+			}
+			i = j + 2;
+		} else if (c == '#' || (c == '-' && i + 2 < len &&
+					s[i + 1] == '-' &&
+					is_space_byte(s[i + 2]))) {
+			while (i < len && s[i] != '\n')
+				i++;
+		} else {
+			j = i + 1;
+			/* <=, >=, !=, <>, <=> */
+			if ((c == '<' || c == '>' || c == '!') && j < len &&
+			    (s[j] == '=' || (c == '<' && s[j] == '>'))) {
+				j++;
+				if (c == '<' && s[j - 1] == '=' && j < len &&
+				    s[j] == '>')
+					j++;
+			}
+			if (token_push(t, SQL_TK_PUNCT, i, j) < 0)
+				return -1;
+			i = j;
+		}
+	}
+
+	return 0;
+}
+
+/* word or quoted identifier equals the upper-cased word */
+bool sql_token_is(const uint8_t *s, const struct sql_token *tk,
+		  const char *word, size_t len)
+{
+	if (tk->type != SQL_TK_WORD && tk->type != SQL_TK_QUOTED_ID)
+		return false;
+	if ((size_t)(tk->end - tk->start) != len)
+		return false;
+	return strncasecmp((const char *)s + tk->start, word, len) == 0;
+}
+
+bool sql_token_is_char(const uint8_t *s, const struct sql_token *tk, char c)
+{
+	return tk->type == SQL_TK_PUNCT && tk->end - tk->start == 1 &&
+	       s[tk->start] == (uint8_t)c;
+}
+
+/* index of the first word token at or after from, -1 if none */
+int sql_token_find(const uint8_t *s, const struct sql_tokens *t, int from,
+		   const char *word, size_t len)
+{
+	int i;
+
+	for (i = from; i < t->n; i++) {
+		if (t->tk[i].type == SQL_TK_WORD &&
+		    sql_token_is(s, &t->tk[i], word, len))
+			return i;
+	}
+	return -1;
+}
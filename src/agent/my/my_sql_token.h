@@ -0,0 +1,60 @@
+/*
+ * Copyright [2021] JD.com, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _MY_SQL_TOKEN_H_
+#define _MY_SQL_TOKEN_H_
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define SQL_TOKEN_LOCAL 64 /* tokens kept on stack before going to heap */
+
+enum sql_token_type {
+	SQL_TK_WORD,      /* keyword or identifier */
+	SQL_TK_NUMBER,    /* numeric literal */
+	SQL_TK_STRING,    /* quoted literal, offsets exclude the quotes */
+	SQL_TK_QUOTED_ID, /* `identifier`, offsets exclude the backticks */
+	SQL_TK_PUNCT      /* operator or structural character */
+};
+
+struct sql_token {
+	uint8_t type;
+	int start; /* first byte */
+	int end;   /* one past the last byte */
+};
+
+/*
+ * token offsets of one statement, produced in a single pass and shared by
+ * statement kind checks, key lookup and value extraction.
+ */
+struct sql_tokens {
+	struct sql_token *tk;
+	int n;
+	int cap;
+	struct sql_token local[SQL_TOKEN_LOCAL];
+};
+
+void sql_tokens_init(struct sql_tokens *t);
+void sql_tokens_deinit(struct sql_tokens *t);
+int sql_tokenize(const uint8_t *s, int len, struct sql_tokens *t);
+
+bool sql_token_is(const uint8_t *s, const struct sql_token *tk,
+		  const char *word, size_t len);
+bool sql_token_is_char(const uint8_t *s, const struct sql_token *tk, char c);
+int sql_token_find(const uint8_t *s, const struct sql_tokens *t, int from,
+		   const char *word, size_t len);
+
+#endif /* _MY_SQL_TOKEN_H_ */
@@ -0,0 +1,1187 @@
+/*
+* Copyright [2021] JD.com, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <inttypes.h>
+#include <stdio.h>
+#include <strings.h>
+#include "da_protocal.h"
+#include "../da_msg.h"
+#include "../da_conn.h"
+#include "../da_buf.h"
+#include "../da_util.h"
+#include "da_array.h"
+#include "my_comm.h"
+#include "my_command.h"
+#include "my_parse.h"
+#include "my_stmt.h"
+#include "my_sql_token.h"
+
+#define NULL_COLUMN 0xfb
+#define UNSIGNED_FLAG 32
+
+/* the bound COM_QUERY packet, may span mbufs */
+struct stmt_writer {
+	struct buf_stqh *q;
+	uint32_t len; /* bytes written, header included */
+};
+
+static int stmt_put(struct stmt_writer *w, const void *p, size_t n)
+{
+	/* a single packet, payload below MAX_PACKET_LENGTH */
+	if (w->len + n >= MAX_PACKET_LENGTH + MYSQL_HEADER_SIZE)
+		return -1;
+	if (my_buf_put(w->q, p, n) < 0)
+		return -1;
+	w->len += n;
+	return 0;
+}
+
+static void stmt_buf_free(struct buf_stqh *q)
+{
+	struct mbuf *b;
+
+	while (!STAILQ_EMPTY(q)) {
+		b = STAILQ_FIRST(q);
+		mbuf_remove(q, b);
+		mbuf_put(b);
+	}
+}
+
+/*
+ * n bytes at off of q in one piece, moved into a mbuf of their own when
+ * they cross the end of a mbuf. NULL if out of q or longer than a mbuf.
+ */
+static uint8_t *stmt_buf_at(struct buf_stqh *q, uint32_t off, uint32_t n)
+{
+	struct mbuf *b, *m, *next, *nnext;
+	uint32_t len = 0, left = 0;
+
+	STAILQ_FOREACH(b, q, next) {
+		len = mbuf_length(b);
+		if (off < len)
+			break;
+		off -= len;
+	}
+	if (b == NULL)
+		return NULL;
+	if (n <= len - off)
+		return b->pos + off;
+
+	for (next = STAILQ_NEXT(b, next); next != NULL;
+	     next = STAILQ_NEXT(next, next))
+		left += mbuf_length(next);
+	if (n - (len - off) > left)
+		return NULL;
+	m = mbuf_get();
+	if (m == NULL)
+		return NULL;
+	if (n > mbuf_size(m)) {
+		mbuf_put(m);
+		return NULL;
+	}
+
+	mbuf_copy(m, b->pos + off, len - off);
+	b->last = b->pos + off;
+	left = n - (len - off);
+	for (next = STAILQ_NEXT(b, next); left > 0; next = nnext) {
+		len = MIN(left, mbuf_length(next));
+		mbuf_copy(m, next->pos, len);
+		next->pos += len;
+		left -= len;
+		nnext = STAILQ_NEXT(next, next);
+		if (mbuf_empty(next)) {
+			mbuf_remove(q, next);
+			mbuf_put(next);
+		}
+	}
+	STAILQ_INSERT_AFTER(q, b, m, next);
+	if (mbuf_empty(b)) {
+		mbuf_remove(q, b);
+		mbuf_put(b);
+	}
+	return m->pos;
+}
+
+/* a dtc key bound as unquoted NULL, which matches no row */
+static bool stmt_key_null(const uint8_t *sql, int start, int end)
+{
+	return end - start == 4 && strncasecmp((const char *)sql + start,
+					       "NULL", 4) == 0 &&
+	       (start == 0 || (sql[start - 1] != '\'' &&
+			       sql[start - 1] != '"'));
+}
+
+static int stmt_put_str(struct stmt_writer *w, const char *s)
+{
+	return stmt_put(w, s, strlen(s));
+}
+
+static uint64_t stmt_load_int(const uint8_t *p, int n)
+{
+	uint64_t v = 0;
+	int i;
+
+	for (i = n - 1; i >= 0; i--)
+		v = (v << 8) | p[i];
+	return v;
+}
+
+static void stmt_store_int(uint8_t *p, uint64_t v, int n)
+{
+	int i;
+
+	for (i = 0; i < n; i++) {
+		p[i] = (uint8_t)v;
+		v >>= 8;
+	}
+}
+
+/*
+ * length encoded integer, return -1 if out of buffer
+ */
+static int stmt_load_lenenc(const uint8_t **pos, const uint8_t *end,
+			    uint64_t *v)
+{
+	const uint8_t *p = *pos;
+	int n;
+
+	if (p >= end)
+		return -1;
+
+	switch (*p) {
+	case 0xfc:
+		n = 2;
+		break;
+	case 0xfd:
+		n = 3;
+		break;
+	case 0xfe:
+		n = 8;
+		break;
+	case 0xfb:
+	case 0xff:
+		return -1;
+	default:
+		*v = *p;
+		*pos = p + 1;
+		return 0;
+	}
+
+	if (end - p - 1 < n)
+		return -1;
+	*v = stmt_load_int(p + 1, n);
+	*pos = p + 1 + n;
+	return 0;
+}
+
+static int stmt_store_lenenc(uint8_t *p, uint64_t v)
+{
+	if (v < 251) {
+		*p = (uint8_t)v;
+		return 1;
+	}
+	if (v < 65536) {
+		*p = 0xfc;
+		stmt_store_int(p + 1, v, 2);
+		return 3;
+	}
+	if (v < 16777216) {
+		*p = 0xfd;
+		stmt_store_int(p + 1, v, 3);
+		return 4;
+	}
+	*p = 0xfe;
+	stmt_store_int(p + 1, v, 8);
+	return 9;
+}
+
+/*
+ * find '?' placeholders outside of literals and comments
+ */
+static int stmt_scan_params(const uint8_t *sql, int len, uint32_t *pos)
+{
+	int i = 0, n = 0;
+
+	while (i < len) {
+		uint8_t c = sql[i];
+		if (c == '\'' || c == '"' || c == '`') {
+			for (i++; i < len && sql[i] != c; i++) {
+				if (sql[i] == '\\' && c != '`')
+					i++;
+			}
+			i++;
+		} else if (c == '#' ||
+			   (c == '-' && i + 2 < len && sql[i + 1] == '-' &&
+			    sql[i + 2] == ' ')) {
+			while (i < len && sql[i] != '\n')
+				i++;
+		} else if (c == '/' && i + 1 < len && sql[i + 1] == '*') {
+			for (i += 2; i + 1 < len; i++) {
+				if (sql[i] == '*' && sql[i + 1] == '/')
+					break;
+			}
+			i += 2;
+		} else {
+			if (c == '?') {
+				if (n == MY_STMT_PARAM_MAX)
+					return -1;
+				pos[n++] = i;
+			}
+			i++;
+		}
+	}
+
+	return n;
+}
+
+/*
+ * route plan of the statement template, see rule_stmt_plan()
+ */
+static void stmt_plan(struct my_stmt *stmt, const char *dbname)
+{
+	struct string str;
+	struct sql_tokens t;
+	char strkey[1024] = { 0 };
+	int keytype = 0;
+	int layer, i, k;
+	size_t keylen;
+
+	stmt->layer = 0;
+	stmt->key_param = -1;
+	stmt->read = 0;
+	strncpy(stmt->dbname, dbname, sizeof(stmt->dbname) - 1);
+
+	string_init(&str);
+	sql_tokens_init(&t);
+	if (string_copy(&str, stmt->sql.data, stmt->sql.len) != 0)
+		return;
+	if (!string_upper(&str))
+		goto done;
+
+	layer = rule_stmt_plan((char *)str.data, (char *)stmt->sql.data,
+			       dbname, strkey, &keytype);
+	log_debug("stmt %u plan layer: %d", stmt->id, layer);
+	if (layer == 2 || layer == 3) {
+		stmt->layer = layer;
+		goto done;
+	}
+	if (layer != 1 || check_cmd_operation(&str) || check_cmd_insert(&str))
+		goto done;
+
+	/* same lookup as my_get_route_key(), key has to be a parameter */
+	keylen = strlen(strkey);
+	if (keylen == 0 || sql_tokenize((uint8_t *)str.data, str.len, &t) < 0)
+		goto done;
+	i = sql_token_find((uint8_t *)str.data, &t, 0, "WHERE", 5);
+	if (i < 0)
+		goto done;
+	for (; i + 2 < t.n; i++) {
+		if (!sql_token_is((uint8_t *)str.data, &t.tk[i], strkey, keylen))
+			continue;
+		if (!sql_token_is_char((uint8_t *)str.data, &t.tk[i + 1], '='))
+			break;
+		for (k = 0; k < stmt->nparam; k++) {
+			if (stmt->param_pos[k] == (uint32_t)t.tk[i + 2].start) {
+				stmt->layer = 1;
+				stmt->keytype = keytype;
+				stmt->key_param = k;
+				stmt->read = check_cmd_select(&str);
+				break;
+			}
+		}
+		break;
+	}
+
+done:
+	sql_tokens_deinit(&t);
+	string_deinit(&str);
+}
+
+/*
+ * resultset columns of a SELECT, left unknown if the rule can't tell
+ */
+static void stmt_columns(struct my_stmt *stmt, const char *dbname)
+{
+	rule_column *cols;
+	int n;
+
+	cols = malloc(MY_STMT_COLUMN_MAX * sizeof(*cols));
+	if (cols == NULL)
+		return;
+	n = rule_stmt_columns((char *)stmt->sql.data, dbname, cols,
+			      MY_STMT_COLUMN_MAX);
+	if (n <= 0) {
+		free(cols);
+		return;
+	}
+	stmt->cols = realloc(cols, n * sizeof(*cols));
+	if (stmt->cols == NULL)
+		stmt->cols = cols;
+	stmt->ncol = n;
+	log_debug("stmt %u: %d columns", stmt->id, n);
+}
+
+int my_stmt_prepare(struct msg *r, uint8_t *sql, int len)
+{
+	struct conn *c = r->owner;
+	struct my_stmt *stmt, **slot = NULL;
+	uint32_t pos[MY_STMT_PARAM_MAX];
+	uint32_t i;
+	int n;
+
+	if (len <= 0)
+		return -1;
+
+	n = stmt_scan_params(sql, len, pos);
+	if (n < 0) {
+		log_error("too many parameters in prepared statement");
+		return -1;
+	}
+
+	if (c->stmts == NULL) {
+		c->stmts = array_create(8, sizeof(struct my_stmt *));
+		if (c->stmts == NULL)
+			return -1;
+	}
+	for (i = 0; i < array_n(c->stmts); i++) {
+		struct my_stmt **s = array_get(c->stmts, i);
+		if (*s == NULL) {
+			slot = s;
+			break;
+		}
+	}
+	if (slot == NULL) {
+		if (array_n(c->stmts) >= MY_STMT_MAX) {
+			log_error("too many prepared statements on c %d", c->fd);
+			return -1;
+		}
+		slot = array_push(c->stmts);
+		if (slot == NULL)
+			return -1;
+		*slot = NULL;
+	}
+
+	stmt = calloc(1, sizeof(*stmt));
+	if (stmt == NULL)
+		return -1;
+	string_init(&stmt->sql);
+	if (string_copy(&stmt->sql, sql, len) != 0)
+		goto error;
+	if (n > 0) {
+		stmt->param_pos = malloc(n * sizeof(uint32_t));
+		if (stmt->param_pos == NULL)
+			goto error;
+		memcpy(stmt->param_pos, pos, n * sizeof(uint32_t));
+	}
+	stmt->id = i + 1;
+	stmt->nparam = n;
+	stmt_plan(stmt, c->dbname);
+	stmt_columns(stmt, c->dbname);
+	*slot = stmt;
+
+	r->data.com_stmt_execute.stmt_id = stmt->id;
+	r->data.com_stmt_execute.parameter_count = stmt->nparam;
+	log_debug("prepare stmt %u, %d params, layer %d", stmt->id, n,
+		  stmt->layer);
+	return 0;
+
+error:
+	string_deinit(&stmt->sql);
+	free(stmt);
+	return -1;
+}
+
+struct my_stmt *my_stmt_get(struct conn *c, uint32_t id)
+{
+	if (c->stmts == NULL || id == 0 || id > array_n(c->stmts))
+		return NULL;
+	return *(struct my_stmt **)array_get(c->stmts, id - 1);
+}
+
+static void stmt_free(struct my_stmt *stmt)
+{
+	string_deinit(&stmt->sql);
+	free(stmt->param_pos);
+	free(stmt->types);
+	free(stmt->cols);
+	free(stmt);
+}
+
+void my_stmt_close(struct conn *c, uint32_t id)
+{
+	struct my_stmt *stmt = my_stmt_get(c, id);
+
+	if (stmt == NULL)
+		return;
+	*(struct my_stmt **)array_get(c->stmts, id - 1) = NULL;
+	stmt_free(stmt);
+}
+
+void my_stmt_deinit(struct conn *c)
+{
+	uint32_t i;
+
+	if (c->stmts == NULL)
+		return;
+	for (i = 0; i < array_n(c->stmts); i++) {
+		struct my_stmt *stmt = *(struct my_stmt **)array_get(c->stmts, i);
+		if (stmt != NULL)
+			stmt_free(stmt);
+	}
+	array_destroy(c->stmts);
+	c->stmts = NULL;
+}
+
+static int stmt_put_string(struct stmt_writer *w, const uint8_t *s, size_t len)
+{
+	size_t i;
+
+	if (stmt_put(w, "'", 1) < 0)
+		return -1;
+	for (i = 0; i < len; i++) {
+		const char *esc = NULL;
+		switch (s[i]) {
+		case '\0':
+			esc = "\\0";
+			break;
+		case '\'':
+			esc = "\\'";
+			break;
+		case '"':
+			esc = "\\\"";
+			break;
+		case '\\':
+			esc = "\\\\";
+			break;
+		case '\n':
+			esc = "\\n";
+			break;
+		case '\r':
+			esc = "\\r";
+			break;
+		case 0x1a:
+			esc = "\\Z";
+			break;
+		}
+		if (esc != NULL) {
+			if (stmt_put_str(w, esc) < 0)
+				return -1;
+		} else if (stmt_put(w, s + i, 1) < 0) {
+			return -1;
+		}
+	}
+	return stmt_put(w, "'", 1);
+}
+
+/*
+ * write one bound parameter as sql literal, [*start, *vend) is the value
+ * without quotes, as offsets into the packet
+ */
+static int stmt_put_param(struct stmt_writer *w, const uint8_t *type,
+			  const uint8_t **pos, const uint8_t *end,
+			  uint32_t *start, uint32_t *vend)
+{
+	const uint8_t *p = *pos;
+	char buf[64];
+	int is_unsigned = type[1] & 0x80;
+	uint64_t v, len;
+	int n = 0;
+
+	switch (type[0]) {
+	case MYSQL_TYPE_NULL:
+		*start = w->len;
+		if (stmt_put_str(w, "NULL") < 0)
+			return -1;
+		*vend = w->len;
+		return 0;
+	case MYSQL_TYPE_TINY:
+		n = 1;
+		break;
+	case MYSQL_TYPE_SHORT:
+	case MYSQL_TYPE_YEAR:
+		n = 2;
+		break;
+	case MYSQL_TYPE_LONG:
+	case MYSQL_TYPE_INT24:
+		n = 4;
+		break;
+	case MYSQL_TYPE_LONGLONG:
+		n = 8;
+		break;
+	case MYSQL_TYPE_FLOAT: {
+		float f;
+		if (end - p < 4)
+			return -1;
+		memcpy(&f, p, 4);
+		snprintf(buf, sizeof(buf), "%.9g", f);
+		p += 4;
+		goto number;
+	}
+	case MYSQL_TYPE_DOUBLE: {
+		double d;
+		if (end - p < 8)
+			return -1;
+		memcpy(&d, p, 8);
+		snprintf(buf, sizeof(buf), "%.17g", d);
+		p += 8;
+		goto number;
+	}
+	case MYSQL_TYPE_DATE:
+	case MYSQL_TYPE_DATETIME:
+	case MYSQL_TYPE_TIMESTAMP: {
+		uint32_t y = 0, mon = 0, d = 0, h = 0, mi = 0, s = 0, us = 0;
+		if (p >= end || end - p - 1 < *p)
+			return -1;
+		len = *p++;
+		if (len >= 4) {
+			y = stmt_load_int(p, 2);
+			mon = p[2];
+			d = p[3];
+		}
+		if (len >= 7) {
+			h = p[4];
+			mi = p[5];
+			s = p[6];
+		}
+		if (len >= 11)
+			us = stmt_load_int(p + 7, 4);
+		p += len;
+		if (type[0] == MYSQL_TYPE_DATE)
+			snprintf(buf, sizeof(buf), "%04u-%02u-%02u", y, mon, d);
+		else if (us)
+			snprintf(buf, sizeof(buf),
+				 "%04u-%02u-%02u %02u:%02u:%02u.%06u", y, mon,
+				 d, h, mi, s, us);
+		else
+			snprintf(buf, sizeof(buf), "%04u-%02u-%02u %02u:%02u:%02u",
+				 y, mon, d, h, mi, s);
+		goto string;
+	}
+	case MYSQL_TYPE_TIME: {
+		uint32_t neg = 0, days = 0, h = 0, mi = 0, s = 0, us = 0;
+		if (p >= end || end - p - 1 < *p)
+			return -1;
+		len = *p++;
+		if (len >= 8) {
+			neg = p[0];
+			days = stmt_load_int(p + 1, 4);
+			h = p[5];
+			mi = p[6];
+			s = p[7];
+		}
+		if (len >= 12)
+			us = stmt_load_int(p + 8, 4);
+		p += len;
+		if (us)
+			snprintf(buf, sizeof(buf), "%s%02u:%02u:%02u.%06u",
+				 neg ? "-" : "", days * 24 + h, mi, s, us);
+		else
+			snprintf(buf, sizeof(buf), "%s%02u:%02u:%02u",
+				 neg ? "-" : "", days * 24 + h, mi, s);
+		goto string;
+	}
+	default:
+		/* strings, decimals and blobs */
+		if (stmt_load_lenenc(&p, end, &len) < 0 ||
+		    (uint64_t)(end - p) < len)
+			return -1;
+		*start = w->len + 1;
+		if (stmt_put_string(w, p, len) < 0)
+			return -1;
+		*vend = w->len - 1;
+		*pos = p + len;
+		return 0;
+	}
+
+	if (end - p < n)
+		return -1;
+	v = stmt_load_int(p, n);
+	p += n;
+	if (is_unsigned) {
+		snprintf(buf, sizeof(buf), "%" PRIu64, v);
+	} else {
+		/* sign extend */
+		int64_t s = n == 8 ? (int64_t)v :
+				     (int64_t)(v << (64 - n * 8)) >> (64 - n * 8);
+		snprintf(buf, sizeof(buf), "%" PRId64, s);
+	}
+
+number:
+	*start = w->len;
+	if (stmt_put_str(w, buf) < 0)
+		return -1;
+	*vend = w->len;
+	*pos = p;
+	return 0;
+
+string:
+	*start = w->len + 1;
+	if (stmt_put_string(w, (uint8_t *)buf, strlen(buf)) < 0)
+		return -1;
+	*vend = w->len - 1;
+	*pos = p;
+	return 0;
+}
+
+/*
+ * build COM_QUERY packet of the statement with parameters bound,
+ * return length of sql and offsets of the dtc key parameter in it
+ */
+static int stmt_bind(struct my_stmt *stmt, struct msg *r,
+		     struct stmt_writer *w, int *key_start, int *key_end)
+{
+	const uint8_t *p = r->data.com_stmt_execute.params;
+	const uint8_t *end = p + r->data.com_stmt_execute.params_length;
+	const uint8_t *nullmap = NULL;
+	uint8_t header[MYSQL_HEADER_SIZE + 1] = { 0 };
+	struct mbuf *first;
+	uint32_t sql, start, vend, last = 0;
+	int i;
+
+	if (stmt->nparam > 0) {
+		nullmap = p;
+		p += (stmt->nparam + 7) / 8;
+		if (p >= end)
+			return -1;
+		if (*p++) {
+			if (end - p < stmt->nparam * 2)
+				return -1;
+			if (stmt->types == NULL) {
+				stmt->types = malloc(stmt->nparam * 2);
+				if (stmt->types == NULL)
+					return -1;
+			}
+			memcpy(stmt->types, p, stmt->nparam * 2);
+			p += stmt->nparam * 2;
+		} else if (stmt->types == NULL) {
+			log_error("stmt %u executed without parameter types",
+				  stmt->id);
+			return -1;
+		}
+	}
+
+	header[MYSQL_HEADER_SIZE] = COM_QUERY;
+	if (stmt_put(w, header, sizeof(header)) < 0)
+		return -1;
+	sql = w->len;
+
+	for (i = 0; i < stmt->nparam; i++) {
+		if (stmt_put(w, stmt->sql.data + last,
+			     stmt->param_pos[i] - last) < 0)
+			return -1;
+		last = stmt->param_pos[i] + 1;
+
+		if (nullmap[i / 8] & (1 << (i % 8)) ||
+		    stmt->types[i * 2] == MYSQL_TYPE_NULL) {
+			/* key = NULL has no row and no backend to go to */
+			if (i == stmt->key_param) {
+				log_error("stmt %u: NULL bound to the dtc key",
+					  stmt->id);
+				return -1;
+			}
+			start = w->len;
+			if (stmt_put_str(w, "NULL") < 0)
+				return -1;
+			vend = w->len;
+		} else if (stmt_put_param(w, stmt->types + i * 2, &p, end,
+					  &start, &vend) < 0) {
+			log_error("stmt %u bind parameter %d failed", stmt->id,
+				  i);
+			return -1;
+		}
+		if (i == stmt->key_param) {
+			*key_start = start - sql;
+			*key_end = vend - sql;
+		}
+	}
+	if (stmt_put(w, stmt->sql.data + last, stmt->sql.len - last) < 0)
+		return -1;
+
+	/* the header is in the first mbuf, it is never split */
+	first = STAILQ_FIRST(w->q);
+	int_conv_3(first->pos, w->len - MYSQL_HEADER_SIZE);
+	first->pos[3] = r->pkt_nr;
+	return w->len - sql;
+}
+
+/*
+ * rewrite COM_STMT_EXECUTE into COM_QUERY and route it
+ */
+int my_stmt_execute(struct msg *r)
+{
+	struct conn *c = r->owner;
+	struct my_stmt *stmt;
+	struct stmt_writer w;
+	struct buf_stqh q;
+	struct mbuf *b;
+	uint8_t *sql, *flat = NULL, *k;
+	uint32_t head, total;
+	int sql_len, layer, i, nkey = 1;
+	int start_offset[MY_ROUTE_KEY_MAX], end_offset[MY_ROUTE_KEY_MAX];
+
+	stmt = my_stmt_get(c, r->data.com_stmt_execute.stmt_id);
+	if (stmt == NULL) {
+		log_error("unknown stmt %lu on c %d",
+			  r->data.com_stmt_execute.stmt_id, c->fd);
+		return -1;
+	}
+	if (stmt->long_data) {
+		log_error("stmt %u: long data is not supported", stmt->id);
+		return -1;
+	}
+
+	STAILQ_INIT(&q);
+	w.q = &q;
+	w.len = 0;
+
+	start_offset[0] = end_offset[0] = -1;
+	sql_len = stmt_bind(stmt, r, &w, &start_offset[0], &end_offset[0]);
+	if (sql_len < 0)
+		goto error;
+	head = w.len - sql_len;
+
+	if (stmt->layer > 0 && strcmp(stmt->dbname, c->dbname) == 0) {
+		layer = stmt->layer;
+		r->keytype = stmt->keytype;
+		if (layer == 1 && stmt->read)
+			r->cmd = MSG_REQ_GET;
+	} else {
+		/* routed on a copy in one piece if the query spans mbufs */
+		b = STAILQ_FIRST(&q);
+		if (STAILQ_NEXT(b, next) == NULL) {
+			sql = b->pos + head;
+		} else {
+			flat = my_buf_dup(&q, &total);
+			if (flat == NULL)
+				goto error;
+			sql = flat + head;
+		}
+		layer = my_get_route_key(sql, sql_len, start_offset,
+					 end_offset, &nkey, c->dbname, r);
+		for (i = 0; layer == 1 && i < nkey; i++) {
+			if (stmt_key_null(sql, start_offset[i], end_offset[i])) {
+				log_error("stmt %u: NULL bound to the dtc key",
+					  stmt->id);
+				layer = -1;
+			}
+		}
+		free(flat);
+	}
+	log_debug("stmt %u layer: %d", stmt->id, layer);
+	if (layer < 1 || layer > 3)
+		goto error;
+
+	if (layer == 1) {
+		/* keys in ascending order, a split moves only later bytes */
+		for (i = 0; i < nkey; i++) {
+			if (start_offset[i] < 0 || end_offset[i] < start_offset[i])
+				goto error;
+			k = stmt_buf_at(&q, head + start_offset[i],
+					end_offset[i] - start_offset[i]);
+			if (k == NULL) {
+				log_error("stmt %u: key %d out of reach",
+					  stmt->id, i);
+				goto error;
+			}
+			r->keys[i].start = k;
+			r->keys[i].end = k + (end_offset[i] - start_offset[i]);
+		}
+		r->keyCount = nkey;
+	} else {
+		r->keys[0].start = NULL;
+		r->keys[0].end = NULL;
+	}
+
+	stmt_buf_free(&r->buf_q);
+	while (!STAILQ_EMPTY(&q)) {
+		b = STAILQ_FIRST(&q);
+		mbuf_remove(&q, b);
+		mbuf_insert(&r->buf_q, b);
+	}
+	r->mlen = w.len;
+	r->data.com_stmt_execute.params = NULL;
+	r->data.com_stmt_execute.params_length = 0;
+	r->layer = layer;
+	return 0;
+
+error:
+	stmt_buf_free(&q);
+	return -1;
+}
+
+/*
+ * column type sent to client, dtc puts 64 bit integers into LONG and
+ * doubles into FLOAT columns
+ */
+static uint8_t stmt_rsp_type(uint8_t type, int ismysql)
+{
+	switch (type) {
+	case MYSQL_TYPE_LONG:
+		return ismysql ? type : MYSQL_TYPE_LONGLONG;
+	case MYSQL_TYPE_FLOAT:
+		return ismysql ? type : MYSQL_TYPE_DOUBLE;
+	case MYSQL_TYPE_DATE:
+	case MYSQL_TYPE_TIME:
+	case MYSQL_TYPE_DATETIME:
+	case MYSQL_TYPE_TIMESTAMP:
+	case MYSQL_TYPE_NEWDATE:
+		/* keep the text form */
+		return MYSQL_TYPE_VAR_STRING;
+	default:
+		return type;
+	}
+}
+
+/*
+ * text row to binary row, out has room for the worst case
+ */
+static int stmt_rsp_row(const uint8_t *p, const uint8_t *end,
+			const uint8_t *types, const uint16_t *flags,
+			uint32_t ncol, uint8_t *out)
+{
+	uint32_t nb = (ncol + 9) / 8;
+	uint8_t *q = out + 1 + nb;
+	uint32_t i;
+
+	out[0] = 0x00;
+	memset(out + 1, 0, nb);
+
+	for (i = 0; i < ncol; i++) {
+		char buf[64];
+		uint64_t len;
+		int n = 0;
+
+		if (p >= end)
+			return -1;
+		if (*p == NULL_COLUMN) {
+			out[1 + (i + 2) / 8] |= 1 << ((i + 2) % 8);
+			p++;
+			continue;
+		}
+		if (stmt_load_lenenc(&p, end, &len) < 0 ||
+		    (uint64_t)(end - p) < len)
+			return -1;
+
+		switch (types[i]) {
+		case MYSQL_TYPE_TINY:
+			n = 1;
+			break;
+		case MYSQL_TYPE_SHORT:
+		case MYSQL_TYPE_YEAR:
+			n = 2;
+			break;
+		case MYSQL_TYPE_LONG:
+		case MYSQL_TYPE_INT24:
+			n = 4;
+			break;
+		case MYSQL_TYPE_LONGLONG:
+			n = 8;
+			break;
+		case MYSQL_TYPE_FLOAT:
+		case MYSQL_TYPE_DOUBLE:
+			break;
+		default:
+			q += stmt_store_lenenc(q, len);
+			memcpy(q, p, len);
+			q += len;
+			p += len;
+			continue;
+		}
+
+		if (len >= sizeof(buf))
+			return -1;
+		memcpy(buf, p, len);
+		buf[len] = '\0';
+		p += len;
+
+		if (types[i] == MYSQL_TYPE_FLOAT) {
+			float f = strtof(buf, NULL);
+			memcpy(q, &f, 4);
+			q += 4;
+		} else if (types[i] == MYSQL_TYPE_DOUBLE) {
+			double d = strtod(buf, NULL);
+			memcpy(q, &d, 8);
+			q += 8;
+		} else {
+			uint64_t v = flags[i] & UNSIGNED_FLAG ?
+					     strtoull(buf, NULL, 10) :
+					     (uint64_t)strtoll(buf, NULL, 10);
+			stmt_store_int(q, v, n);
+			q += n;
+		}
+	}
+
+	return q - out;
+}
+
+/*
+ * convert text resultset to binary resultset for COM_STMT_EXECUTE,
+ * other responses are left untouched
+ */
+int my_stmt_rsp_binary(struct msg *rsp)
+{
+	struct buf_stqh out;
+	struct mbuf *b;
+	uint8_t *raw, *row = NULL, *types = NULL;
+	uint16_t *flags = NULL;
+	uint32_t total = 0, off = 0, ncol = 0, icol = 0, nrow = 0;
+	uint64_t row_size = 0;
+	int state = 0, ret = -1;
+
+	raw = my_buf_dup(&rsp->buf_q, &total);
+	if (raw == NULL)
+		return -1;
+	if (total < MYSQL_HEADER_SIZE + 1) {
+		free(raw);
+		return 0;
+	}
+
+	STAILQ_INIT(&out);
+	for (off = 0; off + MYSQL_HEADER_SIZE <= total;) {
+		uint32_t len = uint_trans_3(raw + off);
+		uint8_t seq = raw[off + 3];
+		uint8_t *p = raw + off + MYSQL_HEADER_SIZE;
+		uint8_t *end = p + len;
+		bool eof;
+
+		if (len == 0 || len > total - off - MYSQL_HEADER_SIZE)
+			break;
+		off += MYSQL_HEADER_SIZE + len;
+		eof = (*p == 0xfe && len < 9) || *p == 0xff;
+
+		switch (state) {
+		case 0: {
+			uint64_t n;
+			const uint8_t *q = p;
+			if (*p == 0x00 || *p == 0xfb || eof) {
+				/* ok, error, local infile: nothing to convert */
+				ret = 0;
+				goto done;
+			}
+			if (stmt_load_lenenc(&q, end, &n) < 0 || n == 0 ||
+			    n > 4096)
+				goto done;
+			ncol = n;
+			types = malloc(ncol);
+			flags = malloc(ncol * sizeof(uint16_t));
+			if (types == NULL || flags == NULL)
+				goto done;
+			state = 1;
+			break;
+		}
+		case 1: {
+			/* catalog, schema, table, org_table, name, org_name */
+			const uint8_t *q = p;
+			uint64_t n;
+			int i;
+			for (i = 0; i < 6; i++) {
+				if (stmt_load_lenenc(&q, end, &n) < 0 ||
+				    (uint64_t)(end - q) < n)
+					goto done;
+				q += n;
+			}
+			/* fixed length fields, charset, length, type, flags */
+			if (end - q < 10)
+				goto done;
+			uint8_t *t = (uint8_t *)q + 7;
+			*t = stmt_rsp_type(*t, rsp->ismysql);
+			types[icol] = *t;
+			flags[icol] = stmt_load_int(t + 1, 2);
+			if (++icol == ncol)
+				state = 2;
+			break;
+		}
+		case 2:
+			state = 3;
+			if (eof)
+				break;
+			/* fall through, no eof after column definitions */
+		case 3: {
+			uint64_t size;
+			int n;
+			if (eof) {
+				state = 4;
+				break;
+			}
+			/* integers grow to 8 bytes at most */
+			size = len + 1 + (ncol + 9) / 8 + 8 * ncol;
+			if (size >= MAX_PACKET_LENGTH)
+				goto done;
+			if (size > row_size) {
+				uint8_t *nrow = realloc(row, size);
+				if (nrow == NULL)
+					goto done;
+				row = nrow;
+				row_size = size;
+			}
+			n = stmt_rsp_row(p, end, types, flags, ncol, row);
+			if (n < 0) {
+				log_error("convert row %u of rsp %" PRIu64
+					  " failed",
+					  nrow, rsp->id);
+				goto done;
+			}
+			if (my_packet_put(&out, row, n, seq) < 0)
+				goto done;
+			nrow++;
+			continue;
+		}
+		default:
+			break;
+		}
+
+		if (my_packet_put(&out, p, len, seq) < 0)
+			goto done;
+	}
+
+	if (off < total && my_buf_put(&out, raw + off, total - off) < 0)
+		goto done;
+
+	while (!STAILQ_EMPTY(&rsp->buf_q)) {
+		b = STAILQ_FIRST(&rsp->buf_q);
+		mbuf_remove(&rsp->buf_q, b);
+		mbuf_put(b);
+	}
+	rsp->mlen = 0;
+	while (!STAILQ_EMPTY(&out)) {
+		b = STAILQ_FIRST(&out);
+		mbuf_remove(&out, b);
+		mbuf_insert(&rsp->buf_q, b);
+		rsp->mlen += mbuf_length(b);
+	}
+	log_debug("rsp %" PRIu64 " to binary resultset, %u columns %u rows",
+		  rsp->id, ncol, nrow);
+	ret = 0;
+
+done:
+	while (!STAILQ_EMPTY(&out)) {
+		b = STAILQ_FIRST(&out);
+		mbuf_remove(&out, b);
+		mbuf_put(b);
+	}
+	free(row);
+	free(types);
+	free(flags);
+	free(raw);
+	return ret;
+}
+
+/*
+ * column definition of a prepared SELECT, typed as the dtc field it reads,
+ * see stmt_rsp_type()
+ */
+static int stmt_column_def(struct msg *dmsg, const rule_column *col,
+			   uint8_t *pkt_nr)
+{
+	uint8_t def[24 + 2 * sizeof(col->name)];
+	uint8_t *p = def;
+	size_t len = strnlen(col->name, sizeof(col->name));
+	uint16_t flags = 0;
+	uint8_t type;
+
+	switch (col->type) {
+	case 1:
+		type = MYSQL_TYPE_LONGLONG;
+		break;
+	case 2:
+		type = MYSQL_TYPE_LONGLONG;
+		flags = UNSIGNED_FLAG;
+		break;
+	case 3:
+		type = MYSQL_TYPE_DOUBLE;
+		break;
+	case 5:
+		type = MYSQL_TYPE_BLOB;
+		break;
+	default:
+		type = MYSQL_TYPE_VAR_STRING;
+		break;
+	}
+
+	/* catalog, schema, table, org_table, name, org_name */
+	memcpy(p, "\x03" "def\x00\x00\x00", 7);
+	p += 7;
+	*p++ = len;
+	memcpy(p, col->name, len);
+	p += len;
+	*p++ = len;
+	memcpy(p, col->name, len);
+	p += len;
+	/* charset, length, type, flags, decimals, filler */
+	*p++ = 0x0c;
+	stmt_store_int(p, type == MYSQL_TYPE_VAR_STRING ? 0x21 : 0x3f, 2);
+	p += 2;
+	stmt_store_int(p, type == MYSQL_TYPE_DOUBLE ? 22 : 0xffff, 4);
+	p += 4;
+	*p++ = type;
+	stmt_store_int(p, flags, 2);
+	p += 2;
+	*p++ = type == MYSQL_TYPE_DOUBLE ? 31 : 0;
+	*p++ = 0x00;
+	*p++ = 0x00;
+
+	if (my_packet_put(&dmsg->buf_q, def, p - def, ++*pkt_nr) < 0)
+		return -1;
+	dmsg->mlen += p - def + MYSQL_HEADER_SIZE;
+	return 0;
+}
+
+/*
+ * COM_STMT_PREPARE_OK, parameters are described as VAR_STRING, columns
+ * as the dtc fields they read if the rule knows them
+ */
+int my_stmt_rsp_prepare(struct msg *dmsg, const struct my_stmt *stmt,
+			uint8_t *pkt_nr)
+{
+	uint8_t ok[12] = { 0x00 };
+	uint8_t def[] = { 0x03, 'd', 'e', 'f', 0x00, 0x00, 0x00,
+			  0x01, '?', 0x00, 0x0c, 0x3f, 0x00,
+			  0x00, 0x00, 0x00, 0x00, MYSQL_TYPE_VAR_STRING,
+			  0x00, 0x00, 0x00, 0x00, 0x00 };
+	uint8_t eof[5] = { 0xfe, 0x00, 0x00, 0x02, 0x00 };
+	uint16_t i;
+
+	stmt_store_int(ok + 1, stmt->id, 4);
+	stmt_store_int(ok + 5, stmt->ncol, 2);
+	stmt_store_int(ok + 7, stmt->nparam, 2);
+	if (my_packet_put(&dmsg->buf_q, ok, sizeof(ok), ++*pkt_nr) < 0)
+		return -1;
+	dmsg->mlen = sizeof(ok) + MYSQL_HEADER_SIZE;
+
+	if (stmt->nparam > 0) {
+		for (i = 0; i < stmt->nparam; i++) {
+			if (my_packet_put(&dmsg->buf_q, def, sizeof(def),
+					  ++*pkt_nr) < 0)
+				return -1;
+			dmsg->mlen += sizeof(def) + MYSQL_HEADER_SIZE;
+		}
+		if (my_packet_put(&dmsg->buf_q, eof, sizeof(eof),
+				  ++*pkt_nr) < 0)
+			return -1;
+		dmsg->mlen += sizeof(eof) + MYSQL_HEADER_SIZE;
+	}
+
+	if (stmt->ncol > 0) {
+		for (i = 0; i < stmt->ncol; i++) {
+			if (stmt_column_def(dmsg, &stmt->cols[i], pkt_nr) < 0)
+				return -1;
+		}
+		if (my_packet_put(&dmsg->buf_q, eof, sizeof(eof),
+				  ++*pkt_nr) < 0)
+			return -1;
+		dmsg->mlen += sizeof(eof) + MYSQL_HEADER_SIZE;
+	}
+	return 0;
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright [2021] JD.com, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _MY_STMT_H_
+#define _MY_STMT_H_
+#include <stdint.h>
+#include "da_string.h"
+
+struct msg;
+struct conn;
+struct _rule_column;
+
+/*
+MYSQL Prepared Statements, See more detail:
+  https://dev.mysql.com/doc/dev/mysql-server/latest/page_protocol_command_phase_ps.html
+*/
+
+#define MY_STMT_MAX 1024 /* prepared statements per client connection */
+#define MY_STMT_PARAM_MAX 1024
+#define MY_STMT_COLUMN_MAX 4096
+
+enum enum_field_types {
+	MYSQL_TYPE_DECIMAL,
+	MYSQL_TYPE_TINY,
+	MYSQL_TYPE_SHORT,
+	MYSQL_TYPE_LONG,
+	MYSQL_TYPE_FLOAT,
+	MYSQL_TYPE_DOUBLE,
+	MYSQL_TYPE_NULL,
+	MYSQL_TYPE_TIMESTAMP,
+	MYSQL_TYPE_LONGLONG,
+	MYSQL_TYPE_INT24,
+	MYSQL_TYPE_DATE,
+	MYSQL_TYPE_TIME,
+	MYSQL_TYPE_DATETIME,
+	MYSQL_TYPE_YEAR,
+	MYSQL_TYPE_NEWDATE,
+	MYSQL_TYPE_VARCHAR,
+	MYSQL_TYPE_BIT,
+	MYSQL_TYPE_NEWDECIMAL = 246,
+	MYSQL_TYPE_ENUM = 247,
+	MYSQL_TYPE_SET = 248,
+	MYSQL_TYPE_TINY_BLOB = 249,
+	MYSQL_TYPE_MEDIUM_BLOB = 250,
+	MYSQL_TYPE_LONG_BLOB = 251,
+	MYSQL_TYPE_BLOB = 252,
+	MYSQL_TYPE_VAR_STRING = 253,
+	MYSQL_TYPE_STRING = 254,
+	MYSQL_TYPE_GEOMETRY = 255
+};
+
+/*
+ * 客户端连接上的一条prepared statement。
+ * 路由在prepare时按模板决定一次，与参数值无关时execute直接使用，
+ * 参数值绑定成文本COM_QUERY转发，dtc key取自绑定的参数。
+ */
+struct my_stmt {
+	uint32_t id;            /* statement id, index in conn stmts + 1 */
+	uint16_t nparam;        /* # parameters */
+	struct string sql;      /* statement text */
+	uint32_t *param_pos;    /* offset of each '?' in sql */
+	uint16_t ncol;          /* # columns of the resultset, 0 if none or unknown */
+	struct _rule_column *cols; /* name and dtc type of each column */
+	uint8_t *types;         /* parameter types bound by last execute */
+	char dbname[250];       /* session db the plan was made under */
+	int layer;              /* route plan, 0 if decided on each execute */
+	int keytype;            /* dtc key type */
+	int key_param;          /* parameter bound to dtc key, layer 1 only */
+	unsigned read : 1;      /* SELECT, may go to a replica */
+	unsigned long_data : 1; /* got COM_STMT_SEND_LONG_DATA */
+};
+
+int my_stmt_prepare(struct msg *r, uint8_t *sql, int len);
+int my_stmt_execute(struct msg *r);
+struct my_stmt *my_stmt_get(struct conn *c, uint32_t id);
+void my_stmt_close(struct conn *c, uint32_t id);
+void my_stmt_deinit(struct conn *c);
+
+int my_stmt_rsp_prepare(struct msg *dmsg, const struct my_stmt *stmt,
+			uint8_t *pkt_nr);
+int my_stmt_rsp_binary(struct msg *rsp);
+
+#endif /* _MY_STMT_H_ */
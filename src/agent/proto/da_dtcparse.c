@@ -1903,7 +1903,7 @@ static int dtc_fragment_get(struct msg *r, uint32_t ncontinuum,
 	return -1;
 }
 
-static uint64_t randomHashSeed = 1;
+static __thread uint64_t randomHashSeed = 1;
 
 #if defined DA_COMPATIBLE_MODE && DA_COMPATIBLE_MODE == 1
 int dtc_fragment(struct msg *r, uint32_t ncontinuum, struct msg_tqh *frag_msgq) {
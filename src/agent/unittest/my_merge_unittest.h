@@ -0,0 +1,267 @@
+#ifndef MY_MERGE_UNITTEST_H_
+#define MY_MERGE_UNITTEST_H_
+
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "gtest/gtest.h"
+
+extern "C" {
+#include "da_core.h"
+#include "da_buf.h"
+#include "my/my_comm.h"
+#include "my/my_merge.h"
+}
+
+static std::string my_packet(uint8_t seq, const std::string &payload)
+{
+	std::string p(MYSQL_HEADER_SIZE, '\0');
+	int_conv_3((uint8_t *)&p[0], payload.size());
+	p[3] = seq;
+	return p + payload;
+}
+
+/* one column resultset with the given rows, sequence ids from 1 */
+static std::string my_resultset(const std::vector<std::string> &rows)
+{
+	static const std::string eof("\xfe\0\0\x02\0", 5);
+	uint8_t seq = 1;
+	std::string rs = my_packet(seq++, "\x01");
+	rs += my_packet(seq++, std::string("\x03" "def\0\0\0\x01v", 10));
+	rs += my_packet(seq++, eof);
+	for (size_t i = 0; i < rows.size(); i++)
+		rs += my_packet(seq++, (char)rows[i].size() + rows[i]);
+	return rs + my_packet(seq, eof);
+}
+
+class MyMergeTest : public testing::Test {
+    protected:
+	static void SetUpTestCase()
+	{
+		struct instance ins;
+		memset(&ins, 0, sizeof(ins));
+		// small chunks, the merged resultset spans several mbufs
+		ins.mbuf_chunk_size = MBUF_MIN_SIZE;
+		ASSERT_EQ(0, mbuf_init(&ins));
+	}
+
+	virtual void SetUp()
+	{
+		STAILQ_INIT(&q_);
+	}
+	virtual void TearDown()
+	{
+		struct mbuf *b;
+		while (!STAILQ_EMPTY(&q_)) {
+			b = STAILQ_FIRST(&q_);
+			mbuf_remove(&q_, b);
+			mbuf_put(b);
+		}
+	}
+
+	/* the query packet of each listed key */
+	std::vector<std::string> rewrite(const std::string &sql, int nkey,
+					 std::vector<std::string> *keys = NULL)
+	{
+		std::vector<std::string> out;
+		std::string pkt = my_packet(0, "\x03" + sql);
+		const uint8_t *p = (const uint8_t *)pkt.data();
+		std::vector<const uint8_t *> start, end;
+		size_t off = pkt.find("(");
+		for (int i = 0; i < nkey; i++) {
+			off = pkt.find_first_not_of(" (,'\"", off);
+			size_t e = pkt.find_first_of(" ,)'\"", off);
+			start.push_back(p + off);
+			end.push_back(p + e);
+			off = e + 1;
+		}
+		struct my_key_list kl;
+		if (my_key_list_init(&kl, p, pkt.size(), start[0],
+				     end[nkey - 1]) < 0)
+			return out;
+		for (int i = 0; i < nkey; i++) {
+			std::string q(pkt.size(), '\0');
+			uint32_t koff;
+			uint32_t n = my_key_list_query(&kl, start[i], end[i],
+						       (uint8_t *)&q[0], &koff);
+			EXPECT_LE(n, pkt.size());
+			EXPECT_EQ(n - MYSQL_HEADER_SIZE,
+				  uint_trans_3((uint8_t *)q.data()));
+			q.resize(n);
+			if (keys != NULL)
+				keys->push_back(q.substr(koff, end[i] - start[i]));
+			out.push_back(q.substr(MYSQL_HEADER_SIZE + 1));
+		}
+		return out;
+	}
+
+	int merge(const std::vector<std::string> &rs, uint32_t *pick)
+	{
+		std::vector<uint8_t *> raw;
+		std::vector<uint32_t> len;
+		for (size_t i = 0; i < rs.size(); i++) {
+			raw.push_back((uint8_t *)rs[i].data());
+			len.push_back(rs[i].size());
+		}
+		return my_rs_merge(&raw[0], &len[0], rs.size(), &q_, pick);
+	}
+
+	std::string bytes()
+	{
+		uint32_t len;
+		uint8_t *p = my_buf_dup(&q_, &len);
+		std::string s((const char *)p, len);
+		free(p);
+		return s;
+	}
+
+	struct buf_stqh q_;
+};
+
+TEST_F(MyMergeTest, RewriteListToEquality)
+{
+	std::vector<std::string> keys;
+	std::vector<std::string> q =
+		rewrite("select v from t where uid IN (1, 22,333) and v > 2", 3,
+			&keys);
+	ASSERT_EQ(3U, q.size());
+	EXPECT_EQ("select v from t where uid = 1 and v > 2", q[0]);
+	EXPECT_EQ("select v from t where uid = 22 and v > 2", q[1]);
+	EXPECT_EQ("select v from t where uid = 333 and v > 2", q[2]);
+	EXPECT_EQ("22", keys[1]);
+
+	keys.clear();
+	q = rewrite("SELECT * FROM t WHERE `uid` in('ab',\"c\")", 2, &keys);
+	ASSERT_EQ(2U, q.size());
+	EXPECT_EQ("SELECT * FROM t WHERE `uid` = 'ab'", q[0]);
+	EXPECT_EQ("SELECT * FROM t WHERE `uid` = \"c\"", q[1]);
+	EXPECT_EQ("c", keys[1]);
+}
+
+TEST_F(MyMergeTest, RewriteSingleKeyList)
+{
+	// a list of one is still sent as key = literal
+	std::vector<std::string> keys;
+	std::vector<std::string> q =
+		rewrite("delete from t where uid IN ( 7 ) limit 1", 1, &keys);
+	ASSERT_EQ(1U, q.size());
+	EXPECT_EQ("delete from t where uid = 7 limit 1", q[0]);
+	EXPECT_EQ("7", keys[0]);
+
+	keys.clear();
+	q = rewrite("SELECT * FROM t WHERE uid in('x')", 1, &keys);
+	ASSERT_EQ(1U, q.size());
+	EXPECT_EQ("SELECT * FROM t WHERE uid = 'x'", q[0]);
+	EXPECT_EQ("x", keys[0]);
+}
+
+TEST_F(MyMergeTest, RewriteNeedsList)
+{
+	// IN part of a longer word, or no closing parenthesis
+	std::string pkt = my_packet(0, "\x03select 1 from t where x JOIN (1, 2)");
+	const uint8_t *p = (const uint8_t *)pkt.data();
+	size_t k = pkt.find("(1");
+	struct my_key_list kl;
+	EXPECT_EQ(-1, my_key_list_init(&kl, p, pkt.size(), p + k + 1,
+				       p + k + 5));
+	pkt = my_packet(0, "\x03select 1 from t where uid IN (1, 2");
+	p = (const uint8_t *)pkt.data();
+	k = pkt.find("(1");
+	EXPECT_EQ(-1, my_key_list_init(&kl, p, pkt.size(), p + k + 1,
+				       p + k + 5));
+}
+
+TEST_F(MyMergeTest, ConcatenatesRows)
+{
+	std::vector<std::string> a, b, c, all;
+	a.push_back("x");
+	c.push_back("y");
+	c.push_back("z");
+	all.push_back("x");
+	all.push_back("y");
+	all.push_back("z");
+	std::vector<std::string> rs;
+	rs.push_back(my_resultset(a));
+	rs.push_back(my_resultset(b));
+	rs.push_back(my_resultset(c));
+	uint32_t pick = 9;
+	ASSERT_EQ(0, merge(rs, &pick));
+	EXPECT_EQ(my_resultset(all), bytes());
+	EXPECT_EQ(9U, pick);
+}
+
+TEST_F(MyMergeTest, ManyRowsSpanMbufs)
+{
+	std::vector<std::string> part, all;
+	std::vector<std::string> rs;
+	for (int i = 0; i < 8; i++) {
+		part.clear();
+		for (int j = 0; j < 20; j++) {
+			std::string v(10 + j, 'a' + i);
+			part.push_back(v);
+			all.push_back(v);
+		}
+		rs.push_back(my_resultset(part));
+	}
+	uint32_t pick;
+	ASSERT_EQ(0, merge(rs, &pick));
+	EXPECT_NE(STAILQ_FIRST(&q_), STAILQ_LAST(&q_, mbuf, next));
+	EXPECT_EQ(my_resultset(all), bytes());
+}
+
+TEST_F(MyMergeTest, ErrorIsSentAsIs)
+{
+	std::vector<std::string> rows(1, "x");
+	std::vector<std::string> rs;
+	rs.push_back(my_resultset(rows));
+	rs.push_back(my_packet(1, "\xff\x15\x04#28000denied"));
+	rs.push_back(my_resultset(rows));
+	uint32_t pick = 0;
+	EXPECT_EQ(1, merge(rs, &pick));
+	EXPECT_EQ(1U, pick);
+	EXPECT_TRUE(STAILQ_EMPTY(&q_));
+}
+
+TEST_F(MyMergeTest, MalformedOrMismatched)
+{
+	std::vector<std::string> rows(1, "x");
+	std::vector<std::string> rs;
+	rs.push_back(my_resultset(rows));
+	rs.push_back(my_resultset(rows).substr(0, 20));
+	uint32_t pick;
+	EXPECT_EQ(-1, merge(rs, &pick));
+	EXPECT_TRUE(STAILQ_EMPTY(&q_));
+
+	// two columns against one
+	std::string two = my_resultset(rows);
+	two[MYSQL_HEADER_SIZE] = 2;
+	rs[1] = two;
+	EXPECT_EQ(-1, merge(rs, &pick));
+	EXPECT_TRUE(STAILQ_EMPTY(&q_));
+}
+
+/* the error packet replaces a partial response in its first mbuf */
+TEST_F(MyMergeTest, ErrorReplacesResponse)
+{
+	std::vector<std::string> rows;
+	for (int i = 0; i < 40; i++)
+		rows.push_back(std::string(30, 'r'));
+	std::string rs = my_resultset(rows);
+	ASSERT_EQ(0, my_buf_put(&q_, (const uint8_t *)rs.data(), rs.size()));
+	struct mbuf *first = STAILQ_FIRST(&q_);
+	ASSERT_NE(first, STAILQ_LAST(&q_, mbuf, next));
+
+	ASSERT_EQ(0, my_rs_error(&q_, 1));
+	EXPECT_EQ(first, STAILQ_FIRST(&q_));
+	EXPECT_EQ(first, STAILQ_LAST(&q_, mbuf, next));
+	std::string err = bytes();
+	ASSERT_GT(err.size(), (size_t)MYSQL_HEADER_SIZE + 9);
+	EXPECT_EQ(err.size() - MYSQL_HEADER_SIZE,
+		  uint_trans_3((const uint8_t *)err.data()));
+	EXPECT_EQ(1, err[3]);
+	EXPECT_EQ('\xff', err[MYSQL_HEADER_SIZE]);
+	EXPECT_EQ("#HY000", err.substr(MYSQL_HEADER_SIZE + 3, 6));
+}
+
+#endif
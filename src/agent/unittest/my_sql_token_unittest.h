@@ -0,0 +1,177 @@
+#ifndef MY_SQL_TOKEN_UNITTEST_H_
+#define MY_SQL_TOKEN_UNITTEST_H_
+
+#include <string.h>
+#include <string>
+#include <vector>
+#include "gtest/gtest.h"
+
+extern "C" {
+#include "my/my_sql_token.h"
+}
+
+/* tokens of a statement as (type, text) pairs */
+class SqlTokenTest : public testing::Test {
+    protected:
+	virtual void SetUp()
+	{
+		sql_tokens_init(&t_);
+	}
+	virtual void TearDown()
+	{
+		sql_tokens_deinit(&t_);
+	}
+
+	int tokenize(const std::string &sql)
+	{
+		sql_ = sql;
+		return sql_tokenize((const uint8_t *)sql_.data(), sql_.size(),
+				    &t_);
+	}
+	const uint8_t *s() const
+	{
+		return (const uint8_t *)sql_.data();
+	}
+	int type(int i) const
+	{
+		return t_.tk[i].type;
+	}
+	std::string text(int i) const
+	{
+		return sql_.substr(t_.tk[i].start,
+				   t_.tk[i].end - t_.tk[i].start);
+	}
+
+	std::string sql_;
+	struct sql_tokens t_;
+};
+
+TEST_F(SqlTokenTest, SplitsStatement)
+{
+	ASSERT_EQ(0, tokenize("SELECT a, `b c` FROM t\n\tWHERE uid='x' AND v>=1.5"));
+	const char *texts[] = { "SELECT", "a",	 ",",	"b c", "FROM", "t",
+				"WHERE",  "uid", "=",	"x",   "AND",  "v",
+				">=",	  "1.5" };
+	int types[] = { SQL_TK_WORD,  SQL_TK_WORD,	SQL_TK_PUNCT,
+			SQL_TK_QUOTED_ID, SQL_TK_WORD,	SQL_TK_WORD,
+			SQL_TK_WORD,  SQL_TK_WORD,	SQL_TK_PUNCT,
+			SQL_TK_STRING, SQL_TK_WORD,	SQL_TK_WORD,
+			SQL_TK_PUNCT, SQL_TK_NUMBER };
+	ASSERT_EQ((int)(sizeof(texts) / sizeof(texts[0])), t_.n);
+	for (int i = 0; i < t_.n; i++) {
+		EXPECT_EQ(types[i], type(i)) << i;
+		EXPECT_EQ(texts[i], text(i)) << i;
+	}
+}
+
+TEST_F(SqlTokenTest, OperatorsAndNumbers)
+{
+	ASSERT_EQ(0, tokenize("a<=b>=c!=d<>e<=>f<g>h=1.5E10+2"));
+	const char *texts[] = { "a", "<=", "b", ">=", "c",   "!=",
+				"d", "<>", "e", "<=>", "f",  "<",
+				"g", ">",  "h", "=",  "1.5E10", "+",
+				"2" };
+	ASSERT_EQ((int)(sizeof(texts) / sizeof(texts[0])), t_.n);
+	for (int i = 0; i < t_.n; i++)
+		EXPECT_EQ(texts[i], text(i)) << i;
+	EXPECT_EQ(SQL_TK_NUMBER, type(16));
+}
+
+TEST_F(SqlTokenTest, QuotedLiterals)
+{
+	ASSERT_EQ(0, tokenize("'it''s' \"a\\\"b\" 'x\\\\' ''"));
+	ASSERT_EQ(4, t_.n);
+	EXPECT_EQ("it''s", text(0));
+	EXPECT_EQ("a\\\"b", text(1));
+	EXPECT_EQ("x\\\\", text(2));
+	EXPECT_EQ("", text(3));
+	for (int i = 0; i < t_.n; i++)
+		EXPECT_EQ(SQL_TK_STRING, type(i));
+
+	EXPECT_EQ(-1, tokenize("select 'abc"));
+	EXPECT_EQ(-1, tokenize("select 'abc\\'"));
+	EXPECT_EQ(-1, tokenize("select `abc"));
+}
+
+TEST_F(SqlTokenTest, CommentsAreDropped)
+{
+	ASSERT_EQ(0, tokenize("/* uid = 1 */ select # uid\n a -- uid\n, b/*x*/c"
+			      " /* open"));
+	ASSERT_EQ(5, t_.n);
+	EXPECT_EQ("select", text(0));
+	EXPECT_EQ("a", text(1));
+	EXPECT_EQ(",", text(2));
+	EXPECT_EQ("b", text(3));
+	EXPECT_EQ("c", text(4));
+
+	// "--" without a blank is two minus signs
+	ASSERT_EQ(0, tokenize("a--1"));
+	ASSERT_EQ(4, t_.n);
+	EXPECT_EQ("-", text(1));
+}
+
+/* word and quote runs of every length end at the same byte as a bytewise scan */
+TEST_F(SqlTokenTest, LongRunsAcrossVectorWidth)
+{
+	for (int n = 1; n <= 100; n++) {
+		std::string word;
+		for (int i = 0; i < n; i++)
+			word += "aZ09_$\xc3\xa9"[i % 8];
+		std::string lit(n, 'q');
+		lit[n / 2] = '\\';
+		if (n / 2 + 1 < n)
+			lit[n / 2 + 1] = '\'';
+		else
+			lit += "'";
+
+		ASSERT_EQ(0, tokenize(word + "=" + word + ".x '" + lit + "'"))
+			<< n;
+		ASSERT_EQ(6, t_.n) << n;
+		EXPECT_EQ(word, text(0));
+		EXPECT_EQ("=", text(1));
+		EXPECT_EQ(word, text(2));
+		EXPECT_EQ(".", text(3));
+		EXPECT_EQ("x", text(4));
+		EXPECT_EQ(SQL_TK_STRING, type(5));
+		EXPECT_EQ(lit, text(5));
+	}
+}
+
+TEST_F(SqlTokenTest, ManyTokensGoToHeap)
+{
+	std::string sql = "insert into t values ";
+	for (int i = 0; i < SQL_TOKEN_LOCAL * 3; i++)
+		sql += i ? ",(1)" : "(1)";
+	ASSERT_EQ(0, tokenize(sql));
+	EXPECT_EQ(4 + SQL_TOKEN_LOCAL * 3 * 4 - 1, t_.n);
+	EXPECT_TRUE(t_.tk != t_.local);
+	EXPECT_EQ(")", text(t_.n - 1));
+
+	// the heap array is reused by the next statement
+	struct sql_token *tk = t_.tk;
+	ASSERT_EQ(0, tokenize("select 1"));
+	EXPECT_EQ(2, t_.n);
+	EXPECT_EQ(tk, t_.tk);
+}
+
+/* the key matches whole identifiers only, never literals or longer names */
+TEST_F(SqlTokenTest, FindWholeWord)
+{
+	ASSERT_EQ(0, tokenize("select uid2 from t where note='uid=1' "
+			      "and `uid`=3 and UID = 4"));
+	int i = sql_token_find(s(), &t_, 0, "uid", 3);
+	ASSERT_GE(i, 0);
+	EXPECT_EQ("UID", text(i));
+	EXPECT_TRUE(sql_token_is_char(s(), &t_.tk[i + 1], '='));
+	EXPECT_EQ("4", text(i + 2));
+	EXPECT_EQ(-1, sql_token_find(s(), &t_, i + 1, "uid", 3));
+
+	// quoted identifiers match sql_token_is but are not keywords
+	int q = sql_token_find(s(), &t_, 0, "and", 3) + 1;
+	EXPECT_EQ(SQL_TK_QUOTED_ID, type(q));
+	EXPECT_TRUE(sql_token_is(s(), &t_.tk[q], "UID", 3));
+	EXPECT_FALSE(sql_token_is(s(), &t_.tk[q], "UI", 2));
+	EXPECT_FALSE(sql_token_is_char(s(), &t_.tk[q + 1], '<'));
+}
+
+#endif
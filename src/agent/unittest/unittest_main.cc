@@ -0,0 +1,8 @@
+#include "my_sql_token_unittest.h"
+#include "my_merge_unittest.h"
+
+int main(int argc, char **argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -122,6 +122,18 @@ public:
 	}
 
 	int process_statement_query(const DTCValue* key, std::string& s_sql);
+	int begin_work(void)
+	{
+		return db_conn.begin_work();
+	}
+	int do_commit(void)
+	{
+		return db_conn.do_commit();
+	}
+	int roll_back(void)
+	{
+		return db_conn.roll_back();
+	}
 	~ConnectorProcess();
 };
 
@@ -45,6 +45,8 @@ BufferPond::BufferPond(PurgeNodeProcessor *pn) : _purge_processor(pn)
 	_feature = 0;
 	_node_index = 0;
 	_col_expand = 0;
+	_col_dict = 0;
+	_key_index = 0;
 
 	memset(_err_msg, 0, sizeof(_err_msg));
 	_need_set_integrity = 0;
@@ -63,6 +65,7 @@ BufferPond::~BufferPond()
 	_ng_info->destroy();
 	_feature->destroy();
 	_node_index->destroy();
+	DELETE(_key_index);
 
 	/* 运行到这里，说明程序是正常stop的，设置共享内存完整性标记 */
 	if (_need_set_integrity) {
@@ -504,6 +507,15 @@ int BufferPond::dtc_mem_init(APP_STORAGE_T *storage)
 		return -1;
 	}
 
+	// string dictionary of dict fields
+	if (TableDefinitionManager::instance()->get_cur_table_def()->has_dict() &&
+	    init_col_dict())
+		return -1;
+
+	// ordered key index
+	if (_cache_info.key_index && init_key_index(NULL))
+		return -1;
+
 	stat_dirty_eldest = 0;
 	stat_dirty_age = 0;
 
@@ -585,6 +597,121 @@ int BufferPond::dtc_mem_attach(APP_STORAGE_T *storage)
 			"column expand feature not enable, do not support column expand");
 		_col_expand = NULL;
 	}
+
+	// string dictionary, nodes may keep codes even if no dict field now
+	p = _feature->get_feature_by_id(STRING_DICT);
+	if (p) {
+		_col_dict = DTCColDict::instance();
+		if (!_col_dict || _col_dict->attach(p->fi_handle)) {
+			snprintf(_err_msg, sizeof(_err_msg), "%s",
+				 _col_dict->error());
+			return -1;
+		}
+	} else if (TableDefinitionManager::instance()
+			   ->get_cur_table_def()
+			   ->has_dict() &&
+		   init_col_dict()) {
+		return -1;
+	}
+
+	// ordered key index, a disabled one is marked lossy
+	p = _feature->get_feature_by_id(KEY_INDEX);
+	if ((p || _cache_info.key_index) && init_key_index(p))
+		return -1;
+	return 0;
+}
+
+int BufferPond::init_col_dict(void)
+{
+	_col_dict = DTCColDict::instance();
+	if (!_col_dict || _col_dict->initialization()) {
+		snprintf(_err_msg, sizeof(_err_msg),
+			 "init string dict failed, %s", _col_dict->error());
+		return -1;
+	}
+	if (_feature->add_feature(STRING_DICT, _col_dict->get_handle())) {
+		snprintf(_err_msg, sizeof(_err_msg),
+			 "add string dict feature failed, %s",
+			 _feature->error());
+		return -1;
+	}
+	return 0;
+}
+
+int BufferPond::init_key_index(FEATURE_INFO_T *p)
+{
+	const DTCTableDefinition *t =
+		TableDefinitionManager::instance()->get_cur_table_def();
+
+	DELETE(_key_index);
+	if (!KeyIndex::key_supported(t)) {
+		log4cplus_warning("key index needs a single integer key");
+		return 0;
+	}
+	NEW(KeyIndex(t->key_format(), t->field_type(0) == DField::Signed),
+	    _key_index);
+	if (_key_index == NULL) {
+		snprintf(_err_msg, sizeof(_err_msg), "new key index error: %m");
+		return -1;
+	}
+
+	if (p != NULL) {
+		if (_key_index->attach(p->fi_handle)) {
+			snprintf(_err_msg, sizeof(_err_msg), "%s",
+				 _key_index->error());
+			return -1;
+		}
+	} else {
+		if (_key_index->init()) {
+			snprintf(_err_msg, sizeof(_err_msg), "%s",
+				 _key_index->error());
+			return -1;
+		}
+		if (_feature->add_feature(KEY_INDEX,
+					  _key_index->get_handle())) {
+			snprintf(_err_msg, sizeof(_err_msg),
+				 "add key index feature failed, %s",
+				 _feature->error());
+			return -1;
+		}
+		// nodes cached before the index existed
+		if (get_total_used_node() > 0)
+			_key_index->set_lossy();
+	}
+
+	if (!_cache_info.key_index) {
+		// not maintained from now on
+		_key_index->set_lossy();
+		DELETE(_key_index);
+		return 0;
+	}
+	// out of memory only leaves the index lossy
+	if (_key_index->lossy())
+		rebuild_key_index();
+	log4cplus_info("key index keys: %u, lossy: %d", _key_index->size(),
+		       _key_index->lossy());
+	return 0;
+}
+
+/* 按node id遍历所有节点重建key索引，只在启动时调用 */
+int BufferPond::rebuild_key_index(void)
+{
+	_key_index->begin_bulk_load();
+	for (NODE_ID_T i = get_min_valid_node_id(); i <= max_node_id(); i++) {
+		Node node = I_SEARCH(i);
+		if (!node || node.not_in_lru_list() || is_time_marker(node) ||
+		    node.vd_handle() == INVALID_HANDLE)
+			continue;
+		DataChunk *data_chunk = M_POINTER(DataChunk, node.vd_handle());
+		if (data_chunk == NULL || data_chunk->key() == NULL)
+			continue;
+		_key_index->bulk_add(data_chunk->key(), i);
+	}
+	if (_key_index->end_bulk_load() != 0) {
+		log4cplus_error("rebuild key index error: %s",
+				_key_index->error());
+		return -1;
+	}
 	return 0;
 }
 
@@ -1156,6 +1283,8 @@ int BufferPond::purge_node(const char *key, Node purge_node)
 
 	/*1. Remove from hash */
 	remove_from_hash(key, purge_node);
+	if (key_index())
+		_key_index->remove(key, purge_node.node_id());
 
 	/*2. Remove from LRU */
 	_ng_info->remove_from_lru(purge_node);
@@ -1304,6 +1433,12 @@ Node BufferPond::cache_allocation(const char *key)
 	/*2. Insert to clean Lru list*/
 	_ng_info->insert_to_clean_lru(allocate_node);
 
+	/*3. Insert to key index, a full index stops being used */
+	if (key_index() &&
+	    _key_index->insert(key, allocate_node.node_id()) != 0)
+		log4cplus_error("key index insert error: %s, index is lossy",
+				_key_index->error());
+
 	return allocate_node;
 }
 
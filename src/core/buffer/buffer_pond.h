@@ -31,6 +31,8 @@
 #include "nodegroup/ng_info.h"
 #include "algorithm/hash.h"
 #include "data/col_expand.h"
+#include "data/col_dict.h"
+#include "key_index.h"
 #include "node/node.h"
 #include "timer/timer_list.h"
 #include "misc/purge_processor.h"
@@ -63,6 +65,8 @@ typedef struct _BlockProperties {
 	unsigned char auto_delete_dirty_shm : 1;
 	// 是否需要强制使用table.conf更新共享内存中的配置
 	unsigned char force_update_table_conf : 1;
+	// 是否维护按key排序的节点索引
+	unsigned char key_index : 1;
 
 	inline void init(int key_format, unsigned long cache_size,
 			 unsigned int create_version)
@@ -92,6 +96,9 @@ class BufferPond : private TimerObject {
 	NodeIndex *_node_index;
 	//列扩展
 	DTCColExpand *_col_expand;
+	DTCColDict *_col_dict;
+	//按key排序的节点索引
+	KeyIndex *_key_index;
 
 	char _err_msg[512];
 	int _need_set_integrity;
@@ -132,6 +139,9 @@ class BufferPond : private TimerObject {
 	int dtc_mem_open(APP_STORAGE_T *);
 	int dtc_mem_attach(APP_STORAGE_T *);
 	int dtc_mem_init(APP_STORAGE_T *);
+	int init_col_dict(void);
+	int init_key_index(FEATURE_INFO_T *);
+	int rebuild_key_index(void);
 	int verify_cache_info(BlockProperties *);
 	unsigned int hash_bucket_num(uint64_t);
 
@@ -219,8 +229,18 @@ class BufferPond : private TimerObject {
 	bool col_expand(const char *table, int len);
 	int try_col_expand(const char *table, int len);
 	bool reload_table();
+	void update_col_dict_stat()
+	{
+		if (_col_dict)
+			_col_dict->update_stat();
+	}
 
 	int cache_open(BlockProperties *);
+	// NULL if disabled or lossy
+	KeyIndex *key_index(void)
+	{
+		return _key_index && !_key_index->lossy() ? _key_index : NULL;
+	}
 	void set_empty_node_limit(int v)
 	{
 		empty_limit = v < 0 ? 0 : v;
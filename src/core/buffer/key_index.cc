@@ -0,0 +1,239 @@
+/*
+* Copyright [2021] JD.com, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <algorithm>
+
+#include "key_index.h"
+
+DTC_USING_NAMESPACE
+
+KeyIndex::KeyIndex(int key_size, int is_signed)
+	: key_size_(key_size), signed_(is_signed), info_(NULL),
+	  handle_(INVALID_HANDLE), tree_(*PtMalloc::instance())
+{
+	memset(errmsg_, 0, sizeof(errmsg_));
+}
+
+KeyIndex::~KeyIndex()
+{
+}
+
+bool KeyIndex::key_supported(const DTCTableDefinition *t)
+{
+	if (t->key_fields() != 1 || t->key_format() <= 0 ||
+	    t->key_format() > 8)
+		return false;
+	return t->field_type(0) == DField::Signed ||
+	       t->field_type(0) == DField::Unsigned;
+}
+
+int KeyIndex::init(void)
+{
+	handle_ = M_CALLOC(sizeof(KEY_INDEX_INFO_T));
+	if (INVALID_HANDLE == handle_) {
+		snprintf(errmsg_, sizeof(errmsg_), "init key index fail, %s",
+			 M_ERROR());
+		return -ENOMEM;
+	}
+
+	info_ = M_POINTER(KEY_INDEX_INFO_T, handle_);
+	info_->ki_count = 0;
+	info_->ki_lossy = 0;
+	info_->ki_key_size = key_size_;
+	info_->ki_signed = signed_;
+	info_->ki_root = INVALID_HANDLE;
+
+	return DTC_CODE_SUCCESS;
+}
+
+int KeyIndex::attach(MEM_HANDLE_T handle)
+{
+	if (INVALID_HANDLE == handle) {
+		snprintf(errmsg_, sizeof(errmsg_),
+			 "attach key index failed, memory handle = 0");
+		return DTC_CODE_FAILED;
+	}
+
+	handle_ = handle;
+	info_ = M_POINTER(KEY_INDEX_INFO_T, handle_);
+	// key定义变了，旧的顺序不可用
+	if (info_->ki_key_size != key_size_ || info_->ki_signed != signed_) {
+		info_->ki_key_size = key_size_;
+		info_->ki_signed = signed_;
+		info_->ki_lossy = 1;
+	}
+
+	return DTC_CODE_SUCCESS;
+}
+
+void KeyIndex::detach(void)
+{
+	info_ = NULL;
+	handle_ = INVALID_HANDLE;
+}
+
+/* packed key为小端的定长整数，有符号数扩展后翻转符号位 */
+uint64_t KeyIndex::normalize(const char *key) const
+{
+	uint64_t v = 0;
+	memcpy(&v, key, key_size_);
+	if (signed_) {
+		int shift = 64 - key_size_ * 8;
+		v = (uint64_t)((int64_t)(v << shift) >> shift);
+		v ^= 1ULL << 63;
+	}
+	return v;
+}
+
+int KeyIndex::insert(const char *key, NODE_ID_T id)
+{
+	uint64_t k = normalize(key);
+	int alloc;
+
+	tree_.do_attach(info_->ki_root);
+	int ret = tree_.do_insert(k, id, alloc);
+	info_->ki_root = tree_.Root();
+	if (ret == 0) {
+		info_->ki_count++;
+		return 0;
+	}
+	if (ret == EC_KEY_EXIST) {
+		ALLOC_HANDLE_T *rec;
+		if (tree_.do_find(k, rec))
+			*rec = id;
+		return 0;
+	}
+
+	// 不完整的索引不再使用，释放树节点
+	snprintf(errmsg_, sizeof(errmsg_), "%s", tree_.get_err_msg());
+	tree_.destory(false);
+	info_->ki_root = INVALID_HANDLE;
+	info_->ki_count = 0;
+	info_->ki_lossy = 1;
+	return -1;
+}
+
+void KeyIndex::remove(const char *key, NODE_ID_T id)
+{
+	uint64_t k = normalize(key);
+	ALLOC_HANDLE_T rec;
+	int freed;
+
+	tree_.do_attach(info_->ki_root);
+	// node id不同说明key已经指向别的节点
+	if (tree_.do_find(k, rec) == 0 || rec != id)
+		return;
+	if (tree_.Delete(k, freed) != 0) {
+		snprintf(errmsg_, sizeof(errmsg_), "%s", tree_.get_err_msg());
+		info_->ki_lossy = 1;
+	} else {
+		info_->ki_count--;
+	}
+	info_->ki_root = tree_.Root();
+}
+
+void KeyIndex::begin_bulk_load(void)
+{
+	bulk_.clear();
+}
+
+int KeyIndex::end_bulk_load(void)
+{
+	std::vector<uint64_t> keys;
+	std::vector<ALLOC_HANDLE_T> ids;
+	int alloc;
+
+	tree_.do_attach(info_->ki_root);
+	tree_.destory(false);
+	info_->ki_root = INVALID_HANDLE;
+	info_->ki_count = 0;
+
+	std::sort(bulk_.begin(), bulk_.end());
+	for (size_t i = 0; i < bulk_.size(); i++) {
+		if (!keys.empty() && keys.back() == bulk_[i].first) {
+			ids.back() = bulk_[i].second;
+			continue;
+		}
+		keys.push_back(bulk_[i].first);
+		ids.push_back(bulk_[i].second);
+	}
+	std::vector<std::pair<uint64_t, NODE_ID_T> >().swap(bulk_);
+
+	if (keys.size() > 0 &&
+	    tree_.bulk_load(&keys[0], &ids[0], keys.size(), alloc) != 0) {
+		snprintf(errmsg_, sizeof(errmsg_), "%s", tree_.get_err_msg());
+		info_->ki_lossy = 1;
+		return -1;
+	}
+	info_->ki_root = tree_.Root();
+	info_->ki_count = keys.size();
+	info_->ki_lossy = 0;
+	return 0;
+}
+
+struct KeyIndexCookie {
+	KeyIndexVisit visit;
+	void *cookie;
+};
+
+static int visit_key_index(MallocBase &stMalloc, ALLOC_HANDLE_T &hRecord,
+			   void *pCookie)
+{
+	KeyIndexCookie *c = (KeyIndexCookie *)pCookie;
+	return c->visit((NODE_ID_T)hRecord, c->cookie);
+}
+
+int KeyIndex::scan(const char *from, const char *to, KeyIndexVisit visit,
+		   void *cookie)
+{
+	if (lossy()) {
+		snprintf(errmsg_, sizeof(errmsg_), "key index is lossy");
+		return -1;
+	}
+
+	KeyIndexCookie c = { visit, cookie };
+	tree_.do_attach(info_->ki_root);
+	tree_.traverse_forward(from ? normalize(from) : 0,
+			       to ? normalize(to) : UINT64_MAX,
+			       visit_key_index, &c);
+	return 0;
+}
+
+struct KeyIndexPage {
+	std::vector<NODE_ID_T> *ids;
+	uint32_t limit;
+};
+
+static int collect_key_page(NODE_ID_T id, void *cookie)
+{
+	KeyIndexPage *page = (KeyIndexPage *)cookie;
+	page->ids->push_back(id);
+	return page->ids->size() >= page->limit;
+}
+
+int KeyIndex::scan(const char *from, const char *to, uint32_t limit,
+		   std::vector<NODE_ID_T> &ids)
+{
+	KeyIndexPage page = { &ids, limit };
+
+	ids.clear();
+	if (limit == 0)
+		return 0;
+	return scan(from, to, collect_key_page, &page);
+}
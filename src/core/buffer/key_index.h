@@ -0,0 +1,122 @@
+/*
+* Copyright [2021] JD.com, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef __DTC_KEY_INDEX_H
+#define __DTC_KEY_INDEX_H
+
+#include <stdint.h>
+#include <vector>
+#include <utility>
+
+#include "namespace.h"
+#include "global.h"
+#include "table/table_def.h"
+#include "tree/b_tree.h"
+
+DTC_BEGIN_NAMESPACE
+
+struct key_index_info {
+	uint32_t ki_count; // keys in index
+	uint8_t ki_lossy; // some cached keys are not indexed
+	uint8_t ki_key_size; // key format the index was built for
+	uint8_t ki_signed;
+	uint8_t ki_reserve;
+	MEM_HANDLE_T ki_root; // b+tree root
+};
+typedef struct key_index_info KEY_INDEX_INFO_T;
+
+// 返回非0时停止遍历
+typedef int (*KeyIndexVisit)(NODE_ID_T id, void *cookie);
+
+/*
+ * 共享内存中按key排序的节点索引，作为KEY_INDEX特性挂在feature表中，
+ * 供按key范围查询和可续传的全量遍历使用。只支持单个整数key：key转成
+ * 保序的64位值，用b+tree存放key到node id的映射。
+ *
+ * 节点分配时插入、淘汰时删除。内存不足时释放整棵树并标记lossy，lossy的
+ * 索引不能再用于遍历，直到下次启动时遍历所有节点重建。
+ */
+class KeyIndex {
+    public:
+	KeyIndex(int key_size, int is_signed);
+	~KeyIndex();
+
+	// 单个整数key才能建索引
+	static bool key_supported(const DTCTableDefinition *t);
+
+	int init(void);
+	int attach(MEM_HANDLE_T handle);
+	void detach(void);
+
+	const char *error() const
+	{
+		return errmsg_;
+	}
+	MEM_HANDLE_T get_handle() const
+	{
+		return handle_;
+	}
+
+	uint32_t size() const
+	{
+		return info_->ki_count;
+	}
+	bool lossy() const
+	{
+		return info_->ki_lossy != 0;
+	}
+	void set_lossy(void)
+	{
+		info_->ki_lossy = 1;
+	}
+
+	uint64_t normalize(const char *key) const;
+
+	// 0: ok, -1: no memory, index marked lossy
+	int insert(const char *key, NODE_ID_T id);
+	void remove(const char *key, NODE_ID_T id);
+
+	// 清空后用bulk_add()收集的条目重建，成功后清除lossy标记
+	void begin_bulk_load(void);
+	void bulk_add(const char *key, NODE_ID_T id)
+	{
+		bulk_.push_back(std::make_pair(normalize(key), id));
+	}
+	int end_bulk_load(void);
+
+	/*
+	 * 按key从小到大访问[from, to]中的节点，from/to为packed key，
+	 * NULL表示不限。lossy时返回-1
+	 */
+	int scan(const char *from, const char *to, KeyIndexVisit visit,
+		 void *cookie);
+	// 一页最多limit个节点，续传时以最后一个key加1为from
+	int scan(const char *from, const char *to, uint32_t limit,
+		 std::vector<NODE_ID_T> &ids);
+
+    private:
+	int key_size_;
+	int signed_;
+	KEY_INDEX_INFO_T *info_;
+	MEM_HANDLE_T handle_;
+	Btree tree_;
+	std::vector<std::pair<uint64_t, NODE_ID_T> > bulk_;
+	char errmsg_[256];
+};
+
+DTC_END_NAMESPACE
+
+#endif
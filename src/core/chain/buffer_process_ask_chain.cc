@@ -155,6 +155,7 @@ void BufferProcessAskChain::transaction_end(void)
 			}
 		}
 	}
+	cache_.update_col_dict_stat();
 
 	CacheTransaction::Free();
 }
@@ -214,8 +215,8 @@ int BufferProcessAskChain::write_hotbackup_log(const char *key, char *pstChunk,
 	log4cplus_debug(" packed key len:%d, key len:%d,  key :%s",
 			packeKey.bin.len, *(unsigned char *)packeKey.bin.ptr,
 			packeKey.bin.ptr + 1);
-	if (uiNodeSize > 0 &&
-	    (iType == DTCHotBackup::SYNC_COLEXPAND_CMD || uiNodeSize <= 100)) {
+	if (uiNodeSize > 0 && (iType == DTCHotBackup::SYNC_COLEXPAND_CMD ||
+			       uiNodeSize <= hotbackup_value_limit_)) {
 		hotbacktask.set_flag(DTCHotBackup::HAS_VALUE);
 		hotbacktask.set_value(pstChunk, uiNodeSize);
 		dispatch_hot_back_task(pJob);
@@ -243,6 +244,27 @@ int BufferProcessAskChain::write_hotbackup_log(const char *key, Node &node,
 			node.vd_handle());
 		uiNodeSize = pstChunk->node_size();
 	}
+
+	// 字典编码只在本进程有效，紧凑格式依赖本地表配置，转成定长原值再写
+	unsigned char uchType = pstChunk ? *(unsigned char *)pstChunk : 0;
+	if (pstChunk && (uchType & DATA_TYPE_MASK) == DATA_TYPE_RAW &&
+	    (uchType & (DATA_TYPE_DICT | DATA_TYPE_PACKED))) {
+		RawData stFrom(PtMalloc::instance());
+		RawData stPlain(&g_stSysMalloc, 1);
+		if (stFrom.do_attach(node.vd_handle()) != 0) {
+			log4cplus_error("attach node for hot backup error: %s",
+					stFrom.get_err_msg());
+			return -1;
+		}
+		stPlain.set_refrence(&stFrom);
+		if (stPlain.copy_all_decoded() != 0) {
+			log4cplus_error("decode node for hot backup error: %s",
+					stPlain.get_err_msg());
+			return -1;
+		}
+		return write_hotbackup_log(key, (char *)stPlain.get_addr(),
+					   stPlain.data_size(), iType);
+	}
 	return write_hotbackup_log(key, (char *)pstChunk, uiNodeSize, iType);
 }
 
@@ -282,6 +304,7 @@ BufferProcessAskChain::BufferProcessAskChain(PollerBase *p,
 	  update_mode_(MODE_SYNC), insert_mode_(MODE_SYNC),
 	  memory_dirty_(false), insert_order_(INSERT_ORDER_LAST),
 	  node_size_limit_(0), node_rows_limit_(0), node_empty_limit_(0),
+	  snapshot_rows_(0),
 
 	  flush_reply_(this), flush_timer_(NULL),
 	  current_pend_flush_request_(0), pend_flush_request_(0),
@@ -293,9 +316,9 @@ BufferProcessAskChain::BufferProcessAskChain(PollerBase *p,
 	  log_hotbackup_key_switch_(false), hotbackup_lru_feature_(NULL),
 	  // Hot Backup
 	  // BlackList
-	  black_list_(0), blacklist_timer_(0)
-
-// BlackList
+	  black_list_(0), blacklist_timer_(0),
+	  // BlackList
+	  miss_coalescer_(NULL), replica_(NULL), hotbackup_value_limit_(100)
 {
 	memset((char *)&cache_info_, 0, sizeof(cache_info_));
 
@@ -334,12 +357,21 @@ BufferProcessAskChain::BufferProcessAskChain(PollerBase *p,
 		g_dtc_config->get_int_val("cache", "max_expire_count_", 100);
 	max_expire_time_ = g_dtc_config->get_int_val(
 		"cache", "max_expire_time_", 3600 * 24 * 30);
+
+	if (g_dtc_config->get_int_val("cache", "MissCoalescing", 1) > 0)
+		miss_coalescer_ = new MissCoalescer(
+			this, g_dtc_config->get_int_val(
+				      "cache", "MissCoalescingTimeout", 5));
 }
 
 BufferProcessAskChain::~BufferProcessAskChain()
 {
 	if (empty_node_filter_ != NULL)
 		delete empty_node_filter_;
+	if (miss_coalescer_ != NULL)
+		delete miss_coalescer_;
+	if (replica_ != NULL)
+		delete replica_;
 }
 
 int BufferProcessAskChain::set_insert_order(int o)
@@ -425,6 +457,8 @@ int BufferProcessAskChain::open_init_buffer(int key_name,
 		enable_auto_clean_dirty_buffer ? 1 : 0;
 	cache_info_.force_update_table_conf =
 		g_dtc_config->get_int_val("cache", "ForceUpdateTableConf", 0);
+	cache_info_.key_index =
+		g_dtc_config->get_int_val("cache", "KeyIndex", 0) > 0 ? 1 : 0;
 
 	log4cplus_debug(
 		"cache_info: \n\tshmkey[%d] \n\tshmsize[" UINT64FMT
@@ -522,6 +556,8 @@ int BufferProcessAskChain::open_init_buffer(int key_name,
 		}
 		((RawDataProcess *)data_process_)
 			->set_limit_node_size(node_size_limit_);
+		((RawDataProcess *)data_process_)
+			->set_snapshot_rows(snapshot_rows_);
 	}
 	if (update_mode_ == MODE_SYNC) {
 		async_log_ = 1;
@@ -575,6 +611,16 @@ int BufferProcessAskChain::open_init_buffer(int key_name,
 				log4cplus_error("init key expire time failed");
 				return -1;
 			}
+			if (key_expire->attach_index(
+				    g_dtc_config->get_int_val(
+					    "cache", "ExpireIndexMaxEntries",
+					    4 << 20),
+				    g_dtc_config->get_int_val(
+					    "cache", "ExpireIndexBatch",
+					    10000)) != 0) {
+				log4cplus_error("init key expire index failed");
+				return -1;
+			}
 			key_expire->start_key_expired_task();
 		} else {
 			log4cplus_error("db mode do not support expire time");
@@ -696,8 +742,19 @@ BufferResult BufferProcessAskChain::buffer_get_data(DTCJobOperation &job)
 	switch (node_status) {
 	case DTC_CODE_NODE_NOTFOUND:
 		if (full_mode_ == false) {
-			if (job.flag_no_cache() != 0)
+			if (job.flag_no_cache() != 0) {
 				job.mark_as_pass_thru();
+			} else if (miss_coalescer_ != NULL) {
+				// wait for the in-flight fill of the same key
+				DTCValue pk = table_define_infomation_->packed_key(
+					job.packed_key());
+				if (miss_coalescer_->try_join(&job, pk.bin.ptr,
+							      pk.bin.len)) {
+					// counted again when re-dispatched
+					--stat_get_count_;
+					return DTC_CODE_BUFFER_UNFINISHED;
+				}
+			}
 			return DTC_CODE_BUFFER_GOTO_NEXT_CHAIN;
 		}
 		--stat_get_hits_; // FullCache Missing treat as miss
@@ -823,6 +880,20 @@ BufferResult BufferProcessAskChain::buffer_get_rb(DTCJobOperation &job)
 	return DTC_CODE_BUFFER_SUCCESS;
 }
 
+bool BufferProcessAskChain::key_resident(DTCJobOperation &job)
+{
+	if (empty_node_filter_ != NULL &&
+	    empty_node_filter_->ISSET(job.int_key()))
+		return true;
+
+	if (!!cache_.cache_find(job.packed_key(), g_target_new_hash ? 1 : 0))
+		return true;
+	if (g_hash_changing &&
+	    !!cache_.cache_find(job.packed_key(), g_target_new_hash ? 0 : 1))
+		return true;
+	return false;
+}
+
 // helper执行GET回来后，更新内存数据
 BufferResult BufferProcessAskChain::buffer_replace_result(DTCJobOperation &job)
 {
@@ -1608,7 +1679,10 @@ BufferResult BufferProcessAskChain::buffer_nodb_insert(DTCJobOperation &job)
 			      "key expire time illegal");
 		return DTC_CODE_BUFFER_ERROR;
 	}
-	return buffer_insert_row(job, false /* async */, true /* setrows */);
+	uint32_t expire = transaction_key_expire();
+	iRet = buffer_insert_row(job, false /* async */, true /* setrows */);
+	track_key_expire(iRet, expire);
+	return iRet;
 }
 
 BufferResult BufferProcessAskChain::buffer_nodb_update(DTCJobOperation &job)
@@ -1635,7 +1709,10 @@ BufferResult BufferProcessAskChain::buffer_nodb_update(DTCJobOperation &job)
 			      "key expire time illegal");
 		return DTC_CODE_BUFFER_ERROR;
 	}
-	return buffer_update_rows(job, false /*Async*/, true /*setrows*/);
+	uint32_t expire = transaction_key_expire();
+	cacheRet = buffer_update_rows(job, false /*Async*/, true /*setrows*/);
+	track_key_expire(cacheRet, expire);
+	return cacheRet;
 }
 
 BufferResult BufferProcessAskChain::buffer_nodb_replace(DTCJobOperation &job)
@@ -1649,23 +1726,31 @@ BufferResult BufferProcessAskChain::buffer_nodb_replace(DTCJobOperation &job)
 			      "key expire time illegal");
 		return DTC_CODE_BUFFER_ERROR;
 	}
+	BufferResult cacheRet;
 	// missing & empty insert it, otherwise replace it
 	switch (node_status) {
 	case DTC_CODE_NODE_EMPTY:
 	case DTC_CODE_NODE_NOTFOUND:
-		return buffer_insert_row(job, false, true /* setrows */);
+		cacheRet = buffer_insert_row(job, false, true /* setrows */);
+		track_key_expire(cacheRet, 0);
+		return cacheRet;
 	case DTC_CODE_NODE_HIT:
 		break;
 	}
-	BufferResult cacheRet = check_and_expire(job);
+	cacheRet = check_and_expire(job);
 	if (cacheRet == DTC_CODE_BUFFER_ERROR) {
 		return cacheRet;
 	} else if (cacheRet == DTC_CODE_BUFFER_SUCCESS) {
 		node_status = DTC_CODE_NODE_NOTFOUND;
 		cache_transaction_node = Node();
-		return buffer_insert_row(job, false, true /* setrows */);
+		cacheRet = buffer_insert_row(job, false, true /* setrows */);
+		track_key_expire(cacheRet, 0);
+		return cacheRet;
 	}
-	return buffer_replace_rows(job, false, true);
+	uint32_t expire = transaction_key_expire();
+	cacheRet = buffer_replace_rows(job, false, true);
+	track_key_expire(cacheRet, expire);
+	return cacheRet;
 }
 
 BufferResult BufferProcessAskChain::buffer_nodb_delete(DTCJobOperation &job)
@@ -2249,6 +2334,24 @@ BufferResult BufferProcessAskChain::check_and_expire(DTCJobOperation &job)
 	return DTC_CODE_BUFFER_GOTO_NEXT_CHAIN;
 }
 
+uint32_t BufferProcessAskChain::transaction_key_expire(void)
+{
+	if (key_expire == NULL || !cache_transaction_node)
+		return 0;
+	return key_expire->node_expire(cache_transaction_node);
+}
+
+void BufferProcessAskChain::track_key_expire(BufferResult ret,
+					     uint32_t old_expire)
+{
+	if (key_expire == NULL || ret == DTC_CODE_BUFFER_ERROR)
+		return;
+	// node may have been purged by the write itself
+	if (!cache_transaction_node)
+		return;
+	key_expire->index_node(cache_transaction_node, old_expire);
+}
+
 void BufferProcessAskChain::job_ask_procedure(DTCJobOperation *job_operation)
 {
 	log4cplus_debug("BufferProcessAskChain enter job_ask_procedure");
@@ -2267,6 +2370,24 @@ void BufferProcessAskChain::job_ask_procedure(DTCJobOperation *job_operation)
 		return;
 	}*/
 
+	// follower的数据只来自master，拒绝客户端写入
+	if (replica_ != NULL) {
+		switch (job_operation->request_code()) {
+		case DRequest::Insert:
+		case DRequest::Update:
+		case DRequest::Delete:
+		case DRequest::Replace:
+			log4cplus_info("replica is readonly, reject write");
+			job_operation->set_error(-EC_SERVER_READONLY,
+						 "buffer_process_unit",
+						 "replica is readonly");
+			job_operation->turn_around_job_answer();
+			return;
+		default:
+			break;
+		}
+	}
+
 	unsigned blacksize = 0;
 	transaction_begin(job_operation);
 
@@ -2424,6 +2545,18 @@ void BufferProcessAskChain::job_answer_procedure(DTCJobOperation *job_operation)
 		}
 	}
 
+	// wake up reads coalesced behind this miss, before job is released
+	if (miss_coalescer_ != NULL &&
+	    job_operation->request_code() == DRequest::Get &&
+	    !job_operation->flag_pass_thru()) {
+		DTCValue pk = table_define_infomation_->packed_key(
+			job_operation->packed_key());
+		miss_coalescer_->complete(job_operation, pk.bin.ptr,
+					  pk.bin.len,
+					  job_operation->result_code() >= 0 &&
+						  key_resident(*job_operation));
+	}
+
 	job_operation->turn_around_job_answer();
 
 	transaction_end();
@@ -2776,6 +2909,9 @@ BufferResult BufferProcessAskChain::buffer_process_admin(DTCJobOperation &Job)
 	case DRequest::SystemCommand::GetKeyList:
 		return buffer_get_key_list(Job);
 
+	case DRequest::SystemCommand::ScanKeyRange:
+		return buffer_scan_key_range(Job);
+
 	case DRequest::SystemCommand::GetUpdateKey:
 		return buffer_get_update_key(Job);
 
@@ -3151,15 +3287,15 @@ BufferProcessAskChain::buffer_column_expand_key(DTCJobOperation &Job)
 	return DTC_CODE_BUFFER_SUCCESS;
 }
 
-BufferResult BufferProcessAskChain::buffer_register_hb(DTCJobOperation &Job)
+int BufferProcessAskChain::activate_hotbackup(void)
 {
 	if (hotbackup_lru_feature_ == NULL) { // 共享内存还没有激活热备特性
 		NEW(HBFeature, hotbackup_lru_feature_);
 		if (hotbackup_lru_feature_ == NULL) {
 			log4cplus_error("new hot-backup feature error: %m");
-			Job.set_error(-EC_SERVER_ERROR, "buffer_register_hb",
-				      "new hot-backup feature fail");
-			return DTC_CODE_BUFFER_ERROR;
+			snprintf(error_message_, sizeof(error_message_),
+				 "new hot-backup feature fail");
+			return -1;
 		}
 		int iRet = hotbackup_lru_feature_->init(time(NULL));
 		if (iRet == -ENOMEM) {
@@ -3170,18 +3306,20 @@ BufferResult BufferProcessAskChain::buffer_register_hb(DTCJobOperation &Job)
 		if (iRet != 0) {
 			log4cplus_error("init hot-backup feature error: %d",
 					iRet);
-			Job.set_error(-EC_SERVER_ERROR, "buffer_register_hb",
-				      "init hot-backup feature fail");
-			return DTC_CODE_BUFFER_ERROR;
+			snprintf(error_message_, sizeof(error_message_),
+				 "init hot-backup feature fail");
+			DELETE(hotbackup_lru_feature_);
+			return -1;
 		}
 		iRet = cache_.add_feature(HOT_BACKUP,
 					  hotbackup_lru_feature_->get_handle());
 		if (iRet != 0) {
 			log4cplus_error("add hot-backup feature error: %d",
 					iRet);
-			Job.set_error(-EC_SERVER_ERROR, "buffer_register_hb",
-				      "add hot-backup feature fail");
-			return DTC_CODE_BUFFER_ERROR;
+			snprintf(error_message_, sizeof(error_message_),
+				 "add hot-backup feature fail");
+			DELETE(hotbackup_lru_feature_);
+			return -1;
 		}
 	}
 	if (hotbackup_lru_feature_->master_uptime() == 0)
@@ -3189,6 +3327,16 @@ BufferResult BufferProcessAskChain::buffer_register_hb(DTCJobOperation &Job)
 
 	//开启变更key日志
 	log_hotbackup_key_switch_ = true;
+	return 0;
+}
+
+BufferResult BufferProcessAskChain::buffer_register_hb(DTCJobOperation &Job)
+{
+	if (activate_hotbackup() != 0) {
+		Job.set_error(-EC_SERVER_ERROR, "buffer_register_hb",
+			      error_message_);
+		return DTC_CODE_BUFFER_ERROR;
+	}
 
 	int64_t hb_timestamp = hotbackup_lru_feature_->master_uptime();
 	Job.versionInfo.set_master_hb_timestamp(hb_timestamp);
@@ -3289,6 +3437,76 @@ BufferResult BufferProcessAskChain::buffer_get_key_list(DTCJobOperation &Job)
 	return DTC_CODE_BUFFER_SUCCESS;
 }
 
+/*
+ * 按key从小到大遍历节点，condition的第一个key为起点(含)，第二个key
+ * 为终点(含)，都是packed key，省略表示不限。每次最多返回limit个节点，
+ * 结果与GetKeyList相同；续传时以最后一个key加1为起点。
+ */
+BufferResult BufferProcessAskChain::buffer_scan_key_range(DTCJobOperation &Job)
+{
+	const DTCFieldValue *condition = Job.request_condition();
+	const char *from = NULL, *to = NULL;
+	uint32_t lcnt = Job.requestInfo.limit_count();
+
+	log4cplus_debug("buffer_scan_key_range start, limit[%u]", lcnt);
+
+	KeyIndex *index = cache_.key_index();
+	if (index == NULL) {
+		Job.set_error(-EBADRQC, CACHE_SVC, "key index not available");
+		return DTC_CODE_BUFFER_ERROR;
+	}
+	int key_size = table_define_infomation_->key_format();
+	for (int i = 0; condition && i < condition->num_fields() && i < 2;
+	     i++) {
+		const DTCValue *key = condition->field_value(i);
+		if (key->bin.len != key_size) {
+			Job.set_error(-EC_KEY_NEEDED, CACHE_SVC,
+				      "scan key size mismatch");
+			return DTC_CODE_BUFFER_ERROR;
+		}
+		(i == 0 ? from : to) = key->bin.ptr;
+	}
+	if (lcnt == 0)
+		lcnt = 1000;
+
+	std::vector<NODE_ID_T> ids;
+	index->scan(from, to, lcnt, ids);
+	if (ids.empty()) {
+		Job.set_error(-EC_FULL_SYNC_COMPLETE, "buffer_scan_key_range",
+			      "no more keys");
+		return DTC_CODE_BUFFER_ERROR;
+	}
+
+	Job.prepare_result_no_limit();
+
+	RowValue r(Job.table_definition());
+	RawData rawdata(&g_stSysMalloc, 1);
+
+	for (size_t i = 0; i < ids.size(); ++i) {
+		Node node = I_SEARCH(ids[i]);
+		if (!node || node.not_in_lru_list() ||
+		    node.vd_handle() == INVALID_HANDLE)
+			continue;
+
+		DataChunk *keyptr = M_POINTER(DataChunk, node.vd_handle());
+		r[1].u64 = DTCHotBackup::HAS_VALUE;
+		r[2] = table_define_infomation_->packed_key(keyptr->key());
+		if (data_process_->get_node_all_rows_count(&node, &rawdata)) {
+			rawdata.destory();
+			continue;
+		}
+		r[3].Set((char *)(rawdata.get_addr()),
+			 (int)(rawdata.data_size()));
+
+		log4cplus_debug("append_row flag");
+		Job.append_row(&r);
+
+		rawdata.destory();
+	}
+
+	return DTC_CODE_BUFFER_SUCCESS;
+}
+
 /*
  * hot backup拉取更新key或者lru变更，如果没有则挂起请求,直到
  * 1. 超时
@@ -3354,13 +3572,10 @@ BufferProcessAskChain::buffer_replace_raw_data(DTCJobOperation &Job)
 {
 	log4cplus_debug("buffer_replace_raw_data start ");
 
-	int iRet;
-
 	const DTCFieldValue *condition = Job.request_condition();
 	const DTCValue *key;
 
 	RowValue stRow(Job.table_definition()); //一行数据
-	RawData stNodeData(&g_stSysMalloc, 1);
 	if (condition->num_fields() < 1) {
 		log4cplus_debug("%s", "replace raw data need key");
 		Job.set_error_dup(-EC_KEY_NEEDED, CACHE_SVC,
@@ -3374,65 +3589,85 @@ BufferProcessAskChain::buffer_replace_raw_data(DTCJobOperation &Job)
 
 	log4cplus_debug("value[len: %d]", stRow[3].bin.len);
 
+	int iRet = replace_raw_node(key->bin.ptr, key->bin.len, stRow[1].u64,
+				    stRow[3].bin.ptr, stRow[3].bin.len);
+	if (iRet != 0) {
+		Job.set_error_dup(iRet, CACHE_SVC, error_message_);
+		return DTC_CODE_BUFFER_ERROR;
+	}
+
+	log4cplus_debug("buffer_replace_raw_data success! ");
+
+	return DTC_CODE_BUFFER_SUCCESS;
+}
+
+/*
+ * 用master的节点数据替换本地节点，key为packed key。
+ * 返回0成功，否则为错误码，错误信息在error_message_中
+ */
+int BufferProcessAskChain::replace_raw_node(const char *key, int key_len,
+					    uint64_t flag, const char *value,
+					    int value_len)
+{
+	int iRet;
+	RawData stNodeData(&g_stSysMalloc, 1);
+
 	//调整备机的空节点过滤
-	if (stRow[1].u64 & DTCHotBackup::EMPTY_NODE && empty_node_filter_) {
-		empty_node_filter_->SET(*(unsigned int *)(key->bin.ptr));
+	if (flag & DTCHotBackup::EMPTY_NODE && empty_node_filter_) {
+		empty_node_filter_->SET(*(unsigned int *)(key));
 	}
 
 	//key在master不存在, 或者是空节点，purge cache.
-	if (stRow[1].u64 & DTCHotBackup::KEY_NOEXIST ||
-	    stRow[1].u64 & DTCHotBackup::EMPTY_NODE) {
+	if (flag & DTCHotBackup::KEY_NOEXIST ||
+	    flag & DTCHotBackup::EMPTY_NODE) {
 		log4cplus_debug("purge slave data");
-		Node stNode = cache_.cache_find_auto_chose_hash(key->bin.ptr);
-		int rows = cache_.node_rows_count(stNode);
-		log4cplus_debug("migrate replay ,row %d", rows);
-		cache_.inc_total_row(0LL - rows);
-		cache_.cache_purge(key->bin.ptr);
-		return DTC_CODE_BUFFER_SUCCESS;
+		purge_raw_node(key);
+		return 0;
 	}
 
 	// 解析成raw data
-	ALLOC_HANDLE_T hData = g_stSysMalloc.Malloc(stRow[3].bin.len);
+	ALLOC_HANDLE_T hData = g_stSysMalloc.Malloc(value_len);
 	if (hData == INVALID_HANDLE) {
 		log4cplus_error("malloc error: %m");
-		Job.set_error(-ENOMEM, CACHE_SVC, "malloc error");
-		return DTC_CODE_BUFFER_ERROR;
+		snprintf(error_message_, sizeof(error_message_),
+			 "malloc error");
+		return -ENOMEM;
 	}
 
-	memcpy(g_stSysMalloc.handle_to_ptr(hData), stRow[3].bin.ptr,
-	       stRow[3].bin.len);
+	memcpy(g_stSysMalloc.handle_to_ptr(hData), value, value_len);
 
 	if ((iRet = stNodeData.do_attach(
 		     hData, 0, table_define_infomation_->key_format())) != 0) {
 		log4cplus_error("parse raw-data error: %d, %s", iRet,
 				stNodeData.get_err_msg());
-		Job.set_error(-EC_BAD_RAW_DATA, CACHE_SVC, "bad raw data");
-		return DTC_CODE_BUFFER_ERROR;
+		snprintf(error_message_, sizeof(error_message_),
+			 "bad raw data");
+		return -EC_BAD_RAW_DATA;
 	}
 
 	// 检查packed key是否匹配
 	DTCValue packed_key = TableDefinitionManager::instance()
 				      ->get_cur_table_def()
 				      ->packed_key(stNodeData.key());
-	if (packed_key.bin.len != key->bin.len ||
-	    memcmp(packed_key.bin.ptr, key->bin.ptr, key->bin.len)) {
+	if (packed_key.bin.len != key_len ||
+	    memcmp(packed_key.bin.ptr, key, key_len)) {
 		log4cplus_error(
 			"packed key miss match, key size=%d, packed key size=%d",
-			key->bin.len, packed_key.bin.len);
+			key_len, packed_key.bin.len);
 		log4cplus_error("packed key miss match, packed_key %s,key %s",
-				packed_key.bin.ptr, key->bin.ptr);
-		Job.set_error(-EC_BAD_RAW_DATA, CACHE_SVC,
-			      "packed key miss match");
-		return DTC_CODE_BUFFER_ERROR;
+				packed_key.bin.ptr, key);
+		snprintf(error_message_, sizeof(error_message_),
+			 "packed key miss match");
+		return -EC_BAD_RAW_DATA;
 	}
 
 	// 查找分配node节点
 	unsigned int uiNodeID;
-	Node stNode = cache_.cache_find_auto_chose_hash(key->bin.ptr);
+	Node stNode = cache_.cache_find_auto_chose_hash(key);
 
 	if (!stNode) {
 		for (int i = 0; i < 2; i++) {
-			stNode = cache_.cache_allocation(key->bin.ptr);
+			stNode = cache_.cache_allocation(key);
 			if (!(!stNode))
 				break;
 			if (cache_.try_purge_size(1, stNode) != 0)
@@ -3440,9 +3675,9 @@ BufferProcessAskChain::buffer_replace_raw_data(DTCJobOperation &Job)
 		}
 		if (!stNode) {
 			log4cplus_error("alloc cache node error");
-			Job.set_error(-EIO, CACHE_SVC,
-				      "alloc cache node error");
-			return DTC_CODE_BUFFER_ERROR;
+			snprintf(error_message_, sizeof(error_message_),
+				 "alloc cache node error");
+			return -EIO;
 		}
 		stNode.vd_handle() = INVALID_HANDLE;
 	} else {
@@ -3459,23 +3694,78 @@ BufferProcessAskChain::buffer_replace_raw_data(DTCJobOperation &Job)
 			/* FIXME: no backup db, can't purge data, no recover solution yet */
 			log4cplus_error("cache replace raw data error: %d, %s",
 					iRet, data_process_->get_err_msg());
-			Job.set_error(-EIO, CACHE_SVC,
-				      "ReplaceRawData() error");
-			return DTC_CODE_BUFFER_ERROR;
+			snprintf(error_message_, sizeof(error_message_),
+				 "ReplaceRawData() error");
+			return -EIO;
 		} else {
 			log4cplus_error(
 				"cache replace raw data error: %d, %s. purge node: %u",
 				iRet, data_process_->get_err_msg(), uiNodeID);
-			cache_.purge_node_and_data(key->bin.ptr, stNode);
-			return DTC_CODE_BUFFER_SUCCESS;
+			cache_.purge_node_and_data(key, stNode);
+			return 0;
 		}
 	}
 
 	cache_.inc_total_row(data_process_->get_increase_row_count());
+	if (key_expire != NULL)
+		key_expire->index_node(stNode, 0);
 
-	log4cplus_debug("buffer_replace_raw_data success! ");
+	return 0;
+}
 
-	return DTC_CODE_BUFFER_SUCCESS;
+void BufferProcessAskChain::purge_raw_node(const char *key)
+{
+	Node stNode = cache_.cache_find_auto_chose_hash(key);
+	int rows = cache_.node_rows_count(stNode);
+	log4cplus_debug("migrate replay ,row %d", rows);
+	cache_.inc_total_row(0LL - rows);
+	cache_.cache_purge(key);
+}
+
+int BufferProcessAskChain::replica_apply(int type, int flag, const char *key,
+					 int key_len, const char *value,
+					 int value_len)
+{
+	switch (type) {
+	case DTCHotBackup::SYNC_LRU:
+	case DTCHotBackup::SYNC_NONE:
+		return 0;
+	case DTCHotBackup::SYNC_PURGE:
+		purge_raw_node(key);
+		return 0;
+	case DTCHotBackup::SYNC_CLEAR:
+		// follower不接受客户端写入，没有脏节点，可以直接清空
+		log4cplus_info("replica clear cache as master did");
+		return clear_cache_data();
+	case DTCHotBackup::SYNC_COLEXPAND:
+	case DTCHotBackup::SYNC_COLEXPAND_CMD:
+		log4cplus_error(
+			"replica can't apply column expand (binlog type %d), "
+			"key[len=%d] skipped, expand the replica table by hand",
+			type, key_len);
+		return -1;
+	default:
+		break;
+	}
+
+	// 节点已删空或超过HotBackupValueLimit未带value，丢弃本地数据
+	if (!(flag & DTCHotBackup::HAS_VALUE) || value_len <= 0) {
+		purge_raw_node(key);
+		return 0;
+	}
+	return replace_raw_node(key, key_len, flag, value, value_len);
+}
+
+int BufferProcessAskChain::start_replica(const char *master,
+					 const char *pos_file, int retry)
+{
+	replica_ = new ReplicaClient(owner, this, retry);
+	if (replica_ == NULL || replica_->do_init(master, pos_file) != 0) {
+		log4cplus_error("start replica of %s failed", master);
+		DELETE(replica_);
+		return -1;
+	}
+	return 0;
 }
 
 BufferResult BufferProcessAskChain::buffer_adjust_lru(DTCJobOperation &Job)
@@ -3918,14 +4208,8 @@ BufferResult BufferProcessAskChain::buffer_migrate(DTCJobOperation &Job)
 	return DTC_CODE_BUFFER_TO_REMOTE_TARGET;
 }
 
-BufferResult BufferProcessAskChain::buffer_clear_cache(DTCJobOperation &Job)
+int BufferProcessAskChain::clear_cache_data(void)
 {
-	if (update_mode_ != MODE_SYNC) {
-		log4cplus_error("try to clear cache for async mode, abort...");
-		Job.set_error(-EC_SERVER_ERROR, "buffer_clear_cache",
-			      "can not clear cache for aync mode, abort");
-		return DTC_CODE_BUFFER_ERROR;
-	}
 	// clean and rebuild
 	int64_t mu = 0, su = 0;
 	if (hotbackup_lru_feature_ != NULL) {
@@ -3943,9 +4227,7 @@ BufferResult BufferProcessAskChain::buffer_clear_cache(DTCJobOperation &Job)
 		}
 		if (ret == -2) {
 			log4cplus_error("error, abort...");
-			Job.set_error(-EC_SERVER_ERROR, "buffer_clear_cache",
-				      "clear cache_ error, abort");
-			return DTC_CODE_BUFFER_ERROR;
+			return -1;
 		}
 	}
 	data_process_->change_mallocator(PtMalloc::instance());
@@ -3964,6 +4246,27 @@ BufferResult BufferProcessAskChain::buffer_clear_cache(DTCJobOperation &Job)
 		hotbackup_lru_feature_->master_uptime() = mu;
 		hotbackup_lru_feature_->slave_uptime() = su;
 	}
+	// expire index lived in the old shm
+	if (key_expire != NULL && key_expire->reset_index() != 0) {
+		log4cplus_error("reset expire index error");
+		exit(-1);
+	}
+	return 0;
+}
+
+BufferResult BufferProcessAskChain::buffer_clear_cache(DTCJobOperation &Job)
+{
+	if (update_mode_ != MODE_SYNC) {
+		log4cplus_error("try to clear cache for async mode, abort...");
+		Job.set_error(-EC_SERVER_ERROR, "buffer_clear_cache",
+			      "can not clear cache for aync mode, abort");
+		return DTC_CODE_BUFFER_ERROR;
+	}
+	if (clear_cache_data() != 0) {
+		Job.set_error(-EC_SERVER_ERROR, "buffer_clear_cache",
+			      "clear cache_ error, abort");
+		return DTC_CODE_BUFFER_ERROR;
+	}
 	// hotbackup
 	char buf[16];
 	memset(buf, 0, sizeof(buf));
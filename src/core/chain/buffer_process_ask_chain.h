@@ -37,12 +37,14 @@
 #include "empty_filter.h"
 #include "namespace.h"
 #include "task_pendlist.h"
+#include "miss_coalescer.h"
 #include "data_chunk.h"
 #include "hb_log.h"
 #include "lru_bit.h"
 #include "hb_feature.h"
 #include "blacklist/blacklist_unit.h"
 #include "expire_time.h"
+#include "replica_client.h"
 #include "buffer_process_answer_chain.h"
 
 DTC_BEGIN_NAMESPACE
@@ -179,6 +181,8 @@ class BufferProcessAskChain : public JobAskInterface<DTCJobOperation>,
 	int node_rows_limit_;
 	// empty nodes limit
 	int node_empty_limit_;
+	// get rows decoded by the agent thread, 0 = off
+	int snapshot_rows_;
 
 	// generated error message
 	char error_message_[256];
@@ -241,6 +245,12 @@ class BufferProcessAskChain : public JobAskInterface<DTCJobOperation>,
 	ExpireTime *key_expire;
 	TimerList *key_expire_timer_;
 	HotBackReplay hotback_reply_;
+	// coalesce concurrent GET miss of the same key
+	MissCoalescer *miss_coalescer_;
+	// follower side of the built-in replication
+	ReplicaClient *replica_;
+	// node larger than this is logged without value
+	unsigned int hotbackup_value_limit_;
 
     private:
 	// level 1 processing
@@ -252,6 +262,8 @@ class BufferProcessAskChain : public JobAskInterface<DTCJobOperation>,
 	BufferResult buffer_replace_result(DTCJobOperation &job);
 	// GET response, DB --> client
 	BufferResult buffer_get_rb(DTCJobOperation &job);
+	// whether the key has a node or an empty mark in cache
+	bool key_resident(DTCJobOperation &job);
 
 	// implementation some admin/purge/flush function
 	BufferResult buffer_process_admin(DTCJobOperation &job);
@@ -303,9 +315,13 @@ class BufferProcessAskChain : public JobAskInterface<DTCJobOperation>,
 	BufferResult buffer_register_hb(DTCJobOperation &job);
 	BufferResult buffer_logout_hb(DTCJobOperation &job);
 	BufferResult buffer_get_key_list(DTCJobOperation &job);
+	BufferResult buffer_scan_key_range(DTCJobOperation &job);
 	BufferResult buffer_get_update_key(DTCJobOperation &job);
 	BufferResult buffer_get_raw_data(DTCJobOperation &job);
 	BufferResult buffer_replace_raw_data(DTCJobOperation &job);
+	int replace_raw_node(const char *key, int key_len, uint64_t flag,
+			     const char *value, int value_len);
+	void purge_raw_node(const char *key);
 	BufferResult buffer_adjust_lru(DTCJobOperation &job);
 	BufferResult buffer_verify_hbt(DTCJobOperation &job);
 	BufferResult buffer_get_hbt(DTCJobOperation &job);
@@ -324,6 +340,8 @@ class BufferProcessAskChain : public JobAskInterface<DTCJobOperation>,
 
 	// clear cache(only support nodb mode)
 	BufferResult buffer_clear_cache(DTCJobOperation &job);
+	// drop all nodes and rebuild the shm, shared with replica SYNC_CLEAR
+	int clear_cache_data(void);
 
 	/* we can still purge clean node if hit ratio is ok */
 	BufferResult cache_purgeforhit(DTCJobOperation &job);
@@ -342,6 +360,7 @@ class BufferProcessAskChain : public JobAskInterface<DTCJobOperation>,
 	int write_hotbackup_log(const char *key, Node &node, int iType);
 	int write_hotbackup_log(DTCJobOperation &job, Node &node, int iType);
 	int write_lru_hotbackup_log(const char *key);
+	int activate_hotbackup(void);
 
     public:
 	virtual void purge_node_processor(const char *key, Node node);
@@ -393,6 +412,12 @@ class BufferProcessAskChain : public JobAskInterface<DTCJobOperation>,
 		return;
 	}
 
+	/* 0 = always decode in cache thread, only for multi thread mode */
+	void set_snapshot_rows(int rows)
+	{
+		snapshot_rows_ = rows < 0 ? 0 : rows;
+	}
+
 	/*
 		 * 0 = no limit,
 		 * 1-999: invalid, use 1000 instead
@@ -413,6 +438,26 @@ class BufferProcessAskChain : public JobAskInterface<DTCJobOperation>,
 		cache_.disable_try_purge();
 	}
 
+	// master: log node value for nodes up to limit bytes
+	void set_hotbackup_value_limit(unsigned int limit)
+	{
+		hotbackup_value_limit_ = limit;
+	}
+	// master: record changed keys from startup, no RegisterHB needed
+	int enable_replication_log(void)
+	{
+		return activate_hotbackup();
+	}
+	// follower: apply binlog streamed from master
+	int start_replica(const char *master, const char *pos_file,
+			  int retry);
+	int replica_apply(int type, int flag, const char *key, int key_len,
+			  const char *value, int value_len);
+	bool buffer_empty(void) const
+	{
+		return cache_.get_total_used_node() == 0;
+	}
+
 	void set_date_expire_alert_time(int time)
 	{
 		cache_.set_date_expire_alert_time(time);
@@ -499,6 +544,9 @@ class BufferProcessAskChain : public JobAskInterface<DTCJobOperation>,
 
 	// expire
 	BufferResult check_and_expire(DTCJobOperation &job);
+	// keep the expire index in step with nodb writes
+	uint32_t transaction_key_expire(void);
+	void track_key_expire(BufferResult ret, uint32_t old_expire);
 
 	friend class TaskPendingList;
 	friend class BufferProcessAnswerChain;
@@ -0,0 +1,78 @@
+/*
+* Copyright [2021] JD.com, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <string.h>
+
+#include "col_dict.h"
+#include "table/table_def_manager.h"
+
+DTC_USING_NAMESPACE
+
+DTCColDict::DTCColDict() : handle_(INVALID_HANDLE)
+{
+	memset(errmsg_, 0, sizeof(errmsg_));
+	stat_entries_ = g_stat_mgr.get_stat_int_counter(DTC_STRING_DICT_ENTRIES);
+	stat_bytes_ = g_stat_mgr.get_stat_int_counter(DTC_STRING_DICT_BYTES);
+	stat_saved_ = g_stat_mgr.get_stat_int_counter(DTC_STRING_DICT_SAVED);
+}
+
+DTCColDict::~DTCColDict()
+{
+}
+
+int DTCColDict::initialization()
+{
+	MEM_HANDLE_T v = M_CALLOC(StringDict::region_size());
+	if (INVALID_HANDLE == v) {
+		snprintf(errmsg_, sizeof(errmsg_),
+			 "init string dict failed, %s", M_ERROR());
+		return DTC_CODE_FAILED;
+	}
+	handle_ = v;
+	dict_.format(M_POINTER(void, v));
+	TableDefinitionManager::instance()->set_string_dict(&dict_);
+	update_stat();
+	log4cplus_info("init string dict, %u bytes",
+		       (unsigned)StringDict::region_size());
+	return DTC_CODE_SUCCESS;
+}
+
+int DTCColDict::attach(MEM_HANDLE_T handle)
+{
+	if (INVALID_HANDLE == handle) {
+		snprintf(errmsg_, sizeof(errmsg_),
+			 "attach string dict failed, memory handle = 0");
+		return DTC_CODE_FAILED;
+	}
+	if (dict_.attach(M_POINTER(void, handle)) != 0) {
+		snprintf(errmsg_, sizeof(errmsg_),
+			 "attach string dict failed, bad magic");
+		return DTC_CODE_FAILED;
+	}
+	handle_ = handle;
+	TableDefinitionManager::instance()->set_string_dict(&dict_);
+	update_stat();
+	log4cplus_info("attach string dict, entries: %u, bytes: %u",
+		       dict_.entries(), dict_.bytes());
+	return DTC_CODE_SUCCESS;
+}
+
+void DTCColDict::update_stat()
+{
+	stat_entries_ = dict_.entries();
+	stat_bytes_ = dict_.bytes();
+	stat_saved_ = dict_.saved();
+}
@@ -0,0 +1,77 @@
+/*
+* Copyright [2021] JD.com, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef __DTC_COL_DICT_H_
+#define __DTC_COL_DICT_H_
+
+#include "namespace.h"
+#include "global.h"
+#include "stat_dtc.h"
+#include "algorithm/singleton.h"
+#include "table/string_dict.h"
+
+DTC_BEGIN_NAMESPACE
+
+/*
+ * 字典字段的共享字典，作为STRING_DICT特性挂在feature表中，与列扩展的
+ * 表定义一起保存在共享内存里，重启attach后节点中的编码仍然有效。
+ * 字典只追加不删除，满了以后新值按原样存放在行中。
+ */
+class DTCColDict {
+    public:
+	DTCColDict();
+	~DTCColDict();
+
+	static DTCColDict *instance()
+	{
+		return Singleton<DTCColDict>::instance();
+	}
+	static void destroy()
+	{
+		Singleton<DTCColDict>::destory();
+	}
+
+	int initialization();
+	int attach(MEM_HANDLE_T handle);
+
+	StringDict *dict()
+	{
+		return &dict_;
+	}
+	// 刷新字典大小及节省字节数统计
+	void update_stat();
+
+	const MEM_HANDLE_T get_handle() const
+	{
+		return handle_;
+	}
+	const char *error() const
+	{
+		return errmsg_;
+	}
+
+    private:
+	StringDict dict_;
+	MEM_HANDLE_T handle_;
+	StatCounter stat_entries_;
+	StatCounter stat_bytes_;
+	StatCounter stat_saved_;
+	char errmsg_[256];
+};
+
+DTC_END_NAMESPACE
+
+#endif
@@ -34,7 +34,7 @@ class DataChunk {
 	*************************************************/
 	ALLOC_SIZE_T base_size()
 	{
-		if (data_type_ == DATA_TYPE_RAW)
+		if ((data_type_ & DATA_TYPE_MASK) == DATA_TYPE_RAW)
 			return (sizeof(RawFormat));
 		else
 			return (sizeof(RootData));
@@ -61,10 +61,10 @@ class DataChunk {
 	*************************************************/
 	const char *key() const
 	{
-		if ((data_type_ & 0x7f) == DATA_TYPE_RAW) {
+		if ((data_type_ & DATA_TYPE_MASK) == DATA_TYPE_RAW) {
 			RawFormat *pstRaw = (RawFormat *)this;
 			return pstRaw->p_key_;
-		} else if ((data_type_ & 0x7f) == DATA_TYPE_TREE_ROOT) {
+		} else if ((data_type_ & DATA_TYPE_MASK) == DATA_TYPE_TREE_ROOT) {
 			RootData *pstRoot = (RootData *)this;
 			return pstRoot->p_key_;
 		}
@@ -79,10 +79,10 @@ class DataChunk {
 	*************************************************/
 	char *key()
 	{
-		if ((data_type_ & 0x7f) == DATA_TYPE_RAW) {
+		if ((data_type_ & DATA_TYPE_MASK) == DATA_TYPE_RAW) {
 			RawFormat *pstRaw = (RawFormat *)this;
 			return pstRaw->p_key_;
-		} else if ((data_type_ & 0x7f) == DATA_TYPE_TREE_ROOT) {
+		} else if ((data_type_ & DATA_TYPE_MASK) == DATA_TYPE_TREE_ROOT) {
 			RootData *pstRoot = (RootData *)this;
 			return pstRoot->p_key_;
 		}
@@ -99,7 +99,7 @@ class DataChunk {
 #define SET_KEY_FUNC(type, key)                                                \
 	void set_key(type key)                                                 \
 	{                                                                      \
-		if (data_type_ == DATA_TYPE_RAW) {                             \
+		if ((data_type_ & DATA_TYPE_MASK) == DATA_TYPE_RAW) {          \
 			RawFormat *pstRaw = (RawFormat *)this;                 \
 			*(type *)(void *)pstRaw->p_key_ = key;                 \
 		} else {                                                       \
@@ -122,7 +122,7 @@ class DataChunk {
 	*************************************************/
 	void set_key(const char *pchKey, int iLen)
 	{
-		if (data_type_ == DATA_TYPE_RAW) {
+		if ((data_type_ & DATA_TYPE_MASK) == DATA_TYPE_RAW) {
 			RawFormat *pstRaw = (RawFormat *)this;
 			*(unsigned char *)pstRaw->p_key_ = iLen;
 			memcpy(pstRaw->p_key_ + 1, pchKey, iLen);
@@ -141,7 +141,7 @@ class DataChunk {
 	*************************************************/
 	void set_key(const char *pchKey)
 	{
-		if (data_type_ == DATA_TYPE_RAW) {
+		if ((data_type_ & DATA_TYPE_MASK) == DATA_TYPE_RAW) {
 			RawFormat *pstRaw = (RawFormat *)this;
 			memcpy(pstRaw->p_key_, pchKey,
 			       *(unsigned char *)pchKey);
@@ -160,7 +160,7 @@ class DataChunk {
 	*************************************************/
 	int str_key_size()
 	{
-		if (data_type_ == DATA_TYPE_RAW) {
+		if ((data_type_ & DATA_TYPE_MASK) == DATA_TYPE_RAW) {
 			RawFormat *pstRaw = (RawFormat *)this;
 			return *(unsigned char *)pstRaw->p_key_;
 		} else {
@@ -182,7 +182,7 @@ class DataChunk {
 
 	unsigned int head_size()
 	{
-		if (data_type_ == DATA_TYPE_RAW)
+		if ((data_type_ & DATA_TYPE_MASK) == DATA_TYPE_RAW)
 			return sizeof(RawFormat);
 		else
 			return sizeof(RootData);
@@ -202,7 +202,7 @@ class DataChunk {
 
 	unsigned int node_size()
 	{
-		if (data_type_ == DATA_TYPE_RAW) {
+		if ((data_type_ & DATA_TYPE_MASK) == DATA_TYPE_RAW) {
 			RawFormat *pstRaw = (RawFormat *)this;
 			return pstRaw->data_size_;
 		} else {
@@ -212,7 +212,7 @@ class DataChunk {
 
 	unsigned int create_time()
 	{
-		if (data_type_ == DATA_TYPE_RAW) {
+		if ((data_type_ & DATA_TYPE_MASK) == DATA_TYPE_RAW) {
 			RawFormat *pstRaw = (RawFormat *)this;
 			return pstRaw->create_time_;
 		} else {
@@ -221,7 +221,7 @@ class DataChunk {
 	}
 	unsigned last_access_time()
 	{
-		if (data_type_ == DATA_TYPE_RAW) {
+		if ((data_type_ & DATA_TYPE_MASK) == DATA_TYPE_RAW) {
 			RawFormat *pstRaw = (RawFormat *)this;
 			return pstRaw->latest_request_time_;
 		} else {
@@ -230,7 +230,7 @@ class DataChunk {
 	}
 	unsigned int last_update_time()
 	{
-		if (data_type_ == DATA_TYPE_RAW) {
+		if ((data_type_ & DATA_TYPE_MASK) == DATA_TYPE_RAW) {
 			RawFormat *pstRaw = (RawFormat *)this;
 			return pstRaw->latest_update_time_;
 		} else {
@@ -240,7 +240,7 @@ class DataChunk {
 
 	uint32_t total_rows()
 	{
-		if (data_type_ == DATA_TYPE_RAW) {
+		if ((data_type_ & DATA_TYPE_MASK) == DATA_TYPE_RAW) {
 			RawFormat *pstRaw = (RawFormat *)this;
 			return pstRaw->row_count_;
 		} else {
@@ -258,9 +258,9 @@ class DataChunk {
 	int destory(MallocBase *pstMalloc)
 	{
 		MEM_HANDLE_T hHandle = pstMalloc->ptr_to_handle(this);
-		if (data_type_ == DATA_TYPE_RAW) {
+		if ((data_type_ & DATA_TYPE_MASK) == DATA_TYPE_RAW) {
 			return pstMalloc->Free(hHandle);
-		} else if (data_type_ == DATA_TYPE_TREE_ROOT) {
+		} else if ((data_type_ & DATA_TYPE_MASK) == DATA_TYPE_TREE_ROOT) {
 			TreeData stTree(pstMalloc);
 			int iRet = stTree.do_attach(hHandle);
 			if (iRet != 0) {
@@ -276,9 +276,9 @@ class DataChunk {
 	{
 		MEM_HANDLE_T hHandle = pstMalloc->ptr_to_handle(this);
 
-		if (data_type_ == DATA_TYPE_RAW) {
+		if ((data_type_ & DATA_TYPE_MASK) == DATA_TYPE_RAW) {
 			return pstMalloc->ask_for_destroy_size(hHandle);
-		} else if (data_type_ == DATA_TYPE_TREE_ROOT) {
+		} else if ((data_type_ & DATA_TYPE_MASK) == DATA_TYPE_TREE_ROOT) {
 			TreeData stTree(pstMalloc);
 			if (stTree.do_attach(hHandle))
 				return 0;
@@ -21,6 +21,7 @@
 HBLog::HBLog(DTCTableDefinition *tbl)
 	: tabledef_(tbl), log_writer_(0), log_reader_(0)
 {
+	path_[0] = prefix_[0] = '\0';
 }
 
 HBLog::~HBLog()
@@ -34,6 +35,8 @@ int HBLog::init(const char *path, const char *prefix, uint64_t total,
 {
 	log_writer_ = new BinlogWriter;
 	log_reader_ = new BinlogReader;
+	snprintf(path_, sizeof(path_), "%s", path);
+	snprintf(prefix_, sizeof(prefix_), "%s", prefix);
 
 	if (log_writer_->init(path, prefix, total, max_size)) {
 		log4cplus_error("init log_writer failed");
@@ -145,14 +148,78 @@ int HBLog::Seek(const JournalID &v)
 	return log_reader_->Seek(v);
 }
 
+int HBLog::set_group_commit(size_t group_size, int sync_policy,
+			    int sync_interval)
+{
+	return log_writer_->set_group_commit(group_size, sync_policy,
+					     sync_interval);
+}
+
+int HBLog::flush(void)
+{
+	return log_writer_->Flush();
+}
+
+bool HBLog::buffered(void) const
+{
+	return log_writer_->buffered();
+}
+
+void HBLog::set_flush_listener(LogFlushListener *l)
+{
+	log_writer_->set_flush_listener(l);
+}
+
+int HBLog::set_format(uint8_t version, uint32_t compress_threshold)
+{
+	return log_writer_->set_format(version, compress_threshold);
+}
+
+BinlogReader *HBLog::new_reader(void)
+{
+	BinlogReader *reader = new BinlogReader;
+	if (reader->init(path_, prefix_)) {
+		log4cplus_error("init binlog reader failed");
+		delete reader;
+		return NULL;
+	}
+	return reader;
+}
+
+class TaskAppendVisitor : public HBLogVisitor {
+    public:
+	TaskAppendVisitor(DTCJobOperation &job) : job_(job)
+	{
+	}
+	virtual int on_row(RowValue &row)
+	{
+		job_.append_row(&row);
+		return 0;
+	}
+
+    private:
+	DTCJobOperation &job_;
+};
+
 /* 批量拉取更新key，返回更新key的个数 */
 int HBLog::task_append_all_rows(DTCJobOperation &job, int limit)
+{
+	TaskAppendVisitor visitor(job);
+	return read_rows(log_reader_, limit, visitor);
+}
+
+int HBLog::read_rows(BinlogReader *reader, int limit, HBLogVisitor &visitor)
 {
 	int count;
-	for (count = 0; count < limit; ++count) {
+	for (count = 0; count < limit && !visitor.full(); ++count) {
 		/* 没有待处理日志 */
-		if (log_reader_->Read())
+		int ret = reader->Read();
+		if (ret == -1)
 			break;
+		if (ret < 0) {
+			log4cplus_error("binlog record broken");
+			return DTC_CODE_FAILED;
+		}
 
 		RawData *raw_data;
 
@@ -164,9 +231,9 @@ int HBLog::task_append_all_rows(DTCJobOperation &job, int limit)
 		}
 
 		if (raw_data->check_size(g_stSysMalloc.get_handle(
-						 log_reader_->record_pointer()),
+						 reader->record_pointer()),
 					 0, tabledef_->key_size(),
-					 log_reader_->record_length(0)) < 0) {
+					 reader->record_length(0)) < 0) {
 			log4cplus_error("raw data broken: wrong size");
 			DELETE(raw_data);
 			return DTC_CODE_FAILED;
@@ -174,7 +241,7 @@ int HBLog::task_append_all_rows(DTCJobOperation &job, int limit)
 
 		/* attach raw data read from one binlog */
 		if (raw_data->do_attach(g_stSysMalloc.get_handle(
-						log_reader_->record_pointer()),
+						reader->record_pointer()),
 					0, tabledef_->key_size())) {
 			log4cplus_error("attach rawdata mem failed");
 
@@ -192,9 +259,12 @@ int HBLog::task_append_all_rows(DTCJobOperation &job, int limit)
 					r[0].u64, r[1].u64, r[2].bin.ptr,
 					r[3].bin.ptr);
 			log4cplus_debug("binlog-type: %d",
-					log_reader_->binlog_type());
+					reader->binlog_type());
 
-			job.append_row(&r);
+			if (visitor.on_row(r) != 0) {
+				DELETE(raw_data);
+				return DTC_CODE_FAILED;
+			}
 		}
 
 		DELETE(raw_data);
@@ -29,6 +29,26 @@
 class BinlogWriter;
 class BinlogReader;
 
+/*
+ * 带value的热备记录上限。未压缩时整条记录也要小于BINLOG_MAX_RECORD_SIZE，
+ * 预留4K给记录头和key，超过的节点只记key，follower收到后清除本地节点
+ */
+#define HB_MAX_VALUE_SIZE (BINLOG_MAX_RECORD_SIZE - (4 << 10))
+
+//逐行接收解码后的binlog记录
+class HBLogVisitor {
+    public:
+	virtual ~HBLogVisitor()
+	{
+	}
+	virtual int on_row(RowValue &row) = 0;
+	//返回true时read_rows在下一条binlog记录前停止
+	virtual bool full(void)
+	{
+		return false;
+	}
+};
+
 class HBLog {
     public:
 	//传入编解码的表结构
@@ -39,6 +59,17 @@ class HBLog {
 		 off_t max_size);
 	int Seek(const JournalID &);
 
+	//组提交参数，见LogWriter::set_group_commit
+	int set_group_commit(size_t group_size, int sync_policy,
+			     int sync_interval);
+	//将组提交缓冲区写盘，读日志前必须调用
+	int flush(void);
+	//缓冲区里是否有未写盘的记录，写盘后通知listener
+	bool buffered(void) const;
+	void set_flush_listener(LogFlushListener *l);
+	//写入的binlog版本，version 3带crc并按批压缩
+	int set_format(uint8_t version, uint32_t compress_threshold);
+
 	JournalID get_reader_jid(void);
 	JournalID get_writer_jid(void);
 
@@ -47,6 +78,10 @@ class HBLog {
 
 	//将多条log记录编码进TaskReqeust
 	int task_append_all_rows(DTCJobOperation &, int limit);
+	//从指定reader读取最多limit条log记录，visitor满时提前返回，返回读取的记录数
+	int read_rows(BinlogReader *reader, int limit, HBLogVisitor &visitor);
+	//同一日志集上的独立reader，由调用者释放
+	BinlogReader *new_reader(void);
 
 	//提供给LRUBitUnit来记录lru变更
 	int write_lru_hb_log(DTCJobOperation &job);
@@ -57,6 +92,8 @@ class HBLog {
 	DTCTableDefinition *tabledef_;
 	BinlogWriter *log_writer_;
 	BinlogReader *log_reader_;
+	char path_[256];
+	char prefix_[256];
 };
 
 #endif
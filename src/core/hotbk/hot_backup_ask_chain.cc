@@ -19,18 +19,23 @@
 #include "task/task_request.h"
 #include "log/log.h"
 #include "hotback_task.h"
+#include "replication_server.h"
 
 extern DTCTableDefinition *g_table_def[];
 
 HotBackupAskChain::HotBackupAskChain(PollerBase *o)
 	: JobAskInterface<DTCJobOperation>(o), ownerThread_(o), main_chain(o),
 	  taskPendList_(this),
-	  hbLog_(TableDefinitionManager::instance()->get_hot_backup_table_def())
+	  hbLog_(TableDefinitionManager::instance()->get_hot_backup_table_def()),
+	  flushTimer_(NULL), replServer_(NULL),
+	  replNotifiedJid_(0)
 {
 }
 
 HotBackupAskChain::~HotBackupAskChain()
 {
+	hbLog_.set_flush_listener(NULL);
+	DELETE(replServer_);
 }
 void HotBackupAskChain::job_ask_procedure(DTCJobOperation *job_operation)
 {
@@ -89,6 +94,83 @@ bool HotBackupAskChain::do_init(uint64_t total, off_t max_size)
 	return true;
 }
 
+int HotBackupAskChain::set_group_commit(size_t group_size, int sync_policy,
+					int sync_interval, int flush_interval)
+{
+	if (hbLog_.set_group_commit(group_size, sync_policy, sync_interval))
+		return -1;
+	hbLog_.set_flush_listener(this);
+
+	disable_timer();
+	if (group_size > 0) {
+		if (flush_interval <= 0)
+			flush_interval = 1;
+		flushTimer_ = ownerThread_->get_timer_list_by_m_seconds(
+			flush_interval);
+		attach_timer(flushTimer_);
+	}
+	return 0;
+}
+
+void HotBackupAskChain::job_timer_procedure(void)
+{
+	if (hbLog_.flush())
+		log4cplus_error("flush hb log failed, %d jobs held",
+				(int)commitWait_.size());
+	attach_timer(flushTimer_);
+}
+
+void HotBackupAskChain::on_log_flushed(void)
+{
+	while (!commitWait_.empty()) {
+		DTCJobOperation *job = commitWait_.front();
+		commitWait_.pop_front();
+		job->turn_around_job_answer();
+	}
+	taskPendList_.Wakeup();
+	notify_replication();
+}
+
+THBResult HotBackupAskChain::commit_hb_log_process(DTCJobOperation &job)
+{
+	// a failed flush keeps the records buffered, the job waits for the
+	// next one that succeeds
+	if (hbLog_.buffered()) {
+		commitWait_.push_back(&job);
+		return HB_PROCESS_PENDING;
+	}
+	taskPendList_.Wakeup();
+	notify_replication();
+	return HB_PROCESS_OK;
+}
+
+int HotBackupAskChain::start_replication(const char *bind_addr, int window,
+					 int batch)
+{
+	replServer_ = new ReplicationServer(ownerThread_, &hbLog_);
+	if (replServer_ == NULL || replServer_->do_init(bind_addr, window,
+							batch) != 0) {
+		log4cplus_error("start replication server on %s failed",
+				bind_addr);
+		DELETE(replServer_);
+		return -1;
+	}
+	log4cplus_info("replication server listen on %s", bind_addr);
+	return 0;
+}
+
+void HotBackupAskChain::notify_replication(void)
+{
+	if (replServer_ == NULL)
+		return;
+
+	uint64_t jid = hbLog_.get_writer_jid();
+	if (jid == replNotifiedJid_)
+		return;
+	replNotifiedJid_ = jid;
+	replServer_->wakeup();
+}
+
 THBResult HotBackupAskChain::write_hb_log_process(DTCJobOperation &job)
 {
 	if (0 != hbLog_.write_update_log(job)) {
@@ -96,8 +178,7 @@ THBResult HotBackupAskChain::write_hb_log_process(DTCJobOperation &job)
 			      "write_hb_log_process fail");
 		return HB_PROCESS_ERROR;
 	}
-	taskPendList_.Wakeup();
-	return HB_PROCESS_OK;
+	return commit_hb_log_process(job);
 }
 
 THBResult HotBackupAskChain::write_lru_hb_log_process(DTCJobOperation &job)
@@ -107,7 +188,7 @@ THBResult HotBackupAskChain::write_lru_hb_log_process(DTCJobOperation &job)
 			      "write_lru_hb_log_process fail");
 		return HB_PROCESS_ERROR;
 	}
-	return HB_PROCESS_OK;
+	return commit_hb_log_process(job);
 }
 
 THBResult HotBackupAskChain::read_hb_log_process(DTCJobOperation &job)
@@ -123,6 +204,9 @@ THBResult HotBackupAskChain::read_hb_log_process(DTCJobOperation &job)
 		return HB_PROCESS_PENDING;
 	}
 
+	// reader works on the file, make buffered records visible first
+	if (hbLog_.flush())
+		log4cplus_error("flush hb log failed");
 	if (hbLog_.Seek(hb_jid)) {
 		job.set_error(-EC_BAD_HOTBACKUP_JID, "HBProcess",
 			      "read_hb_log_process jid overflow");
@@ -162,6 +246,8 @@ THBResult HotBackupAskChain::register_hb_log_process(DTCJobOperation &job)
 		return HB_PROCESS_ERROR;
 	} else {
 		//inc sync
+		if (hbLog_.flush())
+			log4cplus_error("flush hb log failed");
 		if (hbLog_.Seek(client_jid) == 0) {
 			log4cplus_info("inc-sync stage.");
 			job.versionInfo.set_hot_backup_id((uint64_t)client_jid);
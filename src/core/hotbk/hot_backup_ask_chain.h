@@ -21,23 +21,37 @@
 #include "hb_log.h"
 #include "task_pendlist.h"
 #include "stat_manager.h"
+#include "timer/timer_list.h"
 #include <map>
+#include <deque>
 
 class PollerBase;
 class DTCJobOperation;
+class ReplicationServer;
 enum THBResult {
 	HB_PROCESS_ERROR = -1,
 	HB_PROCESS_OK = 0,
 	HB_PROCESS_PENDING = 2,
 };
 
-class HotBackupAskChain : public JobAskInterface<DTCJobOperation> {
+class HotBackupAskChain : public JobAskInterface<DTCJobOperation>,
+			  private TimerObject,
+			  private LogFlushListener {
     public:
 	HotBackupAskChain(PollerBase *o);
 	virtual ~HotBackupAskChain();
 
 	virtual void job_ask_procedure(DTCJobOperation *job_operation);
 	bool do_init(uint64_t total, off_t max_size);
+	// group commit: flush buffered binlog at least every interval ms
+	int set_group_commit(size_t group_size, int sync_policy,
+			     int sync_interval, int flush_interval);
+	int set_binlog_format(int version, int compress_threshold)
+	{
+		return hbLog_.set_format(version, compress_threshold);
+	}
+	// stream binlog to follower dtcd over tcp
+	int start_replication(const char *bind_addr, int window, int batch);
 
     private:
 	/*concrete hb operation*/
@@ -47,12 +61,27 @@ class HotBackupAskChain : public JobAskInterface<DTCJobOperation> {
 	THBResult register_hb_log_process(DTCJobOperation &job);
 	THBResult query_hb_log_info_process(DTCJobOperation &job);
 
+	// flush group commit buffer
+	virtual void job_timer_procedure(void);
+	// new records are on disk, push them to followers
+	void notify_replication(void);
+	// reply now if the record is on disk, else hold it until flushed
+	THBResult commit_hb_log_process(DTCJobOperation &job);
+	// group commit buffer is on disk, reply the held jobs
+	virtual void on_log_flushed(void);
+
     private:
 	PollerBase *ownerThread_;
 	ChainJoint<DTCJobOperation> main_chain;
 	TaskPendingList taskPendList_;
+	// write jobs whose records are still in the group commit buffer
+	std::deque<DTCJobOperation *> commitWait_;
 	HBLog hbLog_;
 	StatSample statIncSyncStep_;
+	TimerList *flushTimer_;
+	ReplicationServer *replServer_;
+	// writer position followers were last woken up at
+	uint64_t replNotifiedJid_;
 };
 
 #endif
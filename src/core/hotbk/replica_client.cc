@@ -0,0 +1,231 @@
+/*
+* Copyright [2021] JD.com, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#include "replica_client.h"
+#include "poll/poller_base.h"
+#include "algorithm/timestamp.h"
+#include "buffer_process_ask_chain.h"
+#include "log/log.h"
+
+ReplicaClient::ReplicaClient(PollerBase *o, BufferProcessAskChain *cache,
+			     int retry)
+	: ReplicationLink(o, -1), owner_(o), cache_(cache), retry_timer_(NULL),
+	  pos_timer_(NULL), pos_saver_(this), pos_fd_(-1), saved_jid_(0),
+	  connecting_(false)
+{
+	retry_timer_ = owner_->get_timer_list(retry > 0 ? retry : 1);
+	pos_timer_ = owner_->get_timer_list_by_m_seconds(REPL_POS_SAVE_INTERVAL);
+
+	stat_applied_ =
+		g_stat_mgr.get_stat_int_counter(HBP_REPL_APPLIED_RECORDS);
+	stat_apply_errors_ =
+		g_stat_mgr.get_stat_int_counter(HBP_REPL_APPLY_ERRORS);
+	stat_staleness_ = g_stat_mgr.get_sample(HBP_REPL_STALENESS_USEC);
+}
+
+ReplicaClient::~ReplicaClient()
+{
+	if (pos_fd_ >= 0) {
+		save_position();
+		close(pos_fd_);
+	}
+}
+
+int ReplicaClient::do_init(const char *master, const char *pos_file)
+{
+	std::string host(master);
+	std::string::size_type p = host.rfind(':');
+	if (p == std::string::npos) {
+		log4cplus_error("bad replication master address: %s", master);
+		return -1;
+	}
+	const char *err = master_.set_address(host.substr(0, p).c_str(),
+					      host.substr(p + 1).c_str());
+	if (err != NULL) {
+		log4cplus_error("bad replication master address %s: %s",
+				master, err);
+		return -1;
+	}
+
+	pos_fd_ = open(pos_file, O_RDWR | O_CREAT, 0644);
+	if (pos_fd_ < 0) {
+		log4cplus_error("open replication position file %s: %m",
+				pos_file);
+		return -1;
+	}
+	uint64_t v = 0;
+	if (pread(pos_fd_, &v, sizeof(v), 0) == sizeof(v))
+		jid_ = v;
+	saved_jid_ = (uint64_t)jid_;
+
+	// 没有位置时只有空cache可以从master当前位置开始跟随
+	if (jid_.Zero() && !cache_->buffer_empty()) {
+		log4cplus_error(
+			"replica has data but no position in %s, full sync needed",
+			pos_file);
+		return -1;
+	}
+
+	log4cplus_info("replica of %s, start at serial=%u, offset=%u", master,
+		       jid_.serial, jid_.offset);
+	pos_saver_.attach_timer(pos_timer_);
+	return connect_master();
+}
+
+int ReplicaClient::connect_master(void)
+{
+	netfd = master_.create_socket();
+	if (netfd < 0) {
+		log4cplus_error("create replication socket: %m");
+		attach_timer(retry_timer_);
+		return 0;
+	}
+	fcntl(netfd, F_SETFL, O_RDWR | O_NONBLOCK);
+	int optval = 1;
+	setsockopt(netfd, SOL_SOCKET, SO_KEEPALIVE, &optval, sizeof(optval));
+
+	if (master_.connect_socket(netfd) < 0 && errno != EINPROGRESS) {
+		log4cplus_info("connect replication master %s: %m",
+			       master_.Name());
+		close(netfd);
+		netfd = -1;
+		attach_timer(retry_timer_);
+		return 0;
+	}
+
+	connecting_ = true;
+	disable_input();
+	enable_output();
+	return attach_poller();
+}
+
+void ReplicaClient::output_notify(void)
+{
+	if (!connecting_) {
+		ReplicationLink::output_notify();
+		return;
+	}
+
+	int err = 0;
+	socklen_t len = sizeof(err);
+	getsockopt(netfd, SOL_SOCKET, SO_ERROR, &err, &len);
+	if (err != 0) {
+		errno = err;
+		log4cplus_info("connect replication master %s: %m",
+			       master_.Name());
+		close_link();
+		return;
+	}
+
+	connecting_ = false;
+	enable_input();
+	if (send_frame(REPL_SUBSCRIBE, jid_.Zero() ? REPL_FROM_TAIL : 0,
+		       (uint64_t)jid_, 0, NULL, 0) < 0)
+		close_link();
+}
+
+void ReplicaClient::on_close(void)
+{
+	save_position();
+	connecting_ = false;
+	attach_timer(retry_timer_);
+}
+
+void ReplicaClient::job_timer_procedure(void)
+{
+	connect_master();
+}
+
+int ReplicaClient::on_frame(const repl_frame_t &frame, const char *payload)
+{
+	switch (frame.type) {
+	case REPL_BATCH:
+		if (apply_batch(frame, payload) != 0)
+			return -1;
+		return send_frame(REPL_ACK, 0, (uint64_t)jid_, 0, NULL, 0);
+	case REPL_RESET: {
+		JournalID tail(frame.jid);
+		log4cplus_error(
+			"master lost replica position[serial=%u, offset=%u], tail[serial=%u, offset=%u], full sync needed",
+			jid_.serial, jid_.offset, tail.serial, tail.offset);
+		return -1;
+	}
+	default:
+		log4cplus_error("unexpected replication frame type: %d",
+				frame.type);
+		return -1;
+	}
+}
+
+int ReplicaClient::apply_batch(const repl_frame_t &frame, const char *payload)
+{
+	const char *p = payload, *end = payload + frame.length;
+
+	for (uint32_t i = 0; i < frame.count; i++) {
+		const repl_record_t *rec = (const repl_record_t *)p;
+		if (end - p < (long)sizeof(*rec) ||
+		    end - p - sizeof(*rec) < (size_t)rec->key_len + rec->value_len) {
+			log4cplus_error("replication batch broken at record %u",
+					i);
+			return -1;
+		}
+		const char *key = p + sizeof(*rec);
+		const char *value = key + rec->key_len;
+		if (cache_->replica_apply(rec->type, rec->flag, key,
+					  rec->key_len, value,
+					  rec->value_len) != 0)
+			++stat_apply_errors_;
+		else
+			++stat_applied_;
+		p = value + rec->value_len;
+	}
+
+	stat_staleness_.push(GET_TIMESTAMP() - frame.timestamp);
+	jid_ = frame.jid;
+	return 0;
+}
+
+void ReplicaClient::PositionTimer::job_timer_procedure(void)
+{
+	client_->save_position();
+	attach_timer(client_->pos_timer_);
+}
+
+/*
+ * 位置只在批次应用之后前进，落盘的位置不会超过已应用的数据
+ */
+int ReplicaClient::save_position(void)
+{
+	uint64_t v = jid_;
+	if (v == saved_jid_)
+		return 0;
+	if (pwrite(pos_fd_, &v, sizeof(v), 0) != sizeof(v)) {
+		log4cplus_error("save replication position: %m");
+		return -1;
+	}
+	if (fdatasync(pos_fd_) != 0) {
+		log4cplus_error("sync replication position: %m");
+		return -1;
+	}
+	saved_jid_ = v;
+	return 0;
+}
@@ -0,0 +1,84 @@
+/*
+* Copyright [2021] JD.com, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef __DTC_REPLICA_CLIENT_H
+#define __DTC_REPLICA_CLIENT_H
+
+#include "replication.h"
+#include "journal_id.h"
+#include "socket/socket_addr.h"
+#include "timer/timer_list.h"
+#include "stat_dtc.h"
+
+class PollerBase;
+class BufferProcessAskChain;
+
+/*
+ * follower端，运行在cache线程中。
+ * 连接master的ReplicationServer，将收到的binlog批次直接应用到本地cache，
+ * 每批应用完成后回ACK。断线后按retry秒重连并从记录的位置续传。
+ * 位置每REPL_POS_SAVE_INTERVAL毫秒落盘一次，不在每批之后fdatasync；
+ * 崩溃后从较早的位置重放，记录都是整节点替换或删除，重复应用结果不变。
+ */
+#define REPL_POS_SAVE_INTERVAL 1000
+class ReplicaClient : public ReplicationLink, private TimerObject {
+    public:
+	ReplicaClient(PollerBase *o, BufferProcessAskChain *cache, int retry);
+	virtual ~ReplicaClient();
+
+	int do_init(const char *master, const char *pos_file);
+	virtual void output_notify(void);
+
+    protected:
+	virtual int on_frame(const repl_frame_t &frame, const char *payload);
+	virtual void on_close(void);
+
+    private:
+	virtual void job_timer_procedure(void);
+	int connect_master(void);
+	int apply_batch(const repl_frame_t &frame, const char *payload);
+	int save_position(void);
+
+	class PositionTimer : public TimerObject {
+	    public:
+		PositionTimer(ReplicaClient *c) : client_(c)
+		{
+		}
+		virtual void job_timer_procedure(void);
+
+	    private:
+		ReplicaClient *client_;
+	};
+
+    private:
+	PollerBase *owner_;
+	BufferProcessAskChain *cache_;
+	TimerList *retry_timer_;
+	TimerList *pos_timer_;
+	PositionTimer pos_saver_;
+	SocketAddress master_;
+	int pos_fd_;
+	JournalID jid_;
+	// 已落盘的位置
+	uint64_t saved_jid_;
+	bool connecting_;
+
+	StatCounter stat_applied_;
+	StatCounter stat_apply_errors_;
+	StatSample stat_staleness_;
+};
+
+#endif
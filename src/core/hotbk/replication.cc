@@ -0,0 +1,171 @@
+/*
+* Copyright [2021] JD.com, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+
+#include "replication.h"
+#include "algorithm/timestamp.h"
+#include "log/log.h"
+
+ReplicationLink::ReplicationLink(EpollOperation *o, int fd)
+	: EpollBase(o, fd), out_sent_(0)
+{
+}
+
+ReplicationLink::~ReplicationLink()
+{
+}
+
+void ReplicationLink::append_record(std::string &out, int type, int flag,
+				    const char *key, int key_len,
+				    const char *value, int value_len)
+{
+	repl_record_t rec;
+	rec.type = type;
+	rec.flag = flag;
+	rec.key_len = key_len;
+	rec.value_len = value_len;
+	out.append((const char *)&rec, sizeof(rec));
+	out.append(key, key_len);
+	if (value_len > 0)
+		out.append(value, value_len);
+}
+
+int ReplicationLink::send_frame(int type, int flag, uint64_t jid,
+				uint32_t count, const char *payload,
+				uint32_t len)
+{
+	repl_frame_t frame;
+	frame.magic = REPL_MAGIC;
+	frame.type = type;
+	frame.flag = flag;
+	frame.length = len;
+	frame.count = count;
+	frame.jid = jid;
+	frame.timestamp = GET_TIMESTAMP();
+
+	// compact sent bytes before growing the buffer
+	if (out_sent_ > 0 && out_sent_ == out_.size()) {
+		out_.clear();
+		out_sent_ = 0;
+	}
+	out_.append((const char *)&frame, sizeof(frame));
+	if (len > 0)
+		out_.append(payload, len);
+	return flush_output();
+}
+
+int ReplicationLink::flush_output(void)
+{
+	while (out_sent_ < out_.size()) {
+		ssize_t n = write(netfd, out_.data() + out_sent_,
+				  out_.size() - out_sent_);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			if (errno == EAGAIN)
+				break;
+			log4cplus_info("replication link write error: %m");
+			return -1;
+		}
+		out_sent_ += n;
+	}
+
+	if (out_sent_ == out_.size()) {
+		out_.clear();
+		out_sent_ = 0;
+		disable_output();
+	} else {
+		enable_output();
+	}
+	return delay_apply_events();
+}
+
+void ReplicationLink::close_link(void)
+{
+	detach_poller();
+	if (netfd >= 0)
+		close(netfd);
+	netfd = -1;
+	in_.clear();
+	out_.clear();
+	out_sent_ = 0;
+	on_close();
+}
+
+void ReplicationLink::input_notify(void)
+{
+	char buf[65536];
+
+	for (;;) {
+		ssize_t n = read(netfd, buf, sizeof(buf));
+		if (n == 0) {
+			log4cplus_info("replication peer closed");
+			close_link();
+			return;
+		}
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			if (errno == EAGAIN)
+				break;
+			log4cplus_info("replication link read error: %m");
+			close_link();
+			return;
+		}
+		in_.append(buf, n);
+		if ((size_t)n < sizeof(buf))
+			break;
+	}
+
+	size_t off = 0;
+	while (in_.size() - off >= sizeof(repl_frame_t)) {
+		const repl_frame_t *frame =
+			(const repl_frame_t *)(in_.data() + off);
+		if (frame->magic != REPL_MAGIC ||
+		    frame->length > REPL_MAX_FRAME) {
+			log4cplus_error("bad replication frame, magic: %x",
+					frame->magic);
+			close_link();
+			return;
+		}
+		if (in_.size() - off < sizeof(repl_frame_t) + frame->length)
+			break;
+
+		repl_frame_t head = *frame;
+		if (on_frame(head, in_.data() + off + sizeof(repl_frame_t)) <
+		    0) {
+			close_link();
+			return;
+		}
+		off += sizeof(repl_frame_t) + head.length;
+	}
+	in_.erase(0, off);
+}
+
+void ReplicationLink::output_notify(void)
+{
+	if (flush_output() < 0)
+		close_link();
+}
+
+void ReplicationLink::hangup_notify(void)
+{
+	log4cplus_info("replication link hangup");
+	close_link();
+}
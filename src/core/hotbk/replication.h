@@ -0,0 +1,104 @@
+/*
+* Copyright [2021] JD.com, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef __DTC_REPLICATION_H
+#define __DTC_REPLICATION_H
+
+#include <stdint.h>
+#include <string>
+
+#include "poll/poller.h"
+
+/*
+ * 内置主从复制的线路格式。
+ *
+ * 每一帧为 repl_frame_t + payload:
+ *     SUBSCRIBE  follower -> master, jid为起始位置
+ *     BATCH      master -> follower, jid为本批之后的位置, payload为count条记录
+ *     ACK        follower -> master, jid为已应用的位置
+ *     RESET      master -> follower, 无法从请求的位置续传, jid为master当前位置
+ *
+ * 记录格式: repl_record_t + key + value
+ */
+#define REPL_MAGIC 0x50455244 /* DREP */
+
+enum { REPL_SUBSCRIBE = 1,
+       REPL_BATCH = 2,
+       REPL_ACK = 3,
+       REPL_RESET = 4,
+};
+
+// SUBSCRIBE flag, follower has no position, start from master's tail
+#define REPL_FROM_TAIL 0x1
+
+typedef struct repl_frame {
+	uint32_t magic;
+	uint16_t type;
+	uint16_t flag;
+	uint32_t length; // payload length
+	uint32_t count; // records in payload
+	uint64_t jid;
+	int64_t timestamp; // usec, master send time
+} __attribute__((packed)) repl_frame_t;
+
+typedef struct repl_record {
+	uint16_t type; // DTCHotBackup::SYNC_*
+	uint16_t flag; // DTCHotBackup::HAS_VALUE ...
+	uint32_t key_len;
+	uint32_t value_len;
+} __attribute__((packed)) repl_record_t;
+
+#define REPL_MAX_FRAME (64 << 20)
+
+/*
+ * 非阻塞的帧收发连接，master会话与follower共用
+ */
+class ReplicationLink : public EpollBase {
+    public:
+	ReplicationLink(EpollOperation *o, int fd);
+	virtual ~ReplicationLink();
+
+	virtual void input_notify(void);
+	virtual void output_notify(void);
+	virtual void hangup_notify(void);
+
+	int send_frame(int type, int flag, uint64_t jid, uint32_t count,
+		       const char *payload, uint32_t len);
+	int pending_output(void) const
+	{
+		return out_.size() - out_sent_;
+	}
+
+	void close_link(void);
+
+	static void append_record(std::string &out, int type, int flag,
+				  const char *key, int key_len,
+				  const char *value, int value_len);
+
+    protected:
+	// 0: continue, <0: close link
+	virtual int on_frame(const repl_frame_t &frame, const char *payload) = 0;
+	// connection is broken, the link closes its fd
+	virtual void on_close(void) = 0;
+	int flush_output(void);
+
+    private:
+	std::string in_;
+	std::string out_;
+	size_t out_sent_;
+};
+
+#endif
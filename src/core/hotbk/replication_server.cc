@@ -0,0 +1,224 @@
+/*
+* Copyright [2021] JD.com, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <errno.h>
+#include <string.h>
+#include <sys/socket.h>
+
+#include "replication_server.h"
+#include "poll/poller_base.h"
+#include "algorithm/timestamp.h"
+#include "log/log.h"
+
+// stop reading binlog while the socket can't keep up
+#define REPL_MAX_PENDING_OUTPUT (8 << 20)
+
+ReplicationSession::ReplicationSession(ReplicationServer *s, int fd)
+	: ReplicationLink(s->owner_, fd), server_(s), reader_(NULL),
+	  subscribed_(false)
+{
+}
+
+ReplicationSession::~ReplicationSession()
+{
+	DELETE(reader_);
+}
+
+int ReplicationSession::on_frame(const repl_frame_t &frame,
+				 const char *payload)
+{
+	switch (frame.type) {
+	case REPL_SUBSCRIBE:
+		return subscribe(frame);
+	case REPL_ACK:
+		return acknowledge(frame);
+	default:
+		log4cplus_error("unexpected replication frame type: %d",
+				frame.type);
+		return -1;
+	}
+}
+
+void ReplicationSession::on_close(void)
+{
+	server_->remove(this);
+	delete this;
+}
+
+int ReplicationSession::subscribe(const repl_frame_t &frame)
+{
+	if (subscribed_) {
+		log4cplus_error("duplicate replication subscribe");
+		return -1;
+	}
+
+	HBLog *log = server_->log_;
+	// readers work on the file, make buffered records visible first
+	log->flush();
+
+	JournalID jid(frame.jid);
+	if (frame.flag & REPL_FROM_TAIL)
+		jid = log->get_writer_jid();
+
+	reader_ = log->new_reader();
+	if (reader_ == NULL)
+		return -1;
+
+	if (jid.Zero() || reader_->Seek(jid) != 0) {
+		JournalID tail = log->get_writer_jid();
+		log4cplus_error(
+			"replication follower position[serial=%u, offset=%u] not in binlog, full sync needed",
+			jid.serial, jid.offset);
+		return send_frame(REPL_RESET, 0, (uint64_t)tail, 0, NULL, 0);
+	}
+
+	log4cplus_info("replication follower subscribed at serial=%u, offset=%u",
+		       jid.serial, jid.offset);
+	subscribed_ = true;
+	return pump();
+}
+
+int ReplicationSession::acknowledge(const repl_frame_t &frame)
+{
+	int64_t now = GET_TIMESTAMP();
+	while (!inflight_.empty() && inflight_.front().jid <= frame.jid) {
+		server_->stat_ack_usec_.push(now - inflight_.front().sent);
+		inflight_.pop_front();
+	}
+	return pump();
+}
+
+int ReplicationSession::pump(void)
+{
+	if (!subscribed_)
+		return 0;
+
+	while ((int)inflight_.size() < server_->window_ &&
+	       pending_output() < REPL_MAX_PENDING_OUTPUT) {
+		batch_.clear();
+		BatchEncodeVisitor visitor(batch_);
+		int n = server_->log_->read_rows(reader_, server_->batch_,
+						 visitor);
+		if (n < 0) {
+			log4cplus_error("replication read binlog failed");
+			return -1;
+		}
+		if (n == 0)
+			break;
+
+		inflight_t f = { (uint64_t)reader_->query_id(),
+				 GET_TIMESTAMP() };
+		inflight_.push_back(f);
+		server_->stat_sent_records_ += visitor.rows;
+		if (send_frame(REPL_BATCH, 0, f.jid, visitor.rows,
+			       batch_.data(), batch_.size()) < 0)
+			return -1;
+	}
+	return 0;
+}
+
+ReplicationServer::ReplicationServer(PollerBase *o, HBLog *log)
+	: owner_(o), log_(log), window_(8), batch_(256)
+{
+	stat_followers_ = g_stat_mgr.get_stat_int_counter(HBP_REPL_FOLLOWERS);
+	stat_sent_records_ =
+		g_stat_mgr.get_stat_int_counter(HBP_REPL_SENT_RECORDS);
+	stat_ack_usec_ = g_stat_mgr.get_sample(HBP_REPL_ACK_USEC);
+}
+
+ReplicationServer::~ReplicationServer()
+{
+	while (!sessions_.empty()) {
+		ReplicationSession *s = sessions_.front();
+		sessions_.pop_front();
+		delete s;
+	}
+}
+
+int ReplicationServer::do_init(const char *bind_addr, int window, int batch)
+{
+	window_ = window > 0 ? window : 1;
+	batch_ = batch > 0 ? batch : 1;
+
+	std::string host(bind_addr);
+	std::string::size_type p = host.rfind(':');
+	if (p == std::string::npos) {
+		log4cplus_error("bad replication listen address: %s",
+				bind_addr);
+		return -1;
+	}
+	const char *err = addr_.set_address(host.substr(0, p).c_str(),
+					    host.substr(p + 1).c_str());
+	if (err != NULL) {
+		log4cplus_error("bad replication listen address %s: %s",
+				bind_addr, err);
+		return -1;
+	}
+
+	netfd = socket_bind(&addr_, 16, 0, 0, 1 /*reuse*/, 1 /*nodelay*/,
+			    0 /*defer_accept*/);
+	if (netfd < 0)
+		return -1;
+
+	enable_input();
+	return attach_poller(owner_);
+}
+
+void ReplicationServer::input_notify(void)
+{
+	for (;;) {
+		struct sockaddr peer;
+		socklen_t size = sizeof(peer);
+		int fd = accept(netfd, &peer, &size);
+		if (fd < 0) {
+			if (errno != EINTR && errno != EAGAIN)
+				log4cplus_info("replication accept failed: %m");
+			break;
+		}
+
+		int optval = 1;
+		setsockopt(fd, SOL_SOCKET, SO_KEEPALIVE, &optval,
+			   sizeof(optval));
+		ReplicationSession *s = new ReplicationSession(this, fd);
+		s->enable_input();
+		if (s->attach_poller() != 0) {
+			log4cplus_error("replication session attach failed");
+			delete s;
+			continue;
+		}
+		sessions_.push_back(s);
+		stat_followers_ = sessions_.size();
+		log4cplus_info("replication follower connected, fd: %d", fd);
+	}
+}
+
+void ReplicationServer::wakeup(void)
+{
+	std::list<ReplicationSession *>::iterator it, next;
+	for (it = sessions_.begin(); it != sessions_.end(); it = next) {
+		next = it;
+		++next;
+		if ((*it)->pump() < 0)
+			(*it)->close_link();
+	}
+}
+
+void ReplicationServer::remove(ReplicationSession *s)
+{
+	sessions_.remove(s);
+	stat_followers_ = sessions_.size();
+	log4cplus_info("replication follower disconnected");
+}
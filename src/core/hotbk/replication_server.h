@@ -0,0 +1,123 @@
+/*
+* Copyright [2021] JD.com, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef __DTC_REPLICATION_SERVER_H
+#define __DTC_REPLICATION_SERVER_H
+
+#include <list>
+#include <deque>
+
+#include "replication.h"
+#include "hb_log.h"
+#include "socket/socket_addr.h"
+#include "stat_dtc.h"
+
+class PollerBase;
+class ReplicationServer;
+
+/*
+ * 单批数据量上限。一条binlog记录解码后小于BINLOG_MAX_RAW_SIZE，
+ * 超过上限后不再读下一条记录，整批一定小于REPL_MAX_FRAME
+ */
+#define REPL_MAX_BATCH (REPL_MAX_FRAME / 2)
+
+//将binlog行编码为复制记录
+class BatchEncodeVisitor : public HBLogVisitor {
+    public:
+	BatchEncodeVisitor(std::string &out) : out_(out), rows(0)
+	{
+	}
+	virtual int on_row(RowValue &r)
+	{
+		ReplicationLink::append_record(out_, r[0].u64, r[1].u64,
+					       r[2].bin.ptr, r[2].bin.len,
+					       r[3].bin.ptr, r[3].bin.len);
+		++rows;
+		return 0;
+	}
+	virtual bool full(void)
+	{
+		return out_.size() >= REPL_MAX_BATCH;
+	}
+
+    private:
+	std::string &out_;
+
+    public:
+	int rows;
+};
+
+/*
+ * 一个follower连接。每个会话持有独立的BinlogReader，
+ * 在途(未确认)批次不超过window个。
+ */
+class ReplicationSession : public ReplicationLink {
+    public:
+	ReplicationSession(ReplicationServer *s, int fd);
+	virtual ~ReplicationSession();
+
+	// send batches until the window is full or the log is drained
+	int pump(void);
+
+    protected:
+	virtual int on_frame(const repl_frame_t &frame, const char *payload);
+	virtual void on_close(void);
+
+    private:
+	int subscribe(const repl_frame_t &frame);
+	int acknowledge(const repl_frame_t &frame);
+
+    private:
+	struct inflight_t {
+		uint64_t jid;
+		int64_t sent;
+	};
+
+	ReplicationServer *server_;
+	BinlogReader *reader_;
+	std::deque<inflight_t> inflight_;
+	std::string batch_;
+	bool subscribed_;
+};
+
+class ReplicationServer : public EpollBase {
+    public:
+	ReplicationServer(PollerBase *o, HBLog *log);
+	virtual ~ReplicationServer();
+
+	int do_init(const char *bind_addr, int window, int batch);
+	virtual void input_notify(void);
+
+	// new binlog records are visible on disk
+	void wakeup(void);
+
+    private:
+	friend class ReplicationSession;
+	void remove(ReplicationSession *s);
+
+	PollerBase *owner_;
+	HBLog *log_;
+	SocketAddress addr_;
+	int window_;
+	int batch_;
+	std::list<ReplicationSession *> sessions_;
+
+	StatCounter stat_followers_;
+	StatCounter stat_sent_records_;
+	StatSample stat_ack_usec_;
+};
+
+#endif
@@ -21,9 +21,13 @@
 #include <stdio.h>
 #include <time.h>
 #include <strings.h>
+#include <errno.h>
 #include "logger.h"
 #include "log/log.h"
 #include "global.h"
+#include "algorithm/timestamp.h"
+#include "algorithm/crc32c.h"
+#include "zlib.h"
 
 LogBase::LogBase() : _fd(-1)
 {
@@ -150,12 +154,56 @@ void LogBase::file_name(char *s, int len, unsigned serial)
 LogWriter::LogWriter()
 	: LogBase(), _cur_size(0), _max_size(0), _total_size(0),
 	  _cur_max_serial(0), //serial start 0
-	  _cur_min_serial(0) //serial start 0
+	  _cur_min_serial(0), //serial start 0
+	  _group_buf(0), _group_cap(0), _group_len(0), _group_records(0),
+	  _group_since(0), _sync_policy(LOG_SYNC_NONE), _sync_interval(0),
+	  _last_sync(0), _unsynced(0), _listener(0)
 {
+	_stat_write_bytes = g_stat_mgr.get_stat_int_counter(HBP_WRITE_BYTES);
+	_stat_group_records = g_stat_mgr.get_sample(HBP_GROUP_RECORDS);
+	_stat_group_delay = g_stat_mgr.get_sample(HBP_GROUP_DELAY_USEC);
 }
 
 LogWriter::~LogWriter()
 {
+	_listener = 0;
+	if (flush())
+		log4cplus_error("binlog records lost on close: %u",
+				_group_records);
+	if (_group_buf)
+		free(_group_buf);
+}
+
+int LogWriter::set_group_commit(size_t group_size, int sync_policy,
+				int sync_interval)
+{
+	if (flush())
+		return -1;
+
+	if (_group_buf) {
+		free(_group_buf);
+		_group_buf = 0;
+	}
+	_group_cap = 0;
+
+	if (group_size > 0) {
+		//按页对齐，便于内核整页拷贝
+		group_size = (group_size + 4095) & ~(size_t)4095;
+		if (posix_memalign((void **)&_group_buf, 4096, group_size)) {
+			log4cplus_error("alloc group commit buffer failed, %m");
+			_group_buf = 0;
+			return -1;
+		}
+		_group_cap = group_size;
+	}
+
+	_sync_policy = sync_policy;
+	_sync_interval = sync_interval;
+	_last_sync = GET_TIMESTAMP();
+
+	log4cplus_info("binlog group commit size:%u, sync policy:%d, interval:%d",
+		       (unsigned int)_group_cap, _sync_policy, _sync_interval);
+	return 0;
 }
 
 int LogWriter::open(const char *path, const char *prefix, off_t max_size,
@@ -176,24 +224,112 @@ int LogWriter::open(const char *path, const char *prefix, off_t max_size,
 	return open_file(_cur_max_serial, 0);
 }
 
+/*
+ * 写满size字节才算成功，失败时截掉已写入的半条，文件里只留完整的记录
+ */
+int LogWriter::write_file(const void *buf, size_t size, uint32_t records)
+{
+	const char *p = (const char *)buf;
+	size_t left = size;
+	off_t start = lseek(_fd, 0, SEEK_CUR);
+
+	while (left > 0) {
+		ssize_t n = ::write(_fd, p, left);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0) {
+			log4cplus_error(
+				"wirte hblog[input size %u, write success size %u] err, %m",
+				(unsigned int)size, (unsigned int)(size - left));
+			if (start >= 0 && ftruncate(_fd, start) == 0)
+				lseek(_fd, start, SEEK_SET);
+			return -1;
+		}
+		p += n;
+		left -= n;
+	}
+
+	_stat_write_bytes += size;
+	_stat_group_records.push(records);
+	return 0;
+}
+
+int LogWriter::sync_file()
+{
+	int64_t now = GET_TIMESTAMP();
+	if (_sync_policy == LOG_SYNC_GROUP ||
+	    (_sync_policy == LOG_SYNC_INTERVAL &&
+	     now - _last_sync >= (int64_t)_sync_interval * 1000)) {
+		if (fdatasync(_fd)) {
+			log4cplus_error("fdatasync hblog failed, %m");
+			return -1;
+		}
+		_last_sync = now;
+	}
+	return 0;
+}
+
 int LogWriter::write(const void *buf, size_t size)
 {
-	unsigned int unused;
+	if (_group_cap == 0 || size > _group_cap) {
+		//未开启组提交或超大记录，直接写盘
+		if (flush() || write_file(buf, size, 1))
+			return -1;
+		_cur_size += size;
+		if (sync_file())
+			return -1;
+	} else {
+		//缓冲区写不出去时不再接收新记录
+		if (_group_len + size > _group_cap && flush())
+			return -1;
 
-	unused = ::write(_fd, buf, size);
-	if (unused != size) {
-		//		log4cplus_error("wirte hblog[input size %u, write success size %d] err", size, unused);
-		log4cplus_error(
-			"wirte hblog[input size %u, write success size %u] err, %m",
-			(unsigned int)size, unused);
+		if (_group_len == 0)
+			_group_since = GET_TIMESTAMP();
+		memcpy(_group_buf + _group_len, buf, size);
+		_group_len += size;
+		_group_records++;
+		_cur_size += size;
 	}
-	_cur_size += size;
+
+	if (_cur_size < _max_size)
+		return 0;
+
+	//记录必须落在其JournalID对应的文件里，切换前先写盘。
+	//写盘失败时本条记录已在缓冲区里，下次写入时再切换
+	if (flush())
+		return 0;
 	return shift_file();
 }
 
+int LogWriter::flush()
+{
+	if (_group_len == 0 && !_unsynced)
+		return 0;
+
+	if (_group_len > 0) {
+		//写盘失败的记录留在缓冲区，write_file已截掉半条，下次原位重写
+		if (write_file(_group_buf, _group_len, _group_records))
+			return -1;
+		_stat_group_delay.push(GET_TIMESTAMP() - _group_since);
+		_group_len = 0;
+		_group_records = 0;
+	}
+
+	//已写入文件的记录不再重写，fsync失败时下次flush()重试
+	_unsynced = 1;
+	if (sync_file())
+		return -1;
+	_unsynced = 0;
+
+	if (_listener)
+		_listener->on_log_flushed();
+	return 0;
+}
+
 JournalID LogWriter::query()
 {
-	JournalID v(_cur_max_serial, _cur_size);
+	//不含缓冲区里未写盘的记录
+	JournalID v(_cur_max_serial, _cur_size - _group_len);
 	return v;
 }
 
@@ -341,9 +477,13 @@ int LogReader::seek(const JournalID &v)
 	return 0;
 }
 
-BinlogWriter::BinlogWriter() : _log_writer()
-
+BinlogWriter::BinlogWriter()
+	: _log_writer(), _version(BINLOG_DEFAULT_VERSION),
+	  _compress_threshold(BINLOG_COMPRESS_THRESHOLD)
 {
+	_stat_raw_bytes = g_stat_mgr.get_stat_int_counter(HBP_BINLOG_RAW_BYTES);
+	_stat_stored_bytes =
+		g_stat_mgr.get_stat_int_counter(HBP_BINLOG_STORED_BYTES);
 }
 
 BinlogWriter::~BinlogWriter()
@@ -358,45 +498,129 @@ int BinlogWriter::init(const char *path, const char *prefix, uint64_t total,
 
 #define struct_sizeof(t) sizeof(((binlog_header_t *)NULL)->t)
 #define struct_typeof(t) typeof(((binlog_header_t *)NULL)->t)
+#define header_size offsetof(binlog_header_t, endof)
+
+int BinlogWriter::set_format(uint8_t version, uint32_t compress_threshold)
+{
+	if (version != BINLOG_DEFAULT_VERSION && version != BINLOG_CRC_VERSION) {
+		log4cplus_error("unsupported binlog version: %d", version);
+		return -1;
+	}
+
+	_version = version;
+	_compress_threshold = compress_threshold;
+	return 0;
+}
 
 int BinlogWriter::insert_header(uint8_t type, uint8_t operater, uint32_t count)
 {
 	_codec_buffer.clear();
 
-	_codec_buffer.expand(offsetof(binlog_header_t, endof));
+	_codec_buffer.expand(header_size + sizeof(uint32_t));
 
 	_codec_buffer << (struct_typeof(length))0; //length
-	_codec_buffer
-		<< (struct_typeof(version))BINLOG_DEFAULT_VERSION; //version
+	_codec_buffer << (struct_typeof(version))_version; //version
 	_codec_buffer << (struct_typeof(type))type; //type
 	_codec_buffer << (struct_typeof(operater))operater; //operator
-	_codec_buffer.append("\0\0\0\0\0", 5); //reserve char[5]
+	_codec_buffer << (struct_typeof(codec))BINLOG_CODEC_NONE; //codec
+	_codec_buffer.append("\0\0\0\0", 4); //reserve char[4]
 	_codec_buffer << (struct_typeof(timestamp))(time(NULL)); //timestamp
 	_codec_buffer << (struct_typeof(recordcount))count; //recordcount
 
+	//version 3: 解压后body的长度，commit时回填
+	if (_version >= BINLOG_CRC_VERSION)
+		_codec_buffer << (uint32_t)0;
+
 	return 0;
 }
 
 int BinlogWriter::append_body(const void *buf, size_t size)
 {
 	_codec_buffer.append((char *)&size, struct_sizeof(length));
+	if (_version >= BINLOG_CRC_VERSION)
+		_codec_buffer.append(crc32c(0, buf, size));
 	_codec_buffer.append((const char *)buf, size);
 
 	return 0;
 }
 
+/*
+ * version 3 binlog format:
+ *
+ * ======================================================================
+ *  binlog_header_t | raw_len | payload
+ * ======================================================================
+ *
+ * payload is (codec compressed) len1 | crc1 | record1 | len2 | crc2 | ...
+ */
+int BinlogWriter::compress_body()
+{
+	const uint32_t offset = header_size + sizeof(uint32_t);
+	uint32_t raw_len = _codec_buffer.size() - offset;
+	if (raw_len >= BINLOG_MAX_RAW_SIZE) {
+		log4cplus_error("binlog body too large: %u", raw_len);
+		return -1;
+	}
+	*(uint32_t *)(_codec_buffer.c_str() + header_size) = raw_len;
+
+	_stat_raw_bytes += raw_len;
+	if (_compress_threshold == 0 || raw_len < _compress_threshold) {
+		_stat_stored_bytes += raw_len;
+		return 0;
+	}
+
+	uLongf zip_len = compressBound(raw_len);
+	_zip_buffer.clear();
+	if (_zip_buffer.resize(offset + zip_len) < 0)
+		return -1;
+
+	if (compress2((Bytef *)_zip_buffer.c_str() + offset, &zip_len,
+		      (const Bytef *)_codec_buffer.c_str() + offset, raw_len,
+		      1) != Z_OK ||
+	    zip_len >= raw_len) {
+		//压缩无收益，原样存储
+		_stat_stored_bytes += raw_len;
+		return 0;
+	}
+
+	memcpy(_zip_buffer.c_str(), _codec_buffer.c_str(), offset);
+	((binlog_header_t *)_zip_buffer.c_str())->codec = BINLOG_CODEC_ZLIB;
+	_zip_buffer.resize(offset + zip_len);
+	_stat_stored_bytes += zip_len;
+	return 1;
+}
+
 int BinlogWriter::Commit()
 {
+	buffer *out = &_codec_buffer;
+	if (_version >= BINLOG_CRC_VERSION) {
+		int ret = compress_body();
+		if (ret < 0) {
+			log4cplus_error("compress binlog body failed");
+			_codec_buffer.clear();
+			return -1;
+		}
+		if (ret > 0)
+			out = &_zip_buffer;
+	}
+
 	//计算总长度
-	uint32_t total = _codec_buffer.size();
+	uint32_t total = out->size();
 	total -= struct_sizeof(length);
 
+	//读者不接受超长记录，写进去会让读者永远停在这里
+	if (total >= BINLOG_MAX_RECORD_SIZE) {
+		log4cplus_error("binlog record too large: %u", total);
+		_codec_buffer.clear();
+		return -1;
+	}
+
 	//写入总长度
 	struct_typeof(length) *length =
-		(struct_typeof(length) *)(_codec_buffer.c_str());
+		(struct_typeof(length) *)(out->c_str());
 	*length = total;
 
-	return _log_writer.write(_codec_buffer.c_str(), _codec_buffer.size());
+	return _log_writer.write(out->c_str(), out->size());
 }
 
 int BinlogWriter::Abort()
@@ -410,8 +634,22 @@ JournalID BinlogWriter::query_id()
 	return _log_writer.query();
 }
 
+int BinlogWriter::set_group_commit(size_t group_size, int sync_policy,
+				   int sync_interval)
+{
+	return _log_writer.set_group_commit(group_size, sync_policy,
+					    sync_interval);
+}
+
+int BinlogWriter::Flush()
+{
+	return _log_writer.flush();
+}
+
 BinlogReader::BinlogReader() : _log_reader()
 {
+	_stat_decode_usec = g_stat_mgr.get_sample(HBP_BINLOG_DECODE_USEC);
+	_stat_crc_errors = g_stat_mgr.get_stat_int_counter(HBP_BINLOG_CRC_ERRORS);
 }
 BinlogReader::~BinlogReader()
 {
@@ -435,7 +673,7 @@ int BinlogReader::Read()
 
 	struct_typeof(length) len =
 		*(struct_typeof(length) *)_codec_buffer.c_str();
-	if (len < 8 || len >= (1 << 20) /*1M*/) {
+	if (len < 8 || len >= BINLOG_MAX_RECORD_SIZE) {
 		// filter some out of range length,
 		// prevent client sending invalid jid crash server
 		return -1;
@@ -445,6 +683,83 @@ int BinlogReader::Read()
 			     len))
 		return -1;
 
+	if (((binlog_header_t *)_codec_buffer.c_str())->version >=
+	    BINLOG_CRC_VERSION)
+		return decode_body();
+
+	return 0;
+}
+
+/*
+ * 将version 3的记录解压、校验后还原成version 2的布局，
+ * record_pointer()/record_length()无需区分版本
+ */
+int BinlogReader::decode_body()
+{
+	int64_t start = GET_TIMESTAMP();
+	const uint32_t offset = header_size + sizeof(uint32_t);
+	if (_codec_buffer.size() < offset)
+		return -2;
+
+	binlog_header_t *header = (binlog_header_t *)_codec_buffer.c_str();
+	uint32_t raw_len = *(uint32_t *)(_codec_buffer.c_str() + header_size);
+	if (raw_len >= BINLOG_MAX_RAW_SIZE)
+		return -2;
+
+	const char *body = _codec_buffer.c_str() + offset;
+	uint32_t body_len = _codec_buffer.size() - offset;
+
+	_zip_buffer.clear();
+	if (_zip_buffer.expand(header_size + raw_len * 2) < 0)
+		return -2;
+	_zip_buffer.append(_codec_buffer.c_str(), header_size);
+
+	if (header->codec == BINLOG_CODEC_ZLIB) {
+		//解压后的数据暂放在缓冲区尾部
+		char *plain = _zip_buffer.c_str() + header_size + raw_len;
+		uLongf plain_len = raw_len;
+		if (uncompress((Bytef *)plain, &plain_len, (const Bytef *)body,
+			       body_len) != Z_OK ||
+		    plain_len != raw_len) {
+			log4cplus_error("uncompress binlog failed");
+			return -2;
+		}
+		body = plain;
+		body_len = raw_len;
+	} else if (header->codec != BINLOG_CODEC_NONE || body_len != raw_len) {
+		log4cplus_error("bad binlog codec: %d", header->codec);
+		return -2;
+	}
+
+	//去掉每条记录的crc，去crc后的数据不会超过原位置，可原地前移
+	char *out = _zip_buffer.c_str() + header_size;
+	const char *end = body + body_len;
+	for (uint32_t i = 0; i < header->recordcount; i++) {
+		const uint32_t prefix =
+			struct_sizeof(length) + sizeof(uint32_t);
+		if ((uint32_t)(end - body) < prefix)
+			return -2;
+		uint32_t len = *(uint32_t *)body;
+		uint32_t crc = *(uint32_t *)(body + struct_sizeof(length));
+		if ((uint32_t)(end - body - prefix) < len)
+			return -2;
+		if (crc32c(0, body + prefix, len) != crc) {
+			++_stat_crc_errors;
+			log4cplus_error("binlog record crc mismatch, jid[%u:%u]",
+					query_id().serial, query_id().offset);
+			return -2;
+		}
+		memmove(out, &len, struct_sizeof(length));
+		memmove(out + struct_sizeof(length), body + prefix, len);
+		out += struct_sizeof(length) + len;
+		body += prefix + len;
+	}
+
+	_zip_buffer.resize(out - _zip_buffer.c_str());
+	_codec_buffer.clear();
+	_codec_buffer.append(_zip_buffer);
+
+	_stat_decode_usec.push(GET_TIMESTAMP() - start);
 	return 0;
 }
 
@@ -23,6 +23,7 @@
 #include "buffer.h"
 #include "log/log.h"
 #include "journal_id.h"
+#include "stat_dtc.h"
 
 #define MAX_PATH_NAME_LEN 8192
 
@@ -54,6 +55,26 @@ class LogBase {
 	char _prefix[MAX_PATH_NAME_LEN]; //日志集的文件前缀
 };
 
+/*
+ * group commit fsync policy
+ */
+enum {
+	LOG_SYNC_NONE = 0, //不主动fsync
+	LOG_SYNC_INTERVAL, //距上次fsync超过间隔才fsync
+	LOG_SYNC_GROUP, //每次组提交都fsync
+};
+
+/*
+ * 组提交缓冲区写盘(并按策略fsync)后的通知
+ */
+class LogFlushListener {
+    public:
+	virtual ~LogFlushListener()
+	{
+	}
+	virtual void on_log_flushed(void) = 0;
+};
+
 class LogWriter : public LogBase {
     public:
 	int open(const char *path, const char *prefix, off_t max_size,
@@ -61,19 +82,55 @@ class LogWriter : public LogBase {
 	int write(const void *buf, size_t size);
 	JournalID query();
 
+	/*
+	 * 组提交: 记录先累积在对齐的内存缓冲区里，缓冲区满、切换文件或
+	 * 调用flush()时才一次性写盘。group_size为0表示每条记录直接写盘。
+	 * 写盘或fsync失败返回-1，写盘失败的记录留在缓冲区里下次重写，
+	 * query()只返回已写盘的位置。
+	 */
+	int set_group_commit(size_t group_size, int sync_policy,
+			     int sync_interval);
+	int flush();
+	// 缓冲区里是否有未写盘的记录
+	bool buffered() const
+	{
+		return _group_len > 0;
+	}
+	void set_flush_listener(LogFlushListener *l)
+	{
+		_listener = l;
+	}
+
     public:
 	LogWriter();
 	virtual ~LogWriter();
 
     private:
 	int shift_file();
+	int write_file(const void *buf, size_t size, uint32_t records);
+	int sync_file();
 
     private:
-	off_t _cur_size; //当前日志文件的大小
+	off_t _cur_size; //当前日志文件的大小(含未写盘部分)
 	off_t _max_size; //单个日志文件允许的最大大小
 	uint64_t _total_size; //日志集允许的最大大小
 	uint32_t _cur_max_serial; //当前日志文件最大编号
 	uint32_t _cur_min_serial; //当前日志文件最大编号
+
+	char *_group_buf; //组提交缓冲区
+	size_t _group_cap; //组提交缓冲区大小
+	size_t _group_len; //组提交缓冲区已用大小
+	uint32_t _group_records; //组提交缓冲区中的记录数
+	int64_t _group_since; //组提交缓冲区中第一条记录的时间(us)
+	int _sync_policy;
+	int _sync_interval; //ms
+	int64_t _last_sync; //上次fsync的时间(us)
+	int _unsynced; //已写盘的组提交记录fsync失败，待重试
+	LogFlushListener *_listener;
+
+	StatCounter _stat_write_bytes;
+	StatSample _stat_group_records;
+	StatSample _stat_group_delay;
 };
 
 class LogReader : public LogBase {
@@ -107,12 +164,21 @@ typedef struct binlog_header {
 	uint8_t version; //版本
 	uint8_t type; //类型: bitmap, dtc, other
 	uint8_t operater; //操作: insert,select,upate ...
-	uint8_t reserve[5]; //保留
+	uint8_t codec; //压缩算法, version >= 3
+	uint8_t reserve[4]; //保留
 	uint32_t timestamp; //时间戳
 	uint32_t recordcount; //子记录个数
 	uint8_t endof[0];
 } __attribute__((__aligned__(1))) binlog_header_t;
 
+/*
+ * binlog codec, version >= 3
+ */
+typedef enum binlog_codec {
+	BINLOG_CODEC_NONE = 0,
+	BINLOG_CODEC_ZLIB = 1,
+} BINLOG_CODEC;
+
 /*
  * binlog type
  * t
@@ -131,6 +197,10 @@ typedef enum binlog_type {
 #define BINLOG_MAX_SIZE (100 * (1U << 20)) //100M,  默认单个日志文件大小
 #define BINLOG_MAX_TOTAL_SIZE (3ULL << 30) //3G，  默认最大日志文件编号
 #define BINLOG_DEFAULT_VERSION 0x02
+#define BINLOG_CRC_VERSION 0x03 //每条记录带crc32c，整批可压缩
+#define BINLOG_COMPRESS_THRESHOLD 256 //小于该长度的批次不压缩
+#define BINLOG_MAX_RECORD_SIZE (1U << 20) //单条binlog落盘长度上限，读写两端一致
+#define BINLOG_MAX_RAW_SIZE (1U << 24) //version 3解压后body的长度上限
 
 class BinlogWriter {
     public:
@@ -144,23 +214,43 @@ class BinlogWriter {
 	int Abort();
 	JournalID query_id();
 
+	int set_group_commit(size_t group_size, int sync_policy,
+			     int sync_interval);
+	int Flush();
+	bool buffered() const
+	{
+		return _log_writer.buffered();
+	}
+	void set_flush_listener(LogFlushListener *l)
+	{
+		_log_writer.set_flush_listener(l);
+	}
+	int set_format(uint8_t version, uint32_t compress_threshold);
+
     public:
 	BinlogWriter();
 	virtual ~BinlogWriter();
 
     private:
 	BinlogWriter(const BinlogWriter &);
+	int compress_body();
 
     private:
 	LogWriter _log_writer; //写者
 	buffer _codec_buffer; //编码缓冲区
+	buffer _zip_buffer; //压缩缓冲区
+	uint8_t _version; //写入的binlog版本
+	uint32_t _compress_threshold;
+
+	StatCounter _stat_raw_bytes;
+	StatCounter _stat_stored_bytes;
 };
 
 class BinlogReader {
     public:
 	int init(const char *path, const char *prefix);
 
-	int Read(); //顺序读，每次读出一条binlog记录
+	int Read(); //顺序读，每次读出一条binlog记录, -2表示记录损坏
 	int Seek(const JournalID &);
 	JournalID query_id();
 
@@ -177,10 +267,15 @@ class BinlogReader {
 
     private:
 	BinlogReader(const BinlogReader &);
+	int decode_body();
 
     private:
 	LogReader _log_reader; //读者
 	buffer _codec_buffer; //编码缓冲区
+	buffer _zip_buffer; //解压/解码缓冲区
+
+	StatSample _stat_decode_usec;
+	StatCounter _stat_crc_errors;
 };
 
 #endif
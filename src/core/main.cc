@@ -196,6 +196,9 @@ static int single_thread_mode_initiazation()
 			return DTC_CODE_FAILED;
 	}
 
+	if (init_replication())
+		return DTC_CODE_FAILED;
+
 	int max_barrier_count =
 		g_dtc_config->get_int_val("cache", "MaxBarrierCount", 100000);
 	int max_key_count =
@@ -363,6 +366,9 @@ static int multiple_thread_mode_initiazation()
 		return DTC_CODE_FAILED;
 	}
 
+	if (init_replication())
+		return DTC_CODE_FAILED;
+
 	if (g_datasource_mode == DTC_MODE_DATABASE_ADDITION) {
 		g_data_connector_ask_instance->do_attach(g_datasource_thread);
 	}
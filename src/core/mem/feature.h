@@ -31,6 +31,9 @@ enum feature_id {
 	EMPTY_FILTER,
 	HOT_BACKUP,
 	COL_EXPAND,
+	EXPIRE_INDEX,
+	STRING_DICT,
+	KEY_INDEX,
 };
 typedef enum feature_id FEATURE_ID_T;
 
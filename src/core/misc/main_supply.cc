@@ -167,10 +167,95 @@ int init_hotbackup_chain_thread()
 		return DTC_CODE_FAILED;
 	}
 
+	//写binlog的job等到所在的组写盘并fsync后才回复
+	if (g_hot_backup_ask_instance->set_group_commit(
+		    g_dtc_config->get_size_val("cache", "BinlogGroupCommitSize",
+					       1ULL << 20, 'B'),
+		    g_dtc_config->get_idx_val(
+			    "cache", "BinlogSyncPolicy",
+			    ((const char *const[]){ "none", "interval",
+						    "group", NULL }),
+			    LOG_SYNC_GROUP),
+		    g_dtc_config->get_int_val("cache", "BinlogSyncInterval",
+					      1000),
+		    g_dtc_config->get_int_val("cache",
+					      "BinlogGroupCommitInterval", 2))) {
+		log4cplus_error("hotbackProcess group commit init fail");
+		return DTC_CODE_FAILED;
+	}
+
+	if (g_hot_backup_ask_instance->set_binlog_format(
+		    g_dtc_config->get_int_val("cache", "BinlogVersion",
+					      BINLOG_CRC_VERSION),
+		    g_dtc_config->get_int_val("cache", "BinlogCompressThreshold",
+					      BINLOG_COMPRESS_THRESHOLD))) {
+		log4cplus_error("hotbackProcess binlog format init fail");
+		return DTC_CODE_FAILED;
+	}
+
 	log4cplus_debug("StartHotbackThread end");
 	return DTC_CODE_SUCCESS;
 }
 
+/*
+ * 内置主从复制:
+ *     ReplicationListen  master监听地址，follower从这里拉取binlog
+ *     ReplicationMaster  follower连接的master地址
+ */
+int init_replication(void)
+{
+	if (g_buffer_process_ask_instance == NULL)
+		return DTC_CODE_SUCCESS;
+
+	const char *listen =
+		g_dtc_config->get_str_val("cache", "ReplicationListen");
+	const char *master =
+		g_dtc_config->get_str_val("cache", "ReplicationMaster");
+
+	// followers apply whole nodes, log values unless configured otherwise.
+	// larger nodes can't fit one binlog record, they are logged by key only
+	// and followers purge them
+	int value_limit = g_dtc_config->get_int_val(
+		"cache", "HotBackupValueLimit",
+		listen && listen[0] ? HB_MAX_VALUE_SIZE : 100);
+	if (value_limit < 0 || value_limit > HB_MAX_VALUE_SIZE) {
+		log4cplus_warning("HotBackupValueLimit %d out of range, use %d",
+				  value_limit, HB_MAX_VALUE_SIZE);
+		value_limit = HB_MAX_VALUE_SIZE;
+	}
+	g_buffer_process_ask_instance->set_hotbackup_value_limit(value_limit);
+
+	if (listen && listen[0]) {
+		if (g_buffer_process_ask_instance->enable_replication_log() !=
+		    0) {
+			log4cplus_error("enable replication log failed: %s",
+					g_buffer_process_ask_instance
+						->last_error_message());
+			return DTC_CODE_FAILED;
+		}
+		if (g_hot_backup_ask_instance->start_replication(
+			    listen,
+			    g_dtc_config->get_int_val(
+				    "cache", "ReplicationWindow", 8),
+			    g_dtc_config->get_int_val(
+				    "cache", "ReplicationBatch", 256)) != 0)
+			return DTC_CODE_FAILED;
+	}
+
+	if (master && master[0]) {
+		const char *pos = g_dtc_config->get_str_val(
+			"cache", "ReplicationPosFile");
+		if (g_buffer_process_ask_instance->start_replica(
+			    master, pos && pos[0] ? pos : "../log/replica.pos",
+			    g_dtc_config->get_int_val(
+				    "cache", "ReplicationRetryInterval", 1)) !=
+		    0)
+			return DTC_CODE_FAILED;
+	}
+
+	return DTC_CODE_SUCCESS;
+}
+
 int init_buffer_process_ask_chain_thread()
 {
 	log4cplus_error("init_buffer_process_ask_chain_thread start");
@@ -186,6 +271,8 @@ int init_buffer_process_ask_chain_thread()
 		g_dtc_config->get_int_val("cache", "LimitNodeRows", 0));
 	g_buffer_process_ask_instance->set_limit_empty_nodes(
 		g_dtc_config->get_int_val("cache", "LimitEmptyNodes", 0));
+	g_buffer_process_ask_instance->set_snapshot_rows(
+		g_dtc_config->get_int_val("cache", "SnapshotGetRows", 1000));
 
 	if (g_buffer_multi_thread->initialize_thread() == DTC_CODE_FAILED) {
 		return DTC_CODE_FAILED;
@@ -77,6 +77,7 @@ int init_remote_dtc_chain(PollerBase *thread);
 int init_data_connector_chain_thread(void);
 int init_buffer_process_ask_chain(PollerBase *thread);
 int init_data_connector_ask_chain(PollerBase *thread);
+int init_replication(void);
 
 int init_remote_log_config();
 int init_config_info();
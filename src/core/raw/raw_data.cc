@@ -17,6 +17,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 #include "raw_data.h"
 #include "global.h"
@@ -85,6 +86,59 @@
 			goto ERROR_RET;                                        \
 		offset_ += s;                                                  \
 	} while (0)
+
+#define GET_VARINT(x)                                                          \
+	do {                                                                   \
+		uint64_t __v = 0;                                              \
+		unsigned char __c;                                             \
+		int __s = 0;                                                   \
+		do {                                                           \
+			if (unlikely(offset_ >= size_ || __s > 63))            \
+				goto ERROR_RET;                                \
+			__c = *(unsigned char *)(p_content_ + offset_++);      \
+			__v |= (uint64_t)(__c & 0x7f) << __s;                  \
+			__s += 7;                                              \
+		} while (__c & 0x80);                                          \
+		x = (typeof(x))__v;                                            \
+	} while (0)
+
+#define SET_VARINT(x)                                                          \
+	do {                                                                   \
+		uint64_t __v = (x);                                            \
+		if (unlikely(offset_ + varint_size(__v) > size_))              \
+			goto ERROR_RET;                                        \
+		for (; __v >= 0x80; __v >>= 7)                                 \
+			*(unsigned char *)(p_content_ + offset_++) =           \
+				(unsigned char)(__v | 0x80);                   \
+		*(unsigned char *)(p_content_ + offset_++) = (unsigned char)__v; \
+	} while (0)
+
+static inline int varint_size(uint64_t v)
+{
+	int n = 1;
+	for (; v >= 0x80; v >>= 7)
+		n++;
+	return n;
+}
+
+static inline uint64_t zigzag(int64_t v)
+{
+	return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+}
+
+static inline int64_t unzigzag(uint64_t v)
+{
+	return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+}
+
+static inline int64_t summary_value(const DTCValue *v, int iType, int iSize)
+{
+	// 与encode_row按字段长度截断后的值一致
+	if (iSize > (int)sizeof(int32_t))
+		return v->s64;
+	return iType == DField::Signed ? (int64_t)(int32_t)v->s64 :
+					 (int64_t)(uint32_t)v->u64;
+}
 const int BTYE_MAX_VALUE = 255;
 RawData::RawData(MallocBase *pstMalloc, int iAutoDestroy)
 {
@@ -95,6 +149,11 @@ RawData::RawData(MallocBase *pstMalloc, int iAutoDestroy)
 	expire_id_ = -1;
 	table_index_ = -1;
 	key_start_ = 0;
+	summary_start_ = 0;
+	summary_count_ = 0;
+	packed_ = 0;
+	time_base_ = 0;
+	dict_ = NULL;
 	data_start_ = 0;
 	offset_ = 0;
 	m_uiLAOffset = 0;
@@ -113,6 +172,7 @@ RawData::RawData(MallocBase *pstMalloc, int iAutoDestroy)
 	auto_destory_ = iAutoDestroy;
 	size_ = 0;
 	p_reference_ = NULL;
+	table_definition_ = NULL;
 	memset(err_message_, 0, sizeof(err_message_));
 }
 
@@ -129,9 +189,32 @@ int RawData::init(uint8_t uchKeyIdx, int iKeySize, const char *pchKey,
 		  ALLOC_SIZE_T uiDataSize, int laId, int expireId, int nodeIdx)
 {
 	int ks = iKeySize != 0 ? iKeySize : 1 + *(unsigned char *)pchKey;
+	int ss = 0;
+	int iSummary = 0;
+	uint8_t auchSummary[MAX_SUMMARY_FIELDS];
+
+	if (table_definition_ != NULL) {
+		for (int i = table_definition_->key_fields();
+		     i <= table_definition_->num_fields() &&
+		     iSummary < MAX_SUMMARY_FIELDS;
+		     i++)
+			if (table_definition_->is_summary(i))
+				auchSummary[iSummary++] = i;
+		if (iSummary > 0)
+			ss = sizeof(uint8_t) + iSummary * sizeof(RawSummary);
+		packed_ = table_definition_->row_format() == ROW_FORMAT_PACKED;
+		dict_ = table_definition_->has_dict() ?
+				table_definition_->string_dict() :
+				NULL;
+	} else {
+		packed_ = 0;
+		dict_ = NULL;
+	}
+	if (packed_)
+		ss += sizeof(uint32_t);
 
-	/*|1字节:类型|4字节:数据大小|4字节: 行数| 1字节 : Get次数| 2字节: 最后访问时间| 2字节 : 最后更新时间|2字节: 最后创建时间 |key|*/
-	uiDataSize += 2 + sizeof(uint32_t) * 2 + sizeof(uint16_t) * 3 + ks;
+	/*|1字节:类型|4字节:数据大小|4字节: 行数| 1字节 : Get次数| 2字节: 最后访问时间| 2字节 : 最后更新时间|2字节: 最后创建时间 |key|[行摘要]|[时间基准]|*/
+	uiDataSize += 2 + sizeof(uint32_t) * 2 + sizeof(uint16_t) * 3 + ks + ss;
 
 	handle_ = INVALID_HANDLE;
 	size_ = 0;
@@ -144,7 +227,7 @@ int RawData::init(uint8_t uchKeyIdx, int iKeySize, const char *pchKey,
 	}
 	size_ = mallocator_->chunk_size(handle_);
 
-	data_size_ = 2 + sizeof(uint32_t) * 2 + sizeof(uint16_t) * 3 + ks;
+	data_size_ = 2 + sizeof(uint32_t) * 2 + sizeof(uint16_t) * 3 + ks + ss;
 	row_count_ = 0;
 	key_index_ = uchKeyIdx;
 	key_size_ = iKeySize;
@@ -161,7 +244,11 @@ int RawData::init(uint8_t uchKeyIdx, int iKeySize, const char *pchKey,
 		snprintf(err_message_, sizeof(err_message_), "node idx error");
 		return -100;
 	}
-	SET_VALUE(((table_index_ << 7) & 0x80) + DATA_TYPE_RAW, unsigned char);
+	SET_VALUE(((table_index_ << 7) & 0x80) + DATA_TYPE_RAW +
+			  (iSummary > 0 ? DATA_TYPE_SUMMARY : 0) +
+			  (packed_ ? DATA_TYPE_PACKED : 0) +
+			  (dict_ != NULL ? DATA_TYPE_DICT : 0),
+		  unsigned char);
 	SET_VALUE(data_size_, uint32_t);
 	SET_VALUE(row_count_, uint32_t);
 
@@ -179,6 +266,19 @@ int RawData::init(uint8_t uchKeyIdx, int iKeySize, const char *pchKey,
 		memcpy(p_content_ + offset_, pchKey, ks);
 		offset_ += ks;
 	}
+	summary_count_ = iSummary;
+	if (summary_count_ > 0) {
+		SET_VALUE(summary_count_, uint8_t);
+		summary_start_ = offset_;
+		SKIP_SIZE(summary_count_ * sizeof(RawSummary));
+		for (int i = 0; i < summary_count_; i++)
+			summary(i)->field_id_ = auchSummary[i];
+		reset_summary(true);
+	}
+	if (packed_) {
+		time_base_ = time(NULL);
+		SET_VALUE(time_base_, uint32_t);
+	}
 	data_start_ = offset_;
 	row_offset_ = data_start_;
 
@@ -260,7 +360,7 @@ int RawData::do_attach(MEM_HANDLE_T hHandle, uint8_t uchKeyIdx, int iKeySize,
 	m_uiLAOffset = 0;
 	unsigned char uchType;
 	GET_VALUE(uchType, unsigned char);
-	if (unlikely((uchType & 0x7f) != DATA_TYPE_RAW)) {
+	if (unlikely((uchType & DATA_TYPE_MASK) != DATA_TYPE_RAW)) {
 		snprintf(err_message_, sizeof(err_message_),
 			 "invalid data type: %u", uchType);
 		return (-2);
@@ -293,6 +393,27 @@ int RawData::do_attach(MEM_HANDLE_T hHandle, uint8_t uchKeyIdx, int iKeySize,
 	ks = iKeySize != 0 ? iKeySize :
 			     1 + *(unsigned char *)(p_content_ + key_start_);
 	SKIP_SIZE(ks);
+	summary_count_ = 0;
+	if (uchType & DATA_TYPE_SUMMARY) {
+		GET_VALUE(summary_count_, uint8_t);
+		summary_start_ = offset_;
+		SKIP_SIZE(summary_count_ * sizeof(RawSummary));
+	}
+	packed_ = (uchType & DATA_TYPE_PACKED) != 0;
+	if (packed_)
+		GET_VALUE(time_base_, uint32_t);
+	dict_ = NULL;
+	if (uchType & DATA_TYPE_DICT) {
+		if (table_definition_ != NULL)
+			dict_ = table_definition_->string_dict();
+		if (unlikely(dict_ == NULL)) {
+			snprintf(err_message_, sizeof(err_message_),
+				 "raw-data handle[" UINT64FMT
+				 "] has dict codes, string dict not attached",
+				 hHandle);
+			return (-4);
+		}
+	}
 	data_start_ = offset_;
 	row_offset_ = data_start_;
 
@@ -332,7 +453,7 @@ int RawData::check_size(MEM_HANDLE_T hHandle, uint8_t uchKeyIdx, int iKeySize,
 	m_uiLAOffset = 0;
 	unsigned char uchType;
 	GET_VALUE(uchType, unsigned char);
-	if (unlikely(uchType != DATA_TYPE_RAW)) {
+	if (unlikely((uchType & DATA_TYPE_MASK) != DATA_TYPE_RAW)) {
 		snprintf(err_message_, sizeof(err_message_),
 			 "invalid data type: %u", uchType);
 		return (-2);
@@ -366,7 +487,7 @@ int RawData::strip_mem()
 }
 
 int RawData::decode_row(RowValue &stRow, unsigned char &uchRowFlags,
-			int iDecodeFlag)
+			int iDecodeFlag, const uint8_t *pFieldMask)
 {
 	if (unlikely(handle_ == INVALID_HANDLE || p_content_ == NULL)) {
 		snprintf(err_message_, sizeof(err_message_),
@@ -376,6 +497,8 @@ int RawData::decode_row(RowValue &stRow, unsigned char &uchRowFlags,
 
 	ALLOC_SIZE_T uiOldOffset = offset_;
 	ALLOC_SIZE_T uiOldRowOffset = row_offset_;
+	const DTCTableDefinition *t = stRow.table_definition();
+	uint64_t c;
 	m_uiLAOffset = 0;
 	row_offset_ = offset_;
 	GET_VALUE(uchRowFlags, unsigned char);
@@ -383,14 +506,22 @@ int RawData::decode_row(RowValue &stRow, unsigned char &uchRowFlags,
 	for (int j = key_index_ + 1; j <= stRow.num_fields();
 	     j++) //拷贝一行数据
 	{
-		if (stRow.table_definition()->is_discard(j))
+		if (t->is_discard(j))
 			continue;
 		if (j == m_iLAId)
 			m_uiLAOffset = offset_;
+		if (pFieldMask != NULL && !FIELD_ISSET(j, pFieldMask)) {
+			if (skip_field(t, j) != 0)
+				goto ERROR_RET;
+			continue;
+		}
 		switch (stRow.field_type(j)) {
 		case DField::Signed:
-			if (unlikely(stRow.field_size(j) >
-				     (int)sizeof(int32_t))) {
+			if (is_varint_field(t, j)) {
+				GET_VARINT(c);
+				unpack_int(t, j, c, stRow.field_value(j));
+			} else if (unlikely(stRow.field_size(j) >
+					    (int)sizeof(int32_t))) {
 				GET_VALUE(stRow.field_value(j)->s64, int64_t);
 			} else {
 				GET_VALUE(stRow.field_value(j)->s64, int32_t);
@@ -398,8 +529,11 @@ int RawData::decode_row(RowValue &stRow, unsigned char &uchRowFlags,
 			break;
 
 		case DField::Unsigned:
-			if (unlikely(stRow.field_size(j) >
-				     (int)sizeof(uint32_t))) {
+			if (is_varint_field(t, j)) {
+				GET_VARINT(c);
+				unpack_int(t, j, c, stRow.field_value(j));
+			} else if (unlikely(stRow.field_size(j) >
+					    (int)sizeof(uint32_t))) {
 				GET_VALUE(stRow.field_value(j)->u64, uint64_t);
 			} else {
 				GET_VALUE(stRow.field_value(j)->u64, uint32_t);
@@ -417,7 +551,22 @@ int RawData::decode_row(RowValue &stRow, unsigned char &uchRowFlags,
 		case DField::String: //字符串
 		case DField::Binary: //二进制数据
 		default: {
-			GET_VALUE(stRow.field_value(j)->bin.len, int);
+			if (is_dict_field(t, j)) {
+				DTCValue *v = stRow.field_value(j);
+				GET_VARINT(c);
+				if (c & 1) {
+					// 指向字典，不复制
+					v->bin.ptr = (char *)dict_->lookup(
+						c >> 1, v->bin.len);
+					if (unlikely(v->bin.ptr == NULL))
+						goto ERROR_RET;
+					break;
+				}
+				v->bin.len = c >> 1;
+			} else if (packed_)
+				GET_VARINT(stRow.field_value(j)->bin.len);
+			else
+				GET_VALUE(stRow.field_value(j)->bin.len, int);
 			stRow.field_value(j)->bin.ptr = p_content_ + offset_;
 			SKIP_SIZE(stRow.field_value(j)->bin.len);
 			break;
@@ -457,38 +606,21 @@ int RawData::get_expire_time(DTCTableDefinition *t, uint32_t &expire)
 	// the first field should be expire time
 	for (int j = key_index_ + 1; j <= table_definition_->num_fields();
 	     j++) { //拷贝一行数据
+		if (table_definition_->is_discard(j))
+			continue;
 		if (j == expire_id_) {
-			expire = *((uint32_t *)(p_content_ + offset_));
+			if (is_varint_field(table_definition_, j)) {
+				uint64_t c;
+				DTCValue v;
+				GET_VARINT(c);
+				unpack_int(table_definition_, j, c, &v);
+				expire = v.u64;
+			} else
+				expire = *((uint32_t *)(p_content_ + offset_));
 			break;
 		}
-
-		switch (table_definition_->field_type(j)) {
-		case DField::Unsigned:
-		case DField::Signed:
-			if (table_definition_->field_size(j) >
-			    (int)sizeof(int32_t))
-				SKIP_SIZE(sizeof(int64_t));
-			else
-				SKIP_SIZE(sizeof(int32_t));
-			;
-			break;
-
-		case DField::Float: //浮点数
-			if (table_definition_->field_size(j) >
-			    (int)sizeof(float))
-				SKIP_SIZE(sizeof(double));
-			else
-				SKIP_SIZE(sizeof(float));
-			break;
-
-		case DField::String: //字符串
-		case DField::Binary: //二进制数据
-		default:
-			int iLen = 0;
-			GET_VALUE(iLen, int);
-			SKIP_SIZE(iLen);
-			break;
-		} //end of switch
+		if (skip_field(table_definition_, j) != 0)
+			goto ERROR_RET;
 	}
 	return 0;
 
@@ -515,37 +647,18 @@ int RawData::get_lastcmod(uint32_t &lastcmod)
 		//id: bug fix skip discard
 		if (table_definition_->is_discard(j))
 			continue;
+		if (j == m_iLCmodId && is_varint_field(table_definition_, j)) {
+			uint64_t c;
+			DTCValue v;
+			GET_VARINT(c);
+			unpack_int(table_definition_, j, c, &v);
+			lastcmod = v.u64;
+			continue;
+		}
 		if (j == m_iLCmodId)
 			lastcmod = *((uint32_t *)(p_content_ + offset_));
-
-		switch (table_definition_->field_type(j)) {
-		case DField::Unsigned:
-		case DField::Signed:
-			if (table_definition_->field_size(j) >
-			    (int)sizeof(int32_t))
-				SKIP_SIZE(sizeof(int64_t));
-			else
-				SKIP_SIZE(sizeof(int32_t));
-			;
-			break;
-
-		case DField::Float: //浮点数
-			if (table_definition_->field_size(j) >
-			    (int)sizeof(float))
-				SKIP_SIZE(sizeof(double));
-			else
-				SKIP_SIZE(sizeof(float));
-			break;
-
-		case DField::String: //字符串
-		case DField::Binary: //二进制数据
-		default: {
-			int iLen = 0;
-			GET_VALUE(iLen, int);
-			SKIP_SIZE(iLen);
-			break;
-		}
-		} //end of switch
+		if (skip_field(table_definition_, j) != 0)
+			goto ERROR_RET;
 	}
 	return (0);
 
@@ -616,18 +729,115 @@ int RawData::re_alloc_chunk(ALLOC_SIZE_T tSize)
 	return (0);
 }
 
+/* 紧凑格式整数字段的编码值，先按字段长度截断，与定长格式取值一致 */
+uint64_t RawData::pack_int(const DTCTableDefinition *t, int id,
+			   const DTCValue *v) const
+{
+	int64_t x = summary_value(v, t->field_type(id), t->field_size(id));
+
+	if (t->is_timestamp(id))
+		return zigzag((int64_t)((uint64_t)x - time_base_));
+	if (t->field_type(id) == DField::Signed)
+		return zigzag(x);
+	return (uint64_t)x;
+}
+
+void RawData::unpack_int(const DTCTableDefinition *t, int id, uint64_t c,
+			 DTCValue *v) const
+{
+	const int type = t->field_type(id);
+	uint64_t x;
+
+	if (t->is_timestamp(id))
+		x = (uint64_t)unzigzag(c) + time_base_;
+	else if (type == DField::Signed)
+		x = (uint64_t)unzigzag(c);
+	else
+		x = c;
+
+	if (t->field_size(id) > (int)sizeof(int32_t))
+		v->u64 = x;
+	else if (type == DField::Signed)
+		v->s64 = (int32_t)x;
+	else
+		v->u64 = (uint32_t)x;
+}
+
+/* 字典字段的varint头，值不能进字典时为长度 */
+uint64_t RawData::dict_header(const DTCValue *v) const
+{
+	uint32_t code = 0;
+
+	if (v->bin.len > 0)
+		code = dict_->intern(v->bin.ptr, v->bin.len);
+	if (code != 0)
+		return ((uint64_t)code << 1) | 1;
+	return (uint64_t)v->bin.len << 1;
+}
+
+/* 跳过当前偏移处的一个字段 */
+int RawData::skip_field(const DTCTableDefinition *t, int id)
+{
+	switch (t->field_type(id)) {
+	case DField::Unsigned:
+	case DField::Signed:
+		if (is_varint_field(t, id)) {
+			uint64_t c;
+			GET_VARINT(c);
+		} else if (t->field_size(id) > (int)sizeof(int32_t))
+			SKIP_SIZE(sizeof(int64_t));
+		else
+			SKIP_SIZE(sizeof(int32_t));
+		break;
+
+	case DField::Float: //浮点数
+		if (t->field_size(id) > (int)sizeof(float))
+			SKIP_SIZE(sizeof(double));
+		else
+			SKIP_SIZE(sizeof(float));
+		break;
+
+	case DField::String: //字符串
+	case DField::Binary: //二进制数据
+	default: {
+		int iLen = 0;
+		if (is_dict_field(t, id)) {
+			uint64_t c;
+			GET_VARINT(c);
+			iLen = (c & 1) ? 0 : c >> 1;
+		} else if (packed_)
+			GET_VARINT(iLen);
+		else
+			GET_VALUE(iLen, int);
+		SKIP_SIZE(iLen);
+		break;
+	}
+	} //end of switch
+
+	return (0);
+
+ERROR_RET:
+	return (-100);
+}
+
 ALLOC_SIZE_T RawData::calc_row_size(const RowValue &stRow, int keyIdx)
 {
 	if (keyIdx == -1)
 		log4cplus_error("RawData may not init yet...");
+	const DTCTableDefinition *t = stRow.table_definition();
 	ALLOC_SIZE_T tSize = 1; // flag
 	for (int j = keyIdx + 1; j <= stRow.num_fields(); j++) //拷贝一行数据
 	{
-		if (stRow.table_definition()->is_discard(j))
+		if (t->is_discard(j))
 			continue;
 		switch (stRow.field_type(j)) {
 		case DField::Signed:
 		case DField::Unsigned:
+			if (is_varint_field(t, j)) {
+				tSize += varint_size(
+					pack_int(t, j, stRow.field_value(j)));
+				break;
+			}
 			tSize += unlikely(stRow.field_size(j) >
 					  (int)sizeof(int32_t)) ?
 					 sizeof(int64_t) :
@@ -644,7 +854,17 @@ ALLOC_SIZE_T RawData::calc_row_size(const RowValue &stRow, int keyIdx)
 		case DField::String: //字符串
 		case DField::Binary: //二进制数据
 		default: {
-			tSize += sizeof(int);
+			if (is_dict_field(t, j)) {
+				uint64_t h = dict_header(stRow.field_value(j));
+				tSize += varint_size(h);
+				if (!(h & 1))
+					tSize += stRow.field_value(j)->bin.len;
+				break;
+			}
+			if (packed_)
+				tSize += varint_size(stRow.field_value(j)->bin.len);
+			else
+				tSize += sizeof(int);
 			tSize += stRow.field_value(j)->bin.len;
 			break;
 		}
@@ -661,6 +881,7 @@ int RawData::encode_row(const RowValue &stRow, unsigned char uchOp,
 			bool expendBuf)
 {
 	int iRet;
+	const DTCTableDefinition *t = stRow.table_definition();
 
 	ALLOC_SIZE_T tSize;
 	tSize = calc_row_size(stRow, key_index_);
@@ -676,21 +897,25 @@ int RawData::encode_row(const RowValue &stRow, unsigned char uchOp,
 	for (int j = key_index_ + 1; j <= stRow.num_fields();
 	     j++) //拷贝一行数据
 	{
-		if (stRow.table_definition()->is_discard(j))
+		if (t->is_discard(j))
 			continue;
 		const DTCValue *const v = stRow.field_value(j);
 		switch (stRow.field_type(j)) {
 		case DField::Signed:
-			if (unlikely(stRow.field_size(j) >
-				     (int)sizeof(int32_t)))
+			if (is_varint_field(t, j))
+				SET_VARINT(pack_int(t, j, v));
+			else if (unlikely(stRow.field_size(j) >
+					  (int)sizeof(int32_t)))
 				SET_VALUE(v->s64, int64_t);
 			else
 				SET_VALUE(v->s64, int32_t);
 			break;
 
 		case DField::Unsigned:
-			if (unlikely(stRow.field_size(j) >
-				     (int)sizeof(uint32_t)))
+			if (is_varint_field(t, j))
+				SET_VARINT(pack_int(t, j, v));
+			else if (unlikely(stRow.field_size(j) >
+					  (int)sizeof(uint32_t)))
 				SET_VALUE(v->u64, uint64_t);
 			else
 				SET_VALUE(v->u64, uint32_t);
@@ -706,12 +931,35 @@ int RawData::encode_row(const RowValue &stRow, unsigned char uchOp,
 		case DField::String: //字符串
 		case DField::Binary: //二进制数据
 		default: {
-			SET_BIN_VALUE(v->bin.ptr, v->bin.len);
+			if (is_dict_field(t, j)) {
+				uint64_t h = dict_header(v);
+				if (h & 1) {
+					SET_VARINT(h);
+					dict_->add_saved(
+						(packed_ ? varint_size(v->bin.len) :
+							   (int)sizeof(int)) +
+						v->bin.len - varint_size(h));
+					break;
+				}
+				SET_VARINT(h);
+			} else if (!packed_) {
+				SET_BIN_VALUE(v->bin.ptr, v->bin.len);
+				break;
+			} else
+				SET_VARINT(v->bin.len);
+			CHECK_SIZE(v->bin.len);
+			if (likely(v->bin.len != 0))
+				memcpy(p_content_ + offset_, v->bin.ptr,
+				       v->bin.len);
+			offset_ += v->bin.len;
 			break;
 		}
 		} //end of switch
 	}
 
+	if (summary_count_ > 0)
+		widen_summary(stRow);
+
 	data_size_ += tSize;
 	set_data_size();
 	row_count_++;
@@ -831,33 +1079,8 @@ int RawData::skip_row(const RowValue &stRow)
 		//id: bug fix skip discard
 		if (stRow.table_definition()->is_discard(j))
 			continue;
-
-		switch (stRow.field_type(j)) {
-		case DField::Unsigned:
-		case DField::Signed:
-			if (stRow.field_size(j) > (int)sizeof(int32_t))
-				SKIP_SIZE(sizeof(int64_t));
-			else
-				SKIP_SIZE(sizeof(int32_t));
-			;
-			break;
-
-		case DField::Float: //浮点数
-			if (stRow.field_size(j) > (int)sizeof(float))
-				SKIP_SIZE(sizeof(double));
-			else
-				SKIP_SIZE(sizeof(float));
-			break;
-
-		case DField::String: //字符串
-		case DField::Binary: //二进制数据
-		default: {
-			int iLen;
-			GET_VALUE(iLen, int);
-			SKIP_SIZE(iLen);
-			break;
-		}
-		} //end of switch
+		if (skip_field(stRow.table_definition(), j) != 0)
+			goto ERROR_RET;
 	}
 
 	return (0);
@@ -1013,6 +1236,8 @@ int RawData::delete_all_rows()
 
 	set_data_size();
 	set_row_count();
+	if (summary_count_ > 0)
+		reset_summary(true);
 
 	need_new_bufer_size = 0;
 
@@ -1030,23 +1255,92 @@ int RawData::set_cur_row_flag(unsigned char uchFlag)
 	return (0);
 }
 
-int RawData::copy_row()
+/* 复制pstFrom中[uiFrom, uiTo)的uiNRows行到末尾，行格式不同时逐行转码 */
+int RawData::copy_rows(RawData *pstFrom, ALLOC_SIZE_T uiFrom,
+		       ALLOC_SIZE_T uiTo, unsigned int uiNRows)
 {
 	int iRet;
-	ALLOC_SIZE_T uiSize = p_reference_->offset_ - p_reference_->row_offset_;
-	if ((iRet = expand_chunk(uiSize)) != 0)
-		return (iRet);
+	ALLOC_SIZE_T uiSize = uiTo - uiFrom;
 
-	memcpy(p_content_ + offset_,
-	       p_reference_->p_content_ + p_reference_->row_offset_, uiSize);
-	offset_ += uiSize;
-	data_size_ += uiSize;
-	row_count_++;
+	if (pstFrom->packed_ == packed_ && pstFrom->dict_ == dict_ &&
+	    (!packed_ || pstFrom->time_base_ == time_base_)) {
+		if ((iRet = expand_chunk(uiSize)) != 0)
+			return (iRet);
 
-	set_data_size();
-	set_row_count();
+		memcpy(p_content_ + data_size_, pstFrom->p_content_ + uiFrom,
+		       uiSize);
+		data_size_ += uiSize;
+		row_count_ += uiNRows;
+		offset_ = data_size_;
 
-	return (0);
+		set_data_size();
+		set_row_count();
+		scan_summary(data_size_ - uiSize, data_size_);
+		return (0);
+	}
+
+	DTCTableDefinition *t = pstFrom->table_definition_ != NULL ?
+					pstFrom->table_definition_ :
+					table_definition_;
+	if (t == NULL) {
+		snprintf(err_message_, sizeof(err_message_),
+			 "copy rows error: tabledef[NULL]");
+		return (-1);
+	}
+
+	ALLOC_SIZE_T uiOldOffset = pstFrom->offset_;
+	ALLOC_SIZE_T uiOldRowOffset = pstFrom->row_offset_;
+	ALLOC_SIZE_T uiOldLAOffset = pstFrom->m_uiLAOffset;
+	RowValue stRow(t);
+	unsigned char uchRowFlags;
+
+	iRet = 0;
+	pstFrom->offset_ = uiFrom;
+	// 多行时先算出转码后的总大小，chunk只扩大一次
+	if (uiNRows > 1) {
+		ALLOC_SIZE_T uiNeed = 0;
+		while (pstFrom->offset_ < uiTo) {
+			if (pstFrom->decode_row(stRow, uchRowFlags, 0) != 0) {
+				snprintf(err_message_, sizeof(err_message_),
+					 "copy rows error: %s",
+					 pstFrom->get_err_msg());
+				iRet = -100;
+				break;
+			}
+			uiNeed += calc_row_size(stRow, key_index_);
+		}
+		if (iRet == 0)
+			iRet = expand_chunk(uiNeed);
+		pstFrom->offset_ = uiFrom;
+	}
+	while (iRet == 0 && pstFrom->offset_ < uiTo) {
+		if (pstFrom->decode_row(stRow, uchRowFlags, 0) != 0) {
+			snprintf(err_message_, sizeof(err_message_),
+				 "copy rows error: %s",
+				 pstFrom->get_err_msg());
+			iRet = -100;
+			break;
+		}
+		offset_ = data_size_;
+		if ((iRet = encode_row(stRow, uchRowFlags)) != 0)
+			break;
+	}
+
+	pstFrom->offset_ = uiOldOffset;
+	pstFrom->row_offset_ = uiOldRowOffset;
+	pstFrom->m_uiLAOffset = uiOldLAOffset;
+	return (iRet);
+}
+
+int RawData::reserve(ALLOC_SIZE_T uiRowsSize)
+{
+	return expand_chunk(uiRowsSize);
+}
+
+int RawData::copy_row()
+{
+	return copy_rows(p_reference_, p_reference_->row_offset_,
+			 p_reference_->offset_, 1);
 }
 
 int RawData::copy_all()
@@ -1064,23 +1358,161 @@ int RawData::copy_all()
 	return (0);
 }
 
-int RawData::append_n_records(unsigned int uiNRows, const char *pchData,
-			      const unsigned int uiLen)
+int RawData::copy_all_decoded()
 {
 	int iRet;
+	RawData *pstFrom = p_reference_;
 
-	iRet = expand_chunk(uiLen);
+	if (pstFrom->dict_ == NULL && !pstFrom->packed_)
+		return copy_all();
+
+	// 与copy_all一样替换本地数据
+	destory();
+	table_definition_ = pstFrom->table_definition_;
+	iRet = init(pstFrom->key_index_, pstFrom->key_size_, pstFrom->key(),
+		    pstFrom->data_size_, pstFrom->m_iLAId, pstFrom->expire_id_,
+		    pstFrom->table_index_);
 	if (iRet != 0)
 		return (iRet);
+	// 还没有行，直接去掉字典标记和紧凑格式的时间基准，行按定长格式重新编码
+	dict_ = NULL;
+	if (packed_) {
+		packed_ = 0;
+		data_size_ -= sizeof(uint32_t);
+		data_start_ = row_offset_ = offset_ = data_size_;
+		set_data_size();
+	}
+	p_content_[0] &= ~(DATA_TYPE_DICT | DATA_TYPE_PACKED);
+	memcpy(p_content_ + get_request_count_offset_,
+	       pstFrom->p_content_ + pstFrom->get_request_count_offset_,
+	       sizeof(uint8_t) + 3 * sizeof(uint16_t));
+	attach_time_stamp();
 
-	memcpy(p_content_ + data_size_, pchData, uiLen);
-	data_size_ += uiLen;
-	row_count_ += uiNRows;
+	return copy_rows(pstFrom, pstFrom->data_start_, pstFrom->data_size_,
+			 pstFrom->row_count_);
+}
 
-	set_data_size();
-	set_row_count();
+int RawData::append_n_records(unsigned int uiNRows, const char *pchData,
+			      const unsigned int uiLen)
+{
+	// 外部的行总是定长格式，借一个只读的RawData描述它
+	RawData stFrom(mallocator_);
+	stFrom.handle_ = handle_;
+	stFrom.p_content_ = (char *)pchData;
+	stFrom.size_ = uiLen;
+	stFrom.data_size_ = uiLen;
+	stFrom.key_index_ = key_index_;
+	stFrom.table_definition_ = table_definition_;
+
+	return copy_rows(&stFrom, 0, uiLen, uiNRows);
+}
 
-	return (0);
+void RawData::reset_summary(bool isEmpty)
+{
+	for (int i = 0; i < summary_count_; i++) {
+		RawSummary *s = summary(i);
+		s->min_ = isEmpty ? INT64_MAX : INT64_MIN;
+		s->max_ = isEmpty ? INT64_MIN : INT64_MAX;
+	}
+}
+
+void RawData::widen_summary(const RowValue &stRow)
+{
+	for (int i = 0; i < summary_count_; i++) {
+		RawSummary *s = summary(i);
+		const int id = s->field_id_;
+		if (unlikely(id > stRow.num_fields())) {
+			s->min_ = INT64_MIN;
+			s->max_ = INT64_MAX;
+			continue;
+		}
+		int64_t v = summary_value(stRow.field_value(id),
+					  stRow.field_type(id),
+					  stRow.field_size(id));
+		if (v < s->min_)
+			s->min_ = v;
+		if (v > s->max_)
+			s->max_ = v;
+	}
+}
+
+/* 已编码的行没有经过encode_row，需要解码出摘要字段 */
+void RawData::scan_summary(ALLOC_SIZE_T uiFrom, ALLOC_SIZE_T uiTo)
+{
+	if (summary_count_ == 0)
+		return;
+	if (table_definition_ == NULL) {
+		reset_summary(false);
+		return;
+	}
+
+	ALLOC_SIZE_T uiOldOffset = offset_;
+	ALLOC_SIZE_T uiOldRowOffset = row_offset_;
+	ALLOC_SIZE_T uiOldLAOffset = m_uiLAOffset;
+	uint8_t fieldMask[32];
+	FIELD_ZERO(fieldMask);
+	for (int i = 0; i < summary_count_; i++)
+		FIELD_SET(summary(i)->field_id_, fieldMask);
+
+	RowValue stRow(table_definition_);
+	unsigned char uchRowFlags;
+	offset_ = uiFrom;
+	while (offset_ < uiTo) {
+		if (decode_row(stRow, uchRowFlags, 0, fieldMask) != 0) {
+			reset_summary(false);
+			break;
+		}
+		widen_summary(stRow);
+	}
+
+	offset_ = uiOldOffset;
+	row_offset_ = uiOldRowOffset;
+	m_uiLAOffset = uiOldLAOffset;
+}
+
+int RawData::may_match(const DTCFieldValue *pstCond) const
+{
+	if (summary_count_ == 0 || pstCond == NULL)
+		return (1);
+
+	for (int i = 0; i < pstCond->num_fields(); i++) {
+		if (pstCond->field_type(i) != DField::Signed)
+			continue;
+		const int id = pstCond->field_id(i);
+		const int64_t v = pstCond->field_value(i)->s64;
+		for (int j = 0; j < summary_count_; j++) {
+			const RawSummary *s = summary(j);
+			if (s->field_id_ != id || s->min_ > s->max_)
+				continue;
+			switch (pstCond->field_operation(i)) {
+			case DField::EQ:
+				if (v < s->min_ || v > s->max_)
+					return (0);
+				break;
+			case DField::NE:
+				if (v == s->min_ && v == s->max_)
+					return (0);
+				break;
+			case DField::LT:
+				if (s->min_ >= v)
+					return (0);
+				break;
+			case DField::LE:
+				if (s->min_ > v)
+					return (0);
+				break;
+			case DField::GT:
+				if (s->max_ <= v)
+					return (0);
+				break;
+			case DField::GE:
+				if (s->max_ < v)
+					return (0);
+				break;
+			}
+		}
+	}
+	return (1);
 }
 
 void RawData::init_timp_stamp()
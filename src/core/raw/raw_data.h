@@ -22,6 +22,7 @@
 #include "field/field.h"
 #include "data/col_expand.h"
 #include "table/table_def_manager.h"
+#include "table/string_dict.h"
 #include "node/node.h"
 
 #define PRE_DECODE_ROW 1
@@ -32,6 +33,15 @@ typedef enum _EnumDataType {
 	DATA_TYPE_TREE_NODE // 树的节点
 } EnumDataType;
 
+// data_type_的最高位是table index，次高位标记树的根节点使用b+tree索引，
+// 或者平板数据在key之后带有行摘要；0x20标记平板数据的行为紧凑格式，
+// 0x10标记字典字段存放共享字典的编码
+#define DATA_TYPE_MASK 0x0f
+#define DATA_TYPE_BTREE 0x40
+#define DATA_TYPE_SUMMARY 0x40
+#define DATA_TYPE_PACKED 0x20
+#define DATA_TYPE_DICT 0x10
+
 typedef enum _enum_oper_type_ {
 	OPER_DIRTY = 0x02, // cover INSERT, DELETE, UPDATE
 	OPER_SELECT = 0x30,
@@ -56,6 +66,20 @@ struct RawFormat {
 	char p_rows_data_[0]; // 行数据
 } __attribute__((packed));
 
+// 行摘要：节点内所有行某个整数字段的最小/最大值，min_ > max_表示没有行。
+// 平板数据的key之后为1字节的个数，接着是各字段的摘要
+struct RawSummary {
+	uint8_t field_id_;
+	int64_t min_;
+	int64_t max_;
+} __attribute__((packed));
+
+// 紧凑格式：整数字段为varint(有符号先zigzag)，时间戳字段为相对于节点
+// 时间基准的差值，字符串/二进制的长度为varint。lastacc需要原地更新，
+// 浮点数没有压缩空间，两者保持定长。时间基准为4字节，位于行摘要之后。
+// 字典节点中字典字段先存一个varint头：最低位为1时其余位是共享字典的
+// 编码，否则其余位是长度，后跟原值(字典已满或值太长)。字典只追加，
+// 解码时值直接指向字典，节点离开本进程前需转回原值。
 // 注意：修改操作可能会导致handle改变，因此需要检查重新保存
 class RawData {
     private:
@@ -70,6 +94,11 @@ class RawData {
 	int table_index_;
 
 	ALLOC_SIZE_T key_start_;
+	ALLOC_SIZE_T summary_start_;
+	uint8_t summary_count_;
+	uint8_t packed_;
+	uint32_t time_base_;
+	StringDict *dict_; // 节点使用字典编码时非NULL
 	ALLOC_SIZE_T data_start_;
 	ALLOC_SIZE_T row_offset_;
 	ALLOC_SIZE_T offset_;
@@ -104,9 +133,33 @@ class RawData {
 	int expand_chunk(ALLOC_SIZE_T expand_size);
 	int re_alloc_chunk(ALLOC_SIZE_T tSize);
 	int skip_row(const RowValue &stRow);
+	int skip_field(const DTCTableDefinition *t, int id);
+	int is_varint_field(const DTCTableDefinition *t, int id) const
+	{
+		return packed_ && id != t->lastacc_field_id();
+	}
+	int is_dict_field(const DTCTableDefinition *t, int id) const
+	{
+		return dict_ != NULL && t->is_dict(id);
+	}
+	uint64_t dict_header(const DTCValue *v) const;
+	uint64_t pack_int(const DTCTableDefinition *t, int id,
+			  const DTCValue *v) const;
+	void unpack_int(const DTCTableDefinition *t, int id, uint64_t c,
+			DTCValue *v) const;
+	int copy_rows(RawData *pstFrom, ALLOC_SIZE_T uiFrom, ALLOC_SIZE_T uiTo,
+		      unsigned int uiNRows);
 	int encode_row(const RowValue &stRow, unsigned char uchOp,
 		       bool expendBuf = true);
 
+	RawSummary *summary(int i) const
+	{
+		return (RawSummary *)(p_content_ + summary_start_) + i;
+	}
+	void reset_summary(bool isEmpty);
+	void widen_summary(const RowValue &stRow);
+	void scan_summary(ALLOC_SIZE_T uiFrom, ALLOC_SIZE_T uiTo);
+
     public:
 	/*************************************************
 	  Description:    构造函数
@@ -289,10 +342,11 @@ class RawData {
 	  Output:		stRow	保存行数据
 				uchRowFlags	行数据是否脏数据等flag
 				iDecodeFlag	是否只是pre-read，不fetch_row移动指针
+				pFieldMask	只解码mask中的字段，其余字段跳过不赋值，NULL为全部解码
 	  Return:		0为成功，非0失败
 	*************************************************/
 	int decode_row(RowValue &stRow, unsigned char &uchRowFlags,
-		       int iDecodeFlag = 0);
+		       int iDecodeFlag = 0, const uint8_t *pFieldMask = NULL);
 
 	/*************************************************
 	  Description:	插入一行数据
@@ -360,6 +414,14 @@ class RawData {
 	*************************************************/
 	int set_cur_row_flag(unsigned char uchFlag);
 
+	/*************************************************
+	  Description:	预先扩大chunk，之后追加共uiRowsSize字节的行不会再realloc
+	  Input:		uiRowsSize	将要追加的行的总大小，见calc_row_size
+	  Output:		
+	  Return:		0为成功，非0失败，EC_NO_MEM时need_size()为需要的大小
+	*************************************************/
+	int reserve(ALLOC_SIZE_T uiRowsSize);
+
 	/*************************************************
 	  Description:	从refrence copy当前行到本地buffer末尾
 	  Input:		
@@ -376,6 +438,15 @@ class RawData {
 	*************************************************/
 	int copy_all();
 
+	/*************************************************
+	  Description:	同copy_all，字典编码转回原值、紧凑格式转为定长格式，
+			用于节点数据离开本进程
+	  Input:		
+	  Output:		
+	  Return:		0为成功，非0失败
+	*************************************************/
+	int copy_all_decoded();
+
 	/*************************************************
 	  Description:	添加N行已经格式化好的数据到末尾
 	  Input:		
@@ -385,6 +456,14 @@ class RawData {
 	int append_n_records(unsigned int uiNRows, const char *pchData,
 			     const unsigned int uiLen);
 
+	/*************************************************
+	  Description:	用行摘要判断是否可能有行满足条件
+	  Input:		pstCond	请求的条件，字段id为节点表定义的id
+	  Output:		
+	  Return:		0为一定没有行满足条件，1为可能有
+	*************************************************/
+	int may_match(const DTCFieldValue *pstCond) const;
+
 	/*************************************************
 	  Description:	更新最后访问时间戳
 	  Input:	时间戳	
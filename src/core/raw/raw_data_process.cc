@@ -19,6 +19,7 @@
 #include <string.h>
 
 #include "raw_data_process.h"
+#include "raw_snapshot.h"
 #include "global.h"
 #include "log/log.h"
 #include "sys_malloc.h"
@@ -37,6 +38,7 @@ RawDataProcess::RawDataProcess(MallocBase *pstMalloc,
 {
 	memcpy(&update_mode_, pstUpdateMode, sizeof(update_mode_));
 	nodeSizeLimit = 0;
+	snapshot_rows_ = 0;
 	history_datasize = g_stat_mgr.get_sample(DATA_SIZE_HISTORY_STAT);
 	history_rowsize = g_stat_mgr.get_sample(ROW_SIZE_HISTORY_STAT);
 }
@@ -109,7 +111,7 @@ int RawDataProcess::get_node_all_rows_count(Node *p_node, RawData *pstRows)
 	}
 
 	pstRows->set_refrence(&raw_data_);
-	if (pstRows->copy_all() != 0) {
+	if (pstRows->copy_all_decoded() != 0) {
 		log4cplus_error("copy data error: %d,%s", iRet,
 				pstRows->get_err_msg());
 		return (-2);
@@ -331,8 +333,11 @@ int RawDataProcess::get_dirty_row_count(DTCJobOperation &job_op, Node *p_node)
 
 	DTCTableDefinition *t = raw_data_.get_node_table_def();
 	RowValue stRow(t);
+	/* only the row flags are needed */
+	uint8_t fieldMask[32];
+	FIELD_ZERO(fieldMask);
 	for (unsigned int i = 0; i < uiTotalRows; i++) {
-		iRet = raw_data_.decode_row(stRow, uchRowFlags, 0);
+		iRet = raw_data_.decode_row(stRow, uchRowFlags, 0, fieldMask);
 		if (iRet != 0) {
 			log4cplus_error("raw-data decode row error: %d,%s",
 					iRet, raw_data_.get_err_msg());
@@ -383,6 +388,10 @@ int RawDataProcess::do_delete(DTCJobOperation &job_op, Node *p_node,
 	int iAffectRows = 0;
 	unsigned char uchRowFlags;
 	unsigned int uiTotalRows = raw_data_.total_rows();
+	/* 行摘要表明没有行满足条件，不用逐行解码 */
+	if (!job_op.all_rows() && stpNodeTab == stpTaskTab &&
+	    raw_data_.may_match(job_op.request_condition()) == 0)
+		uiTotalRows = 0;
 	for (unsigned int i = 0; i < uiTotalRows; i++) {
 		iRet = raw_data_.decode_row(*stpNodeRow, uchRowFlags, 0);
 		if (iRet != DTC_CODE_SUCCESS) {
@@ -438,11 +447,83 @@ int RawDataProcess::do_delete(DTCJobOperation &job_op, Node *p_node,
 	return DTC_CODE_SUCCESS;
 }
 
-int RawDataProcess::do_get(DTCJobOperation &job_op, Node *p_node)
+/*
+ * 逐行解码rows，满足条件的行加入job的结果。laid大于0时回写返回行的
+ * 最后访问时间，rows必须是cache线程attach的节点；快照只能传-1
+ */
+int RawDataProcess::append_rows(DTCJobOperation &job_op, RawData &rows,
+				int laid)
 {
 	int iRet;
 	DTCTableDefinition *stpNodeTab, *stpTaskTab;
 	RowValue *stpNodeRow, *stpTaskRow;
+	unsigned int uiTotalRows = rows.total_rows();
+
+	stpNodeTab = rows.get_node_table_def();
+	stpTaskTab = job_op.table_definition();
+	RowValue stNodeRow(stpNodeTab);
+	RowValue stTaskRow(stpTaskTab);
+	if (stpNodeTab == stpTaskTab) {
+		stpNodeRow = &stTaskRow;
+		stpTaskRow = &stTaskRow;
+	} else {
+		stpNodeRow = &stNodeRow;
+		stpTaskRow = &stTaskRow;
+	}
+	/*
+	 * 节点和请求同一个表定义时，只解码条件、返回字段和过期时间，
+	 * 其余字段跳过；count only只需要条件字段
+	 */
+	uint8_t fieldMask[32];
+	const uint8_t *pFieldMask = NULL;
+	if (stpNodeTab == stpTaskTab) {
+		FIELD_ZERO(fieldMask);
+		if (!job_op.all_rows())
+			job_op.request_condition()->build_field_mask(fieldMask);
+		if (!job_op.count_only())
+			job_op.request_fields()->build_field_mask(fieldMask);
+		if (stpTaskTab->expire_time_field_id() > 0)
+			FIELD_SET(stpTaskTab->expire_time_field_id(),
+				  fieldMask);
+		pFieldMask = fieldMask;
+	}
+	unsigned char uchRowFlags;
+	for (unsigned int i = 0; i < uiTotalRows; i++) //逐行拷贝数据
+	{
+		job_op.update_key(
+			*stpNodeRow); // use stpNodeRow is fine, as just modify key field
+		if ((iRet = rows.decode_row(*stpNodeRow, uchRowFlags, 0,
+					    pFieldMask)) != 0) {
+			log4cplus_error("raw-data decode row error: %d,%s",
+					iRet, rows.get_err_msg());
+			return (-2);
+		}
+		// this pointer compare is ok, as these two is both come from tabledefmanager. if they mean same, they are same object.
+		if (stpNodeTab != stpTaskTab) {
+			stpTaskRow->Copy(stpNodeRow);
+		}
+		if (job_op.compare_row(*stpTaskRow) == 0) //如果不符合查询条件
+			continue;
+
+		if (stpTaskTab->expire_time_field_id() > 0)
+			stpTaskRow->update_expire_time();
+		//当前行添加到task中
+		log4cplus_debug("append_row flag");
+		if (job_op.append_row(stpTaskRow) > 0 && laid > 0) {
+			rows.update_lastacc(job_op.Timestamp());
+		}
+		if (job_op.all_rows() && job_op.result_full()) {
+			job_op.set_total_rows((int)uiTotalRows);
+			break;
+		}
+	}
+	return (0);
+}
+
+int RawDataProcess::do_get(DTCJobOperation &job_op, Node *p_node)
+{
+	int iRet;
+	RawSnapshot *pstSnapshot;
 
 	log4cplus_debug("do_get start! ");
 
@@ -471,50 +552,19 @@ int RawDataProcess::do_get(DTCJobOperation &job_op, Node *p_node)
 		} else {
 			job_op.set_total_rows((int)uiTotalRows);
 		}
-	} else {
-		stpNodeTab = raw_data_.get_node_table_def();
-		stpTaskTab = job_op.table_definition();
-		RowValue stNodeRow(stpNodeTab);
-		RowValue stTaskRow(stpTaskTab);
-		if (stpNodeTab == stpTaskTab) {
-			stpNodeRow = &stTaskRow;
-			stpTaskRow = &stTaskRow;
-		} else {
-			stpNodeRow = &stNodeRow;
-			stpTaskRow = &stTaskRow;
-		}
-		unsigned char uchRowFlags;
-		for (unsigned int i = 0; i < uiTotalRows; i++) //逐行拷贝数据
-		{
-			job_op.update_key(
-				*stpNodeRow); // use stpNodeRow is fine, as just modify key field
-			if ((iRet = raw_data_.decode_row(
-				     *stpNodeRow, uchRowFlags, 0)) != 0) {
-				log4cplus_error(
-					"raw-data decode row error: %d,%s",
-					iRet, raw_data_.get_err_msg());
-				return (-2);
-			}
-			// this pointer compare is ok, as these two is both come from tabledefmanager. if they mean same, they are same object.
-			if (stpNodeTab != stpTaskTab) {
-				stpTaskRow->Copy(stpNodeRow);
-			}
-			if (job_op.compare_row(*stpTaskRow) ==
-			    0) //如果不符合查询条件
-				continue;
-
-			if (stpTaskTab->expire_time_field_id() > 0)
-				stpTaskRow->update_expire_time();
-			//当前行添加到task中
-			log4cplus_debug("append_row flag");
-			if (job_op.append_row(stpTaskRow) > 0 && laid > 0) {
-				raw_data_.update_lastacc(job_op.Timestamp());
-			}
-			if (job_op.all_rows() && job_op.result_full()) {
-				job_op.set_total_rows((int)uiTotalRows);
-				break;
-			}
-		}
+	} else if (!job_op.all_rows() &&
+		   raw_data_.get_node_table_def() ==
+			   job_op.table_definition() &&
+		   raw_data_.may_match(job_op.request_condition()) == 0) {
+		/* 行摘要表明没有行满足条件，不用逐行解码 */
+	} else if (snapshot_rows_ > 0 && uiTotalRows >= snapshot_rows_ &&
+		   laid <= 0 && !job_op.is_batch_request() &&
+		   job_op.owner_client() != NULL &&
+		   (pstSnapshot = RawSnapshot::create(raw_data_)) != NULL) {
+		/* 大节点只拷贝一次内存，由回包线程解码 */
+		job_op.set_row_source(pstSnapshot);
+	} else if ((iRet = append_rows(job_op, raw_data_, laid)) != 0) {
+		return (iRet);
 	}
 	/*更新访问时间和查找操作计数*/
 	raw_data_.update_last_access_time_by_hour();
@@ -662,6 +712,40 @@ int RawDataProcess::do_append(DTCJobOperation &job_op, Node *p_node,
 	return DTC_CODE_SUCCESS;
 }
 
+/*
+ * 先过一遍helper返回的结果集，算出节点所有行编码后的大小，chunk一次
+ * 分配到位，逐行插入时不再realloc。失败时不报错，逐行插入自己处理内存不足。
+ */
+void RawDataProcess::reserve_result(DTCJobOperation &job_op, Node *p_node,
+				    RowValue *pstNodeRow)
+{
+	ResultSet *pstResultSet = job_op.result;
+	const DTCTableDefinition *stpNodeTab = pstNodeRow->table_definition();
+	const int keyIdx = stpNodeTab->key_fields() - 1;
+	uint64_t all_rows_size = 0;
+
+	if (pstResultSet->total_rows() <= 1)
+		return;
+
+	for (int i = 0; i < pstResultSet->total_rows(); i++) {
+		RowValue *pstRow = pstResultSet->_fetch_row();
+		if (pstRow == NULL)
+			break;
+		if (pstRow->table_definition() != stpNodeTab) {
+			pstNodeRow->Copy(pstRow);
+			pstRow = pstNodeRow;
+		}
+		all_rows_size += raw_data_.calc_row_size(*pstRow, keyIdx);
+	}
+	pstResultSet->rewind();
+
+	if (raw_data_.reserve(all_rows_size) == EC_NO_MEM &&
+	    p_buffer_pond_->try_purge_size(raw_data_.need_size(), *p_node) ==
+		    0)
+		raw_data_.reserve(all_rows_size);
+	p_node->vd_handle() = raw_data_.get_handle();
+}
+
 int RawDataProcess::do_replace_all(DTCJobOperation &job_op, Node *p_node)
 {
 	log4cplus_debug("do_replace_all start! ");
@@ -733,6 +817,7 @@ int RawDataProcess::do_replace_all(DTCJobOperation &job_op, Node *p_node)
 
 	if (job_op.result != NULL) {
 		ResultSet *pstResultSet = job_op.result;
+		reserve_result(job_op, p_node, stpNodeRow);
 		for (int i = 0; i < pstResultSet->total_rows(); i++) {
 			RowValue *pstRow = pstResultSet->_fetch_row();
 			if (pstRow == NULL) {
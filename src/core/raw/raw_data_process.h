@@ -49,6 +49,7 @@ class RawDataProcess : public DataProcess {
 	char err_message_[4096];
 
 	unsigned int nodeSizeLimit; // -DEBUG-
+	unsigned int snapshot_rows_; // get的行数达到此值时交给回包线程解码，0为关闭
 
 	/*对历史节点数据的采样统计，放在高端内存操作管理的地方，便于收敛统计点 , modify by tomchen 2014.08.27*/
 	StatSample history_datasize;
@@ -61,6 +62,12 @@ class RawDataProcess : public DataProcess {
 
     private:
 	int encode_to_private_area(RawData &, RowValue &, unsigned char);
+	void reserve_result(DTCJobOperation &job_op, Node *p_node,
+			    RowValue *pstNodeRow);
+
+    public:
+	static int append_rows(DTCJobOperation &job_op, RawData &rows,
+			       int laid);
 
     public:
 	RawDataProcess(MallocBase *pstMalloc,
@@ -72,6 +79,10 @@ class RawDataProcess : public DataProcess {
 	{
 		nodeSizeLimit = node_size;
 	} // -DEBUG-
+	void set_snapshot_rows(int rows)
+	{
+		snapshot_rows_ = rows < 0 ? 0 : rows;
+	}
 
 	const char *get_err_msg()
 	{
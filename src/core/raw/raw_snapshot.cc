@@ -0,0 +1,64 @@
+/*
+* Copyright [2021] JD.com, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <string.h>
+
+#include "raw_snapshot.h"
+#include "raw_data_process.h"
+#include "sys_malloc.h"
+#include "log/log.h"
+
+DTC_USING_NAMESPACE
+
+RawSnapshot::RawSnapshot() : rows_(&g_stSysMalloc, 1)
+{
+}
+
+RawSnapshot::~RawSnapshot()
+{
+}
+
+RawSnapshot *RawSnapshot::create(RawData &pstFrom)
+{
+	RawSnapshot *pstSnapshot;
+	NEW(RawSnapshot, pstSnapshot);
+	if (pstSnapshot == NULL)
+		return (NULL);
+
+	ALLOC_SIZE_T uiSize = pstFrom.data_size();
+	MEM_HANDLE_T hHandle = g_stSysMalloc.Malloc(uiSize);
+	if (hHandle == INVALID_HANDLE) {
+		log4cplus_warning("raw-data snapshot malloc %u error: %s",
+				  uiSize, g_stSysMalloc.get_err_msg());
+		delete pstSnapshot;
+		return (NULL);
+	}
+	memcpy(g_stSysMalloc.handle_to_ptr(hHandle), pstFrom.get_addr(),
+	       uiSize);
+	if (pstSnapshot->rows_.do_attach(hHandle) != 0) {
+		log4cplus_error("raw-data snapshot attach error: %s",
+				pstSnapshot->rows_.get_err_msg());
+		/* 句柄已交给rows_，随快照释放 */
+		delete pstSnapshot;
+		return (NULL);
+	}
+	return (pstSnapshot);
+}
+
+int RawSnapshot::fill_result(DTCJobOperation &job_op)
+{
+	return RawDataProcess::append_rows(job_op, rows_, -1);
+}
@@ -0,0 +1,58 @@
+/*
+* Copyright [2021] JD.com, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef RAW_SNAPSHOT_H
+#define RAW_SNAPSHOT_H
+
+#include "namespace.h"
+#include "raw_data.h"
+#include "task/task_request.h"
+
+DTC_BEGIN_NAMESPACE
+
+// get结果的节点快照：cache线程把节点内存整块拷贝到进程私有的堆上，
+// 交给job，由回包线程解码、过滤并填充结果。快照是节点的一个只读版本，
+// 之后对节点的修改、realloc或淘汰都不影响它，不需要推迟释放共享内存。
+// 字典字段解码后指向共享字典，字典只追加，可以跨线程读。
+class RawSnapshot : public JobRowSource {
+    private:
+	RawData rows_;
+
+	RawSnapshot();
+
+    public:
+	virtual ~RawSnapshot();
+
+	/*************************************************
+	  Description:	拷贝一个已attach的节点
+	  Input:		pstFrom	节点数据
+	  Output:		
+	  Return:		快照，内存不足或attach失败返回NULL
+	*************************************************/
+	static RawSnapshot *create(RawData &pstFrom);
+
+	/*************************************************
+	  Description:	解码快照中的行，满足条件的加入job的结果
+	  Input:		job_op	快照所属的请求
+	  Output:		
+	  Return:		0为成功，非0失败
+	*************************************************/
+	virtual int fill_result(DTCJobOperation &job_op);
+};
+
+DTC_END_NAMESPACE
+
+#endif
@@ -0,0 +1,146 @@
+/*
+* Copyright [2021] JD.com, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "miss_coalescer.h"
+#include "poll/poller_base.h"
+#include "algorithm/timestamp.h"
+#include "log/log.h"
+
+DTC_USING_NAMESPACE
+
+MissCoalescer::MissCoalescer(JobAskInterface<DTCJobOperation> *o, int to)
+	: timeout_(to), timelist_(0), owner_(o), resuming_(0)
+{
+	timelist_ = owner_->owner->get_timer_list(timeout_);
+
+	stat_coalesced_count_ =
+		g_stat_mgr.get_stat_int_counter(DTC_COALESCED_MISS_COUNT);
+	stat_coalesced_bypass_ =
+		g_stat_mgr.get_stat_int_counter(DTC_COALESCED_MISS_BYPASS);
+	stat_coalesced_wait_ = g_stat_mgr.get_sample(DTC_COALESCED_MISS_USEC);
+}
+
+MissCoalescer::~MissCoalescer()
+{
+	std::map<std::string, flight_t>::iterator it;
+	std::list<waiter_t>::iterator wt;
+
+	for (it = inflight_.begin(); it != inflight_.end(); ++it)
+		ready_.splice(ready_.end(), it->second.waiters);
+
+	//把所有请求踢回客户端
+	for (wt = ready_.begin(); wt != ready_.end(); ++wt) {
+		wt->job->set_error(-ETIMEDOUT, __FUNCTION__,
+				   "object deconstruct");
+		wt->job->turn_around_job_answer();
+	}
+}
+
+int MissCoalescer::try_join(DTCJobOperation *job, const char *key, int len)
+{
+	if (job == resuming_)
+		return 0;
+
+	std::string k(key, len);
+	std::map<std::string, flight_t>::iterator it = inflight_.find(k);
+	if (it == inflight_.end()) {
+		// first miss becomes the leader
+		flight_t &f = inflight_[k];
+		f.leader = job;
+		f.start = time(NULL);
+		// ready timer re-attaches the timeout check by itself
+		if (inflight_.size() == 1 && ready_.empty())
+			attach_timer(timelist_);
+		return 0;
+	}
+
+	waiter_t w = { job, GET_TIMESTAMP(), false };
+	it->second.waiters.push_back(w);
+	++stat_coalesced_count_;
+	log4cplus_debug("coalesce miss behind in-flight fill, waiters: %d",
+			(int)it->second.waiters.size());
+	return 1;
+}
+
+void MissCoalescer::complete(DTCJobOperation *job, const char *key, int len,
+			     bool filled)
+{
+	if (inflight_.empty())
+		return;
+
+	std::map<std::string, flight_t>::iterator it =
+		inflight_.find(std::string(key, len));
+	// not a leader, or flight already timed out
+	if (it == inflight_.end() || it->second.leader != job)
+		return;
+
+	release(it->second.waiters, !filled);
+	inflight_.erase(it);
+}
+
+void MissCoalescer::release(std::list<waiter_t> &w, bool bypass)
+{
+	if (w.empty())
+		return;
+
+	if (bypass) {
+		std::list<waiter_t>::iterator it;
+		for (it = w.begin(); it != w.end(); ++it)
+			it->bypass = true;
+		stat_coalesced_bypass_ += w.size();
+	}
+
+	ready_.splice(ready_.end(), w);
+	// re-dispatch outside the current cache transaction
+	attach_ready_timer(owner_->owner);
+}
+
+void MissCoalescer::job_timer_procedure(void)
+{
+	log4cplus_debug("enter timer procedure");
+	std::list<waiter_t> copy;
+	copy.swap(ready_);
+
+	time_t now = time(NULL);
+	std::map<std::string, flight_t>::iterator it, next;
+	for (it = inflight_.begin(); it != inflight_.end(); it = next) {
+		next = it;
+		++next;
+		//超时处理, leader的应答到达时会因找不到flight被忽略
+		if (it->second.start + timeout_ < now) {
+			std::list<waiter_t> &w = it->second.waiters;
+			std::list<waiter_t>::iterator wt;
+			for (wt = w.begin(); wt != w.end(); ++wt)
+				wt->bypass = true;
+			stat_coalesced_bypass_ += w.size();
+			copy.splice(copy.end(), w);
+			inflight_.erase(it);
+		}
+	}
+
+	int64_t ts = GET_TIMESTAMP();
+	std::list<waiter_t>::iterator wt;
+	for (wt = copy.begin(); wt != copy.end(); ++wt) {
+		stat_coalesced_wait_.push(ts - wt->since);
+		resuming_ = wt->bypass ? wt->job : 0;
+		owner_->job_ask_procedure(wt->job);
+	}
+	resuming_ = 0;
+
+	if (!inflight_.empty())
+		attach_timer(timelist_);
+	log4cplus_debug("leave timer procedure");
+}
@@ -0,0 +1,86 @@
+/*
+* Copyright [2021] JD.com, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef __TASK_MISS_COALESCER_H
+#define __TASK_MISS_COALESCER_H
+
+#include <list>
+#include <map>
+#include <string>
+
+#include "timer/timer_list.h"
+#include "namespace.h"
+#include "task/task_request.h"
+#include "stat_dtc.h"
+
+DTC_BEGIN_NAMESPACE
+/*
+ * cache miss 合并表。
+ *
+ * 同一个packed key的并发GET miss只让第一个(leader)去数据源回读，
+ * 其余请求挂在leader上，等leader回读结果写入cache后重新投递，
+ * 从刚装载的节点中直接应答。
+ *     1. leader回读后节点未能进cache(超限/失败)，等待者各自直连数据源
+ *     2. 等待超时的请求同样各自直连数据源
+ */
+class MissCoalescer : private TimerObject {
+    public:
+	MissCoalescer(JobAskInterface<DTCJobOperation> *o, int timeout = 5);
+	~MissCoalescer();
+
+	// 1: job parked behind an in-flight fill, 0: job should go datasource
+	int try_join(DTCJobOperation *job, const char *key, int len);
+	// leader replied, filled indicates whether the node is resident now
+	void complete(DTCJobOperation *job, const char *key, int len,
+		      bool filled);
+
+    private:
+	virtual void job_timer_procedure(void);
+	struct waiter_t {
+		DTCJobOperation *job;
+		int64_t since;
+		bool bypass;
+	};
+	void release(std::list<waiter_t> &w, bool bypass);
+
+    private:
+	MissCoalescer(const MissCoalescer &);
+	const MissCoalescer &operator=(const MissCoalescer &);
+
+    private:
+	struct flight_t {
+		DTCJobOperation *leader;
+		time_t start;
+		std::list<waiter_t> waiters;
+	};
+
+	int timeout_;
+	TimerList *timelist_;
+	JobAskInterface<DTCJobOperation> *owner_;
+	std::map<std::string, flight_t> inflight_;
+	// jobs waiting to be re-dispatched by the ready timer
+	std::list<waiter_t> ready_;
+	// job being re-dispatched which must not join a flight again
+	DTCJobOperation *resuming_;
+
+	StatCounter stat_coalesced_count_;
+	StatCounter stat_coalesced_bypass_;
+	StatSample stat_coalesced_wait_;
+};
+
+DTC_END_NAMESPACE
+
+#endif
@@ -0,0 +1,161 @@
+/*
+* Copyright [2021] JD.com, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+
+#include "expire_index.h"
+
+DTC_USING_NAMESPACE
+
+#define EXPIRE_INDEX_SIZE(n)                                                   \
+	(sizeof(EXPIRE_INDEX_INFO_T) + (n) * sizeof(EXPIRE_ENTRY_T))
+
+ExpireIndex::ExpireIndex()
+	: info_(NULL), handle_(INVALID_HANDLE), max_entries_(4 << 20), drops_(0)
+{
+	memset(errmsg_, 0, sizeof(errmsg_));
+}
+
+ExpireIndex::~ExpireIndex()
+{
+}
+
+int ExpireIndex::init(uint32_t capacity)
+{
+	handle_ = M_CALLOC(EXPIRE_INDEX_SIZE(capacity));
+	if (INVALID_HANDLE == handle_) {
+		snprintf(errmsg_, sizeof(errmsg_),
+			 "init expire index fail, %s", M_ERROR());
+		return -ENOMEM;
+	}
+
+	info_ = M_POINTER(EXPIRE_INDEX_INFO_T, handle_);
+	info_->ei_size = 0;
+	info_->ei_capacity = capacity;
+	info_->ei_lossy = 0;
+
+	return DTC_CODE_SUCCESS;
+}
+
+int ExpireIndex::attach(MEM_HANDLE_T handle)
+{
+	if (INVALID_HANDLE == handle) {
+		snprintf(errmsg_, sizeof(errmsg_),
+			 "attach expire index failed, memory handle = 0");
+		return DTC_CODE_FAILED;
+	}
+
+	handle_ = handle;
+	info_ = M_POINTER(EXPIRE_INDEX_INFO_T, handle_);
+
+	return DTC_CODE_SUCCESS;
+}
+
+void ExpireIndex::detach(void)
+{
+	info_ = NULL;
+	handle_ = INVALID_HANDLE;
+}
+
+int ExpireIndex::grow(void)
+{
+	uint32_t n = info_->ei_capacity * 2;
+	if (n > max_entries_)
+		n = max_entries_;
+	if (n <= info_->ei_capacity)
+		return -1;
+
+	MEM_HANDLE_T h = M_REALLOC(handle_, EXPIRE_INDEX_SIZE(n));
+	if (INVALID_HANDLE == h) {
+		snprintf(errmsg_, sizeof(errmsg_),
+			 "grow expire index to %u fail, %s", n, M_ERROR());
+		return -1;
+	}
+
+	handle_ = h;
+	info_ = M_POINTER(EXPIRE_INDEX_INFO_T, handle_);
+	info_->ei_capacity = n;
+	return 0;
+}
+
+int ExpireIndex::push(NODE_ID_T id, uint32_t expire)
+{
+	if (info_->ei_size == info_->ei_capacity && grow() != 0) {
+		info_->ei_lossy = 1;
+		++drops_;
+		return -1;
+	}
+
+	EXPIRE_ENTRY_T &e = info_->ei_heap[info_->ei_size];
+	e.ee_expire = expire;
+	e.ee_node = id;
+	sift_up(info_->ei_size++);
+	return 0;
+}
+
+void ExpireIndex::pop(void)
+{
+	if (info_->ei_size == 0)
+		return;
+
+	info_->ei_heap[0] = info_->ei_heap[--info_->ei_size];
+	sift_down(0);
+}
+
+void ExpireIndex::sift_up(uint32_t i)
+{
+	EXPIRE_ENTRY_T *h = info_->ei_heap;
+	EXPIRE_ENTRY_T e = h[i];
+
+	while (i > 0) {
+		uint32_t p = (i - 1) / 2;
+		if (h[p].ee_expire <= e.ee_expire)
+			break;
+		h[i] = h[p];
+		i = p;
+	}
+	h[i] = e;
+}
+
+void ExpireIndex::sift_down(uint32_t i)
+{
+	EXPIRE_ENTRY_T *h = info_->ei_heap;
+	uint32_t n = info_->ei_size;
+	if (i >= n)
+		return;
+	EXPIRE_ENTRY_T e = h[i];
+
+	for (;;) {
+		uint32_t c = i * 2 + 1;
+		if (c >= n)
+			break;
+		if (c + 1 < n && h[c + 1].ee_expire < h[c].ee_expire)
+			++c;
+		if (e.ee_expire <= h[c].ee_expire)
+			break;
+		h[i] = h[c];
+		i = c;
+	}
+	h[i] = e;
+}
+
+void ExpireIndex::rebuild(void)
+{
+	for (uint32_t i = info_->ei_size / 2; i > 0; i--)
+		sift_down(i - 1);
+}
@@ -0,0 +1,139 @@
+/*
+* Copyright [2021] JD.com, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef __DTC_EXPIRE_INDEX_H
+#define __DTC_EXPIRE_INDEX_H
+
+#include <stdint.h>
+
+#include "namespace.h"
+#include "global.h"
+
+DTC_BEGIN_NAMESPACE
+
+struct expire_entry {
+	uint32_t ee_expire; // absolute expire second
+	NODE_ID_T ee_node; // node id
+};
+typedef struct expire_entry EXPIRE_ENTRY_T;
+
+struct expire_index_info {
+	uint32_t ei_size; // entries in heap
+	uint32_t ei_capacity; // allocated entries
+	uint32_t ei_lossy; // some ttl nodes are not indexed
+	uint32_t ei_reserve;
+	EXPIRE_ENTRY_T ei_heap[0];
+};
+typedef struct expire_index_info EXPIRE_INDEX_INFO_T;
+
+/*
+ * 共享内存中按过期时间排序的小顶堆，作为EXPIRE_INDEX特性挂在feature表中，
+ * 重启attach后仍然有效。
+ *
+ * 节点更新过期时间时只插入新条目，不删除旧条目；出堆时由调用者根据节点
+ * 当前的过期时间判断条目是否已失效(节点已淘汰、过期时间被推后或node id
+ * 被复用)。
+ */
+class ExpireIndex {
+    public:
+	ExpireIndex();
+	~ExpireIndex();
+
+	int init(uint32_t capacity);
+	int attach(MEM_HANDLE_T handle);
+	void detach(void);
+
+	const char *error() const
+	{
+		return errmsg_;
+	}
+	// handle changes when the heap grows
+	MEM_HANDLE_T get_handle() const
+	{
+		return handle_;
+	}
+
+	uint32_t size() const
+	{
+		return info_->ei_size;
+	}
+	uint32_t capacity() const
+	{
+		return info_->ei_capacity;
+	}
+	bool lossy() const
+	{
+		return info_->ei_lossy != 0;
+	}
+	void set_lossy(bool v = true)
+	{
+		info_->ei_lossy = v ? 1 : 0;
+	}
+	uint32_t max_entries() const
+	{
+		return max_entries_;
+	}
+	void set_max_entries(uint32_t m)
+	{
+		max_entries_ = m;
+	}
+
+	// 0: ok, -1: index full, entry dropped and index marked lossy
+	int push(NODE_ID_T id, uint32_t expire);
+	// entries dropped by push() since this process attached
+	uint32_t drops() const
+	{
+		return drops_;
+	}
+	const EXPIRE_ENTRY_T *top(void) const
+	{
+		return info_->ei_size ? &info_->ei_heap[0] : NULL;
+	}
+	void pop(void);
+	void clear(void)
+	{
+		info_->ei_size = 0;
+	}
+	// drop entries rejected by keep(), then re-heapify
+	template <class Pred> uint32_t compact(Pred keep)
+	{
+		uint32_t i, n = 0;
+		for (i = 0; i < info_->ei_size; i++)
+			if (keep(info_->ei_heap[i]))
+				info_->ei_heap[n++] = info_->ei_heap[i];
+		i = info_->ei_size - n;
+		info_->ei_size = n;
+		rebuild();
+		return i;
+	}
+
+    private:
+	int grow(void);
+	void sift_up(uint32_t i);
+	void sift_down(uint32_t i);
+	void rebuild(void);
+
+    private:
+	EXPIRE_INDEX_INFO_T *info_;
+	MEM_HANDLE_T handle_;
+	uint32_t max_entries_;
+	uint32_t drops_;
+	char errmsg_[256];
+};
+
+DTC_END_NAMESPACE
+
+#endif
@@ -22,7 +22,9 @@ DTC_USING_NAMESPACE
 
 ExpireTime::ExpireTime(TimerList *t, BufferPond *c, DataProcess *p,
 		       DTCTableDefinition *td, int e)
-	: timer(t), cache(c), process(p), table_definition_(td), max_expire_(e)
+	: timer(t), cache(c), process(p), table_definition_(td), max_expire_(e),
+	  index_(NULL), index_batch_(10000), pushes_since_compact_(~0U),
+	  rebuild_next_(INVALID_NODE_ID), rebuild_end_(0), rebuild_drops_(0)
 {
 	stat_expire_count =
 		g_stat_mgr.get_stat_int_counter(DTC_KEY_EXPIRE_DTC_COUNT);
@@ -35,10 +37,16 @@ ExpireTime::ExpireTime(TimerList *t, BufferPond *c, DataProcess *p,
 		g_stat_mgr.get_stat_int_counter(DTC_DELETE_COUNT);
 	stat_purge_request_count =
 		g_stat_mgr.get_stat_int_counter(DTC_PURGE_COUNT);
+	stat_expire_lag = g_stat_mgr.get_sample(DTC_KEY_EXPIRE_LAG);
+	stat_index_size =
+		g_stat_mgr.get_stat_int_counter(DTC_KEY_EXPIRE_INDEX_SIZE);
+	stat_index_stale =
+		g_stat_mgr.get_stat_int_counter(DTC_KEY_EXPIRE_INDEX_STALE);
 }
 
 ExpireTime::~ExpireTime()
 {
+	DELETE(index_);
 }
 
 void ExpireTime::start_key_expired_task(void)
@@ -48,6 +56,180 @@ void ExpireTime::start_key_expired_task(void)
 	return;
 }
 
+int ExpireTime::attach_index(uint32_t max_entries, int batch)
+{
+	FEATURE_INFO_T *feature = cache->query_feature_by_id(EXPIRE_INDEX);
+
+	index_batch_ = batch;
+	NEW(ExpireIndex, index_);
+	if (index_ == NULL) {
+		log4cplus_error("new expire index error: %m");
+		return -1;
+	}
+	index_->set_max_entries(max_entries);
+
+	if (feature != NULL) {
+		if (index_->attach(feature->fi_handle) != 0) {
+			log4cplus_error("expire index attach error: %s",
+					index_->error());
+			return -1;
+		}
+		log4cplus_info("attach expire index, entries: %u, lossy: %d",
+			       index_->size(), index_->lossy());
+		return 0;
+	}
+
+	if (index_->init(index_->max_entries() < 1024 ?
+				 index_->max_entries() :
+				 1024) != 0) {
+		log4cplus_error("expire index init error: %s",
+				index_->error());
+		return -1;
+	}
+	if (cache->add_feature(EXPIRE_INDEX, index_->get_handle()) != 0) {
+		log4cplus_error("add expire index feature error");
+		return -1;
+	}
+	// nodes cached before the index existed are added by rebuild_index()
+	if (cache->get_total_used_node() > 0)
+		index_->set_lossy();
+	log4cplus_info("create expire index, lossy: %d", index_->lossy());
+	return 0;
+}
+
+int ExpireTime::reset_index(void)
+{
+	if (index_ == NULL)
+		return 0;
+
+	index_->detach();
+	rebuild_next_ = INVALID_NODE_ID;
+	pushes_since_compact_ = ~0U;
+	if (index_->init(index_->max_entries() < 1024 ?
+				 index_->max_entries() :
+				 1024) != 0) {
+		log4cplus_error("expire index init error: %s",
+				index_->error());
+		return -1;
+	}
+	return cache->add_feature(EXPIRE_INDEX, index_->get_handle());
+}
+
+int ExpireTime::save_index_handle(void)
+{
+	FEATURE_INFO_T *feature = cache->query_feature_by_id(EXPIRE_INDEX);
+	if (feature == NULL)
+		return -1;
+	feature->fi_handle = index_->get_handle();
+	return 0;
+}
+
+uint32_t ExpireTime::node_expire(Node node)
+{
+	uint32_t expire = 0;
+	if (!node || node.vd_handle() == INVALID_HANDLE)
+		return 0;
+	if (process->get_expire_time(table_definition_, &node, expire) != 0)
+		return 0;
+	return expire;
+}
+
+// 条目仍然有效: 节点在用且当前过期时间与条目一致
+struct ExpireEntryAlive {
+	ExpireTime *owner;
+	BufferPond *cache;
+	bool operator()(const EXPIRE_ENTRY_T &e) const
+	{
+		Node node = I_SEARCH(e.ee_node);
+		if (!node || node.not_in_lru_list() ||
+		    cache->is_time_marker(node))
+			return false;
+		return owner->node_expire(node) == e.ee_expire;
+	}
+};
+
+void ExpireTime::compact_index(void)
+{
+	ExpireEntryAlive alive = { this, cache };
+	uint32_t n = index_->compact(alive);
+	stat_index_stale += n;
+	pushes_since_compact_ = 0;
+	log4cplus_info("expire index compacted, %u stale entries dropped", n);
+}
+
+void ExpireTime::push_index(NODE_ID_T id, uint32_t expire)
+{
+	MEM_HANDLE_T h = index_->get_handle();
+	// 堆已满时整理一次是O(n)，两次整理之间至少间隔半个堆的入堆次数
+	if (index_->size() == index_->capacity() &&
+	    index_->capacity() >= index_->max_entries() &&
+	    pushes_since_compact_ >= index_->capacity() / 2)
+		compact_index();
+	if (pushes_since_compact_ < index_->capacity())
+		++pushes_since_compact_;
+
+	if (index_->push(id, expire) != 0)
+		log4cplus_error("expire index full, fallback to sampling: %s",
+				index_->error());
+	if (h != index_->get_handle())
+		save_index_handle();
+	stat_index_size = index_->size();
+}
+
+void ExpireTime::index_node(Node node, uint32_t old_expire)
+{
+	if (index_ == NULL || !node)
+		return;
+
+	uint32_t expire = node_expire(node);
+	// 过期时间未变化的更新不重复入堆
+	if (expire == 0 || expire == old_expire)
+		return;
+	push_index(node.node_id(), expire);
+}
+
+/*
+ * 索引不完整时清空堆，分批扫描所有节点重新入堆，扫描期间的写入照常入堆，
+ * 未扫描到的节点仍由采样淘汰。整轮没有条目被丢弃才清除lossy。
+ */
+void ExpireTime::rebuild_index(void)
+{
+	if (!rebuilding()) {
+		index_->clear();
+		pushes_since_compact_ = ~0U;
+		rebuild_next_ = cache->get_min_valid_node_id();
+		rebuild_end_ = cache->max_node_id();
+		rebuild_drops_ = index_->drops();
+		log4cplus_info("expire index lossy, rebuild node %u - %u",
+			       rebuild_next_, rebuild_end_);
+	}
+
+	for (int budget = index_batch_;
+	     budget > 0 && rebuild_next_ <= rebuild_end_;
+	     --budget, ++rebuild_next_) {
+		Node node = I_SEARCH(rebuild_next_);
+		if (!node || node.not_in_lru_list() ||
+		    cache->is_time_marker(node))
+			continue;
+		uint32_t expire = node_expire(node);
+		if (expire != 0)
+			push_index(node.node_id(), expire);
+	}
+	if (rebuild_next_ <= rebuild_end_)
+		return;
+
+	rebuild_next_ = INVALID_NODE_ID;
+	if (index_->drops() == rebuild_drops_) {
+		index_->set_lossy(false);
+		log4cplus_info("expire index rebuilt, entries: %u",
+			       index_->size());
+	} else {
+		log4cplus_error("expire index still full after rebuild, %u "
+				"entries dropped",
+				index_->drops() - rebuild_drops_);
+	}
+}
+
 int ExpireTime::try_expire_count()
 {
 	int num1 = max_expire_ - (stat_get_request_count.get() +
@@ -60,16 +242,58 @@ int ExpireTime::try_expire_count()
 	return num1 < num2 ? num1 : num2;
 }
 
-void ExpireTime::job_timer_procedure(void)
+int ExpireTime::purge_expired(Node node)
+{
+	cache->inc_total_row(0LL - cache->node_rows_count(node));
+	if (cache->purge_node_and_data(node) != 0) {
+		log4cplus_error("purge node error, node: %d", node.node_id());
+		return -1;
+	}
+	++stat_expire_count;
+	return 0;
+}
+
+void ExpireTime::expire_by_index(uint32_t now)
+{
+	const EXPIRE_ENTRY_T *e;
+	int budget = index_batch_, k = 0;
+
+	while (budget-- > 0 && (e = index_->top()) != NULL &&
+	       e->ee_expire <= now) {
+		NODE_ID_T id = e->ee_node;
+		uint32_t due = e->ee_expire;
+		index_->pop();
+
+		Node node = I_SEARCH(id);
+		if (!node || node.not_in_lru_list() ||
+		    cache->is_time_marker(node)) {
+			// purged already
+			++stat_index_stale;
+			continue;
+		}
+		uint32_t expire = node_expire(node);
+		if (expire == 0 || expire > now) {
+			// ttl was extended or node id reused, a newer entry exists
+			++stat_index_stale;
+			continue;
+		}
+		log4cplus_debug("expire index purge node: %d, due: %u",
+				node.node_id(), due);
+		stat_expire_lag.push(now - expire);
+		if (purge_expired(node) == 0)
+			++k;
+	}
+	stat_index_size = index_->size();
+	log4cplus_debug("expire index purged %d node, %u left", k,
+			index_->size());
+}
+
+void ExpireTime::expire_by_sample(struct timeval &tv)
 {
-	log4cplus_debug("enter timer procedure");
-	log4cplus_debug("sched key expire job");
 	int start = cache->get_min_valid_node_id(), end = cache->max_node_id();
 	int count, interval = end - start, node_id;
 	int i, j, k = 0;
-	struct timeval tv;
 
-	gettimeofday(&tv, NULL);
 	log4cplus_debug("tv.tv_usec: %ld", tv.tv_usec);
 	srandom(tv.tv_usec);
 	count = try_expire_count();
@@ -98,18 +322,29 @@ void ExpireTime::job_timer_procedure(void)
 				log4cplus_debug(
 					"expire time timer purge node: %d, %d",
 					node.node_id(), ++k);
-				cache->inc_total_row(
-					0LL - cache->node_rows_count(node));
-				if (cache->purge_node_and_data(node) != 0) {
-					log4cplus_error(
-						"purge node error, node: %d",
-						node.node_id());
-				}
-				++stat_expire_count;
+				stat_expire_lag.push(tv.tv_sec - expire);
+				purge_expired(node);
 			}
 		}
 	}
 	log4cplus_debug("expire time found %d real node, %d", i, k);
+}
+
+void ExpireTime::job_timer_procedure(void)
+{
+	log4cplus_debug("enter timer procedure");
+	log4cplus_debug("sched key expire job");
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	if (index_ != NULL) {
+		expire_by_index(tv.tv_sec);
+		if (index_->lossy())
+			rebuild_index();
+	}
+	// 索引不完整(升级前的节点或索引溢出)时仍需随机采样兜底
+	if (index_ == NULL || index_->lossy())
+		expire_by_sample(tv);
 
 	attach_timer(timer);
 	log4cplus_debug("leave timer procedure");
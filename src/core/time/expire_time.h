@@ -24,6 +24,7 @@
 #include "buffer_pond.h"
 #include "data_process.h"
 #include "raw_data_process.h"
+#include "expire_index.h"
 
 DTC_BEGIN_NAMESPACE
 
@@ -37,6 +38,29 @@ class ExpireTime : private TimerObject {
 	void start_key_expired_task(void);
 	int try_expire_count();
 
+	// bind the persistent expire index, creating it on first start
+	int attach_index(uint32_t max_entries, int batch);
+	// shm was re-created by clear cache, old index is gone
+	int reset_index(void);
+	uint32_t node_expire(Node node);
+	// called after a write, old_expire is the value before the write
+	void index_node(Node node, uint32_t old_expire);
+
+	// scan index_batch_ node ids of a rebuild, starting one if idle
+	void rebuild_index(void);
+	int rebuilding(void) const
+	{
+		return rebuild_next_ != INVALID_NODE_ID;
+	}
+
+    private:
+	void expire_by_index(uint32_t now);
+	void expire_by_sample(struct timeval &tv);
+	int purge_expired(Node node);
+	int save_index_handle(void);
+	void push_index(NODE_ID_T id, uint32_t expire);
+	void compact_index(void);
+
     private:
 	TimerList *timer;
 	BufferPond *cache;
@@ -49,8 +73,21 @@ class ExpireTime : private TimerObject {
 	StatCounter stat_update_request_count;
 	StatCounter stat_delete_request_count;
 	StatCounter stat_purge_request_count;
+	StatSample stat_expire_lag;
+	StatCounter stat_index_size;
+	StatCounter stat_index_stale;
 
 	int max_expire_;
+	ExpireIndex *index_;
+	// max index entries popped/node ids rebuilt per tick
+	int index_batch_;
+	// pushes since the last compaction, compact at most once per half heap
+	uint32_t pushes_since_compact_;
+	// next/last node id to rebuild, INVALID_NODE_ID when idle
+	NODE_ID_T rebuild_next_;
+	NODE_ID_T rebuild_end_;
+	// index drops when the rebuild started
+	uint32_t rebuild_drops_;
 };
 
 DTC_END_NAMESPACE
@@ -0,0 +1,655 @@
+/*
+* Copyright [2021] JD.com, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "log/log.h"
+#include "b_tree.h"
+#include "value.h"
+#include "data_chunk.h"
+
+uint64_t KeyNormalize(const char *pchKey, void *pCmpCookie)
+{
+	CmpCookie *cookie = reinterpret_cast<CmpCookie *>(pCmpCookie);
+	const DTCValue *value = reinterpret_cast<const DTCValue *>(pchKey);
+
+	switch (cookie->p_table_->field_type(cookie->m_index_)) {
+	case DField::Signed:
+		// 翻转符号位，负数排在正数前面
+		return (uint64_t)value->s64 ^ (1ULL << 63);
+
+	case DField::Unsigned:
+		return value->u64;
+
+	default:
+		return 0;
+	}
+}
+
+void _BtreeNode::do_init(uint8_t chLeaf)
+{
+	m_chLeaf = chLeaf;
+	m_ushNItems = 0;
+	m_hPrev = INVALID_HANDLE;
+	m_hNext = INVALID_HANDLE;
+}
+
+int _BtreeNode::lower_bound(uint64_t ullKey) const
+{
+	int iLeft = 0;
+	int iRight = m_ushNItems;
+
+	while (iLeft < iRight) {
+		int i = (iLeft + iRight) >> 1;
+		if (m_aullKeys[i] < ullKey)
+			iLeft = i + 1;
+		else
+			iRight = i;
+	}
+	return iLeft;
+}
+
+int _BtreeNode::child_of(uint64_t ullKey) const
+{
+	int iLeft = 1;
+	int iRight = m_ushNItems;
+
+	while (iLeft < iRight) {
+		int i = (iLeft + iRight) >> 1;
+		if (m_aullKeys[i] <= ullKey)
+			iLeft = i + 1;
+		else
+			iRight = i;
+	}
+	return iLeft - 1;
+}
+
+void _BtreeNode::insert_at(int iPos, uint64_t ullKey, ALLOC_HANDLE_T hItem)
+{
+	int iMove = m_ushNItems - iPos;
+
+	memmove(&m_aullKeys[iPos + 1], &m_aullKeys[iPos],
+		iMove * sizeof(uint64_t));
+	memmove(&m_ahItems[iPos + 1], &m_ahItems[iPos],
+		iMove * sizeof(ALLOC_HANDLE_T));
+	m_aullKeys[iPos] = ullKey;
+	m_ahItems[iPos] = hItem;
+	m_ushNItems++;
+}
+
+void _BtreeNode::remove_at(int iPos)
+{
+	int iMove = m_ushNItems - iPos - 1;
+
+	memmove(&m_aullKeys[iPos], &m_aullKeys[iPos + 1],
+		iMove * sizeof(uint64_t));
+	memmove(&m_ahItems[iPos], &m_ahItems[iPos + 1],
+		iMove * sizeof(ALLOC_HANDLE_T));
+	m_ushNItems--;
+}
+
+/* 返回0插入成功，1节点分裂(hSplit为新的右兄弟)，-2 key已存在 */
+int _BtreeNode::do_insert(MallocBase &stMalloc, ALLOC_HANDLE_T hNode,
+			  uint64_t ullKey, ALLOC_HANDLE_T hRecord,
+			  ALLOC_HANDLE_T *phSpare, int &iSpare,
+			  uint64_t &ullSplitKey, ALLOC_HANDLE_T &hSplit)
+{
+	BtreeNode *p_node;
+	GET_OBJ(stMalloc, hNode, p_node);
+
+	int i;
+	if (p_node->m_chLeaf) {
+		i = p_node->lower_bound(ullKey);
+		if (i < p_node->m_ushNItems && p_node->m_aullKeys[i] == ullKey)
+			return (-2);
+	} else {
+		uint64_t ullChildKey;
+		ALLOC_HANDLE_T hChild;
+		int iChild = p_node->child_of(ullKey);
+		int iRet = do_insert(stMalloc, p_node->m_ahItems[iChild],
+				     ullKey, hRecord, phSpare, iSpare,
+				     ullChildKey, hChild);
+		if (iRet != 1)
+			return (iRet);
+		i = iChild + 1;
+		ullKey = ullChildKey;
+		hRecord = hChild;
+	}
+
+	if (p_node->m_ushNItems < PAGE_SIZE) {
+		p_node->insert_at(i, ullKey, hRecord);
+		return (0);
+	}
+
+	hSplit = phSpare[--iSpare];
+	BtreeNode *p_new;
+	GET_OBJ(stMalloc, hSplit, p_new);
+	p_new->do_init(p_node->m_chLeaf);
+
+	// 追加到最右边的叶子时新节点只放新key，按序插入得到的叶子都是满的
+	int iMove = PAGE_SIZE / 2;
+	if (p_node->m_chLeaf && i == PAGE_SIZE &&
+	    p_node->m_hNext == INVALID_HANDLE)
+		iMove = 0;
+
+	memcpy(p_new->m_aullKeys, &p_node->m_aullKeys[PAGE_SIZE - iMove],
+	       iMove * sizeof(uint64_t));
+	memcpy(p_new->m_ahItems, &p_node->m_ahItems[PAGE_SIZE - iMove],
+	       iMove * sizeof(ALLOC_HANDLE_T));
+	p_new->m_ushNItems = iMove;
+	p_node->m_ushNItems -= iMove;
+
+	// iMove为0时旧节点仍是满的，新key只能放进新节点
+	if (iMove && i <= p_node->m_ushNItems)
+		p_node->insert_at(i, ullKey, hRecord);
+	else
+		p_new->insert_at(i - p_node->m_ushNItems, ullKey, hRecord);
+
+	if (p_node->m_chLeaf) {
+		p_new->m_hPrev = hNode;
+		p_new->m_hNext = p_node->m_hNext;
+		if (p_node->m_hNext != INVALID_HANDLE) {
+			BtreeNode *p_next;
+			GET_OBJ(stMalloc, p_node->m_hNext, p_next);
+			p_next->m_hPrev = hSplit;
+		}
+		p_node->m_hNext = hSplit;
+	}
+
+	ullSplitKey = p_new->m_aullKeys[0];
+	return (1);
+}
+
+/* 返回0删除成功或key不存在，1节点已空(由上层释放) */
+int _BtreeNode::Delete(MallocBase &stMalloc, ALLOC_HANDLE_T hNode,
+		       uint64_t ullKey, int &iFreeNode)
+{
+	BtreeNode *p_node;
+	GET_OBJ(stMalloc, hNode, p_node);
+
+	if (p_node->m_chLeaf) {
+		int i = p_node->lower_bound(ullKey);
+		if (i >= p_node->m_ushNItems || p_node->m_aullKeys[i] != ullKey)
+			return (0);
+		p_node->remove_at(i);
+		return p_node->m_ushNItems == 0 ? 1 : 0;
+	}
+
+	int i = p_node->child_of(ullKey);
+	ALLOC_HANDLE_T hChild = p_node->m_ahItems[i];
+	int iRet = Delete(stMalloc, hChild, ullKey, iFreeNode);
+	if (iRet != 1)
+		return (iRet);
+
+	BtreeNode *p_child;
+	GET_OBJ(stMalloc, hChild, p_child);
+	if (p_child->m_chLeaf) {
+		BtreeNode *p_link;
+		if (p_child->m_hPrev != INVALID_HANDLE) {
+			GET_OBJ(stMalloc, p_child->m_hPrev, p_link);
+			p_link->m_hNext = p_child->m_hNext;
+		}
+		if (p_child->m_hNext != INVALID_HANDLE) {
+			GET_OBJ(stMalloc, p_child->m_hNext, p_link);
+			p_link->m_hPrev = p_child->m_hPrev;
+		}
+	}
+	stMalloc.Free(hChild);
+	iFreeNode++;
+
+	p_node->remove_at(i);
+	return p_node->m_ushNItems == 0 ? 1 : 0;
+}
+
+int _BtreeNode::destory(MallocBase &stMalloc, ALLOC_HANDLE_T hNode,
+			bool bFreeRecord)
+{
+	if (hNode == INVALID_HANDLE)
+		return (0);
+
+	BtreeNode *p_node;
+	GET_OBJ(stMalloc, hNode, p_node);
+	for (int i = 0; i < p_node->m_ushNItems; i++) {
+		if (!p_node->m_chLeaf)
+			destory(stMalloc, p_node->m_ahItems[i], bFreeRecord);
+		else if (bFreeRecord)
+			stMalloc.Free(p_node->m_ahItems[i]);
+	}
+	stMalloc.Free(hNode);
+
+	return (0);
+}
+
+unsigned _BtreeNode::ask_for_destroy_size(MallocBase &stMalloc,
+					  ALLOC_HANDLE_T hNode)
+{
+	unsigned size = 0;
+
+	if (hNode == INVALID_HANDLE)
+		return size;
+
+	BtreeNode *p_node;
+	GET_OBJ(stMalloc, hNode, p_node);
+	for (int i = 0; i < p_node->m_ushNItems; i++) {
+		if (p_node->m_chLeaf)
+			size += stMalloc.chunk_size(p_node->m_ahItems[i]);
+		else
+			size += ask_for_destroy_size(stMalloc,
+						     p_node->m_ahItems[i]);
+	}
+	size += stMalloc.chunk_size(hNode);
+
+	return size;
+}
+
+Btree::Btree(MallocBase &stMalloc) : m_stMalloc(stMalloc)
+{
+	root_handle_ = INVALID_HANDLE;
+	err_message_[0] = 0;
+}
+
+Btree::~Btree()
+{
+}
+
+unsigned Btree::node_size(void)
+{
+	return sizeof(BtreeNode);
+}
+
+ALLOC_HANDLE_T Btree::leaf_of(uint64_t ullKey)
+{
+	ALLOC_HANDLE_T hNode = root_handle_;
+	BtreeNode *p_node;
+
+	while (hNode != INVALID_HANDLE) {
+		GET_OBJ(m_stMalloc, hNode, p_node);
+		if (p_node->m_chLeaf)
+			break;
+		hNode = p_node->m_ahItems[p_node->child_of(ullKey)];
+	}
+	return hNode;
+}
+
+ALLOC_HANDLE_T Btree::first_node()
+{
+	ALLOC_HANDLE_T hNode = root_handle_;
+	BtreeNode *p_node;
+
+	if (hNode == INVALID_HANDLE)
+		return INVALID_HANDLE;
+	for (;;) {
+		GET_OBJ(m_stMalloc, hNode, p_node);
+		if (p_node->m_chLeaf)
+			return p_node->m_ahItems[0];
+		hNode = p_node->m_ahItems[0];
+	}
+}
+
+int Btree::do_insert(uint64_t ullKey, ALLOC_HANDLE_T hRecord, int &iAllocNode)
+{
+	ALLOC_HANDLE_T ahSpare[BtreeNode::MAX_DEPTH + 1];
+	int iSpare = 0;
+	int iDepth = 0;
+	BtreeNode *p_node;
+
+	iAllocNode = 0;
+
+	// 先数出路径上底部连续满的节点，分裂需要的节点提前分配好，
+	// 避免分裂到一半内存不足
+	int iNeed = 0;
+	for (ALLOC_HANDLE_T hNode = root_handle_; hNode != INVALID_HANDLE;) {
+		GET_OBJ(m_stMalloc, hNode, p_node);
+		iDepth++;
+		if (p_node->m_ushNItems < BtreeNode::PAGE_SIZE)
+			iNeed = 0;
+		else
+			iNeed++;
+		if (p_node->m_chLeaf)
+			break;
+		hNode = p_node->m_ahItems[p_node->child_of(ullKey)];
+	}
+	// 空树或者整条路径都满时还需要一个新的根节点
+	if (iNeed == iDepth)
+		iNeed++;
+	if (iDepth >= BtreeNode::MAX_DEPTH) {
+		snprintf(err_message_, sizeof(err_message_),
+			 "b+tree too deep: %d", iDepth);
+		return (-1);
+	}
+
+	for (; iSpare < iNeed; iSpare++) {
+		ahSpare[iSpare] = m_stMalloc.Malloc(sizeof(BtreeNode));
+		if (ahSpare[iSpare] == INVALID_HANDLE) {
+			snprintf(err_message_, sizeof(err_message_),
+				 "alloc tree-node error: %s",
+				 m_stMalloc.get_err_msg());
+			while (--iSpare >= 0)
+				m_stMalloc.Free(ahSpare[iSpare]);
+			return (EC_NO_MEM);
+		}
+	}
+
+	int iRet = 0;
+	if (root_handle_ == INVALID_HANDLE) {
+		root_handle_ = ahSpare[--iSpare];
+		GET_OBJ(m_stMalloc, root_handle_, p_node);
+		p_node->do_init(1);
+		p_node->insert_at(0, ullKey, hRecord);
+	} else {
+		uint64_t ullSplitKey;
+		ALLOC_HANDLE_T hSplit;
+		iRet = BtreeNode::do_insert(m_stMalloc, root_handle_, ullKey,
+					    hRecord, ahSpare, iSpare,
+					    ullSplitKey, hSplit);
+		if (iRet == 1) {
+			ALLOC_HANDLE_T hRoot = ahSpare[--iSpare];
+			GET_OBJ(m_stMalloc, hRoot, p_node);
+			p_node->do_init(0);
+			p_node->insert_at(0, 0, root_handle_);
+			p_node->insert_at(1, ullSplitKey, hSplit);
+			root_handle_ = hRoot;
+			iRet = 0;
+		}
+	}
+
+	iAllocNode = iNeed - iSpare;
+	while (--iSpare >= 0)
+		m_stMalloc.Free(ahSpare[iSpare]);
+
+	if (iRet == -2) {
+		snprintf(err_message_, sizeof(err_message_),
+			 "key already exists.");
+		return (EC_KEY_EXIST);
+	}
+	return (iRet);
+}
+
+int Btree::Delete(uint64_t ullKey, int &iFreeNode)
+{
+	iFreeNode = 0;
+	if (root_handle_ == INVALID_HANDLE)
+		return (0);
+
+	int iRet = BtreeNode::Delete(m_stMalloc, root_handle_, ullKey,
+				     iFreeNode);
+	if (iRet == 1) {
+		m_stMalloc.Free(root_handle_);
+		iFreeNode++;
+		root_handle_ = INVALID_HANDLE;
+		return (0);
+	} else if (iRet < 0) {
+		snprintf(err_message_, sizeof(err_message_), "tree error");
+		return (-1);
+	}
+
+	// 根节点只剩一个子树时降低树高
+	BtreeNode *p_node;
+	for (;;) {
+		GET_OBJ(m_stMalloc, root_handle_, p_node);
+		if (p_node->m_chLeaf || p_node->m_ushNItems > 1)
+			break;
+		ALLOC_HANDLE_T hChild = p_node->m_ahItems[0];
+		m_stMalloc.Free(root_handle_);
+		iFreeNode++;
+		root_handle_ = hChild;
+	}
+
+	return (0);
+}
+
+int Btree::do_find(uint64_t ullKey, ALLOC_HANDLE_T *&phRecord)
+{
+	phRecord = NULL;
+
+	ALLOC_HANDLE_T hNode = leaf_of(ullKey);
+	if (hNode == INVALID_HANDLE)
+		return (0);
+
+	BtreeNode *p_node;
+	GET_OBJ(m_stMalloc, hNode, p_node);
+	int i = p_node->lower_bound(ullKey);
+	if (i >= p_node->m_ushNItems || p_node->m_aullKeys[i] != ullKey)
+		return (0);
+
+	phRecord = &p_node->m_ahItems[i];
+	return (1);
+}
+
+int Btree::do_find(uint64_t ullKey, ALLOC_HANDLE_T &hRecord)
+{
+	ALLOC_HANDLE_T *phRecord;
+
+	hRecord = INVALID_HANDLE;
+	if (do_find(ullKey, phRecord) != 1)
+		return (0);
+	hRecord = *phRecord;
+	return (1);
+}
+
+uint32_t Btree::bulk_node_count(uint32_t uiCount)
+{
+	uint32_t uiTotal = 0;
+	uint32_t n = (uiCount + BtreeNode::PAGE_SIZE - 1) / BtreeNode::PAGE_SIZE;
+
+	uiTotal += n;
+	while (n > 1) {
+		n = (n + BtreeNode::PAGE_SIZE - 1) / BtreeNode::PAGE_SIZE;
+		uiTotal += n;
+	}
+	return uiTotal;
+}
+
+int Btree::bulk_load(const uint64_t *pullKeys, const ALLOC_HANDLE_T *phRecords,
+		     uint32_t uiCount, int &iAllocNode)
+{
+	std::vector<ALLOC_HANDLE_T> vAll;
+	std::vector<ALLOC_HANDLE_T> vLevel, vUpper;
+	std::vector<uint64_t> vLevelKeys, vUpperKeys;
+	ALLOC_HANDLE_T hNode, hPrev = INVALID_HANDLE;
+	BtreeNode *p_node;
+
+	iAllocNode = 0;
+	if (root_handle_ != INVALID_HANDLE) {
+		snprintf(err_message_, sizeof(err_message_),
+			 "bulk load into non-empty tree");
+		return (-1);
+	}
+
+	for (uint32_t i = 0; i < uiCount; i += BtreeNode::PAGE_SIZE) {
+		hNode = m_stMalloc.Malloc(sizeof(BtreeNode));
+		if (hNode == INVALID_HANDLE)
+			goto NO_MEM;
+		vAll.push_back(hNode);
+
+		uint32_t n = uiCount - i < (uint32_t)BtreeNode::PAGE_SIZE ?
+				     uiCount - i :
+				     BtreeNode::PAGE_SIZE;
+		GET_OBJ(m_stMalloc, hNode, p_node);
+		p_node->do_init(1);
+		memcpy(p_node->m_aullKeys, pullKeys + i, n * sizeof(uint64_t));
+		memcpy(p_node->m_ahItems, phRecords + i,
+		       n * sizeof(ALLOC_HANDLE_T));
+		p_node->m_ushNItems = n;
+		p_node->m_hPrev = hPrev;
+		if (hPrev != INVALID_HANDLE) {
+			BtreeNode *p_prev;
+			GET_OBJ(m_stMalloc, hPrev, p_prev);
+			p_prev->m_hNext = hNode;
+		}
+		hPrev = hNode;
+
+		vLevel.push_back(hNode);
+		vLevelKeys.push_back(pullKeys[i]);
+	}
+
+	while (vLevel.size() > 1) {
+		vUpper.clear();
+		vUpperKeys.clear();
+		for (size_t i = 0; i < vLevel.size();
+		     i += BtreeNode::PAGE_SIZE) {
+			hNode = m_stMalloc.Malloc(sizeof(BtreeNode));
+			if (hNode == INVALID_HANDLE)
+				goto NO_MEM;
+			vAll.push_back(hNode);
+
+			size_t n = vLevel.size() - i < BtreeNode::PAGE_SIZE ?
+					   vLevel.size() - i :
+					   BtreeNode::PAGE_SIZE;
+			GET_OBJ(m_stMalloc, hNode, p_node);
+			p_node->do_init(0);
+			memcpy(p_node->m_aullKeys, &vLevelKeys[i],
+			       n * sizeof(uint64_t));
+			memcpy(p_node->m_ahItems, &vLevel[i],
+			       n * sizeof(ALLOC_HANDLE_T));
+			p_node->m_ushNItems = n;
+
+			vUpper.push_back(hNode);
+			vUpperKeys.push_back(vLevelKeys[i]);
+		}
+		vLevel.swap(vUpper);
+		vLevelKeys.swap(vUpperKeys);
+	}
+
+	if (!vLevel.empty())
+		root_handle_ = vLevel[0];
+	iAllocNode = vAll.size();
+	return (0);
+
+NO_MEM:
+	snprintf(err_message_, sizeof(err_message_),
+		 "alloc tree-node error: %s", m_stMalloc.get_err_msg());
+	for (size_t i = 0; i < vAll.size(); i++)
+		m_stMalloc.Free(vAll[i]);
+	return (EC_NO_MEM);
+}
+
+int Btree::destory(bool bFreeRecord)
+{
+	BtreeNode::destory(m_stMalloc, root_handle_, bFreeRecord);
+	root_handle_ = INVALID_HANDLE;
+	return (0);
+}
+
+unsigned Btree::ask_for_destroy_size(void)
+{
+	return BtreeNode::ask_for_destroy_size(m_stMalloc, root_handle_);
+}
+
+/* 从hNode的第i项开始沿叶子链表向后访问，key大于ullEnd时停止 */
+static int visit_forward(MallocBase &stMalloc, ALLOC_HANDLE_T hNode, int i,
+			 uint64_t ullEnd, ItemVisit pfVisit, void *pCookie)
+{
+	BtreeNode *p_node;
+	int iRet;
+
+	while (hNode != INVALID_HANDLE) {
+		GET_OBJ(stMalloc, hNode, p_node);
+		for (; i < p_node->m_ushNItems; i++) {
+			if (p_node->m_aullKeys[i] > ullEnd)
+				return (0);
+			ALLOC_HANDLE_T hItem = p_node->m_ahItems[i];
+			if ((iRet = pfVisit(stMalloc, hItem, pCookie)) != 0)
+				return (iRet);
+			p_node->m_ahItems[i] = hItem;
+		}
+		hNode = p_node->m_hNext;
+		i = 0;
+	}
+	return (0);
+}
+
+/* 从hNode的第i项开始沿叶子链表向前访问，i为-1时从上一个叶子的末尾开始 */
+static int visit_backward(MallocBase &stMalloc, ALLOC_HANDLE_T hNode, int i,
+			  ItemVisit pfVisit, void *pCookie)
+{
+	BtreeNode *p_node;
+	int iRet;
+
+	while (hNode != INVALID_HANDLE) {
+		GET_OBJ(stMalloc, hNode, p_node);
+		for (; i >= 0; i--) {
+			ALLOC_HANDLE_T hItem = p_node->m_ahItems[i];
+			if ((iRet = pfVisit(stMalloc, hItem, pCookie)) != 0)
+				return (iRet);
+			p_node->m_ahItems[i] = hItem;
+		}
+		hNode = p_node->m_hPrev;
+		if (hNode != INVALID_HANDLE) {
+			GET_OBJ(stMalloc, hNode, p_node);
+			i = p_node->m_ushNItems - 1;
+		}
+	}
+	return (0);
+}
+
+int Btree::traverse_forward(ItemVisit pfVisit, void *pCookie)
+{
+	return visit_forward(m_stMalloc, leaf_of(0), 0, UINT64_MAX, pfVisit,
+			     pCookie);
+}
+
+int Btree::traverse_backward(ItemVisit pfVisit, void *pCookie)
+{
+	ALLOC_HANDLE_T hNode = leaf_of(UINT64_MAX);
+	if (hNode == INVALID_HANDLE)
+		return (0);
+
+	BtreeNode *p_node;
+	GET_OBJ(m_stMalloc, hNode, p_node);
+	return visit_backward(m_stMalloc, hNode, p_node->m_ushNItems - 1,
+			      pfVisit, pCookie);
+}
+
+int Btree::traverse_forward(uint64_t ullKey, ItemVisit pfVisit, void *pCookie)
+{
+	return traverse_forward(ullKey, UINT64_MAX, pfVisit, pCookie);
+}
+
+int Btree::traverse_forward(uint64_t ullKey, uint64_t ullKey1,
+			    ItemVisit pfVisit, void *pCookie)
+{
+	ALLOC_HANDLE_T hNode = leaf_of(ullKey);
+	if (hNode == INVALID_HANDLE)
+		return (0);
+
+	BtreeNode *p_node;
+	GET_OBJ(m_stMalloc, hNode, p_node);
+	return visit_forward(m_stMalloc, hNode, p_node->lower_bound(ullKey),
+			     ullKey1, pfVisit, pCookie);
+}
+
+int Btree::traverse_backward(uint64_t ullKey, ItemVisit pfVisit, void *pCookie)
+{
+	ALLOC_HANDLE_T hNode = leaf_of(ullKey);
+	if (hNode == INVALID_HANDLE)
+		return (0);
+
+	BtreeNode *p_node;
+	GET_OBJ(m_stMalloc, hNode, p_node);
+	int i = p_node->lower_bound(ullKey);
+	if (i >= p_node->m_ushNItems || p_node->m_aullKeys[i] != ullKey)
+		i--;
+	if (i < 0) {
+		hNode = p_node->m_hPrev;
+		if (hNode == INVALID_HANDLE)
+			return (0);
+		GET_OBJ(m_stMalloc, hNode, p_node);
+		i = p_node->m_ushNItems - 1;
+	}
+	return visit_backward(m_stMalloc, hNode, i, pfVisit, pCookie);
+}
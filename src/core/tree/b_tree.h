@@ -0,0 +1,148 @@
+/*
+* Copyright [2021] JD.com, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef B_TREE_H
+#define B_TREE_H
+
+#include <stdint.h>
+#include "mem/mallocator.h"
+#include "t_tree.h"
+
+/*************************************************
+  Description:	把索引key转换成保序的64位定长key，节点内直接比较，
+		不再解引用记录
+  Input:		pchKey		DTCValue格式的key
+			pCmpCookie	CmpCookie，提供索引字段的类型
+  Return:		定长key
+*************************************************/
+uint64_t KeyNormalize(const char *pchKey, void *pCmpCookie);
+
+class Btree {
+    protected:
+	ALLOC_HANDLE_T root_handle_;
+	MallocBase &m_stMalloc;
+	char err_message_[4096];
+
+	ALLOC_HANDLE_T leaf_of(uint64_t ullKey);
+
+    public:
+	Btree(MallocBase &stMalloc);
+	~Btree();
+
+	const char *get_err_msg()
+	{
+		return err_message_;
+	}
+	const ALLOC_HANDLE_T Root() const
+	{
+		return root_handle_;
+	}
+	void do_attach(ALLOC_HANDLE_T hRoot)
+	{
+		root_handle_ = hRoot;
+	}
+	ALLOC_HANDLE_T first_node();
+
+	/*************************************************
+	  Description:	将key insert到树里，hRecord为key对应的数据
+	  Output:		iAllocNode	新分配的树节点个数
+	  Return:		0为成功，EC_NO_MEM为内存不足，EC_KEY_EXIST为key已经存在
+	*************************************************/
+	int do_insert(uint64_t ullKey, ALLOC_HANDLE_T hRecord,
+		      int &iAllocNode);
+
+	/*************************************************
+	  Description:	删除key(不释放key对应的数据)，叶子空了即释放，不做合并
+	  Output:		iFreeNode	释放的树节点个数
+	  Return:		0为成功，其他值为错误
+	*************************************************/
+	int Delete(uint64_t ullKey, int &iFreeNode);
+
+	/*************************************************
+	  Description:	查找key对应的数据
+	  Output:		phRecord	指向叶子节点item的指针
+	  Return:		0为查找不到，1为找到数据
+	*************************************************/
+	int do_find(uint64_t ullKey, ALLOC_HANDLE_T *&phRecord);
+	int do_find(uint64_t ullKey, ALLOC_HANDLE_T &hRecord);
+
+	/*************************************************
+	  Description:	用已排序、无重复的key建一棵满节点的树，树必须为空
+	  Output:		iAllocNode	新分配的树节点个数
+	  Return:		0为成功，EC_NO_MEM为内存不足
+	*************************************************/
+	int bulk_load(const uint64_t *pullKeys, const ALLOC_HANDLE_T *phRecords,
+		      uint32_t uiCount, int &iAllocNode);
+	// bulk_load建uiCount个key的树要分配的节点个数
+	static uint32_t bulk_node_count(uint32_t uiCount);
+
+	// bFreeRecord为false时只释放树节点，item不是记录handle时使用
+	int destory(bool bFreeRecord = true);
+	unsigned ask_for_destroy_size(void);
+	static unsigned node_size(void);
+
+	// 沿叶子链表遍历，pfVisit返回非0时终止
+	int traverse_forward(ItemVisit pfVisit, void *pCookie);
+	int traverse_backward(ItemVisit pfVisit, void *pCookie);
+	// 遍历大于等于key的所有记录
+	int traverse_forward(uint64_t ullKey, ItemVisit pfVisit,
+			     void *pCookie);
+	// 遍历范围[key, key1]
+	int traverse_forward(uint64_t ullKey, uint64_t ullKey1,
+			     ItemVisit pfVisit, void *pCookie);
+	// 从大到小遍历小于等于key的所有记录
+	int traverse_backward(uint64_t ullKey, ItemVisit pfVisit,
+			      void *pCookie);
+};
+
+/************************************************************
+  Description:    b+tree节点。key为定长的保序key，与item分开连续存放，
+		  节点内二分查找不访问记录；叶子前后相连，供范围遍历
+***********************************************************/
+struct _BtreeNode {
+	enum { PAGE_SIZE = 30, // 每个节点保存多少条记录
+	       MAX_DEPTH = 16 };
+
+	uint8_t m_chLeaf;
+	uint16_t m_ushNItems;
+	ALLOC_HANDLE_T m_hPrev; // 仅叶子使用
+	ALLOC_HANDLE_T m_hNext;
+	// 叶子为记录的key；内部节点m_aullKeys[i]为子树i的下界，[0]不使用
+	uint64_t m_aullKeys[PAGE_SIZE];
+	ALLOC_HANDLE_T m_ahItems[PAGE_SIZE];
+
+	void do_init(uint8_t chLeaf);
+	// 第一个大于等于key的位置
+	int lower_bound(uint64_t ullKey) const;
+	// 内部节点中key所在的子树
+	int child_of(uint64_t ullKey) const;
+	void insert_at(int iPos, uint64_t ullKey, ALLOC_HANDLE_T hItem);
+	void remove_at(int iPos);
+
+	static int do_insert(MallocBase &stMalloc, ALLOC_HANDLE_T hNode,
+			     uint64_t ullKey, ALLOC_HANDLE_T hRecord,
+			     ALLOC_HANDLE_T *phSpare, int &iSpare,
+			     uint64_t &ullSplitKey, ALLOC_HANDLE_T &hSplit);
+	static int Delete(MallocBase &stMalloc, ALLOC_HANDLE_T hNode,
+			  uint64_t ullKey, int &iFreeNode);
+	static int destory(MallocBase &stMalloc, ALLOC_HANDLE_T hNode,
+			   bool bFreeRecord);
+	static unsigned ask_for_destroy_size(MallocBase &stMalloc,
+					     ALLOC_HANDLE_T hNode);
+} __attribute__((packed));
+typedef struct _BtreeNode BtreeNode;
+
+#endif
@@ -135,6 +135,10 @@ int TreeData::do_init(uint8_t uchKeyIdx, int iKeySize, const char *pchKey,
 	p_tree_root_ = Pointer<RootData>();
 	p_tree_root_->data_type_ =
 		((table_index_ << 7) & 0x80) + DATA_TYPE_TREE_ROOT;
+	if (p_table_ != NULL &&
+	    p_table_->index_engine() == INDEX_ENGINE_BTREE)
+		p_tree_root_->data_type_ |= DATA_TYPE_BTREE;
+	t_tree_.set_btree(p_tree_root_->data_type_ & DATA_TYPE_BTREE);
 	p_tree_root_->tree_size_ = 0;
 	p_tree_root_->total_raw_size_ = 0;
 	p_tree_root_->node_count_ = 0;
@@ -208,11 +212,12 @@ int TreeData::do_attach(MEM_HANDLE_T hHandle, uint8_t uchKeyIdx, int iKeySize,
 
 	unsigned char uchType;
 	uchType = p_tree_root_->data_type_;
-	if (unlikely((uchType & 0x7f) != DATA_TYPE_TREE_ROOT)) {
+	if (unlikely((uchType & DATA_TYPE_MASK) != DATA_TYPE_TREE_ROOT)) {
 		snprintf(err_message_, sizeof(err_message_),
 			 "invalid data type: %u", uchType);
 		return (-2);
 	}
+	t_tree_.set_btree(uchType & DATA_TYPE_BTREE);
 
 	m_uiLAOffset = 0;
 
@@ -337,13 +342,13 @@ int TreeData::insert_sub_tree(uint8_t uchCondIdxCnt,
 		return (-100);
 	}
 
-	bool isAllocNode = false;
+	int iAllocNode = 0;
 	DTCValue value = stCondition[TTREE_INDEX_POS];
 	char *indexKey = reinterpret_cast<char *>(&value);
 	CmpCookie cookie(p_table_, uchCondIdxCnt);
-	iRet = t_tree_.do_insert(indexKey, &cookie, pfComp, hRoot, isAllocNode);
-	if (iRet == 0 && isAllocNode) {
-		p_tree_root_->tree_size_ += sizeof(TtreeNode);
+	iRet = t_tree_.do_insert(indexKey, &cookie, pfComp, hRoot, iAllocNode);
+	if (iRet == 0) {
+		p_tree_root_->tree_size_ += iAllocNode * t_tree_.node_size();
 	}
 	return iRet;
 }
@@ -406,7 +411,7 @@ int TreeData::insert_row_flag(const RowValue &stRow, KeyComparator pfComp,
 		if (iRet != 0) {
 			snprintf(err_message_, sizeof(err_message_),
 				 "insert error");
-			need_new_bufer_size = sizeof(TtreeNode);
+			need_new_bufer_size = t_tree_.node_size();
 			mallocator_->Free(hRecord);
 			goto ERROR_INSERT_RET;
 		}
@@ -532,12 +537,14 @@ int TreeData::copy_tree_all(RawData *new_data)
 
 	new_data->rewind();
 	RowValue stOldRow(p_table_);
+	begin_bulk_load();
 	for (unsigned int i = 0; i < uiTotalRows; i++) {
 		unsigned char uchRowFlags;
 		stOldRow.default_value();
 		if (new_data->decode_row(stOldRow, uchRowFlags, 0) != 0) {
 			log4cplus_error("raw-data decode row error: %s",
 					new_data->get_err_msg());
+			destroy_sub_tree();
 			return (-1);
 		}
 
@@ -551,6 +558,32 @@ int TreeData::copy_tree_all(RawData *new_data)
 		}
 	}
 
+	iRet = end_bulk_load();
+	if (iRet == EC_NO_MEM) {
+		need_new_bufer_size =
+			new_data->data_size() - new_data->data_start();
+		destroy_sub_tree();
+	}
+	return iRet;
+}
+
+void TreeData::begin_bulk_load()
+{
+	t_tree_.begin_bulk_load();
+}
+
+int TreeData::end_bulk_load()
+{
+	int iAllocNode = 0;
+	int iRet = t_tree_.end_bulk_load(iAllocNode);
+	if (iRet != 0) {
+		snprintf(err_message_, sizeof(err_message_),
+			 "build tree error: %s", t_tree_.get_err_msg());
+		need_new_bufer_size = t_tree_.bulk_load_size();
+		return iRet;
+	}
+	p_tree_root_->tree_size_ += iAllocNode * t_tree_.node_size();
+	p_tree_root_->root_handle_ = t_tree_.Root();
 	return (0);
 }
 
@@ -778,7 +811,7 @@ int TreeData::replace_tree_data(DTCJobOperation &job_op, Node *p_node,
 					    0) //RowFormat上的内容已删光
 				{
 					//删除tree node
-					bool isFreeNode = false;
+					int iFreeNode = 0;
 					DTCValue value = (stOldRow)
 						[TTREE_INDEX_POS]; //for轮询的最后一行数据
 					char *indexKey =
@@ -789,7 +822,7 @@ int TreeData::replace_tree_data(DTCJobOperation &job_op, Node *p_node,
 					int iret = t_tree_.Delete(indexKey,
 								  &cookie,
 								  KeyCompare,
-								  isFreeNode);
+								  iFreeNode);
 					if (iret != 0) {
 						snprintf(
 							err_message_,
@@ -798,9 +831,9 @@ int TreeData::replace_tree_data(DTCJobOperation &job_op, Node *p_node,
 							iret);
 						return -4;
 					}
-					if (isFreeNode)
-						p_tree_root_->tree_size_ -=
-							sizeof(TtreeNode);
+					p_tree_root_->tree_size_ -=
+						iFreeNode *
+						t_tree_.node_size();
 					p_tree_root_->tree_size_ -= size_;
 					p_tree_root_->node_count_--;
 					p_tree_root_->root_handle_ =
@@ -938,20 +971,20 @@ int TreeData::replace_sub_raw_data(DTCJobOperation &job_op,
 	    uiTotalRows - iDelete == 0) //RowFormat上的内容已删光
 	{
 		//删除tree node
-		bool isFreeNode = false;
+		int iFreeNode = 0;
 		DTCValue value =
 			(*stpCurRow)[TTREE_INDEX_POS]; //for轮询的最后一行数据
 		char *indexKey = reinterpret_cast<char *>(&value);
 		CmpCookie cookie(p_table_, TTREE_INDEX_POS);
 		int iret = t_tree_.Delete(indexKey, &cookie, KeyCompare,
-					  isFreeNode);
+					  iFreeNode);
 		if (iret != 0) {
 			snprintf(err_message_, sizeof(err_message_),
 				 "delete stTree failed:%d", iret);
 			return -4;
 		}
-		if (isFreeNode)
-			p_tree_root_->tree_size_ -= sizeof(TtreeNode);
+		p_tree_root_->tree_size_ -=
+			iFreeNode * t_tree_.node_size();
 		p_tree_root_->tree_size_ -= size_;
 		p_tree_root_->node_count_--;
 		p_tree_root_->root_handle_ = t_tree_.Root();
@@ -1103,20 +1136,20 @@ int TreeData::update_sub_raw_data(DTCJobOperation &job_op, MEM_HANDLE_T hRecord)
 	    uiTotalRows - iDelete == 0) //RowFormat上的内容已删光
 	{
 		//删除tree node
-		bool isFreeNode = false;
+		int iFreeNode = 0;
 		DTCValue value =
 			(*stpCurRow)[TTREE_INDEX_POS]; //for轮询的最后一行数据
 		char *indexKey = reinterpret_cast<char *>(&value);
 		CmpCookie cookie(p_table_, TTREE_INDEX_POS);
 		int iret = t_tree_.Delete(indexKey, &cookie, KeyCompare,
-					  isFreeNode);
+					  iFreeNode);
 		if (iret != 0) {
 			snprintf(err_message_, sizeof(err_message_),
 				 "delete stTree failed:%d", iret);
 			return -4;
 		}
-		if (isFreeNode)
-			p_tree_root_->tree_size_ -= sizeof(TtreeNode);
+		p_tree_root_->tree_size_ -=
+			iFreeNode * t_tree_.node_size();
 		p_tree_root_->tree_size_ -= size_;
 		p_tree_root_->node_count_--;
 		p_tree_root_->root_handle_ = t_tree_.Root();
@@ -1188,21 +1221,21 @@ int TreeData::delete_sub_raw_data(DTCJobOperation &job_op, MEM_HANDLE_T hRecord)
 		 uiTotalRows > 0) //RowFormat上的内容已删光
 	{
 		//删除tree node
-		bool isFreeNode = false;
+		int iFreeNode = 0;
 		DTCValue value =
 			(*stpNodeRow)[TTREE_INDEX_POS]; //for轮询的最后一行数据
 		char *indexKey = reinterpret_cast<char *>(&value);
 		CmpCookie cookie(p_table_, TTREE_INDEX_POS);
 		int iret = t_tree_.Delete(indexKey, &cookie, KeyCompare,
-					  isFreeNode);
+					  iFreeNode);
 		if (iret != 0) {
 			snprintf(err_message_, sizeof(err_message_),
 				 "delete stTree failed:%d\t%.4000s", iret,
 				 t_tree_.get_err_msg());
 			return -4;
 		}
-		if (isFreeNode)
-			p_tree_root_->tree_size_ -= sizeof(TtreeNode);
+		p_tree_root_->tree_size_ -=
+			iFreeNode * t_tree_.node_size();
 		p_tree_root_->tree_size_ -= size_;
 		p_tree_root_->node_count_--;
 		p_tree_root_->root_handle_ = t_tree_.Root();
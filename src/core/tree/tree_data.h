@@ -18,7 +18,7 @@
 #define TREE_DATA_H
 
 #include "raw/raw_data.h"
-#include "t_tree.h"
+#include "tree_index.h"
 #include "protocol.h"
 #include "task/task_request.h"
 #include "value.h"
@@ -118,7 +118,7 @@ typedef struct {
 class TreeData {
     private:
 	RootData *p_tree_root_; // 注意：地址可能会因为realloc而改变
-	Ttree t_tree_;
+	TreeIndex t_tree_;
 	DTCTableDefinition *p_table_;
 	uint8_t index_depth_;
 	int table_index_;
@@ -412,6 +412,13 @@ class TreeData {
 	*************************************************/
 	int copy_tree_all(RawData *new_data);
 
+	/*************************************************
+	  Description:	批量插入开始/结束，b+tree索引在结束时一次建树
+	  Output:		
+	*************************************************/
+	void begin_bulk_load();
+	int end_bulk_load();
+
 	/*************************************************
 	  Description:	copy data from t-tree to raw
 	  Output:		
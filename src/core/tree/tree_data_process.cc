@@ -444,6 +444,7 @@ int TreeDataProcess::do_replace_all(DTCJobOperation &job_op, Node *p_node)
 
 	if (job_op.result != NULL) {
 		ResultSet *pstResultSet = job_op.result;
+		m_stTreeData.begin_bulk_load();
 		for (int i = 0; i < pstResultSet->total_rows(); i++) {
 			RowValue *pstRow = pstResultSet->_fetch_row();
 			if (pstRow == NULL) {
@@ -510,6 +511,23 @@ int TreeDataProcess::do_replace_all(DTCJobOperation &job_op, Node *p_node)
 			return (-4);
 		}
 
+		iRet = m_stTreeData.end_bulk_load();
+		if (iRet == EC_NO_MEM &&
+		    p_buffer_pond_->try_purge_size(m_stTreeData.need_size(),
+						   *p_node) == 0)
+			iRet = m_stTreeData.end_bulk_load();
+		if (iRet != 0) {
+			snprintf(err_message_, sizeof(err_message_),
+				 "tree-data bulk load error: ret=%d,err=%.*s",
+				 iRet, (int)sizeof(err_message_) - 50,
+				 m_stTreeData.get_err_msg());
+			job_op.push_black_list_size(all_rows_size);
+			p_buffer_pond_->purge_node(job_op.packed_key(),
+						   *p_node);
+			m_stTreeData.destory();
+			return (-4);
+		}
+
 		rows_count_ += pstResultSet->total_rows();
 	}
 
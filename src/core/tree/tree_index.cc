@@ -0,0 +1,210 @@
+/*
+* Copyright [2021] JD.com, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <vector>
+#include "tree_index.h"
+#include "value.h"
+#include "data_chunk.h"
+
+TreeIndex::TreeIndex(MallocBase &stMalloc)
+	: m_stMalloc(stMalloc), t_tree_(stMalloc), b_tree_(stMalloc),
+	  is_btree_(false), is_bulk_(false)
+{
+}
+
+ALLOC_HANDLE_T TreeIndex::first_node()
+{
+	if (!is_btree_)
+		return t_tree_.first_node();
+	if (is_bulk_)
+		return bulk_items_.empty() ? INVALID_HANDLE :
+					     bulk_items_.begin()->second;
+	return b_tree_.first_node();
+}
+
+int TreeIndex::do_insert(const char *pchKey, void *pCmpCookie,
+			 KeyComparator pfComp, ALLOC_HANDLE_T hRecord,
+			 int &iAllocNode)
+{
+	iAllocNode = 0;
+	if (!is_btree_) {
+		bool isAllocNode = false;
+		int iRet = t_tree_.do_insert(pchKey, pCmpCookie, pfComp,
+					     hRecord, isAllocNode);
+		if (isAllocNode)
+			iAllocNode = 1;
+		return iRet;
+	}
+
+	uint64_t ullKey = KeyNormalize(pchKey, pCmpCookie);
+	if (is_bulk_) {
+		if (!bulk_items_.insert(std::make_pair(ullKey, hRecord)).second)
+			return (EC_KEY_EXIST);
+		return (0);
+	}
+	return b_tree_.do_insert(ullKey, hRecord, iAllocNode);
+}
+
+int TreeIndex::Delete(const char *pchKey, void *pCmpCookie,
+		      KeyComparator pfComp, int &iFreeNode)
+{
+	iFreeNode = 0;
+	if (!is_btree_) {
+		bool isFreeNode = false;
+		int iRet = t_tree_.Delete(pchKey, pCmpCookie, pfComp,
+					  isFreeNode);
+		if (isFreeNode)
+			iFreeNode = 1;
+		return iRet;
+	}
+
+	uint64_t ullKey = KeyNormalize(pchKey, pCmpCookie);
+	if (is_bulk_) {
+		bulk_items_.erase(ullKey);
+		return (0);
+	}
+	return b_tree_.Delete(ullKey, iFreeNode);
+}
+
+int TreeIndex::do_find(const char *pchKey, void *pCmpCookie,
+		       KeyComparator pfComp, ALLOC_HANDLE_T &hRecord)
+{
+	ALLOC_HANDLE_T *phRecord;
+
+	hRecord = INVALID_HANDLE;
+	if (!is_btree_)
+		return t_tree_.do_find(pchKey, pCmpCookie, pfComp, hRecord);
+	if (do_find(pchKey, pCmpCookie, pfComp, phRecord) != 1)
+		return (0);
+	hRecord = *phRecord;
+	return (1);
+}
+
+int TreeIndex::do_find(const char *pchKey, void *pCmpCookie,
+		       KeyComparator pfComp, ALLOC_HANDLE_T *&phRecord)
+{
+	if (!is_btree_)
+		return t_tree_.do_find(pchKey, pCmpCookie, pfComp, phRecord);
+
+	uint64_t ullKey = KeyNormalize(pchKey, pCmpCookie);
+	if (is_bulk_) {
+		std::map<uint64_t, ALLOC_HANDLE_T>::iterator it =
+			bulk_items_.find(ullKey);
+		phRecord = it == bulk_items_.end() ? NULL : &it->second;
+		return phRecord != NULL ? 1 : 0;
+	}
+	return b_tree_.do_find(ullKey, phRecord);
+}
+
+int TreeIndex::destory()
+{
+	if (!is_btree_)
+		return t_tree_.destory();
+
+	if (is_bulk_) {
+		std::map<uint64_t, ALLOC_HANDLE_T>::iterator it;
+		for (it = bulk_items_.begin(); it != bulk_items_.end(); ++it)
+			m_stMalloc.Free(it->second);
+		bulk_items_.clear();
+		is_bulk_ = false;
+	}
+	return b_tree_.destory();
+}
+
+int TreeIndex::traverse_forward(ItemVisit pfVisit, void *pCookie)
+{
+	if (!is_btree_)
+		return t_tree_.traverse_forward(pfVisit, pCookie);
+
+	if (is_bulk_) {
+		int iRet;
+		std::map<uint64_t, ALLOC_HANDLE_T>::iterator it;
+		for (it = bulk_items_.begin(); it != bulk_items_.end(); ++it)
+			if ((iRet = pfVisit(m_stMalloc, it->second,
+					    pCookie)) != 0)
+				return iRet;
+		return (0);
+	}
+	return b_tree_.traverse_forward(pfVisit, pCookie);
+}
+
+int TreeIndex::traverse_forward(const char *pchKey, void *pCmpCookie,
+				KeyComparator pfComp, ItemVisit pfVisit,
+				void *pCookie)
+{
+	if (!is_btree_)
+		return t_tree_.traverse_forward(pchKey, pCmpCookie, pfComp,
+						pfVisit, pCookie);
+	return b_tree_.traverse_forward(KeyNormalize(pchKey, pCmpCookie),
+					pfVisit, pCookie);
+}
+
+int TreeIndex::traverse_forward(const char *pchKey, const char *pchKey1,
+				void *pCmpCookie, KeyComparator pfComp,
+				ItemVisit pfVisit, void *pCookie)
+{
+	if (!is_btree_)
+		return t_tree_.traverse_forward(pchKey, pchKey1, pCmpCookie,
+						pfComp, pfVisit, pCookie);
+	return b_tree_.traverse_forward(KeyNormalize(pchKey, pCmpCookie),
+					KeyNormalize(pchKey1, pCmpCookie),
+					pfVisit, pCookie);
+}
+
+int TreeIndex::traverse_backward(const char *pchKey, void *pCmpCookie,
+				 KeyComparator pfComp, ItemVisit pfVisit,
+				 void *pCookie)
+{
+	if (!is_btree_)
+		return t_tree_.traverse_backward(pchKey, pCmpCookie, pfComp,
+						 pfVisit, pCookie);
+	return b_tree_.traverse_backward(KeyNormalize(pchKey, pCmpCookie),
+					 pfVisit, pCookie);
+}
+
+void TreeIndex::begin_bulk_load()
+{
+	if (is_btree_ && b_tree_.Root() == INVALID_HANDLE) {
+		bulk_items_.clear();
+		is_bulk_ = true;
+	}
+}
+
+int TreeIndex::end_bulk_load(int &iAllocNode)
+{
+	iAllocNode = 0;
+	if (!is_bulk_)
+		return (0);
+
+	std::vector<uint64_t> vKeys;
+	std::vector<ALLOC_HANDLE_T> vRecords;
+	vKeys.reserve(bulk_items_.size());
+	vRecords.reserve(bulk_items_.size());
+	std::map<uint64_t, ALLOC_HANDLE_T>::iterator it;
+	for (it = bulk_items_.begin(); it != bulk_items_.end(); ++it) {
+		vKeys.push_back(it->first);
+		vRecords.push_back(it->second);
+	}
+
+	int iRet = b_tree_.bulk_load(vKeys.data(), vRecords.data(),
+				     vKeys.size(), iAllocNode);
+	if (iRet != 0)
+		return iRet;
+
+	bulk_items_.clear();
+	is_bulk_ = false;
+	return (0);
+}
@@ -0,0 +1,112 @@
+/*
+* Copyright [2021] JD.com, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef TREE_INDEX_H
+#define TREE_INDEX_H
+
+#include <map>
+#include "t_tree.h"
+#include "b_tree.h"
+
+/************************************************************
+  Description:    TreeData的索引，按表的配置使用t-tree或者b+tree。
+		  b+tree在批量加载期间先把key暂存在有序表里，结束时一次建树
+***********************************************************/
+class TreeIndex {
+    private:
+	MallocBase &m_stMalloc;
+	Ttree t_tree_;
+	Btree b_tree_;
+	bool is_btree_;
+	bool is_bulk_;
+	std::map<uint64_t, ALLOC_HANDLE_T> bulk_items_;
+
+    public:
+	TreeIndex(MallocBase &stMalloc);
+
+	void set_btree(bool isBtree)
+	{
+		is_btree_ = isBtree;
+	}
+	bool is_btree() const
+	{
+		return is_btree_;
+	}
+	const char *get_err_msg()
+	{
+		return is_btree_ ? b_tree_.get_err_msg() :
+				   t_tree_.get_err_msg();
+	}
+	const ALLOC_HANDLE_T Root() const
+	{
+		return is_btree_ ? b_tree_.Root() : t_tree_.Root();
+	}
+	void do_attach(ALLOC_HANDLE_T hRoot)
+	{
+		t_tree_.do_attach(hRoot);
+		b_tree_.do_attach(hRoot);
+	}
+	unsigned node_size() const
+	{
+		return is_btree_ ? Btree::node_size() : sizeof(TtreeNode);
+	}
+	ALLOC_HANDLE_T first_node();
+
+	int do_insert(const char *pchKey, void *pCmpCookie,
+		      KeyComparator pfComp, ALLOC_HANDLE_T hRecord,
+		      int &iAllocNode);
+	int Delete(const char *pchKey, void *pCmpCookie, KeyComparator pfComp,
+		   int &iFreeNode);
+	int do_find(const char *pchKey, void *pCmpCookie, KeyComparator pfComp,
+		    ALLOC_HANDLE_T &hRecord);
+	int do_find(const char *pchKey, void *pCmpCookie, KeyComparator pfComp,
+		    ALLOC_HANDLE_T *&phRecord);
+	int destory();
+
+	int traverse_forward(ItemVisit pfVisit, void *pCookie);
+	int traverse_forward(const char *pchKey, void *pCmpCookie,
+			     KeyComparator pfComp, ItemVisit pfVisit,
+			     void *pCookie);
+	int traverse_forward(const char *pchKey, const char *pchKey1,
+			     void *pCmpCookie, KeyComparator pfComp,
+			     ItemVisit pfVisit, void *pCookie);
+	int traverse_backward(const char *pchKey, void *pCmpCookie,
+			      KeyComparator pfComp, ItemVisit pfVisit,
+			      void *pCookie);
+
+	/*************************************************
+	  Description:	开始批量加载，之后的insert/find只操作暂存的key，
+			树必须为空；t-tree不做处理
+	*************************************************/
+	void begin_bulk_load();
+
+	/*************************************************
+	  Description:	用暂存的key建树
+	  Output:		iAllocNode	新分配的树节点个数
+	  Return:		0为成功，EC_NO_MEM为内存不足，此时暂存的key保留，可以重试
+	*************************************************/
+	int end_bulk_load(int &iAllocNode);
+	// end_bulk_load一次要分配的内存大小，不在批量加载时为一个节点
+	unsigned bulk_load_size() const
+	{
+		if (!is_bulk_)
+			return node_size();
+		return Btree::bulk_node_count(bulk_items_.size()) *
+		       Btree::node_size();
+	}
+};
+
+#endif
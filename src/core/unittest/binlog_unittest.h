@@ -0,0 +1,233 @@
+#ifndef BINLOG_UNITTEST_H_
+#define BINLOG_UNITTEST_H_
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "unittest_comm.h"
+#include "log/logger.h"
+
+class BinlogTest : public testing::Test {
+    protected:
+	int write_record(BinlogWriter &w, uint8_t type,
+			 const std::string &body)
+	{
+		w.insert_header(type, 0, 1);
+		w.append_body(body.data(), body.size());
+		return w.Commit();
+	}
+
+	/* 读出下一条记录，只取第一条子记录 */
+	int read_record(BinlogReader &r, std::string &body)
+	{
+		int ret = r.Read();
+		if (ret == 0)
+			body.assign(r.record_pointer(0), r.record_length(0));
+		return ret;
+	}
+
+	std::string binlog_file(uint32_t serial)
+	{
+		char s[256];
+		snprintf(s, sizeof(s), "%s/ut.binlog.%u", dir_.path(), serial);
+		return s;
+	}
+
+	TempDir dir_;
+};
+
+TEST_F(BinlogTest, V2RoundTrip)
+{
+	BinlogWriter w;
+	ASSERT_EQ(0, w.init(dir_.path(), "ut"));
+	ASSERT_EQ(0, w.set_format(BINLOG_DEFAULT_VERSION, 0));
+	ASSERT_EQ(0, write_record(w, BINLOG_INSERT, "hello"));
+	ASSERT_EQ(0, write_record(w, BINLOG_UPDATE, std::string(1000, 'x')));
+
+	BinlogReader r;
+	ASSERT_EQ(0, r.init(dir_.path(), "ut"));
+	std::string body;
+	ASSERT_EQ(0, read_record(r, body));
+	EXPECT_EQ(BINLOG_INSERT, r.binlog_type());
+	EXPECT_EQ(1U, r.record_count());
+	EXPECT_EQ("hello", body);
+	ASSERT_EQ(0, read_record(r, body));
+	EXPECT_EQ(BINLOG_UPDATE, r.binlog_type());
+	EXPECT_EQ(std::string(1000, 'x'), body);
+	EXPECT_EQ(-1, r.Read());
+}
+
+TEST_F(BinlogTest, V3RoundTrip)
+{
+	BinlogWriter w;
+	ASSERT_EQ(0, w.init(dir_.path(), "ut"));
+	/* 短记录原样存储，长记录压缩 */
+	ASSERT_EQ(0, w.set_format(BINLOG_CRC_VERSION, 256));
+
+	std::string small("abc");
+	std::string big;
+	for (int i = 0; i < 4096; i++)
+		big.push_back("dtc"[i % 3]);
+	ASSERT_EQ(0, write_record(w, BINLOG_INSERT, small));
+	ASSERT_EQ(0, write_record(w, BINLOG_PRUGE, big));
+
+	/* 一条binlog多条子记录 */
+	w.insert_header(BINLOG_UPDATE, 0, 3);
+	w.append_body("a", 1);
+	w.append_body("", 0);
+	w.append_body(big.data(), 100);
+	ASSERT_EQ(0, w.Commit());
+
+	BinlogReader r;
+	ASSERT_EQ(0, r.init(dir_.path(), "ut"));
+	std::string body;
+	ASSERT_EQ(0, read_record(r, body));
+	EXPECT_EQ(small, body);
+	ASSERT_EQ(0, read_record(r, body));
+	EXPECT_EQ(BINLOG_PRUGE, r.binlog_type());
+	EXPECT_EQ(big, body);
+	ASSERT_EQ(0, r.Read());
+	ASSERT_EQ(3U, r.record_count());
+	EXPECT_EQ("a", std::string(r.record_pointer(0), r.record_length(0)));
+	EXPECT_EQ(0U, r.record_length(1));
+	EXPECT_EQ(big.substr(0, 100),
+		  std::string(r.record_pointer(2), r.record_length(2)));
+	EXPECT_EQ(-1, r.Read());
+}
+
+TEST_F(BinlogTest, V3CompressedStoredSize)
+{
+	BinlogWriter w;
+	ASSERT_EQ(0, w.init(dir_.path(), "ut"));
+	ASSERT_EQ(0, w.set_format(BINLOG_CRC_VERSION, 1));
+	std::string zeros(BINLOG_MAX_RECORD_SIZE * 2, '\0');
+	ASSERT_EQ(0, write_record(w, BINLOG_INSERT, zeros));
+
+	struct stat st;
+	ASSERT_EQ(0, stat(binlog_file(1).c_str(), &st));
+	EXPECT_LT(st.st_size, (off_t)BINLOG_MAX_RECORD_SIZE);
+
+	BinlogReader r;
+	ASSERT_EQ(0, r.init(dir_.path(), "ut"));
+	std::string body;
+	ASSERT_EQ(0, read_record(r, body));
+	EXPECT_EQ(zeros, body);
+}
+
+TEST_F(BinlogTest, CrcMismatch)
+{
+	BinlogWriter w;
+	ASSERT_EQ(0, w.init(dir_.path(), "ut"));
+	ASSERT_EQ(0, w.set_format(BINLOG_CRC_VERSION, 0));
+	ASSERT_EQ(0, write_record(w, BINLOG_INSERT, "hello world"));
+
+	/* 改掉最后一个字节 */
+	int fd = ::open(binlog_file(1).c_str(), O_RDWR);
+	ASSERT_GE(fd, 0);
+	off_t end = lseek(fd, 0, SEEK_END);
+	ASSERT_EQ(1, pwrite(fd, "X", 1, end - 1));
+	close(fd);
+
+	BinlogReader r;
+	ASSERT_EQ(0, r.init(dir_.path(), "ut"));
+	EXPECT_EQ(-2, r.Read());
+}
+
+TEST_F(BinlogTest, WriterRejectsOversizeRecord)
+{
+	for (int v = BINLOG_DEFAULT_VERSION; v <= BINLOG_CRC_VERSION; v++) {
+		TempDir dir;
+		BinlogWriter w;
+		ASSERT_EQ(0, w.init(dir.path(), "ut"));
+		ASSERT_EQ(0, w.set_format(v, 0));
+		ASSERT_EQ(0, write_record(w, BINLOG_INSERT, "before"));
+		JournalID jid = w.query_id();
+		EXPECT_EQ(-1, write_record(w, BINLOG_INSERT,
+					   std::string(BINLOG_MAX_RECORD_SIZE,
+						       'x')));
+		EXPECT_EQ((uint64_t)jid, (uint64_t)w.query_id());
+		ASSERT_EQ(0, write_record(w, BINLOG_INSERT, "after"));
+
+		/* 读者不会停在超长记录上 */
+		BinlogReader r;
+		ASSERT_EQ(0, r.init(dir.path(), "ut"));
+		std::string body;
+		ASSERT_EQ(0, read_record(r, body));
+		EXPECT_EQ("before", body);
+		ASSERT_EQ(0, read_record(r, body));
+		EXPECT_EQ("after", body);
+	}
+}
+
+struct FlushCounter : public LogFlushListener {
+	FlushCounter() : n(0)
+	{
+	}
+	virtual void on_log_flushed(void)
+	{
+		n++;
+	}
+	int n;
+};
+
+TEST_F(BinlogTest, GroupCommit)
+{
+	BinlogWriter w;
+	FlushCounter counter;
+	ASSERT_EQ(0, w.init(dir_.path(), "ut"));
+	ASSERT_EQ(0, w.set_format(BINLOG_CRC_VERSION, 0));
+	ASSERT_EQ(0, w.set_group_commit(4096, LOG_SYNC_NONE, 0));
+	for (int i = 0; i < 100; i++)
+		ASSERT_EQ(0, write_record(w, BINLOG_INSERT,
+					  std::string(i + 1, 'a' + i % 26)));
+	/* 缓冲区满时写盘，最后一批还在缓冲区里，没有JournalID */
+	JournalID before = w.query_id();
+	EXPECT_TRUE(w.buffered());
+	w.set_flush_listener(&counter);
+	ASSERT_EQ(0, w.Flush());
+	EXPECT_FALSE(w.buffered());
+	EXPECT_EQ(1, counter.n);
+	w.set_flush_listener(NULL);
+	JournalID jid = w.query_id();
+	EXPECT_GT(jid.offset, before.offset);
+
+	struct stat st;
+	ASSERT_EQ(0, stat(binlog_file(jid.serial).c_str(), &st));
+	EXPECT_EQ((off_t)jid.offset, st.st_size);
+
+	BinlogReader r;
+	ASSERT_EQ(0, r.init(dir_.path(), "ut"));
+	std::string body;
+	for (int i = 0; i < 100; i++) {
+		ASSERT_EQ(0, read_record(r, body));
+		EXPECT_EQ(std::string(i + 1, 'a' + i % 26), body);
+	}
+	EXPECT_EQ(-1, r.Read());
+}
+
+/* 写盘失败的记录留在缓冲区，不通知，位置不前进 */
+TEST_F(BinlogTest, GroupCommitKeepsRecordsOnWriteFailure)
+{
+	/* 第一个文件写满后切到2号文件，让它落到/dev/full上 */
+	BinlogWriter w;
+	FlushCounter counter;
+	ASSERT_EQ(0, w.init(dir_.path(), "ut", BINLOG_MAX_TOTAL_SIZE, 64));
+	ASSERT_EQ(0, symlink("/dev/full", binlog_file(2).c_str()));
+	ASSERT_EQ(0, w.set_group_commit(4096, LOG_SYNC_NONE, 0));
+	ASSERT_EQ(0, write_record(w, BINLOG_INSERT, std::string(64, 'x')));
+	ASSERT_EQ(2U, w.query_id().serial);
+
+	w.set_flush_listener(&counter);
+	ASSERT_EQ(0, write_record(w, BINLOG_INSERT, "kept"));
+	JournalID jid = w.query_id();
+
+	EXPECT_EQ(-1, w.Flush());
+	EXPECT_TRUE(w.buffered());
+	EXPECT_EQ(-1, w.Flush());
+	EXPECT_TRUE(w.buffered());
+	EXPECT_EQ(0, counter.n);
+	EXPECT_EQ((uint64_t)jid, (uint64_t)w.query_id());
+	w.set_flush_listener(NULL);
+}
+
+#endif
@@ -0,0 +1,284 @@
+#ifndef BTREE_UNITTEST_H_
+#define BTREE_UNITTEST_H_
+
+#include <algorithm>
+#include <vector>
+#include "unittest_comm.h"
+#include "tree/b_tree.h"
+#include "sys_malloc.h"
+
+/* 记录里只存key，遍历时按顺序收集 */
+static int collect_key(MallocBase &stMalloc, ALLOC_HANDLE_T &hRecord,
+		       void *pCookie)
+{
+	std::vector<uint64_t> *keys = (std::vector<uint64_t> *)pCookie;
+	keys->push_back(*stMalloc.Pointer<uint64_t>(hRecord));
+	return 0;
+}
+
+class BtreeTest : public testing::Test {
+    protected:
+	BtreeTest() : tree_(g_stSysMalloc), nodes_(0)
+	{
+	}
+	virtual void TearDown()
+	{
+		tree_.destory();
+	}
+
+	int insert(uint64_t key)
+	{
+		ALLOC_HANDLE_T h = g_stSysMalloc.Malloc(sizeof(uint64_t));
+		*g_stSysMalloc.Pointer<uint64_t>(h) = key;
+		int alloc = 0;
+		int ret = tree_.do_insert(key, h, alloc);
+		if (ret != 0)
+			g_stSysMalloc.Free(h);
+		nodes_ += alloc;
+		return ret;
+	}
+
+	int remove(uint64_t key)
+	{
+		ALLOC_HANDLE_T h;
+		if (tree_.do_find(key, h) != 1)
+			return -1;
+		int freed = 0;
+		int ret = tree_.Delete(key, freed);
+		if (ret == 0)
+			g_stSysMalloc.Free(h);
+		nodes_ -= freed;
+		return ret;
+	}
+
+	std::vector<uint64_t> forward(void)
+	{
+		std::vector<uint64_t> keys;
+		tree_.traverse_forward(collect_key, &keys);
+		return keys;
+	}
+
+	/* 检查节点内key有序、子树key在分隔key范围内、叶子链表完整，返回节点数 */
+	int check_node(ALLOC_HANDLE_T h, uint64_t lo, uint64_t hi, bool has_hi,
+		       std::vector<ALLOC_HANDLE_T> &leaves)
+	{
+		BtreeNode *p = g_stSysMalloc.Pointer<BtreeNode>(h);
+		EXPECT_GT(p->m_ushNItems, 0);
+		EXPECT_LE(p->m_ushNItems, (int)BtreeNode::PAGE_SIZE);
+		int start = p->m_chLeaf ? 0 : 1;
+		for (int i = start; i < p->m_ushNItems; i++) {
+			EXPECT_GE(p->m_aullKeys[i], lo);
+			if (has_hi)
+				EXPECT_LT(p->m_aullKeys[i], hi);
+			if (i > start)
+				EXPECT_LT(p->m_aullKeys[i - 1],
+					  p->m_aullKeys[i]);
+		}
+		if (p->m_chLeaf) {
+			leaves.push_back(h);
+			return 1;
+		}
+		int n = 1;
+		for (int i = 0; i < p->m_ushNItems; i++) {
+			uint64_t clo = i ? p->m_aullKeys[i] : lo;
+			bool chas = i + 1 < p->m_ushNItems || has_hi;
+			uint64_t chi = i + 1 < p->m_ushNItems ?
+					       p->m_aullKeys[i + 1] :
+					       hi;
+			n += check_node(p->m_ahItems[i], clo, chi, chas,
+					leaves);
+		}
+		return n;
+	}
+
+	void check_tree(size_t count)
+	{
+		std::vector<ALLOC_HANDLE_T> leaves;
+		int n = 0;
+		if (tree_.Root() != INVALID_HANDLE)
+			n = check_node(tree_.Root(), 0, 0, false, leaves);
+		EXPECT_EQ(nodes_, n);
+		for (size_t i = 0; i < leaves.size(); i++) {
+			BtreeNode *p = g_stSysMalloc.Pointer<BtreeNode>(
+				leaves[i]);
+			EXPECT_EQ(i ? leaves[i - 1] : INVALID_HANDLE,
+				  p->m_hPrev);
+			EXPECT_EQ(i + 1 < leaves.size() ? leaves[i + 1] :
+							  INVALID_HANDLE,
+				  p->m_hNext);
+		}
+		std::vector<uint64_t> keys = forward();
+		EXPECT_EQ(count, keys.size());
+		for (size_t i = 1; i < keys.size(); i++)
+			EXPECT_LT(keys[i - 1], keys[i]);
+	}
+
+	Btree tree_;
+	int nodes_;
+};
+
+TEST_F(BtreeTest, AscendingInsertFillsLeaves)
+{
+	const int n = 30 * 40 + 7;
+	for (int i = 0; i < n; i++)
+		ASSERT_EQ(0, insert(i));
+	check_tree(n);
+
+	// 按序追加时除最后一个叶子外都是满的
+	std::vector<ALLOC_HANDLE_T> leaves;
+	check_node(tree_.Root(), 0, 0, false, leaves);
+	EXPECT_EQ((size_t)(n + 29) / 30, leaves.size());
+
+	ALLOC_HANDLE_T h;
+	for (int i = 0; i < n; i++) {
+		ASSERT_EQ(1, tree_.do_find(i, h));
+		EXPECT_EQ((uint64_t)i, *g_stSysMalloc.Pointer<uint64_t>(h));
+	}
+	EXPECT_EQ(0, tree_.do_find(n, h));
+}
+
+TEST_F(BtreeTest, DescendingInsert)
+{
+	const int n = 2000;
+	for (int i = n; i > 0; i--)
+		ASSERT_EQ(0, insert(i * 3));
+	check_tree(n);
+	ALLOC_HANDLE_T h;
+	EXPECT_EQ(1, tree_.do_find(3, h));
+	EXPECT_EQ(0, tree_.do_find(4, h));
+}
+
+TEST_F(BtreeTest, RandomInsertAndDuplicate)
+{
+	std::vector<uint64_t> keys;
+	for (uint64_t i = 0; i < 5000; i++)
+		keys.push_back(i * 7919 % 100003);
+	std::random_shuffle(keys.begin(), keys.end());
+	for (size_t i = 0; i < keys.size(); i++)
+		ASSERT_EQ(0, insert(keys[i]));
+	check_tree(keys.size());
+
+	EXPECT_EQ(EC_KEY_EXIST, insert(keys[123]));
+	check_tree(keys.size());
+
+	std::sort(keys.begin(), keys.end());
+	EXPECT_TRUE(keys == forward());
+}
+
+TEST_F(BtreeTest, SignedKeysKeepOrder)
+{
+	int64_t v[] = { -5, 3, -1000000000000LL, 0, 77, -1 };
+	for (size_t i = 0; i < sizeof(v) / sizeof(v[0]); i++)
+		ASSERT_EQ(0, insert((uint64_t)v[i] ^ (1ULL << 63)));
+	std::vector<uint64_t> keys = forward();
+	ASSERT_EQ(6U, keys.size());
+	EXPECT_EQ(-1000000000000LL, (int64_t)(keys[0] ^ (1ULL << 63)));
+	EXPECT_EQ(77, (int64_t)(keys[5] ^ (1ULL << 63)));
+}
+
+TEST_F(BtreeTest, DeleteShrinksAndFreesNodes)
+{
+	std::vector<uint64_t> keys;
+	for (uint64_t i = 0; i < 3000; i++)
+		keys.push_back(i);
+	std::random_shuffle(keys.begin(), keys.end());
+	for (size_t i = 0; i < keys.size(); i++)
+		ASSERT_EQ(0, insert(keys[i]));
+
+	std::random_shuffle(keys.begin(), keys.end());
+	for (size_t i = 0; i < keys.size(); i++) {
+		ASSERT_EQ(0, remove(keys[i]));
+		ALLOC_HANDLE_T h;
+		ASSERT_EQ(0, tree_.do_find(keys[i], h));
+		if (i % 500 == 0)
+			check_tree(keys.size() - i - 1);
+	}
+	EXPECT_EQ(INVALID_HANDLE, tree_.Root());
+	EXPECT_EQ(0, nodes_);
+
+	// 删空后还能继续使用
+	ASSERT_EQ(0, insert(42));
+	check_tree(1);
+}
+
+TEST_F(BtreeTest, SplitAfterDeleteFromMiddle)
+{
+	for (int i = 0; i < 600; i++)
+		ASSERT_EQ(0, insert(i * 2));
+	for (int i = 100; i < 400; i++)
+		ASSERT_EQ(0, remove(i * 2));
+	// 在删过的区间和满叶子中间插入，触发中间节点分裂
+	for (int i = 0; i < 600; i++)
+		ASSERT_EQ(0, insert(i * 2 + 1));
+	check_tree(300 + 600);
+}
+
+TEST_F(BtreeTest, RangeScan)
+{
+	for (int i = 1; i <= 1000; i++)
+		ASSERT_EQ(0, insert(i * 10));
+
+	std::vector<uint64_t> keys;
+	tree_.traverse_forward(95, 305, collect_key, &keys);
+	ASSERT_EQ(21U, keys.size());
+	EXPECT_EQ(100U, keys.front());
+	EXPECT_EQ(300U, keys.back());
+
+	keys.clear();
+	tree_.traverse_forward(9990, collect_key, &keys);
+	ASSERT_EQ(2U, keys.size());
+	EXPECT_EQ(9990U, keys[0]);
+
+	keys.clear();
+	tree_.traverse_backward(35, collect_key, &keys);
+	ASSERT_EQ(3U, keys.size());
+	EXPECT_EQ(30U, keys[0]);
+	EXPECT_EQ(10U, keys[2]);
+
+	keys.clear();
+	tree_.traverse_backward(collect_key, &keys);
+	ASSERT_EQ(1000U, keys.size());
+	EXPECT_EQ(10000U, keys[0]);
+
+	keys.clear();
+	tree_.traverse_forward(10001, collect_key, &keys);
+	EXPECT_TRUE(keys.empty());
+	tree_.traverse_backward(5, collect_key, &keys);
+	EXPECT_TRUE(keys.empty());
+}
+
+TEST_F(BtreeTest, BulkLoadThenInsert)
+{
+	std::vector<uint64_t> keys;
+	std::vector<ALLOC_HANDLE_T> records;
+	for (uint64_t i = 0; i < 1000; i++) {
+		keys.push_back(i * 2);
+		ALLOC_HANDLE_T h = g_stSysMalloc.Malloc(sizeof(uint64_t));
+		*g_stSysMalloc.Pointer<uint64_t>(h) = i * 2;
+		records.push_back(h);
+	}
+	int alloc = 0;
+	ASSERT_EQ(0, tree_.bulk_load(&keys[0], &records[0], keys.size(),
+				     alloc));
+	nodes_ = alloc;
+	/* 内存不足重试时按这个数申请 */
+	EXPECT_EQ((uint32_t)alloc, Btree::bulk_node_count(keys.size()));
+	check_tree(1000);
+
+	for (uint64_t i = 0; i < 1000; i++)
+		ASSERT_EQ(0, insert(i * 2 + 1));
+	check_tree(2000);
+}
+
+TEST(BtreeBulkTest, NodeCountPerLevel)
+{
+	uint32_t page = BtreeNode::PAGE_SIZE;
+	EXPECT_EQ(0U, Btree::bulk_node_count(0));
+	EXPECT_EQ(1U, Btree::bulk_node_count(1));
+	EXPECT_EQ(1U, Btree::bulk_node_count(page));
+	EXPECT_EQ(3U, Btree::bulk_node_count(page + 1));
+	EXPECT_EQ(page + 1, Btree::bulk_node_count(page * page));
+	EXPECT_EQ(page + 1 + 3, Btree::bulk_node_count(page * page + 1));
+}
+
+#endif
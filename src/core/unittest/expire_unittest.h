@@ -0,0 +1,245 @@
+#ifndef EXPIRE_UNITTEST_H_
+#define EXPIRE_UNITTEST_H_
+
+#include <vector>
+#include <algorithm>
+#include "unittest_comm.h"
+#include "expire_time.h"
+
+#define EXPIRE_FIELDS                                                          \
+	"      - {name: uid, type: unsigned, size: 4, unique: 1}\n"           \
+	"      - {name: v, type: signed, size: 4}\n"                          \
+	"      - {name: _dtc_sys_expiretime, type: unsigned, size: 4}\n"
+
+struct KeepOdd {
+	bool operator()(const EXPIRE_ENTRY_T &e) const
+	{
+		return e.ee_node % 2;
+	}
+};
+
+class ExpireIndexTest : public testing::Test {
+    protected:
+	void SetUp()
+	{
+		ASSERT_EQ(0, pond_.open(EXPIRE_FIELDS));
+	}
+	TestPond pond_;
+};
+
+TEST_F(ExpireIndexTest, PopsInExpireOrder)
+{
+	ExpireIndex index;
+	ASSERT_EQ(0, index.init(4));
+	std::vector<uint32_t> expires;
+	for (uint32_t i = 0; i < 1000; i++) {
+		uint32_t e = (i * 7919) % 1009;
+		expires.push_back(e);
+		ASSERT_EQ(0, index.push(i, e));
+	}
+	EXPECT_EQ(1000U, index.size());
+	EXPECT_FALSE(index.lossy());
+
+	std::sort(expires.begin(), expires.end());
+	for (size_t i = 0; i < expires.size(); i++) {
+		ASSERT_TRUE(index.top() != NULL);
+		EXPECT_EQ(expires[i], index.top()->ee_expire);
+		index.pop();
+	}
+	EXPECT_TRUE(index.top() == NULL);
+}
+
+TEST_F(ExpireIndexTest, FullIndexDropsAndGoesLossy)
+{
+	ExpireIndex index;
+	index.set_max_entries(8);
+	ASSERT_EQ(0, index.init(2));
+	for (uint32_t i = 0; i < 8; i++)
+		ASSERT_EQ(0, index.push(i, 100 + i));
+	EXPECT_EQ(8U, index.capacity());
+	EXPECT_EQ(-1, index.push(8, 1));
+	EXPECT_TRUE(index.lossy());
+	EXPECT_EQ(1U, index.drops());
+	EXPECT_EQ(100U, index.top()->ee_expire);
+}
+
+TEST_F(ExpireIndexTest, CompactKeepsHeapOrder)
+{
+	ExpireIndex index;
+	ASSERT_EQ(0, index.init(16));
+	for (uint32_t i = 0; i < 100; i++)
+		ASSERT_EQ(0, index.push(i, 1000 - i));
+	EXPECT_EQ(50U, index.compact(KeepOdd()));
+	EXPECT_EQ(50U, index.size());
+	uint32_t last = 0;
+	while (index.top() != NULL) {
+		EXPECT_EQ(1U, index.top()->ee_node % 2);
+		EXPECT_LE(last, index.top()->ee_expire);
+		last = index.top()->ee_expire;
+		index.pop();
+	}
+}
+
+class ExpireTimeTest : public testing::Test {
+    protected:
+	void SetUp()
+	{
+		ASSERT_EQ(0, pond_.open(EXPIRE_FIELDS));
+		mode_.m_iAsyncServer = MODE_SYNC;
+		mode_.m_iUpdateMode = MODE_SYNC;
+		mode_.m_iInsertMode = MODE_SYNC;
+		mode_.m_uchInsertOrder = 0;
+		process_ = new RawDataProcess(PtMalloc::instance(),
+					      pond_.table(), pond_.pond(),
+					      &mode_);
+		expire_ = new ExpireTime(NULL, pond_.pond(), process_,
+					 pond_.table(), 1000);
+	}
+	void TearDown()
+	{
+		delete expire_;
+		delete process_;
+	}
+
+	/* 缓存一个key，唯一的一行带过期时间 */
+	Node cache_key(uint32_t key, uint32_t expire)
+	{
+		Node node = pond_.alloc(key);
+		if (!node || set_expire(node, key, expire) != 0)
+			return Node();
+		return node;
+	}
+	/* 替换节点的数据，旧数据留在共享内存里不回收 */
+	int set_expire(Node node, uint32_t key, uint32_t expire)
+	{
+		RawData raw(PtMalloc::instance());
+		if (raw.do_init((const char *)&key, 0) != 0)
+			return -1;
+		RowValue row(pond_.table());
+		row[0].u64 = key;
+		row[1].s64 = 0;
+		row[2].u64 = expire;
+		if (raw.insert_row(row, false, false) != 0)
+			return -1;
+		node.vd_handle() = raw.get_handle();
+		return 0;
+	}
+
+	int rebuild_all(void)
+	{
+		int ticks = 0;
+		do {
+			expire_->rebuild_index();
+			++ticks;
+		} while (expire_->rebuilding());
+		return ticks;
+	}
+
+	TestPond pond_;
+	UpdateMode mode_;
+	RawDataProcess *process_;
+	ExpireTime *expire_;
+};
+
+TEST_F(ExpireTimeTest, RebuildIndexesNodesCachedBefore)
+{
+	for (uint32_t k = 1; k <= 100; k++)
+		ASSERT_TRUE(!!cache_key(k, 5000 + k));
+
+	/* 索引晚于节点创建，标记为lossy */
+	ASSERT_EQ(0, expire_->attach_index(1 << 20, 16));
+	FEATURE_INFO_T *f = pond_.pond()->query_feature_by_id(EXPIRE_INDEX);
+	ASSERT_TRUE(f != NULL);
+	ExpireIndex index;
+	ASSERT_EQ(0, index.attach(f->fi_handle));
+	EXPECT_TRUE(index.lossy());
+
+	/* 每次最多扫描16个node id */
+	EXPECT_GT(rebuild_all(), 1);
+	ASSERT_EQ(0, index.attach(f->fi_handle));
+	EXPECT_FALSE(index.lossy());
+	EXPECT_EQ(100U, index.size());
+	EXPECT_EQ(5001U, index.top()->ee_expire);
+}
+
+TEST_F(ExpireTimeTest, StaleEntriesCompactedInBatches)
+{
+	ASSERT_EQ(0, expire_->attach_index(64, 1000));
+	FEATURE_INFO_T *f = pond_.pond()->query_feature_by_id(EXPIRE_INDEX);
+	ASSERT_TRUE(f != NULL);
+
+	/* 同一批key反复更新过期时间，旧条目失效后被整理掉 */
+	std::vector<Node> nodes;
+	for (uint32_t k = 1; k <= 20; k++) {
+		Node node = cache_key(k, 1000);
+		ASSERT_TRUE(!!node);
+		expire_->index_node(node, 0);
+		nodes.push_back(node);
+	}
+	for (uint32_t round = 1; round <= 20; round++) {
+		for (uint32_t k = 1; k <= 20; k++) {
+			ASSERT_EQ(0, set_expire(nodes[k - 1], k, 1000 + round));
+			expire_->index_node(nodes[k - 1], 1000 + round - 1);
+		}
+	}
+
+	ExpireIndex index;
+	ASSERT_EQ(0, index.attach(f->fi_handle));
+	EXPECT_FALSE(index.lossy());
+	EXPECT_LE(index.size(), 64U);
+	EXPECT_GE(index.top()->ee_expire, 1017U);
+}
+
+TEST_F(ExpireTimeTest, RebuildAfterOverflow)
+{
+	ASSERT_EQ(0, expire_->attach_index(64, 1000));
+	FEATURE_INFO_T *f = pond_.pond()->query_feature_by_id(EXPIRE_INDEX);
+	ASSERT_TRUE(f != NULL);
+
+	/* 超过半个堆的条目有效，整理赶不上入堆，条目被丢弃 */
+	std::vector<Node> nodes;
+	for (uint32_t k = 1; k <= 40; k++) {
+		Node node = cache_key(k, 1000);
+		ASSERT_TRUE(!!node);
+		expire_->index_node(node, 0);
+		nodes.push_back(node);
+	}
+	for (uint32_t round = 1; round <= 3; round++) {
+		for (uint32_t k = 1; k <= 40; k++) {
+			ASSERT_EQ(0, set_expire(nodes[k - 1], k, 1000 + round));
+			expire_->index_node(nodes[k - 1], 1000 + round - 1);
+		}
+	}
+	ExpireIndex index;
+	ASSERT_EQ(0, index.attach(f->fi_handle));
+	ASSERT_TRUE(index.lossy());
+
+	/* 缓存非空也能重建 */
+	rebuild_all();
+	ASSERT_EQ(0, index.attach(f->fi_handle));
+	EXPECT_FALSE(index.lossy());
+	EXPECT_EQ(40U, index.size());
+	EXPECT_EQ(1003U, index.top()->ee_expire);
+}
+
+TEST_F(ExpireTimeTest, RebuildStaysLossyWhenTooManyKeys)
+{
+	ASSERT_EQ(0, expire_->attach_index(16, 1000));
+	FEATURE_INFO_T *f = pond_.pond()->query_feature_by_id(EXPIRE_INDEX);
+	ASSERT_TRUE(f != NULL);
+	for (uint32_t k = 1; k <= 32; k++) {
+		Node node = cache_key(k, 2000 + k);
+		ASSERT_TRUE(!!node);
+		expire_->index_node(node, 0);
+	}
+
+	ExpireIndex index;
+	ASSERT_EQ(0, index.attach(f->fi_handle));
+	EXPECT_TRUE(index.lossy());
+	rebuild_all();
+	ASSERT_EQ(0, index.attach(f->fi_handle));
+	EXPECT_TRUE(index.lossy());
+	EXPECT_EQ(16U, index.size());
+}
+
+#endif
@@ -0,0 +1,162 @@
+#ifndef FIELD_AGGREGATE_UNITTEST_H_
+#define FIELD_AGGREGATE_UNITTEST_H_
+
+#include <string>
+#include <vector>
+#include "unittest_comm.h"
+#include "field/field.h"
+#include "my/my_request.h"
+#include "dtc_error_code.h"
+
+#define AGGREGATE_FIELDS                                                       \
+	"      - {name: uid, type: unsigned, size: 4, unique: 1}\n"           \
+	"      - {name: a, type: signed, size: 8}\n"                          \
+	"      - {name: b, type: unsigned, size: 4}\n"                        \
+	"      - {name: f, type: float, size: 8}\n"                           \
+	"      - {name: s, type: string, size: 16}\n"                         \
+	"      - {name: n, type: signed, size: 4, nullable: 1}\n"
+
+/* 聚合结果与逐行计算一致，空集和不支持的聚合按SQL语义处理 */
+class FieldAggregateTest : public testing::Test {
+    protected:
+	virtual void SetUp()
+	{
+		ASSERT_EQ(0, pond_.open(AGGREGATE_FIELDS));
+		uint8_t ids[] = { 0, 1, 2, 3, 4, 5 };
+		fs_ = new DTCFieldSet(ids, 6);
+	}
+	virtual void TearDown()
+	{
+		delete fs_;
+	}
+
+	int compile(const std::vector<uint8_t> &spec)
+	{
+		return agg_.Compile(pond_.table(), *fs_, (const char *)&spec[0],
+				    spec.size());
+	}
+
+	void add(int64_t a, uint64_t b, double f, const char *s)
+	{
+		RowValue row(pond_.table());
+		row[0].u64 = 1;
+		row[1].s64 = a;
+		row[2].u64 = b;
+		row[3].flt = f;
+		row[4].Set(s, strlen(s));
+		row[5].s64 = 0;
+		ASSERT_EQ(0, agg_.Add(row));
+	}
+
+	/* 一条select的聚合函数，-1为不支持 */
+	int aggregate_array(const char *sql, std::vector<uint8_t> &funcs)
+	{
+		MyRequest mr;
+		if (!hsql::SQLParser::parse(sql, mr.get_result()) ||
+		    !mr.get_result()->isValid())
+			return -2;
+		return mr.get_aggregate_array(funcs);
+	}
+
+	TestPond pond_;
+	DTCFieldSet *fs_;
+	RowAggregate agg_;
+};
+
+TEST_F(FieldAggregateTest, SumMinMax)
+{
+	uint8_t spec[] = { 1, DField::Sum, 2, DField::Max, 3, DField::Min,
+			   4, DField::Max, 0, DField::Count };
+	ASSERT_EQ(0, compile(std::vector<uint8_t>(spec, spec + sizeof(spec))));
+	ASSERT_TRUE(agg_.is_active());
+	agg_.Start();
+	add(-5, 7, 2.5, "b");
+	add(12, 3, -1.0, "C");
+	add(-4, 9, 0.5, "a");
+	EXPECT_EQ(3U, agg_.num_rows());
+
+	RowValue out(pond_.table());
+	agg_.Output(out);
+	EXPECT_EQ(3, out[1].s64);
+	EXPECT_EQ(9U, out[2].u64);
+	EXPECT_EQ(-1.0, out[3].flt);
+	// 字符串比较不区分大小写
+	EXPECT_EQ("C", std::string(out[4].str.ptr, out[4].str.len));
+	EXPECT_FALSE(RowAggregate::is_null(DField::Sum, agg_.num_rows()));
+
+	// 重新开始时清空
+	agg_.Start();
+	add(1, 1, 1.0, "x");
+	agg_.Output(out);
+	EXPECT_EQ(1U, agg_.num_rows());
+	EXPECT_EQ(1, out[1].s64);
+}
+
+/* 没有匹配的行时SUM/MIN/MAX和普通列为NULL，COUNT为0 */
+TEST_F(FieldAggregateTest, EmptySetIsNull)
+{
+	uint8_t spec[] = { 1, DField::Sum, 2, DField::Min, 0, DField::Count };
+	ASSERT_EQ(0, compile(std::vector<uint8_t>(spec, spec + sizeof(spec))));
+	agg_.Start();
+	EXPECT_EQ(0U, agg_.num_rows());
+	EXPECT_TRUE(RowAggregate::is_null(DField::Sum, agg_.num_rows()));
+	EXPECT_TRUE(RowAggregate::is_null(DField::Min, agg_.num_rows()));
+	EXPECT_TRUE(RowAggregate::is_null(DField::Max, agg_.num_rows()));
+	EXPECT_TRUE(RowAggregate::is_null(DField::None, agg_.num_rows()));
+	EXPECT_FALSE(RowAggregate::is_null(DField::Count, agg_.num_rows()));
+}
+
+/* cache里不保存NULL，可为NULL的字段上的COUNT(col)无法忽略NULL */
+TEST_F(FieldAggregateTest, CountOfNullableIsRefused)
+{
+	uint8_t nullable[] = { 5, DField::Count };
+	EXPECT_EQ(-EC_BAD_OPERATOR,
+		  compile(std::vector<uint8_t>(nullable,
+					       nullable + sizeof(nullable))));
+	uint8_t plain[] = { 1, DField::Count };
+	EXPECT_EQ(0, compile(std::vector<uint8_t>(plain, plain + 2)));
+	uint8_t sum[] = { 5, DField::Sum };
+	EXPECT_EQ(0, compile(std::vector<uint8_t>(sum, sum + 2)));
+}
+
+TEST_F(FieldAggregateTest, BadSpec)
+{
+	uint8_t str_sum[] = { 4, DField::Sum };
+	EXPECT_EQ(-EC_BAD_VALUE_TYPE,
+		  compile(std::vector<uint8_t>(str_sum, str_sum + 2)));
+	uint8_t two[] = { 1, DField::Min, 1, DField::Max };
+	EXPECT_EQ(-EC_BAD_OPERATOR, compile(std::vector<uint8_t>(two, two + 4)));
+	uint8_t missing[] = { 9, DField::Max };
+	EXPECT_EQ(-EC_BAD_FIELD_ID,
+		  compile(std::vector<uint8_t>(missing, missing + 2)));
+	uint8_t odd[] = { 1, DField::Max, 2 };
+	EXPECT_EQ(-EC_BAD_VALUE_LENGTH,
+		  compile(std::vector<uint8_t>(odd, odd + 3)));
+}
+
+/* GROUP BY不分组，无论有没有聚合函数都拒绝 */
+TEST_F(FieldAggregateTest, GroupByIsRefused)
+{
+	std::vector<uint8_t> funcs;
+	ASSERT_EQ(0, aggregate_array("select count(*), sum(a), a from t "
+				     "where uid = 1",
+				     funcs));
+	ASSERT_EQ(3U, funcs.size());
+	EXPECT_EQ(DField::Count, funcs[0]);
+	EXPECT_EQ(DField::Sum, funcs[1]);
+	EXPECT_EQ(DField::None, funcs[2]);
+
+	EXPECT_EQ(0, aggregate_array("select a from t where uid = 1", funcs));
+	EXPECT_TRUE(funcs.empty());
+
+	EXPECT_EQ(-1, aggregate_array("select a, count(*) from t where uid = 1 "
+				      "group by a",
+				      funcs));
+	EXPECT_EQ(-1, aggregate_array("select a from t where uid = 1 group by a",
+				      funcs));
+	EXPECT_EQ(-1, aggregate_array("select count(distinct a) from t "
+				      "where uid = 1",
+				      funcs));
+}
+
+#endif
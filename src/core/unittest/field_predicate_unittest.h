@@ -0,0 +1,198 @@
+#ifndef FIELD_PREDICATE_UNITTEST_H_
+#define FIELD_PREDICATE_UNITTEST_H_
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include "unittest_comm.h"
+#include "raw_data.h"
+#include "field/field.h"
+
+#define PREDICATE_FIELDS                                                       \
+	"      - {name: uid, type: unsigned, size: 4, unique: 1}\n"           \
+	"      - {name: a, type: signed, size: 8}\n"                          \
+	"      - {name: b, type: unsigned, size: 4}\n"                        \
+	"      - {name: s, type: string, size: 16}\n"                         \
+	"      - {name: bn, type: binary, size: 16}\n"                        \
+	"      - {name: d, type: string, size: 16, dict: 1}\n"                \
+	"      - {name: f, type: float, size: 8}\n"
+
+static const int64_t g_pred_ints[] = { INT64_MIN, INT64_MIN + 1, -100, -1,
+				       0,	  1,		 2,    100,
+				       INT64_MAX - 1, INT64_MAX };
+static const char *g_pred_strs[] = { "", "a", "A", "abc", "ABC", "abd", "b", "zzz" };
+
+#define PRED_NINTS (int)(sizeof(g_pred_ints) / sizeof(g_pred_ints[0]))
+#define PRED_NSTRS (int)(sizeof(g_pred_strs) / sizeof(g_pred_strs[0]))
+
+/*
+ * 编译后的条件与逐个条件解释执行的结果一致。
+ * 行从节点解码，字典字段的值指向字典，条件值有的在字典里有的不在。
+ */
+class FieldPredicateTest : public testing::Test {
+    protected:
+	virtual void SetUp()
+	{
+		ASSERT_EQ(0, pond_.open(PREDICATE_FIELDS));
+		ASSERT_TRUE(pond_.table()->string_dict() != NULL);
+		srandom(42);
+	}
+
+	/* 值集合很小，条件和行的值经常相等 */
+	void random_value(int type, DTCValue &v)
+	{
+		switch (type) {
+		case DField::Signed:
+		case DField::Unsigned:
+			v.s64 = g_pred_ints[random() % PRED_NINTS];
+			break;
+		case DField::Float:
+			v.flt = (double)(random() % 5);
+			break;
+		default:
+			// 最后一个值不写入行，只出现在条件里
+			const char *s = g_pred_strs[random() % (PRED_NSTRS - 1)];
+			v.Set(s, strlen(s));
+			break;
+		}
+	}
+
+	void build_rows(RawData &node, int n)
+	{
+		uint32_t key = 1;
+		ASSERT_EQ(0, node.do_init((const char *)&key, 0));
+		RowValue row(pond_.table());
+		for (int i = 0; i < n; i++) {
+			row[0].u64 = key;
+			for (int id = 1; id < pond_.table()->num_fields() + 1;
+			     id++)
+				random_value(pond_.table()->field_type(id),
+					     row[id]);
+			// 无符号字段只存4字节
+			row[2].u64 = (uint32_t)row[2].u64;
+			ASSERT_EQ(0, node.insert_row(row, false, false));
+		}
+	}
+
+	/* 随机条件，偶尔带key字段、类型不匹配或者不支持的类型 */
+	void random_condition(DTCFieldValue &cond, int n)
+	{
+		for (int i = 0; i < n; i++) {
+			int id = random() % (pond_.table()->num_fields() + 1);
+			int op = random() % DField::TotalComparison;
+			int type = pond_.table()->field_type(id);
+			if (type == DField::Unsigned)
+				type = DField::Signed;
+			if (random() % 8 == 0)
+				type = 1 + random() % (DField::TotalType - 1);
+			DTCValue v;
+			if (type == DField::String || type == DField::Binary) {
+				const char *s = g_pred_strs[random() % PRED_NSTRS];
+				v.Set(s, strlen(s));
+			} else {
+				random_value(type, v);
+			}
+			cond.add_value(id, op, type, v);
+		}
+	}
+
+	TestPond pond_;
+};
+
+TEST_F(FieldPredicateTest, SameResultAsInterpreted)
+{
+	RawData node(PtMalloc::instance());
+	build_rows(node, 400);
+	std::vector<RowValue *> rows;
+	unsigned char flag;
+	node.rewind();
+	for (unsigned i = 0; i < node.total_rows(); i++) {
+		RowValue *r = new RowValue(pond_.table());
+		ASSERT_EQ(0, node.decode_row(*r, flag));
+		rows.push_back(r);
+	}
+
+	int matched = 0, total = 0;
+	for (int round = 0; round < 3000; round++) {
+		DTCFieldValue cond(8);
+		random_condition(cond, 1 + round % 6);
+		int first = round % 5 == 0 ? 1 + random() % 7 : 256;
+		for (size_t i = 0; i < rows.size(); i++) {
+			int expect = cond.compare_interpreted(*rows[i], first);
+			ASSERT_EQ(expect, cond.Compare(*rows[i], first))
+				<< "round " << round << " row " << i;
+			matched += expect;
+			total++;
+		}
+	}
+	// 条件既不能全不满足也不能全满足，否则没有比较意义
+	EXPECT_GT(matched, total / 50);
+	EXPECT_LT(matched, total / 2);
+
+	for (size_t i = 0; i < rows.size(); i++)
+		delete rows[i];
+	node.destory();
+}
+
+/* 同一字段上的范围合并，边界值上不溢出 */
+TEST_F(FieldPredicateTest, FoldedRangeBoundaries)
+{
+	RowValue row(pond_.table());
+	row[0].u64 = 1;
+	row[4].Set("", 0);
+	row[3].Set("", 0);
+	row[5].Set("", 0);
+	struct {
+		int op1;
+		int64_t v1;
+		int op2;
+		int64_t v2;
+	} cases[] = {
+		{ DField::LT, INT64_MIN, DField::GE, INT64_MIN },
+		{ DField::GT, INT64_MAX, DField::LE, INT64_MAX },
+		{ DField::GE, 5, DField::LE, 5 },
+		{ DField::GT, 5, DField::LT, 6 },
+		{ DField::EQ, 3, DField::EQ, 4 },
+		{ DField::EQ, 3, DField::NE, 3 },
+		{ DField::LE, INT64_MIN, DField::GE, INT64_MIN },
+	};
+	for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+		DTCFieldValue cond(2);
+		DTCValue v;
+		v.s64 = cases[c].v1;
+		cond.add_value(1, cases[c].op1, DField::Signed, v);
+		v.s64 = cases[c].v2;
+		cond.add_value(1, cases[c].op2, DField::Signed, v);
+		for (int i = 0; i < PRED_NINTS; i++) {
+			row[1].s64 = g_pred_ints[i];
+			EXPECT_EQ(cond.compare_interpreted(row),
+				  cond.Compare(row))
+				<< "case " << c << " value " << row[1].s64;
+		}
+	}
+}
+
+/* 条件修改后重新编译 */
+TEST_F(FieldPredicateTest, RecompileAfterChange)
+{
+	RowValue row(pond_.table());
+	row[0].u64 = 1;
+	row[1].s64 = 10;
+	DTCFieldValue cond(2);
+	DTCValue v;
+	v.s64 = 5;
+	cond.add_value(1, DField::GT, DField::Signed, v);
+	EXPECT_EQ(1, cond.Compare(row));
+
+	v.s64 = 10;
+	cond.add_value(1, DField::LT, DField::Signed, v);
+	EXPECT_EQ(0, cond.Compare(row));
+
+	cond.Clean();
+	EXPECT_EQ(1, cond.Compare(row));
+	cond.add_value(1, DField::EQ, DField::Signed, v);
+	EXPECT_EQ(1, cond.Compare(row));
+}
+
+#endif
@@ -0,0 +1,214 @@
+#ifndef KEY_INDEX_UNITTEST_H_
+#define KEY_INDEX_UNITTEST_H_
+
+#include <map>
+#include <vector>
+#include "unittest_comm.h"
+#include "key_index.h"
+#include "raw_data.h"
+
+#define KEY_INDEX_FIELDS                                                       \
+	"      - {name: uid, type: unsigned, size: 4, unique: 1}\n"           \
+	"      - {name: v, type: signed, size: 4}\n"
+
+class KeyIndexTest : public testing::Test {
+    protected:
+	virtual void SetUp()
+	{
+		ASSERT_EQ(0, pond_.open(KEY_INDEX_FIELDS, 1));
+		ASSERT_TRUE(pond_.pond()->key_index() != NULL);
+	}
+
+	/* 按ScanKeyRange的方式分页，返回遍历到的key */
+	std::vector<uint32_t> scan_pages(KeyIndex *index, uint32_t from,
+					 uint32_t to, uint32_t limit,
+					 int &pages)
+	{
+		std::vector<uint32_t> keys;
+		std::vector<NODE_ID_T> ids;
+		pages = 0;
+		for (;;) {
+			EXPECT_EQ(0, index->scan((const char *)&from,
+						 (const char *)&to, limit,
+						 ids));
+			if (ids.empty())
+				break;
+			EXPECT_LE(ids.size(), limit);
+			++pages;
+			for (size_t i = 0; i < ids.size(); i++)
+				keys.push_back(id_key_[ids[i]]);
+			from = keys.back() + 1;
+		}
+		return keys;
+	}
+
+	/* 缓存一个key，带一行数据，重建索引时从数据里取key */
+	void alloc(uint32_t key)
+	{
+		Node node = pond_.alloc(key);
+		ASSERT_TRUE(!!node);
+		id_key_[node.node_id()] = key;
+
+		RawData raw(PtMalloc::instance());
+		ASSERT_EQ(0, raw.do_init((const char *)&key, 0));
+		RowValue row(pond_.table());
+		row[0].u64 = key;
+		row[1].s64 = 0;
+		ASSERT_EQ(0, raw.insert_row(row, false, false));
+		node.vd_handle() = raw.get_handle();
+	}
+
+	TestPond pond_;
+	std::map<NODE_ID_T, uint32_t> id_key_;
+};
+
+TEST_F(KeyIndexTest, AllocAndPurgeKeepIndex)
+{
+	for (uint32_t k = 1000; k > 0; k--)
+		alloc(k * 3);
+	KeyIndex *index = pond_.pond()->key_index();
+	EXPECT_EQ(1000U, index->size());
+
+	for (uint32_t k = 1; k <= 1000; k += 2) {
+		uint32_t key = k * 3;
+		ASSERT_EQ(0, pond_.pond()->cache_purge((const char *)&key));
+	}
+	EXPECT_EQ(500U, index->size());
+
+	int pages;
+	std::vector<uint32_t> keys = scan_pages(index, 0, ~0U, 64, pages);
+	ASSERT_EQ(500U, keys.size());
+	for (size_t i = 0; i < keys.size(); i++)
+		EXPECT_EQ((i + 1) * 6, keys[i]);
+}
+
+TEST_F(KeyIndexTest, PagingStopsAtEndOfRange)
+{
+	for (uint32_t k = 1; k <= 300; k++)
+		alloc(k * 10);
+	KeyIndex *index = pond_.pond()->key_index();
+
+	// 终点包含在内，正好整页结束时再取一次得到空页
+	int pages;
+	std::vector<uint32_t> keys = scan_pages(index, 15, 1000, 11, pages);
+	ASSERT_EQ(99U, keys.size());
+	EXPECT_EQ(20U, keys.front());
+	EXPECT_EQ(1000U, keys.back());
+	EXPECT_EQ(9, pages);
+
+	keys = scan_pages(index, 3001, ~0U, 10, pages);
+	EXPECT_TRUE(keys.empty());
+	EXPECT_EQ(0, pages);
+
+	std::vector<NODE_ID_T> ids;
+	uint32_t from = 10, to = 10;
+	EXPECT_EQ(0, index->scan((const char *)&from, (const char *)&to, 0,
+				 ids));
+	EXPECT_TRUE(ids.empty());
+	EXPECT_EQ(0, index->scan((const char *)&from, (const char *)&to, 5,
+				 ids));
+	ASSERT_EQ(1U, ids.size());
+	EXPECT_EQ(10U, id_key_[ids[0]]);
+}
+
+TEST_F(KeyIndexTest, RebuildAfterRestartWhenLossy)
+{
+	for (uint32_t k = 1; k <= 200; k++)
+		alloc(k);
+	KeyIndex *index = pond_.pond()->key_index();
+	index->set_lossy();
+	EXPECT_TRUE(pond_.pond()->key_index() == NULL);
+
+	ASSERT_EQ(0, pond_.reopen(1));
+	index = pond_.pond()->key_index();
+	ASSERT_TRUE(index != NULL);
+	EXPECT_EQ(200U, index->size());
+
+	int pages;
+	std::vector<uint32_t> keys = scan_pages(index, 0, ~0U, 1000, pages);
+	ASSERT_EQ(200U, keys.size());
+	EXPECT_EQ(1U, keys.front());
+	EXPECT_EQ(200U, keys.back());
+}
+
+TEST_F(KeyIndexTest, DisabledIndexIsRebuiltWhenEnabled)
+{
+	ASSERT_EQ(0, pond_.reopen(0));
+	EXPECT_TRUE(pond_.pond()->key_index() == NULL);
+	for (uint32_t k = 1; k <= 50; k++)
+		alloc(k);
+
+	ASSERT_EQ(0, pond_.reopen(1));
+	KeyIndex *index = pond_.pond()->key_index();
+	ASSERT_TRUE(index != NULL);
+	EXPECT_EQ(50U, index->size());
+}
+
+TEST_F(KeyIndexTest, SignedKeysInOrder)
+{
+	KeyIndex index(4, 1);
+	ASSERT_EQ(0, index.init());
+	int32_t v[] = { 5, -1, 0, -2000000000, 2000000000, -7 };
+	for (size_t i = 0; i < sizeof(v) / sizeof(v[0]); i++)
+		ASSERT_EQ(0, index.insert((const char *)&v[i], i + 1));
+
+	std::vector<NODE_ID_T> ids;
+	int32_t from = -7, to = 5;
+	ASSERT_EQ(0, index.scan((const char *)&from, (const char *)&to, 100,
+				ids));
+	// -7, -1, 0, 5
+	ASSERT_EQ(4U, ids.size());
+	EXPECT_EQ(6U, ids[0]);
+	EXPECT_EQ(2U, ids[1]);
+	EXPECT_EQ(3U, ids[2]);
+	EXPECT_EQ(1U, ids[3]);
+
+	// 同一个key指向新节点，删除旧节点时不影响
+	ASSERT_EQ(0, index.insert((const char *)&v[0], 100));
+	index.remove((const char *)&v[0], 1);
+	EXPECT_EQ(6U, index.size());
+	index.remove((const char *)&v[0], 100);
+	EXPECT_EQ(5U, index.size());
+}
+
+/* 内存不足时整棵树释放并标记lossy，重建后恢复 */
+TEST_F(KeyIndexTest, OutOfMemoryMakesIndexLossy)
+{
+	KeyIndex index(4, 0);
+	ASSERT_EQ(0, index.init());
+	uint32_t k = 1;
+	ASSERT_EQ(0, index.insert((const char *)&k, 1));
+
+	std::vector<ALLOC_HANDLE_T> hold;
+	for (ALLOC_SIZE_T size = 1 << 20; size >= 16; size >>= 1) {
+		for (;;) {
+			ALLOC_HANDLE_T h = PtMalloc::instance()->Malloc(size);
+			if (h == INVALID_HANDLE)
+				break;
+			hold.push_back(h);
+		}
+	}
+
+	int ret = 0;
+	for (k = 2; k < 100 && ret == 0; k++)
+		ret = index.insert((const char *)&k, k);
+	EXPECT_EQ(-1, ret);
+	EXPECT_TRUE(index.lossy());
+	EXPECT_EQ(0U, index.size());
+
+	std::vector<NODE_ID_T> ids;
+	EXPECT_EQ(-1, index.scan(NULL, NULL, 10, ids));
+
+	for (size_t i = 0; i < hold.size(); i++)
+		PtMalloc::instance()->Free(hold[i]);
+
+	index.begin_bulk_load();
+	for (k = 1; k <= 10; k++)
+		index.bulk_add((const char *)&k, k);
+	ASSERT_EQ(0, index.end_bulk_load());
+	EXPECT_FALSE(index.lossy());
+	EXPECT_EQ(0, index.scan(NULL, NULL, 100, ids));
+	EXPECT_EQ(10U, ids.size());
+}
+
+#endif
@@ -0,0 +1,575 @@
+#ifndef RAW_DATA_UNITTEST_H_
+#define RAW_DATA_UNITTEST_H_
+
+#include <string.h>
+#include <string>
+#include <vector>
+#include "unittest_comm.h"
+#include "raw_data.h"
+#include "sys_malloc.h"
+
+#define DICT_FIELDS                                                            \
+	"      - {name: uid, type: unsigned, size: 4, unique: 1}\n"           \
+	"      - {name: color, type: string, size: 300, dict: 1}\n"           \
+	"      - {name: v, type: signed, size: 8}\n"
+
+struct TestRow {
+	std::string color;
+	int64_t v;
+};
+
+/*
+ * 字典节点和紧凑格式节点离开本进程前转成定长原值，
+ * 对端没有本地字典也能attach
+ */
+class NodeExportTest : public testing::TestWithParam<bool> {
+    protected:
+	virtual void SetUp()
+	{
+		std::string fields(DICT_FIELDS);
+		if (GetParam())
+			fields += "    row_format: packed\n";
+		ASSERT_EQ(0, pond_.open(fields.c_str()));
+		ASSERT_TRUE(pond_.table()->string_dict() != NULL);
+
+		TestRow rows[] = { { "red", 1 },
+				   { "green", -1 },
+				   { "red", 1LL << 40 },
+				   { "", 0 },
+				   { std::string(280, 'x'), -(1LL << 40) } };
+		rows_.assign(rows, rows + sizeof(rows) / sizeof(rows[0]));
+	}
+
+	int fill(RawData &raw, uint32_t key)
+	{
+		if (raw.do_init((const char *)&key, 0) != 0)
+			return -1;
+		RowValue row(pond_.table());
+		for (size_t i = 0; i < rows_.size(); i++) {
+			row[0].u64 = key;
+			row[1].Set(rows_[i].color.data(),
+				   rows_[i].color.size());
+			row[2].s64 = rows_[i].v;
+			if (raw.insert_row(row, false, false) != 0)
+				return -1;
+		}
+		return 0;
+	}
+
+	void expect_rows(RawData &raw)
+	{
+		RowValue row(pond_.table());
+		unsigned char flag;
+		ASSERT_EQ(rows_.size(), raw.total_rows());
+		raw.rewind();
+		for (size_t i = 0; i < rows_.size(); i++) {
+			ASSERT_EQ(0, raw.decode_row(row, flag));
+			EXPECT_EQ(rows_[i].color,
+				  std::string(row[1].bin.ptr, row[1].bin.len));
+			EXPECT_EQ(rows_[i].v, row[2].s64);
+		}
+	}
+
+	TestPond pond_;
+	std::vector<TestRow> rows_;
+};
+
+TEST_P(NodeExportTest, ExportedNodeAttachesWithoutDict)
+{
+	RawData node(PtMalloc::instance());
+	ASSERT_EQ(0, fill(node, 7));
+	unsigned char type = *(const unsigned char *)node.get_addr();
+	EXPECT_TRUE(type & DATA_TYPE_DICT);
+	EXPECT_EQ(GetParam(), (type & DATA_TYPE_PACKED) != 0);
+
+	RawData plain(&g_stSysMalloc, 1);
+	plain.set_refrence(&node);
+	ASSERT_EQ(0, plain.copy_all_decoded());
+	type = *(const unsigned char *)plain.get_addr();
+	EXPECT_EQ(0, type & (DATA_TYPE_DICT | DATA_TYPE_PACKED));
+	EXPECT_EQ(7U, *(const uint32_t *)plain.key());
+
+	// 对端: 把收到的字节放进自己的内存，没有字典
+	StringDict *dict = pond_.table()->string_dict();
+	pond_.table()->set_string_dict(NULL);
+	ALLOC_HANDLE_T h = PtMalloc::instance()->Malloc(plain.data_size());
+	ASSERT_NE(INVALID_HANDLE, h);
+	memcpy(PtMalloc::instance()->handle_to_ptr(h), plain.get_addr(),
+	       plain.data_size());
+
+	RawData peer(PtMalloc::instance());
+	ASSERT_EQ(0, peer.do_attach(h)) << peer.get_err_msg();
+	expect_rows(peer);
+
+	// 原节点在没有字典的对端无法使用
+	RawData raw_copy(PtMalloc::instance());
+	EXPECT_EQ(-4, raw_copy.do_attach(node.get_handle()));
+
+	PtMalloc::instance()->Free(h);
+	pond_.table()->set_string_dict(dict);
+}
+
+TEST_P(NodeExportTest, DecodedCopyKeepsRows)
+{
+	RawData node(PtMalloc::instance());
+	ASSERT_EQ(0, fill(node, 9));
+
+	RawData plain(&g_stSysMalloc, 1);
+	plain.set_refrence(&node);
+	ASSERT_EQ(0, plain.copy_all_decoded());
+	expect_rows(plain);
+	expect_rows(node);
+}
+
+INSTANTIATE_TEST_CASE_P(RowFormat, NodeExportTest, testing::Bool());
+
+#define PACKED_FIELDS                                                          \
+	"      - {name: uid, type: unsigned, size: 4, unique: 1}\n"           \
+	"      - {name: s8, type: signed, size: 8}\n"                         \
+	"      - {name: s4, type: signed, size: 4}\n"                         \
+	"      - {name: u8, type: unsigned, size: 8}\n"                       \
+	"      - {name: u4, type: unsigned, size: 4}\n"                       \
+	"      - {name: mtime, type: unsigned, size: 4, default: lastmod}\n"  \
+	"      - {name: f, type: float, size: 8}\n"                           \
+	"      - {name: s, type: string, size: 300}\n"                        \
+	"    row_format: packed\n"
+
+struct PackedValue {
+	int64_t s8;
+	int64_t s4;
+	uint64_t u8;
+	uint64_t u4;
+	int64_t mtime_delta; // 相对于节点时间基准
+	double f;
+	int len;
+};
+
+/* 紧凑格式的行编码后原样解码，整数字段按定长格式的截断规则取值 */
+class PackedRowTest : public testing::Test {
+    protected:
+	virtual void SetUp()
+	{
+		ASSERT_EQ(0, pond_.open(PACKED_FIELDS));
+		ASSERT_EQ(ROW_FORMAT_PACKED, pond_.table()->row_format());
+		ASSERT_TRUE(pond_.table()->is_timestamp(5));
+	}
+
+	void set_row(RowValue &row, const PackedValue &p, uint32_t base)
+	{
+		str_.assign(p.len, 'a' + p.len % 26);
+		row[0].u64 = 1;
+		row[1].s64 = p.s8;
+		row[2].s64 = p.s4;
+		row[3].u64 = p.u8;
+		row[4].u64 = p.u4;
+		row[5].u64 = (uint32_t)(base + p.mtime_delta);
+		row[6].flt = p.f;
+		row[7].Set(str_.data(), str_.size());
+	}
+
+	void expect_row(RowValue &row, const PackedValue &p, uint32_t base)
+	{
+		EXPECT_EQ(p.s8, row[1].s64);
+		EXPECT_EQ((int32_t)p.s4, row[2].s64);
+		EXPECT_EQ(p.u8, row[3].u64);
+		EXPECT_EQ((uint32_t)p.u4, row[4].u64);
+		EXPECT_EQ((uint32_t)(base + p.mtime_delta), row[5].u64);
+		EXPECT_EQ(p.f, row[6].flt);
+		ASSERT_EQ(p.len, row[7].bin.len);
+		EXPECT_EQ(std::string(p.len, 'a' + p.len % 26),
+			  std::string(row[7].bin.ptr, row[7].bin.len));
+	}
+
+	/* 节点的时间基准在行摘要之后，这个表没有摘要 */
+	uint32_t time_base(RawData &raw)
+	{
+		return *(const uint32_t *)(raw.key() + sizeof(uint32_t));
+	}
+
+	void round_trip(const PackedValue *values, size_t n)
+	{
+		RawData node(PtMalloc::instance());
+		uint32_t key = 1;
+		ASSERT_EQ(0, node.do_init((const char *)&key, 0));
+		ASSERT_TRUE(*(const unsigned char *)node.get_addr() &
+			    DATA_TYPE_PACKED);
+		uint32_t base = time_base(node);
+
+		RowValue row(pond_.table());
+		for (size_t i = 0; i < n; i++) {
+			set_row(row, values[i], base);
+			ASSERT_EQ(0, node.insert_row(row, false, false));
+		}
+
+		unsigned char flag;
+		node.rewind();
+		for (size_t i = 0; i < n; i++) {
+			SCOPED_TRACE(i);
+			ASSERT_EQ(0, node.decode_row(row, flag));
+			expect_row(row, values[i], base);
+		}
+
+		// 转成定长格式后取值不变
+		RawData plain(&g_stSysMalloc, 1);
+		plain.set_refrence(&node);
+		ASSERT_EQ(0, plain.copy_all_decoded());
+		plain.rewind();
+		for (size_t i = 0; i < n; i++) {
+			SCOPED_TRACE(i);
+			ASSERT_EQ(0, plain.decode_row(row, flag));
+			expect_row(row, values[i], base);
+		}
+		node.destory();
+	}
+
+	TestPond pond_;
+	std::string str_;
+};
+
+TEST_F(PackedRowTest, VarintBoundaries)
+{
+	std::vector<PackedValue> v;
+	const uint64_t edges[] = { 0,	    1,		127,	   128,
+				   16383,   16384,	(1 << 21) - 1, 1 << 21,
+				   1 << 28, 1ULL << 35, 1ULL << 56, 1ULL << 63,
+				   UINT64_MAX };
+	for (size_t i = 0; i < sizeof(edges) / sizeof(edges[0]); i++) {
+		uint64_t e = edges[i];
+		PackedValue p = { (int64_t)e, (int64_t)e,  e, e,
+				  0,	      (double)e, (int)(e % 300) };
+		v.push_back(p);
+		// zigzag的边界: -64/63, -65/64
+		PackedValue q = { -(int64_t)(e >> 1) - 1, -(int64_t)(e >> 1),
+				  e - 1, e + 1, 0, -1.5, 127 + (int)(i & 1) };
+		v.push_back(q);
+	}
+	PackedValue ext[] = {
+		{ INT64_MIN, INT32_MIN, 0, UINT32_MAX, 0, 0, 0 },
+		{ INT64_MAX, INT32_MAX, UINT64_MAX, 0, 0, 0, 16383 % 300 },
+		{ -64, -64, 0, 0, 0, 0, 0 },
+		{ 63, 63, 0, 0, 0, 0, 0 },
+		{ -65, -65, 0, 0, 0, 0, 0 },
+		{ 64, 64, 0, 0, 0, 0, 0 },
+	};
+	v.insert(v.end(), ext, ext + sizeof(ext) / sizeof(ext[0]));
+	round_trip(&v[0], v.size());
+}
+
+TEST_F(PackedRowTest, TimestampDeltas)
+{
+	// 早于、等于、晚于节点的时间基准，以及离基准很远的值
+	PackedValue v[] = {
+		{ 0, 0, 0, 0, 0, 0, 1 },
+		{ 0, 0, 0, 0, -1, 0, 1 },
+		{ 0, 0, 0, 0, -100000, 0, 1 },
+		{ 0, 0, 0, 0, 86400 * 365, 0, 1 },
+		{ 0, 0, 0, 0, -(int64_t)time(NULL), 0, 1 }, // 0
+		{ 0, 0, 0, 0, (int64_t)UINT32_MAX - time(NULL), 0, 1 },
+	};
+	round_trip(v, sizeof(v) / sizeof(v[0]));
+}
+
+/* 4字节字段截断后再编码，和定长格式存储的结果一致 */
+TEST_F(PackedRowTest, NarrowFieldsTruncate)
+{
+	PackedValue v[] = {
+		{ 0, 1LL << 32, 0, (1ULL << 32) + 5, 0, 0, 0 },
+		{ 0, -(1LL << 33) - 7, 0, UINT64_MAX, 0, 0, 0 },
+	};
+	round_trip(v, sizeof(v) / sizeof(v[0]));
+}
+
+TEST_F(PackedRowTest, SmallValuesTakeLessSpace)
+{
+	RawData node(PtMalloc::instance());
+	uint32_t key = 1;
+	ASSERT_EQ(0, node.do_init((const char *)&key, 0));
+	uint32_t base = time_base(node);
+	PackedValue p = { 3, -2, 100, 7, 5, 0.5, 3 };
+	RowValue row(pond_.table());
+	set_row(row, p, base);
+	ASSERT_EQ(0, node.insert_row(row, false, false));
+	uint32_t packed = node.data_size();
+
+	RawData plain(&g_stSysMalloc, 1);
+	plain.set_refrence(&node);
+	ASSERT_EQ(0, plain.copy_all_decoded());
+	// 头部少了时间基准，行数据少了整数和长度字段的定长部分
+	EXPECT_LT(packed - sizeof(uint32_t) + 20, plain.data_size());
+	node.destory();
+}
+
+/*
+ * calc_row_size与实际编码的大小一致，reserve之后逐行插入不再realloc。
+ * 参数: 0定长格式，1紧凑格式，2紧凑格式带字典字段
+ */
+class RowSizeTest : public testing::TestWithParam<int> {
+    protected:
+	virtual void SetUp()
+	{
+		std::string fields =
+			"      - {name: uid, type: unsigned, size: 4, unique: 1}\n"
+			"      - {name: s8, type: signed, size: 8}\n"
+			"      - {name: u4, type: unsigned, size: 4}\n"
+			"      - {name: mtime, type: unsigned, size: 4, default: lastmod}\n";
+		fields += GetParam() == 2 ?
+				  "      - {name: s, type: string, size: 300, dict: 1}\n" :
+				  "      - {name: s, type: string, size: 300}\n";
+		if (GetParam() > 0)
+			fields += "    row_format: packed\n";
+		ASSERT_EQ(0, pond_.open(fields.c_str()));
+		now_ = time(NULL);
+	}
+
+	void set_row(RowValue &row, int i)
+	{
+		str_.assign(i * 7 % 290, 'a' + i % 3);
+		row[0].u64 = 5;
+		row[1].s64 = (i & 1 ? -1 : 1) * ((int64_t)1 << (i % 63));
+		row[2].u64 = i * 1000;
+		row[3].u64 = now_ - i * 3600;
+		row[4].Set(str_.data(), str_.size());
+	}
+
+	TestPond pond_;
+	std::string str_;
+	uint32_t now_;
+};
+
+TEST_P(RowSizeTest, CalcRowSizeMatchesEncoding)
+{
+	RawData node(PtMalloc::instance());
+	uint32_t key = 5;
+	ASSERT_EQ(0, node.do_init((const char *)&key, 0));
+	const int keyIdx = pond_.table()->key_fields() - 1;
+
+	RowValue row(pond_.table());
+	for (int i = 0; i < 100; i++) {
+		set_row(row, i);
+		uint32_t before = node.data_size();
+		ALLOC_SIZE_T size = node.calc_row_size(row, keyIdx);
+		ASSERT_EQ(0, node.insert_row(row, false, false));
+		EXPECT_EQ(size, node.data_size() - before) << "row " << i;
+	}
+	node.destory();
+}
+
+TEST_P(RowSizeTest, ReserveOnceThenNoRealloc)
+{
+	RawData node(PtMalloc::instance());
+	uint32_t key = 5;
+	ASSERT_EQ(0, node.do_init((const char *)&key, 0));
+	const int keyIdx = pond_.table()->key_fields() - 1;
+
+	RowValue row(pond_.table());
+	ALLOC_SIZE_T total = 0;
+	for (int i = 0; i < 200; i++) {
+		set_row(row, i);
+		total += node.calc_row_size(row, keyIdx);
+	}
+	ASSERT_EQ(0, node.reserve(total));
+	MEM_HANDLE_T handle = node.get_handle();
+	uint32_t start = node.data_size();
+
+	for (int i = 0; i < 200; i++) {
+		set_row(row, i);
+		ASSERT_EQ(0, node.insert_row(row, false, false));
+		ASSERT_EQ(handle, node.get_handle()) << "row " << i;
+	}
+	EXPECT_EQ(start + total, node.data_size());
+	node.destory();
+}
+
+/* 多行转码复制先算总大小，结果与逐行插入相同 */
+TEST_P(RowSizeTest, CopyRowsTranscodesAllRows)
+{
+	RawData node(PtMalloc::instance());
+	uint32_t key = 5;
+	ASSERT_EQ(0, node.do_init((const char *)&key, 0));
+	RowValue row(pond_.table());
+	for (int i = 0; i < 50; i++) {
+		set_row(row, i);
+		ASSERT_EQ(0, node.insert_row(row, false, false));
+	}
+
+	RawData plain(&g_stSysMalloc, 1);
+	plain.set_refrence(&node);
+	ASSERT_EQ(0, plain.copy_all_decoded());
+	ASSERT_EQ(50U, plain.total_rows());
+
+	// 定长格式的行再追加回原格式的节点
+	RawData back(PtMalloc::instance());
+	ASSERT_EQ(0, back.do_init((const char *)&key, 0));
+	uint32_t start = back.data_size();
+	ASSERT_EQ(0, back.append_n_records(
+			     plain.total_rows(), plain.get_addr() + plain.data_start(),
+			     plain.data_size() - plain.data_start()));
+	EXPECT_EQ(50U, back.total_rows());
+	EXPECT_EQ(node.data_size() - node.data_start(),
+		  back.data_size() - start);
+
+	RowValue got(pond_.table());
+	unsigned char flag;
+	back.rewind();
+	for (int i = 0; i < 50; i++) {
+		set_row(row, i);
+		ASSERT_EQ(0, back.decode_row(got, flag));
+		EXPECT_EQ(row[1].s64, got[1].s64);
+		EXPECT_EQ(row[3].u64, got[3].u64);
+		EXPECT_EQ(str_, std::string(got[4].bin.ptr, got[4].bin.len));
+	}
+	node.destory();
+	back.destory();
+}
+
+INSTANTIATE_TEST_CASE_P(RowFormat, RowSizeTest, testing::Values(0, 1, 2));
+
+#define SUMMARY_FIELDS                                                         \
+	"      - {name: uid, type: unsigned, size: 4, unique: 1}\n"           \
+	"      - {name: ts, type: signed, size: 8, summary: 1}\n"             \
+	"      - {name: u4, type: unsigned, size: 4, summary: 1}\n"           \
+	"      - {name: v, type: signed, size: 4}\n"
+
+/* 行摘要随插入放宽，may_match只在一定没有行满足条件时返回0 */
+class RawSummaryTest : public testing::Test {
+    protected:
+	virtual void SetUp()
+	{
+		ASSERT_EQ(0, pond_.open(SUMMARY_FIELDS));
+		ASSERT_TRUE(pond_.table()->is_summary(1));
+		ASSERT_TRUE(pond_.table()->is_summary(2));
+		ASSERT_FALSE(pond_.table()->is_summary(3));
+	}
+
+	int insert(RawData &raw, int64_t ts, uint32_t u4)
+	{
+		RowValue row(pond_.table());
+		row[0].u64 = 1;
+		row[1].s64 = ts;
+		row[2].u64 = u4;
+		row[3].s64 = 0;
+		return raw.insert_row(row, false, false);
+	}
+
+	int match(RawData &raw, int id, int op, int64_t v)
+	{
+		DTCFieldValue cond(1);
+		cond.add_value(id, op, DField::Signed, DTCValue::Make(v));
+		return raw.may_match(&cond);
+	}
+
+	TestPond pond_;
+};
+
+TEST_F(RawSummaryTest, RangeOfInsertedRows)
+{
+	RawData node(PtMalloc::instance());
+	uint32_t key = 1;
+	ASSERT_EQ(0, node.do_init((const char *)&key, 0));
+	ASSERT_TRUE(*(const unsigned char *)node.get_addr() &
+		    DATA_TYPE_SUMMARY);
+	ASSERT_EQ(0, insert(node, -20, 7));
+	ASSERT_EQ(0, insert(node, 100, UINT32_MAX));
+	ASSERT_EQ(0, insert(node, 35, 9));
+
+	EXPECT_EQ(1, match(node, 1, DField::EQ, 35));
+	EXPECT_EQ(1, match(node, 1, DField::EQ, 0)); // 范围内但没有这一行
+	EXPECT_EQ(0, match(node, 1, DField::EQ, 101));
+	EXPECT_EQ(0, match(node, 1, DField::EQ, -21));
+	EXPECT_EQ(0, match(node, 1, DField::LT, -20));
+	EXPECT_EQ(1, match(node, 1, DField::LE, -20));
+	EXPECT_EQ(0, match(node, 1, DField::GT, 100));
+	EXPECT_EQ(1, match(node, 1, DField::GE, 100));
+	EXPECT_EQ(1, match(node, 1, DField::NE, 35));
+
+	// 4字节无符号字段不按有符号截断
+	EXPECT_EQ(1, match(node, 2, DField::GE, UINT32_MAX));
+	EXPECT_EQ(0, match(node, 2, DField::GT, UINT32_MAX));
+	EXPECT_EQ(0, match(node, 2, DField::LT, 7));
+
+	// 没有摘要的字段总是可能满足
+	EXPECT_EQ(1, match(node, 3, DField::GT, 1000));
+	node.destory();
+}
+
+TEST_F(RawSummaryTest, NotEqualOnSingleValue)
+{
+	RawData node(PtMalloc::instance());
+	uint32_t key = 1;
+	ASSERT_EQ(0, node.do_init((const char *)&key, 0));
+	ASSERT_EQ(0, insert(node, 5, 1));
+	ASSERT_EQ(0, insert(node, 5, 2));
+	EXPECT_EQ(0, match(node, 1, DField::NE, 5));
+	EXPECT_EQ(1, match(node, 2, DField::NE, 1));
+	node.destory();
+}
+
+/* 删除所有行后摘要清空，不保留旧行的范围 */
+TEST_F(RawSummaryTest, DeleteAllResets)
+{
+	RawData node(PtMalloc::instance());
+	uint32_t key = 1;
+	ASSERT_EQ(0, node.do_init((const char *)&key, 0));
+	ASSERT_EQ(0, insert(node, 1000, 1));
+	ASSERT_EQ(1, match(node, 1, DField::GT, 500));
+	ASSERT_EQ(0, node.delete_all_rows());
+	ASSERT_EQ(0, insert(node, 5, 1));
+	EXPECT_EQ(0, match(node, 1, DField::GT, 500));
+	EXPECT_EQ(1, match(node, 1, DField::LE, 5));
+	node.destory();
+}
+
+/* 按字节追加的行重新扫描摘要 */
+TEST_F(RawSummaryTest, AppendedRowsAreScanned)
+{
+	RawData node(PtMalloc::instance());
+	uint32_t key = 1;
+	ASSERT_EQ(0, node.do_init((const char *)&key, 0));
+	for (int i = 0; i < 10; i++)
+		ASSERT_EQ(0, insert(node, i * 10, i));
+
+	RawData back(PtMalloc::instance());
+	ASSERT_EQ(0, back.do_init((const char *)&key, 0));
+	ASSERT_EQ(0, back.append_n_records(
+			     node.total_rows(), node.get_addr() + node.data_start(),
+			     node.data_size() - node.data_start()));
+	EXPECT_EQ(1, match(back, 1, DField::GE, 90));
+	EXPECT_EQ(0, match(back, 1, DField::GT, 90));
+	EXPECT_EQ(0, match(back, 1, DField::LT, 0));
+	EXPECT_EQ(0, match(back, 2, DField::EQ, 10));
+	node.destory();
+	back.destory();
+}
+
+/* 只有非key的整数字段可以带摘要，lastacc在读时原地改写，不能带摘要 */
+TEST(RawSummaryConfigTest, RejectedFields)
+{
+	const char *bad[] = {
+		"      - {name: uid, type: unsigned, size: 4, summary: 1}\n",
+		"      - {name: uid, type: unsigned, size: 4}\n"
+		"      - {name: f, type: float, size: 8, summary: 1}\n",
+		"      - {name: uid, type: unsigned, size: 4}\n"
+		"      - {name: s, type: string, size: 8, summary: 1}\n",
+		"      - {name: uid, type: unsigned, size: 4}\n"
+		"      - {name: atime, type: unsigned, size: 4, default: lastacc, summary: 1}\n",
+		"      - {name: uid, type: unsigned, size: 4}\n"
+		"      - {name: a, type: signed, size: 4, summary: 1}\n"
+		"      - {name: b, type: signed, size: 4, summary: 1}\n"
+		"      - {name: c, type: signed, size: 4, summary: 1}\n"
+		"      - {name: d, type: signed, size: 4, summary: 1}\n"
+		"      - {name: e, type: signed, size: 4, summary: 1}\n",
+	};
+	for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+		TestPond pond;
+		EXPECT_NE(0, pond.open(bad[i])) << bad[i];
+	}
+
+	TestPond pond;
+	ASSERT_EQ(0, pond.open("      - {name: uid, type: unsigned, size: 4}\n"
+			       "      - {name: atime, type: unsigned, size: 4, default: lastacc}\n"
+			       "      - {name: mtime, type: unsigned, size: 4, default: lastmod, summary: 1}\n"));
+	EXPECT_FALSE(pond.table()->is_summary(1));
+	EXPECT_TRUE(pond.table()->is_summary(2));
+}
+
+#endif
@@ -0,0 +1,180 @@
+#ifndef RAW_SNAPSHOT_UNITTEST_H_
+#define RAW_SNAPSHOT_UNITTEST_H_
+
+#include <vector>
+#include "unittest_comm.h"
+#include "raw_data.h"
+#include "raw_data_process.h"
+#include "raw_snapshot.h"
+#include "task/task_request.h"
+
+/*
+ * 快照和直接在节点上get的结果一致，快照之后节点的修改不影响快照。
+ * 参数: 0定长格式，1紧凑格式
+ */
+class RawSnapshotTest : public testing::TestWithParam<int> {
+    protected:
+	virtual void SetUp()
+	{
+		std::string fields =
+			"      - {name: uid, type: unsigned, size: 4, unique: 1}\n"
+			"      - {name: v, type: signed, size: 4}\n"
+			"      - {name: s, type: string, size: 64}\n";
+		if (GetParam())
+			fields += "    row_format: packed\n";
+		ASSERT_EQ(0, pond_.open(fields.c_str()));
+		key_.u64 = 7;
+	}
+
+	void fill_node(RawData &node, int rows, int base)
+	{
+		uint32_t key = 7;
+		ASSERT_EQ(0, node.do_init((const char *)&key, 0));
+		RowValue row(pond_.table());
+		for (int i = 0; i < rows; i++) {
+			char s[16];
+			int n = snprintf(s, sizeof(s), "row%d", base + i);
+			row[0].u64 = key;
+			row[1].s64 = base + i;
+			row[2].Set(s, n);
+			ASSERT_EQ(0, node.insert_row(row, false, false));
+		}
+	}
+
+	/* select v, s where v >= ge，limit为0时不限制 */
+	void prepare(DTCJobOperation &job, int ge, int limit)
+	{
+		job.set_data_table(pond_.table());
+		job.set_request_key(&key_);
+		uint8_t ids[] = { 1, 2 };
+		job.set_request_fields(new DTCFieldSet(ids, 2));
+		DTCFieldValue *cond = new DTCFieldValue(1);
+		DTCValue v;
+		v.s64 = ge;
+		cond->add_value(1, DField::GE, DField::Signed, v);
+		job.set_request_condition(cond);
+		job.clear_all_rows();
+		ASSERT_EQ(0, job.prepare_result(0, limit));
+	}
+
+	std::vector<int> result(DTCJobOperation &job)
+	{
+		std::vector<int> vals;
+		EXPECT_EQ(0, job.process_internal_result());
+		if (job.result == NULL)
+			return vals;
+		const RowValue *r;
+		while ((r = job.result->fetch_row()) != NULL) {
+			char s[16];
+			int n = snprintf(s, sizeof(s), "row%d",
+					 (int)(*r)[1].s64);
+			EXPECT_EQ(std::string(s, n),
+				  std::string((*r)[2].bin.ptr, (*r)[2].bin.len));
+			vals.push_back((*r)[1].s64);
+		}
+		return vals;
+	}
+
+	TestPond pond_;
+	DTCValue key_;
+};
+
+TEST_P(RawSnapshotTest, SameRowsAsDirectGet)
+{
+	RawData node(PtMalloc::instance());
+	fill_node(node, 300, 0);
+
+	DTCJobOperation direct;
+	prepare(direct, 120, 0);
+	node.rewind();
+	ASSERT_EQ(0, RawDataProcess::append_rows(direct, node, -1));
+
+	RawSnapshot *snapshot = RawSnapshot::create(node);
+	ASSERT_TRUE(snapshot != NULL);
+	DTCJobOperation job;
+	prepare(job, 120, 0);
+	job.set_row_source(snapshot);
+	EXPECT_TRUE(job.has_row_source());
+	ASSERT_EQ(0, job.fill_row_source());
+	EXPECT_FALSE(job.has_row_source());
+
+	std::vector<int> expect = result(direct);
+	ASSERT_EQ(180U, expect.size());
+	EXPECT_EQ(120, expect.front());
+	EXPECT_EQ(299, expect.back());
+	EXPECT_TRUE(expect == result(job));
+	node.destory();
+}
+
+/* 快照后节点被改写、重新分配并释放，快照仍返回拷贝时的行 */
+TEST_P(RawSnapshotTest, NodeChangesAfterSnapshotAreInvisible)
+{
+	RawData node(PtMalloc::instance());
+	fill_node(node, 50, 0);
+	RawSnapshot *snapshot = RawSnapshot::create(node);
+	ASSERT_TRUE(snapshot != NULL);
+
+	ASSERT_EQ(0, node.delete_all_rows());
+	RowValue row(pond_.table());
+	for (int i = 0; i < 500; i++) {
+		row[0].u64 = 7;
+		row[1].s64 = 1000 + i;
+		row[2].Set("changed", 7);
+		ASSERT_EQ(0, node.insert_row(row, false, false));
+	}
+	node.destory();
+	// 占用刚释放的内存
+	RawData other(PtMalloc::instance());
+	fill_node(other, 500, 5000);
+
+	DTCJobOperation job;
+	prepare(job, 0, 0);
+	job.set_row_source(snapshot);
+	ASSERT_EQ(0, job.fill_row_source());
+	std::vector<int> vals = result(job);
+	ASSERT_EQ(50U, vals.size());
+	for (int i = 0; i < 50; i++)
+		EXPECT_EQ(i, vals[i]);
+	other.destory();
+}
+
+TEST_P(RawSnapshotTest, LimitAppliesToSnapshot)
+{
+	RawData node(PtMalloc::instance());
+	fill_node(node, 100, 0);
+
+	DTCJobOperation job;
+	prepare(job, 30, 10);
+	job.set_row_source(RawSnapshot::create(node));
+	ASSERT_EQ(0, job.fill_row_source());
+	std::vector<int> vals = result(job);
+	ASSERT_EQ(10U, vals.size());
+	EXPECT_EQ(30, vals.front());
+	EXPECT_EQ(39, vals.back());
+	node.destory();
+}
+
+/* 请求已经出错时不解码，快照随job释放 */
+TEST_P(RawSnapshotTest, ErrorJobDropsSnapshot)
+{
+	RawData node(PtMalloc::instance());
+	fill_node(node, 20, 0);
+
+	DTCJobOperation job;
+	prepare(job, 0, 0);
+	job.set_row_source(RawSnapshot::create(node));
+	job.set_error(-EC_SERVER_ERROR, "test", NULL);
+	EXPECT_EQ(0, job.fill_row_source());
+	EXPECT_FALSE(job.has_row_source());
+	EXPECT_EQ(0, (int)job.get_result_packet()->numRows);
+
+	// 未使用的快照在job析构时释放
+	DTCJobOperation dropped;
+	prepare(dropped, 0, 0);
+	dropped.set_row_source(RawSnapshot::create(node));
+	node.destory();
+}
+
+INSTANTIATE_TEST_CASE_P(RowFormat, RawSnapshotTest, testing::Values(0, 1));
+
+#endif
@@ -0,0 +1,135 @@
+#ifndef REPLICATION_UNITTEST_H_
+#define REPLICATION_UNITTEST_H_
+
+#include <string.h>
+#include "unittest_comm.h"
+#include "hotbk/replication_server.h"
+#include "table/hotbackup_table_def.h"
+#include "task/task_request.h"
+
+/* 各层上限之间的关系，改动任何一个都要保持成立 */
+TEST(ReplicationLimitTest, LimitsFitEachOther)
+{
+	EXPECT_LT(HB_MAX_VALUE_SIZE + 256 + sizeof(repl_record_t),
+		  (size_t)BINLOG_MAX_RECORD_SIZE);
+	EXPECT_LE((size_t)REPL_MAX_BATCH + BINLOG_MAX_RAW_SIZE,
+		  (size_t)REPL_MAX_FRAME);
+}
+
+TEST(ReplicationLimitTest, AppendRecordLayout)
+{
+	std::string out;
+	ReplicationLink::append_record(out, DTCHotBackup::SYNC_UPDATE,
+				       DTCHotBackup::HAS_VALUE, "key", 3,
+				       "value", 5);
+	ReplicationLink::append_record(out, DTCHotBackup::SYNC_PURGE,
+				       DTCHotBackup::NON_VALUE, "k2", 2, NULL,
+				       0);
+	ASSERT_EQ(2 * sizeof(repl_record_t) + 3 + 5 + 2, out.size());
+
+	const repl_record_t *rec = (const repl_record_t *)out.data();
+	EXPECT_EQ((int)DTCHotBackup::SYNC_UPDATE, (int)rec->type);
+	EXPECT_EQ((int)DTCHotBackup::HAS_VALUE, (int)rec->flag);
+	EXPECT_EQ(3U, rec->key_len);
+	EXPECT_EQ(5U, rec->value_len);
+	EXPECT_EQ(0, memcmp(rec + 1, "keyvalue", 8));
+
+	rec = (const repl_record_t *)(out.data() + sizeof(*rec) + 8);
+	EXPECT_EQ((int)DTCHotBackup::SYNC_PURGE, (int)rec->type);
+	EXPECT_EQ(0U, rec->value_len);
+	EXPECT_EQ(0, memcmp(rec + 1, "k2", 2));
+}
+
+class ReplicationLogTest : public testing::Test {
+    protected:
+	ReplicationLogTest() : table_(build_hot_backup_table()), log_(table_)
+	{
+	}
+
+	virtual void SetUp()
+	{
+		ASSERT_TRUE(table_ != NULL);
+		ASSERT_EQ(0, log_.init(dir_.path(), "hb", 0, 1ULL << 30));
+		// 不压缩，最坏情况下的记录大小
+		ASSERT_EQ(0, log_.set_format(BINLOG_CRC_VERSION, 0));
+	}
+
+	int write(int type, const std::string &key, const std::string &value)
+	{
+		DTCJobOperation job;
+		HotBackTask &t = job.get_hot_back_task();
+		t.set_type(type);
+		t.set_flag(value.empty() ? DTCHotBackup::NON_VALUE :
+					   DTCHotBackup::HAS_VALUE);
+		t.set_packed_key((char *)key.data(), key.size());
+		t.set_value((char *)value.data(), value.size());
+		return log_.write_update_log(job);
+	}
+
+	TempDir dir_;
+	DTCTableDefinition *table_;
+	HBLog log_;
+};
+
+/* 按上限记录value的节点能写入一条binlog记录并原样读回 */
+TEST_F(ReplicationLogTest, ValueAtLimitRoundTrip)
+{
+	std::string key("\x04"
+			"ukey",
+			5);
+	std::string value(HB_MAX_VALUE_SIZE, 'v');
+	value[0] = 'a';
+	value[value.size() - 1] = 'z';
+	ASSERT_EQ(0, write(DTCHotBackup::SYNC_UPDATE, key, value));
+
+	BinlogReader *reader = log_.new_reader();
+	ASSERT_TRUE(reader != NULL);
+	std::string batch;
+	BatchEncodeVisitor visitor(batch);
+	EXPECT_EQ(1, log_.read_rows(reader, 16, visitor));
+	EXPECT_EQ(1, visitor.rows);
+
+	const repl_record_t *rec = (const repl_record_t *)batch.data();
+	ASSERT_EQ(sizeof(*rec) + key.size() + value.size(), batch.size());
+	EXPECT_EQ((int)DTCHotBackup::SYNC_UPDATE, (int)rec->type);
+	EXPECT_EQ((int)DTCHotBackup::HAS_VALUE, (int)rec->flag);
+	EXPECT_EQ(key, std::string((const char *)(rec + 1), rec->key_len));
+	EXPECT_TRUE(value == std::string((const char *)(rec + 1) + key.size(),
+					 rec->value_len));
+	delete reader;
+}
+
+/* 大value时一批不超过帧上限，剩余记录留给下一批 */
+TEST_F(ReplicationLogTest, BatchStopsAtByteLimit)
+{
+	const int total = REPL_MAX_BATCH / HB_MAX_VALUE_SIZE + 8;
+	std::string value(HB_MAX_VALUE_SIZE, 'v');
+	for (int i = 0; i < total; i++) {
+		char key[8];
+		key[0] = 4;
+		memcpy(key + 1, &i, 4);
+		ASSERT_EQ(0, write(DTCHotBackup::SYNC_UPDATE,
+				   std::string(key, 5), value));
+	}
+
+	BinlogReader *reader = log_.new_reader();
+	ASSERT_TRUE(reader != NULL);
+	int rows = 0, batches = 0;
+	for (;;) {
+		std::string batch;
+		BatchEncodeVisitor visitor(batch);
+		int n = log_.read_rows(reader, 256, visitor);
+		ASSERT_GE(n, 0);
+		if (n == 0)
+			break;
+		EXPECT_LE(batch.size(), (size_t)REPL_MAX_FRAME);
+		EXPECT_EQ(n, visitor.rows);
+		rows += visitor.rows;
+		++batches;
+	}
+	EXPECT_EQ(total, rows);
+	EXPECT_GE(batches, 2);
+	delete reader;
+}
+
+#endif
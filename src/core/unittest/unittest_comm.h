@@ -0,0 +1,133 @@
+#ifndef CORE_UNITTEST_COMMON_H_
+#define CORE_UNITTEST_COMMON_H_
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include "gtest/gtest.h"
+#include "buffer_pond.h"
+#include "table/table_def_manager.h"
+
+/* 每个用例独占一个临时目录，结束时删除 */
+class TempDir {
+    public:
+	TempDir()
+	{
+		snprintf(path_, sizeof(path_), "/tmp/dtc_unittest.XXXXXX");
+		if (mkdtemp(path_) == NULL)
+			path_[0] = '\0';
+	}
+	~TempDir()
+	{
+		if (path_[0] != '\0') {
+			std::string cmd = std::string("rm -rf ") + path_;
+			if (system(cmd.c_str()))
+				;
+		}
+	}
+	const char *path() const
+	{
+		return path_;
+	}
+
+    private:
+	char path_[64];
+};
+
+/*
+ * 在私有的共享内存上打开BufferPond，fields为yaml格式的字段列表，
+ * 第一个字段是key。析构时删除共享内存。
+ */
+class TestPond {
+    public:
+	TestPond() : pond_(NULL), table_(NULL), key_(0x7e570000 + getpid() % 0xffff)
+	{
+		remove_shm();
+	}
+	~TestPond()
+	{
+		close();
+		remove_shm();
+	}
+
+	int open(const char *fields, int key_index = 0,
+		 uint64_t size = 64 << 20)
+	{
+		std::string file = std::string(dir_.path()) + "/dtc.yaml";
+		FILE *fp = fopen(file.c_str(), "w");
+		if (fp == NULL)
+			return -1;
+		fprintf(fp, "primary:\n  db: ut\n  table: t\n  cache:\n"
+			    "    field:\n%s",
+			fields);
+		fclose(fp);
+
+		TableDefinitionManager *m = TableDefinitionManager::instance();
+		table_ = m->load_table(file.c_str());
+		if (table_ == NULL)
+			return -1;
+		m->set_cur_table_def(table_, 0);
+
+		memset(&info_, 0, sizeof(info_));
+		info_.init(table_->key_format(), size, 4);
+		info_.ipc_mem_key = key_;
+		info_.sync_update = 1;
+		info_.key_index = key_index;
+		return reopen(key_index);
+	}
+	/* 重新attach已有的共享内存，模拟重启 */
+	int reopen(int key_index)
+	{
+		close();
+		info_.key_index = key_index;
+		pond_ = new BufferPond();
+		if (pond_->cache_open(&info_) != 0) {
+			fprintf(stderr, "cache open: %s\n", pond_->error());
+			return -1;
+		}
+		return 0;
+	}
+	void close()
+	{
+		delete pond_;
+		pond_ = NULL;
+	}
+
+	BufferPond *pond()
+	{
+		return pond_;
+	}
+	DTCTableDefinition *table()
+	{
+		return table_;
+	}
+
+	/* 按4字节整数key分配节点 */
+	Node alloc(uint32_t key)
+	{
+		return pond_->cache_allocation((const char *)&key);
+	}
+	Node find(uint32_t key)
+	{
+		return pond_->cache_find((const char *)&key, 0);
+	}
+
+    private:
+	void remove_shm()
+	{
+		int id = shmget(key_, 0, 0);
+		if (id >= 0)
+			shmctl(id, IPC_RMID, NULL);
+	}
+
+    private:
+	TempDir dir_;
+	BufferPond *pond_;
+	DTCTableDefinition *table_;
+	BlockProperties info_;
+	int key_;
+};
+
+#endif
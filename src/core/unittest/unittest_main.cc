@@ -0,0 +1,15 @@
+#include "binlog_unittest.h"
+#include "expire_unittest.h"
+#include "replication_unittest.h"
+#include "btree_unittest.h"
+#include "key_index_unittest.h"
+#include "raw_data_unittest.h"
+#include "raw_snapshot_unittest.h"
+#include "field_predicate_unittest.h"
+#include "field_aggregate_unittest.h"
+
+int main(int argc, char **argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -37,6 +37,16 @@ bool DataConf::ParseAgentConf(std::string path){
         return false;
     }
     std::string listen_on = c_listen_on;
+    // shards of the module, the agent routes a key by them
+    char* c_hash = (char *) mxmlElementGetAttr(poolnode, "Hash");
+    hash_ = c_hash != NULL ? c_hash : "chash";
+    shard_vec_.clear();
+    for(mxml_node_t* shardnode = mxmlFindElement(poolnode, poolnode, "CACHESHARDING", NULL, NULL, MXML_DESCEND);
+        shardnode != NULL;
+        shardnode = mxmlFindElement(shardnode, poolnode, "CACHESHARDING", NULL, NULL, MXML_DESCEND)){
+        char* c_name = (char *) mxmlElementGetAttr(shardnode, "ShardingName");
+        shard_vec_.push_back(c_name != NULL ? c_name : "");
+    }
     mxmlDelete(tree);
     std::string::size_type pos = listen_on.find(":");
     if(pos == std::string::npos){
@@ -101,6 +111,23 @@ int DataConf::ParseConfig(const std::string& config_path, ConfigParam& config_pa
     }
     config_param.data_rule_ = node.as<string>();
 
+    node = config["data_lifecycle"]["bulk.enable"];
+    config_param.bulk_enable_ = node? node.as<bool>(): false;
+
+    node = config["data_lifecycle"]["bulk.page.count"];
+    int bulk_page_cnt = node? node.as<int>(): 1000;
+    node = config["data_lifecycle"]["bulk.parallel"];
+    int bulk_parallel = node? node.as<int>(): 4;
+    node = config["data_lifecycle"]["bulk.rate.limit"];
+    int bulk_rate_limit = node? node.as<int>(): 1000;
+    if(bulk_page_cnt <= 0 || bulk_parallel <= 0 || bulk_rate_limit < 0){
+        log4cplus_error("bulk.page.count and bulk.parallel should be greater than 0, bulk.rate.limit should not be negative.");
+        return DTC_CODE_PARSE_CONFIG_ERR;
+    }
+    config_param.bulk_page_cnt_ = bulk_page_cnt;
+    config_param.bulk_parallel_ = bulk_parallel;
+    config_param.bulk_rate_limit_ = bulk_rate_limit;
+
     node = config["data_lifecycle"]["rule.cron"];
     config_param.operate_time_rule_ = node? node.as<string>(): "00 01 * * * ?";
 
@@ -150,6 +177,9 @@ int DataConf::ParseConfig(const std::string& config_path, ConfigParam& config_pa
     }
     config_param.key_field_name_ = node.as<string>();
 
+    node = config["primary"]["cache"]["field"][0]["type"];
+    config_param.key_type_ = node? node.as<string>(): "";
+
     int field_size = config["primary"]["cache"]["field"].size();
     if(field_size <= 0){
         log4cplus_error("parse field name error.");
@@ -179,6 +209,8 @@ int DataConf::ParseConfig(const std::string& config_path, ConfigParam& config_pa
     }
     config_param.table_name_ = node.as<string>();
     config_param.port_ = port_;
+    config_param.agent_hash_ = hash_;
+    config_param.shard_vec_ = shard_vec_;
 
     node = config["primary"]["option.file.path"];
     config_param.option_file = node? node.as<string>(): "";
@@ -188,5 +220,8 @@ int DataConf::ParseConfig(const std::string& config_path, ConfigParam& config_pa
         config_param.single_query_cnt_, config_param.data_rule_.c_str(), config_param.operate_time_rule_.c_str(),
         config_param.operate_type_.c_str(), config_param.life_cycle_table_name_.c_str(), config_param.key_field_name_.c_str(),
         config_param.table_name_.c_str(), config_param.hot_db_name_.c_str(), config_param.cold_db_name_.c_str());
+    log4cplus_debug("bulk_enable: %d, bulk_page_cnt: %d, bulk_parallel: %d, bulk_rate_limit: %d, shard count: %d",
+        config_param.bulk_enable_, config_param.bulk_page_cnt_, config_param.bulk_parallel_,
+        config_param.bulk_rate_limit_, (int)config_param.shard_vec_.size());
     return 0;
 }
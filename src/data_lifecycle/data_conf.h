@@ -24,6 +24,13 @@ public:
     std::string full_db_pwd_;
     uint32_t port_;
     std::string option_file;
+    bool bulk_enable_;            // page by keyset, delete over parallel agent connections
+    uint32_t bulk_page_cnt_;      // rows queried per page in bulk mode
+    uint32_t bulk_parallel_;      // agent connections deleting at the same time
+    uint32_t bulk_rate_limit_;    // deletes per second of all connections, 0 for no limit
+    std::string key_type_;        // type of the key field: signed, unsigned, string or binary
+    std::string agent_hash_;      // Hash of the agent module
+    std::vector<std::string> shard_vec_;  // ShardingName of the agent module, in order
 };
 
 class DataConf{
@@ -36,6 +43,8 @@ public:
     uint32_t Port();
 private:
     uint32_t port_;
+    std::string hash_;
+    std::vector<std::string> shard_vec_;
 };
 
 
@@ -2,17 +2,27 @@
 #include "global.h"
 #include "data_conf.h"
 #include "croncpp.h"
+#include "algorithm/chash.h"
 #include <unistd.h>
 #include <set>
 #include <ifaddrs.h>
 #include <netinet/in.h>
 #include <string.h>
 #include <arpa/inet.h>
+#include <thread>
+#include <functional>
+#include <algorithm>
 
 #define default_option_file "../conf/my.conf"
 
 DataManager::DataManager(){
     next_process_time_ = 0;
+    agent_port_ = 3306;
+    bulk_enable_ = false;
+    bulk_page_cnt_ = 1000;
+    bulk_parallel_ = 1;
+    bulk_rate_limit_ = 0;
+    shard_cnt_ = 1;
     DBHost* db_host = new DBHost();
     memset(db_host, 0, sizeof(db_host));
     strcpy(db_host->Host, "127.0.0.1");
@@ -37,20 +47,23 @@ life_cycle_table_name_(config_param.life_cycle_table_name_),
 hot_db_name_(config_param.hot_db_name_),
 cold_db_name_(config_param.cold_db_name_),
 field_vec_(config_param.field_vec_),
-field_flag_vec_(config_param.field_flag_vec_){
+field_flag_vec_(config_param.field_flag_vec_),
+agent_port_(config_param.port_),
+bulk_enable_(config_param.bulk_enable_),
+bulk_page_cnt_(config_param.bulk_page_cnt_),
+bulk_parallel_(config_param.bulk_parallel_),
+bulk_rate_limit_(config_param.bulk_rate_limit_),
+key_type_(config_param.key_type_),
+shard_cnt_(1){
     next_process_time_ = 0;
-    DBHost* db_host = new DBHost();
-    memset(db_host, 0, sizeof(db_host));
-    strcpy(db_host->Host, "127.0.0.1");
-    db_host->Port = config_param.port_;
-    strcpy(db_host->User, "root");
-    strcpy(db_host->Password, "root");
-    db_host->ReadTimeout = 1;
-    db_host->WriteTimeout = 1;
-    db_conn_ = new CDBConn(db_host);
-    if(NULL != db_host){
-        delete db_host;
+    if(config_param.shard_vec_.size() > 1){
+        if(config_param.agent_hash_ == "chash"){
+            BuildContinuum(config_param.shard_vec_);
+        } else {
+            log4cplus_warning("agent hash %s not supported, lanes ignore the shards.", config_param.agent_hash_.c_str());
+        }
     }
+    db_conn_ = CreateAgentConn();
 
     std::vector<std::string> full_db_vec = splitVecStr(config_param.full_db_addr_, ":");
     if(full_db_vec.size() == 2){
@@ -81,6 +94,23 @@ DataManager::~DataManager(){
     if(NULL != full_db_conn_){
         delete full_db_conn_;
     }
+    for(auto iter = lane_conn_vec_.begin(); iter != lane_conn_vec_.end(); iter++){
+        delete *iter;
+    }
+}
+
+CDBConn* DataManager::CreateAgentConn(){
+    DBHost* db_host = new DBHost();
+    memset(db_host, 0, sizeof(DBHost));
+    strcpy(db_host->Host, "127.0.0.1");
+    db_host->Port = agent_port_;
+    strcpy(db_host->User, "root");
+    strcpy(db_host->Password, "root");
+    db_host->ReadTimeout = 1;
+    db_host->WriteTimeout = 1;
+    CDBConn* db_conn = new CDBConn(db_host);
+    delete db_host;
+    return db_conn;
 }
 
 static std::string GetIp(){
@@ -149,6 +179,9 @@ int DataManager::DoProcess(){
 }
 
 int DataManager::DoTaskOnce(){
+    if(bulk_enable_){
+        return DoBulkTaskOnce();
+    }
     while(true){
         uint64_t last_delete_id = 0;
         std::string last_invisible_time;
@@ -160,7 +193,7 @@ int DataManager::DoTaskOnce(){
         if("" == last_invisible_time){
             last_invisible_time = "1970-01-01 08:00:00";
         }
-        std::string query_sql = ConstructQuerySql(last_delete_id, last_invisible_time);
+        std::string query_sql = ConstructQuerySql(last_delete_id, last_invisible_time, single_query_cnt_);
         std::vector<QueryInfo> query_info_vec;
         //full_db_conn_->do_query(cold_db_name_.c_str(), "set names utf8");
         ret = DoQuery(query_sql, query_info_vec);
@@ -192,6 +225,184 @@ int DataManager::DoTaskOnce(){
     return 0;
 }
 
+int DataManager::DoBulkTaskOnce(){
+    while(lane_conn_vec_.size() < bulk_parallel_){
+        lane_conn_vec_.push_back(CreateAgentConn());
+    }
+
+    BulkStat stat;
+    stat.start_time = std::chrono::steady_clock::now();
+    int ret = 0;
+    while(!stop){
+        uint64_t last_delete_id = 0;
+        std::string last_invisible_time;
+        ret = GetLastId(last_delete_id, last_invisible_time);
+        if(0 != ret){
+            log4cplus_error("GetLastId error, ret: %d", ret);
+            ret = DTC_CODE_MYSQL_QRY_ERR;
+            break;
+        }
+        if("" == last_invisible_time){
+            last_invisible_time = "1970-01-01 08:00:00";
+        }
+        std::string query_sql = ConstructQuerySql(last_delete_id, last_invisible_time, bulk_page_cnt_);
+        std::vector<QueryInfo> query_info_vec;
+        ret = DoQuery(query_sql, query_info_vec);
+        if(0 != ret){
+            log4cplus_error("DoQuery error, ret: %d", ret);
+            ret = DTC_CODE_MYSQL_QRY_ERR;
+            break;
+        }
+        if(query_info_vec.size() == 0){
+            break;
+        }
+
+        // rows of a key stay on one lane, lanes follow the dtc shards, see KeyLane().
+        std::vector<std::vector<std::string> > lane_sql_vec(bulk_parallel_);
+        for(auto iter = query_info_vec.begin(); iter != query_info_vec.end(); iter++){
+            lane_sql_vec[KeyLane(iter->key_info)].push_back(ConstructDeleteSql(iter->field_info));
+        }
+
+        std::vector<int> lane_ret_vec(bulk_parallel_, 0);
+        std::vector<std::thread> thread_vec;
+        for(uint32_t lane = 0; lane < bulk_parallel_; lane++){
+            if(lane_sql_vec[lane].empty()){
+                continue;
+            }
+            thread_vec.push_back(std::thread([this, lane, &lane_sql_vec, &lane_ret_vec](){
+                lane_ret_vec[lane] = DeleteLane(lane, lane_sql_vec[lane]);
+            }));
+        }
+        for(auto iter = thread_vec.begin(); iter != thread_vec.end(); iter++){
+            iter->join();
+        }
+
+        for(uint32_t lane = 0; lane < bulk_parallel_; lane++){
+            if(0 != lane_ret_vec[lane]){
+                ret = lane_ret_vec[lane];
+                break;
+            }
+        }
+        if(0 != ret){
+            // rows of the page are deleted again next time, last id stays.
+            stat.fail_page_cnt++;
+            log4cplus_error("bulk delete error, ret: %d, page: %lu", ret, stat.page_cnt);
+            ret = DTC_CODE_MYSQL_DEL_ERR;
+            break;
+        }
+
+        last_delete_id_ = query_info_vec.back().id;
+        last_invisible_time_ = query_info_vec.back().invisible_time;
+        ret = UpdateLastDeleteId();
+        if(0 != ret){
+            // rows of the page are gone, deleting them again next time is harmless.
+            log4cplus_error("UpdateLastDeleteId error, ret: %d, page: %lu", ret, stat.page_cnt);
+            ret = DTC_CODE_MYSQL_QRY_ERR;
+            break;
+        }
+
+        stat.page_cnt++;
+        stat.delete_cnt += query_info_vec.size();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - stat.start_time).count();
+        log4cplus_info("bulk page: %lu, rows: %d, deleted: %lu, %.1f rows/s, last id: %lu, last invisible time: %s",
+            stat.page_cnt, (int)query_info_vec.size(), stat.delete_cnt,
+            seconds > 0 ? stat.delete_cnt / seconds : 0.0, last_delete_id_, last_invisible_time_.c_str());
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - stat.start_time).count();
+    log4cplus_info("bulk task end, ret: %d, pages: %lu, deleted: %lu, failed pages: %lu, %.1f s, %.1f rows/s",
+        ret, stat.page_cnt, stat.delete_cnt, stat.fail_page_cnt, seconds,
+        seconds > 0 ? stat.delete_cnt / seconds : 0.0);
+    return ret;
+}
+
+// delete rows of a lane in order, paced by the lane's share of the rate limit.
+int DataManager::DeleteLane(uint32_t lane, const std::vector<std::string>& sql_vec){
+    std::chrono::microseconds interval(0);
+    if(bulk_rate_limit_ > 0){
+        interval = std::chrono::microseconds(1000000ULL * bulk_parallel_ / bulk_rate_limit_);
+    }
+    std::chrono::steady_clock::time_point next_time = std::chrono::steady_clock::now();
+    for(auto iter = sql_vec.begin(); iter != sql_vec.end(); iter++){
+        if(interval.count() > 0){
+            std::this_thread::sleep_until(next_time);
+            next_time += interval;
+        }
+        int ret = DoLaneDelete(lane, *iter);
+        if(0 != ret){
+            return ret;
+        }
+    }
+    return 0;
+}
+
+// the agent's ketama ring: 100 points per shard, named "ShardingName#i".
+// chash() is the agent's hash_chash(), signed chars included.
+void DataManager::BuildContinuum(const std::vector<std::string>& shard_vec){
+    continuum_.clear();
+    for(uint32_t shard = 0; shard < shard_vec.size(); shard++){
+        for(uint32_t i = 0; i < 100; i++){
+            char host[86] = "";
+            int host_len = snprintf(host, sizeof(host), "%s#%u", shard_vec[shard].c_str(), i);
+            if(host_len >= (int)sizeof(host)){
+                host_len = sizeof(host) - 1;
+            }
+            continuum_.push_back(std::make_pair(chash(host, host_len), shard));
+        }
+    }
+    std::sort(continuum_.begin(), continuum_.end());
+    shard_cnt_ = shard_vec.size();
+}
+
+// key bytes hashed by the agent, see my_key_idx(): the 8 bytes of an integer
+// decoded from the literal, or the length and the bytes of a string(lower case)/binary.
+bool DataManager::KeyHash(const std::string& key, uint32_t& hash){
+    if(key_type_ == "signed" || key_type_ == "unsigned"){
+        if(key.empty() || key.size() > 8){
+            return false;
+        }
+        int64_t s64 = (int8_t)key[0];
+        for(size_t i = 1; i < key.size(); i++){
+            s64 = (s64 << 8) | (uint8_t)key[i];
+        }
+        hash = chash((const char*)&s64, sizeof(s64));
+        return true;
+    }
+    if(key_type_ == "string" || key_type_ == "binary"){
+        std::string temp(1, (char)key.size());
+        temp += key;
+        if(key_type_ == "string"){
+            for(size_t i = 1; i < temp.size(); i++){
+                if(temp[i] >= 'A' && temp[i] <= 'Z'){
+                    temp[i] |= 0x20;
+                }
+            }
+        }
+        hash = chash(temp.data(), temp.size());
+        return true;
+    }
+    return false;
+}
+
+// lane of a key. keys of a shard go to the lanes of that shard only, so lanes
+// spread over the shards like the agent does; the rest by std::hash.
+uint32_t DataManager::KeyLane(const std::string& key){
+    uint32_t hash = 0;
+    if(shard_cnt_ <= 1 || continuum_.empty() || !KeyHash(key, hash)){
+        return std::hash<std::string>()(key) % bulk_parallel_;
+    }
+    auto iter = std::lower_bound(continuum_.begin(), continuum_.end(), std::make_pair(hash, (uint32_t)0));
+    if(iter == continuum_.end()){
+        iter = continuum_.begin();
+    }
+    uint32_t shard = iter->second;
+    if(shard_cnt_ >= bulk_parallel_){
+        return shard % bulk_parallel_;
+    }
+    uint32_t shard_lane_cnt = (bulk_parallel_ - shard + shard_cnt_ - 1) / shard_cnt_;
+    return shard + shard_cnt_ * (std::hash<std::string>()(key) % shard_lane_cnt);
+}
+
 void DataManager::SetTimeRule(const std::string& time_rule){
     operate_time_rule_ = time_rule;
 }
@@ -222,7 +433,7 @@ int DataManager::GetLastId(uint64_t& last_delete_id, std::string& last_invisible
     return 0;
 }
 
-std::string DataManager::ConstructQuerySql(uint64_t last_delete_id, std::string last_invisible_time){
+std::string DataManager::ConstructQuerySql(uint64_t last_delete_id, std::string last_invisible_time, uint32_t query_cnt){
     // example: select id from table_A where status=0 and (invisible_time>6 or (invisible_time=6 and id>6)) order by invisible_time limit 2
     std::stringstream ss_sql;
     ss_sql << "select id,invisible_time,";
@@ -237,7 +448,7 @@ std::string DataManager::ConstructQuerySql(uint64_t last_delete_id, std::string
         << ") and (invisible_time>'" << last_invisible_time
         << "' or (invisible_time='" << last_invisible_time
         << "' and id>" << last_delete_id
-        << ")) order by invisible_time,id limit " << single_query_cnt_;
+        << ")) order by invisible_time,id limit " << query_cnt;
     log4cplus_debug("query sql: %s", ss_sql.str().c_str());
     return ss_sql.str();
 }
@@ -339,6 +550,16 @@ int DataManager::DoDelete(const std::string& delete_sql){
     return 0;
 }
 
+int DataManager::DoLaneDelete(uint32_t lane, const std::string& delete_sql){
+    CDBConn* db_conn = lane_conn_vec_[lane];
+    int ret = db_conn->do_query(hot_db_name_.c_str(), delete_sql.c_str());
+    if(0 != ret){
+        log4cplus_debug("DoLaneDelete error, lane: %u, ret: %d, err msg: %s, delete_sql: %s", lane, ret, db_conn->get_err_msg(), delete_sql.c_str());
+        return ret;
+    }
+    return 0;
+}
+
 int DataManager::UpdateLastDeleteId(){
     std::string local_ip = GetIp();
     std::stringstream ss_sql;
@@ -18,6 +18,17 @@ public:
     std::vector<std::string> field_info;
 };
 
+// progress of a bulk run
+class BulkStat
+{
+public:
+    BulkStat(): page_cnt(0), delete_cnt(0), fail_page_cnt(0){}
+    uint64_t page_cnt;
+    uint64_t delete_cnt;
+    uint64_t fail_page_cnt;
+    std::chrono::steady_clock::time_point start_time;
+};
+
 class DataManager
 {
 public:
@@ -28,21 +39,29 @@ public:
     int ConnectFullDB();
     int DoProcess();
     int DoTaskOnce();
+    int DoBulkTaskOnce();
     void SetTimeRule(const std::string& time_rule);
     void SetDataRule(const std::string& data_rule){
     data_rule_ = data_rule;
     }
     virtual int GetLastId(uint64_t& last_delete_id, std::string& last_invisible_time);
-    std::string ConstructQuerySql(uint64_t last_delete_id, std::string last_invisible_time);
+    std::string ConstructQuerySql(uint64_t last_delete_id, std::string last_invisible_time, uint32_t query_cnt);
     virtual int DoQuery(const std::string& query_sql, std::vector<QueryInfo>& query_info_vec);
     std::set<std::string> ConstructDeleteSql(const std::string& key);
     std::string ConstructDeleteSql(const std::vector<std::string>& key_vec);
     virtual int DoDelete(const std::string& delete_sql);
+    virtual int DoLaneDelete(uint32_t lane, const std::string& delete_sql);
     virtual int UpdateLastDeleteId();
     std::set<std::string> splitStr(const std::string& src, const std::string& separate_character);
     std::vector<std::string> splitVecStr(const std::string& src, const std::string& separate_character);
     int CreateTable();
     int ShowVariables();
+    uint32_t KeyLane(const std::string& key);
+private:
+    CDBConn* CreateAgentConn();
+    int DeleteLane(uint32_t lane, const std::vector<std::string>& sql_vec);
+    void BuildContinuum(const std::vector<std::string>& shard_vec);
+    bool KeyHash(const std::string& key, uint32_t& hash);
 private:
     std::string data_rule_; // example: status=0
     std::string operate_time_rule_; // example: 0 */5 * * * ?
@@ -59,6 +78,15 @@ private:
     std::string last_invisible_time_;
     std::vector<std::string> field_vec_;
     std::vector<int> field_flag_vec_;
+    uint32_t agent_port_;
+    bool bulk_enable_;
+    uint32_t bulk_page_cnt_;
+    uint32_t bulk_parallel_;
+    uint32_t bulk_rate_limit_;
+    std::vector<CDBConn*> lane_conn_vec_;  // agent connections of bulk mode, one per lane
+    std::string key_type_;
+    uint32_t shard_cnt_;
+    std::vector<std::pair<uint32_t, uint32_t> > continuum_;  // (point, shard) of the agent's chash ring, sorted
 };
 
 
@@ -3,6 +3,7 @@
 
 #include "unittest_comm.h"
 #include "../data_manager.h"
+#include "algorithm/chash.h"
 
 UNITEST_NAMESPACE_BEGIN
 class MockDataManager : public DataManager{
@@ -16,6 +17,7 @@ public:
     MOCK_METHOD(int, GetLastId, (uint64_t& last_delete_id, std::string& last_invisible_time));
     MOCK_METHOD(int, DoQuery, (const std::string& query_sql, std::vector<QueryInfo>& query_info_vec));
     MOCK_METHOD(int, DoDelete, (const std::string& delete_sql));
+    MOCK_METHOD(int, DoLaneDelete, (uint32_t lane, const std::string& delete_sql));
     MOCK_METHOD(int, UpdateLastDeleteId, ());
 };
 
@@ -63,5 +65,154 @@ TEST_F(DataManagerTest , DoProcessTest){
     printf("4\n");
     EXPECT_EQ(0, data_manager_->DoTaskOnce());
 }
+
+static ConfigParam BulkConfigParam(){
+    ConfigParam config_param;
+    config_param.single_query_cnt_ = 10;
+    config_param.data_rule_ = "status = 0";
+    config_param.operate_time_rule_ = "0 */1 * * * ?";
+    config_param.table_name_ = "dtc_opensource";
+    config_param.key_field_name_ = "uid";
+    config_param.field_vec_.push_back("uid");
+    config_param.field_flag_vec_.push_back(0);
+    config_param.full_db_addr_ = "127.0.0.1:3306";
+    config_param.port_ = 12001;
+    config_param.bulk_enable_ = true;
+    config_param.bulk_page_cnt_ = 3;
+    config_param.bulk_parallel_ = 2;
+    config_param.bulk_rate_limit_ = 0;
+    config_param.key_type_ = "unsigned";
+    return config_param;
+}
+
+TEST(DataManagerBulkTest, DoBulkTaskTest){
+    MockDataManager data_manager_mock(BulkConfigParam());
+
+    std::vector<QueryInfo> query_info_vec;
+    for(int i = 1; i <= 3; i++){
+        QueryInfo info;
+        info.id = i;
+        info.invisible_time = "2022-03-01 15:00:43";
+        info.key_info = std::to_string(i);
+        info.field_info.push_back(info.key_info);
+        query_info_vec.push_back(info);
+    }
+    EXPECT_CALL(data_manager_mock , GetLastId(testing::_, testing::_)).Times(AnyNumber())
+        .WillRepeatedly(Return(0));
+    EXPECT_CALL(data_manager_mock , DoQuery(testing::_, testing::_)).Times(2)
+        .WillOnce(DoAll(SetArgReferee<1>(query_info_vec), Return(0)))
+        .WillOnce(Return(0));
+    EXPECT_CALL(data_manager_mock , DoLaneDelete(testing::_, testing::_)).Times(3)
+        .WillRepeatedly(Return(0));
+    EXPECT_CALL(data_manager_mock , UpdateLastDeleteId()).Times(1)
+        .WillOnce(Return(0));
+    EXPECT_EQ(0, data_manager_mock.DoTaskOnce());
+}
+
+TEST(DataManagerBulkTest, DoBulkTaskFailTest){
+    MockDataManager data_manager_mock(BulkConfigParam());
+
+    std::vector<QueryInfo> query_info_vec;
+    QueryInfo info;
+    info.id = 1;
+    info.invisible_time = "2022-03-01 15:00:43";
+    info.key_info = "1";
+    info.field_info.push_back(info.key_info);
+    query_info_vec.push_back(info);
+    EXPECT_CALL(data_manager_mock , GetLastId(testing::_, testing::_)).Times(AnyNumber())
+        .WillRepeatedly(Return(0));
+    EXPECT_CALL(data_manager_mock , DoQuery(testing::_, testing::_)).Times(1)
+        .WillOnce(DoAll(SetArgReferee<1>(query_info_vec), Return(0)));
+    EXPECT_CALL(data_manager_mock , DoLaneDelete(testing::_, testing::_)).Times(1)
+        .WillOnce(Return(1));
+    // last id is kept when a lane fails
+    EXPECT_CALL(data_manager_mock , UpdateLastDeleteId()).Times(0);
+    EXPECT_NE(0, data_manager_mock.DoTaskOnce());
+}
+
+TEST(DataManagerBulkTest, UpdateLastDeleteIdFailTest){
+    MockDataManager data_manager_mock(BulkConfigParam());
+
+    std::vector<QueryInfo> query_info_vec;
+    QueryInfo info;
+    info.id = 1;
+    info.invisible_time = "2022-03-01 15:00:43";
+    info.key_info = "1";
+    info.field_info.push_back(info.key_info);
+    query_info_vec.push_back(info);
+    EXPECT_CALL(data_manager_mock , GetLastId(testing::_, testing::_)).Times(AnyNumber())
+        .WillRepeatedly(Return(0));
+    EXPECT_CALL(data_manager_mock , DoQuery(testing::_, testing::_)).Times(1)
+        .WillOnce(DoAll(SetArgReferee<1>(query_info_vec), Return(0)));
+    EXPECT_CALL(data_manager_mock , DoLaneDelete(testing::_, testing::_)).Times(1)
+        .WillOnce(Return(0));
+    // the next page is not queried once last id fails to be saved
+    EXPECT_CALL(data_manager_mock , UpdateLastDeleteId()).Times(1)
+        .WillOnce(Return(1));
+    EXPECT_NE(0, data_manager_mock.DoTaskOnce());
+}
+
+// lanes follow the agent's shards: chash of the key on a ring of the ShardingName
+TEST(DataManagerBulkTest, KeyLaneTest){
+    ConfigParam config_param = BulkConfigParam();
+    config_param.agent_hash_ = "chash";
+    config_param.shard_vec_.push_back("shard0");
+    config_param.shard_vec_.push_back("shard1");
+    config_param.shard_vec_.push_back("shard2");
+    config_param.bulk_parallel_ = 3;
+    config_param.key_type_ = "signed";
+    MockDataManager int_manager(config_param);
+    EXPECT_EQ(0U, int_manager.KeyLane("1"));
+    EXPECT_EQ(0U, int_manager.KeyLane("42"));
+    EXPECT_EQ(2U, int_manager.KeyLane("12345678"));
+    EXPECT_EQ(2U, int_manager.KeyLane("-7"));
+    EXPECT_EQ(1U, int_manager.KeyLane("99999"));
+
+    config_param.key_type_ = "string";
+    MockDataManager str_manager(config_param);
+    EXPECT_EQ(2U, str_manager.KeyLane("abc"));
+    EXPECT_EQ(2U, str_manager.KeyLane("ABC"));
+    EXPECT_EQ(2U, str_manager.KeyLane("user_1001"));
+    EXPECT_EQ(0U, str_manager.KeyLane("\xc3\xa9t\xc3\xa9"));
+    EXPECT_EQ(1U, str_manager.KeyLane("x"));
+
+    // more lanes than shards: a shard owns the lanes congruent to it
+    config_param.bulk_parallel_ = 7;
+    MockDataManager wide_manager(config_param);
+    const char* keys[] = {"abc", "user_1001", "x", "y", "z"};
+    for(int i = 0; i < 5; i++){
+        uint32_t lane = wide_manager.KeyLane(keys[i]);
+        EXPECT_LT(lane, 7U);
+        EXPECT_EQ(str_manager.KeyLane(keys[i]), lane % 3);
+    }
+
+    // fewer lanes than shards
+    config_param.bulk_parallel_ = 2;
+    MockDataManager narrow_manager(config_param);
+    EXPECT_EQ(0U, narrow_manager.KeyLane("abc"));
+    EXPECT_EQ(1U, narrow_manager.KeyLane("x"));
+}
+
+// values taken from the agent's hash_chash() and ketama_dispatch() on the same ring
+TEST(DataManagerBulkTest, KeyLaneMatchesAgentTest){
+    EXPECT_EQ(2047952446U, chash("shard0#0", 8));
+    EXPECT_EQ(1217788228U, chash("shard2#99", 9));
+    EXPECT_EQ(1567434808U, chash("\x05\xc3\xa9t\xc3\xa9", 6));
+
+    ConfigParam config_param = BulkConfigParam();
+    config_param.agent_hash_ = "chash";
+    config_param.shard_vec_.push_back("shard0");
+    config_param.shard_vec_.push_back("shard1");
+    config_param.shard_vec_.push_back("shard2");
+    config_param.bulk_parallel_ = 3;
+    config_param.key_type_ = "signed";
+    MockDataManager int_manager(config_param);
+    EXPECT_EQ(0U, int_manager.KeyLane("\x80"));
+
+    config_param.key_type_ = "string";
+    MockDataManager str_manager(config_param);
+    EXPECT_EQ(2U, str_manager.KeyLane("y"));
+    EXPECT_EQ(2U, str_manager.KeyLane("z"));
+}
 UNITEST_NAMESPACE_END
 #endif
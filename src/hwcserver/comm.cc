@@ -22,6 +22,8 @@ const char *CComm::version = "hwc.0.1";
 const char* CComm::dtc_conf = "../conf/dtc.yaml";
 int CComm::backend = 0;
 int CComm::normal = 1;
+int CComm::apply_workers = 4;
+int CComm::sync_limit = 128;
 
 void CComm::show_usage(int argc, char **argv)
 {
@@ -31,6 +33,8 @@ void CComm::show_usage(int argc, char **argv)
         "\t -b, --backend  runing in background.\n"
         "\t -v, --version  show version.\n"
         "\t -d, --dtc_conf dtc config file path.\n"
+        "\t -w, --workers  # threads applying rows to cold db, default 4.\n"
+        "\t -l, --limit    # keys fetched from master in a batch, default 128.\n"
         "\t -h, --help     display this help and exit.\n\n", argv[0]);
     return;
 }
@@ -55,11 +59,13 @@ void CComm::parse_argv(int argc, char **argv)
         {"version", 0, 0, 'v'},
         {"help", 0, 0, 'h'},
         {"dtc_conf", 1, 0, 'd'},
+        {"workers", 1, 0, 'w'},
+        {"limit", 1, 0, 'l'},
         {0, 0, 0, 0},
     };
 
     while ((c =
-        getopt_long(argc, argv, "nbvt:hd:", long_options,
+        getopt_long(argc, argv, "nbvt:hd:w:l:", long_options,
                 &option_index)) != -1) {
         switch (c) {
         case 'n':
@@ -82,6 +88,20 @@ void CComm::parse_argv(int argc, char **argv)
                     dtc_conf = optarg;
                 }
             break;
+        case 'w':
+            apply_workers = atoi(optarg);
+            if (apply_workers <= 0) {
+                show_usage(argc, argv);
+                exit(-1);
+            }
+            break;
+        case 'l':
+            sync_limit = atoi(optarg);
+            if (sync_limit <= 0) {
+                show_usage(argc, argv);
+                exit(-1);
+            }
+            break;
         case '?':
         default:
             show_usage(argc, argv);
@@ -50,6 +50,8 @@ public:
 	static char* table_conf;
 	static int backend;
 	static int normal;
+	static int apply_workers;
+	static int sync_limit;
 };
 
 #endif
@@ -33,7 +33,9 @@ void BinlogState::HandleEvent()
             case -DTC::EC_FULL_SYNC_STAGE:
             case -DTC::EC_INC_SYNC_STAGE:
             {
-                if (p_hwc_sync_unit_->Run(&CComm::master)) {
+                if (p_hwc_sync_unit_->Run(&CComm::master,
+                        p_hwc_state_manager_->GetDBConfigParser(),
+                        CComm::sync_limit)) {
                     p_hwc_state_manager_->ChangeState(E_HWC_STATE_FAULT);
                 }
             }
@@ -1,5 +1,7 @@
 #include "hwc_sync_unit.h"
 #include <string>
+#include <functional>
+#include <math.h>
 #include <sys/time.h>
 // local
 #include "comm.h"
@@ -9,16 +11,169 @@
 #include "dtcapi.h"
 #include "mysqld_error.h"
 
-HwcSync::HwcSync(DTC::Server* p_server)
+HwcApplyWorker::HwcApplyWorker(HwcSync* p_sync)
+    : p_sync_(p_sync)
+    , i_done_(0)
+    , b_busy_(false)
+    , b_stop_(false)
+{ }
+
+HwcApplyWorker::~HwcApplyWorker()
+{
+    Stop();
+}
+
+int HwcApplyWorker::Init(
+    const DbConfig* p_db_config,
+    DTCTableDefinition* p_dtc_tab_def)
+{
+    return o_mysql_process_.do_init(0 , p_db_config, p_dtc_tab_def, 0);
+}
+
+void HwcApplyWorker::Start()
+{
+    b_stop_ = false;
+    o_thread_ = std::thread(&HwcApplyWorker::Loop, this);
+}
+
+void HwcApplyWorker::Stop()
+{
+    if (!o_thread_.joinable()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> o_lock(o_mutex_);
+        b_stop_ = true;
+    }
+    o_cond_.notify_all();
+    o_thread_.join();
+}
+
+void HwcApplyWorker::Post(std::vector<HwcSyncRow>& o_rows)
+{
+    {
+        std::lock_guard<std::mutex> o_lock(o_mutex_);
+        o_rows_.swap(o_rows);
+        i_done_ = 0;
+        b_busy_ = true;
+    }
+    o_cond_.notify_all();
+}
+
+void HwcApplyWorker::Wait()
+{
+    std::unique_lock<std::mutex> o_lock(o_mutex_);
+    while (b_busy_) {
+        o_cond_.wait(o_lock);
+    }
+}
+
+void HwcApplyWorker::Loop()
+{
+    while (true) {
+        {
+            std::unique_lock<std::mutex> o_lock(o_mutex_);
+            while (!b_busy_ && !b_stop_) {
+                o_cond_.wait(o_lock);
+            }
+            if (b_stop_) {
+                return;
+            }
+        }
+
+        // 失败则回滚，从未提交的行开始重试
+        uint32_t ui_count = 0;
+        while (ApplyShare() != 0) {
+            o_mysql_process_.roll_back();
+            uint64_t ui_interval = pow(2, ++ui_count);
+            sleep(ui_interval);
+            log4cplus_error("apply rows fail sequence:%d , committed:%zu/%zu" ,
+                ui_count , i_done_ , o_rows_.size());
+        }
+
+        {
+            std::lock_guard<std::mutex> o_lock(o_mutex_);
+            o_rows_.clear();
+            b_busy_ = false;
+        }
+        o_cond_.notify_all();
+    }
+}
+
+/*
+ * rows from i_done_ on are applied in one transaction. a duplicate entry
+ * means the row is in already, but CDBConn closes the connection on any
+ * error and the open transaction is lost with it, rows before are redone.
+ */
+int HwcApplyWorker::ApplyShare()
+{
+    size_t i_begin = i_done_;
+    size_t i = i_done_;
+
+    if (o_mysql_process_.begin_work()) {
+        return -1;
+    }
+
+    while (i < o_rows_.size()) {
+        int i_ret = p_sync_->apply_row(o_mysql_process_, o_rows_[i]);
+        if (-ER_DUP_ENTRY == i_ret) {
+            if (RedoRows(i_begin, i)) {
+                return -1;
+            }
+            i_done_ = i_begin = ++i;
+            if (o_mysql_process_.begin_work()) {
+                return -1;
+            }
+            continue;
+        }
+
+        if (i_ret != 0) {
+            return -1;
+        }
+        ++i;
+    }
+
+    if (o_mysql_process_.do_commit()) {
+        return -1;
+    }
+    i_done_ = i;
+    return 0;
+}
+
+int HwcApplyWorker::RedoRows(size_t i_begin, size_t i_end)
+{
+    if (i_begin == i_end) {
+        return 0;
+    }
+
+    if (o_mysql_process_.begin_work()) {
+        return -1;
+    }
+
+    for (size_t i = i_begin; i < i_end; ++i) {
+        if (p_sync_->apply_row(o_mysql_process_, o_rows_[i])) {
+            return -1;
+        }
+    }
+    return o_mysql_process_.do_commit();
+}
+
+//***************************分割线***************************
+HwcSync::HwcSync(DTC::Server* p_server, const DbConfig* p_db_config)
     : i_limit_(1)
     , p_master_(p_server)
+    , p_db_config_(p_db_config)
     , o_journal_id_(CComm::registor.JournalId())
 { } 
 
 HwcSync::~HwcSync()
-{ }
+{
+    stop_workers();
+}
 
 int HwcSync::query_cold_server(
+    ConnectorProcess& o_mysql_process,
     DTCJobOperation* p_job,
     const DTCValue* key)
 {
@@ -41,7 +196,7 @@ int HwcSync::query_cold_server(
         p_job->num_fields() + 1);
     p_job->set_request_fields(p_dtc_field_set);
 
-    if (CComm::mysql_process_.do_process(p_job)) {
+    if (o_mysql_process.do_process(p_job)) {
         return -1;
     }
 
@@ -49,24 +204,6 @@ int HwcSync::query_cold_server(
 
 }
 
-void HwcSync::sql_statement_query(
-    const DTCValue* p_key,
-    std::string& s_sql)
-{
-    uint32_t ui_count = 0;
-
-    do {
-        int i_ret = CComm::mysql_process_.process_statement_query(p_key , s_sql);
-        if (-ER_DUP_ENTRY == i_ret || 0 == i_ret) {
-            break;
-        }
-        
-        uint64_t ui_interval = pow(2, ++ui_count);
-        sleep(ui_interval);
-        log4cplus_error("sql statement query fail sequence:%d" , ui_count);
-    } while (true);
-}
-
 void HwcSync::decode_hotbin_result(
     ResultSet* o_hot_res,
     const HwcBinlogCont& o_hwc_bin)
@@ -78,6 +215,90 @@ void HwcSync::decode_hotbin_result(
     o_hot_res->set_value_data(o_hwc_bin.i_raw_nums , o_raw_bin);
 }
 
+/*
+ * return 0 if the row is in cold db or has to be skipped, -ER_DUP_ENTRY if
+ * it was in already, other values if it has to be applied again.
+ */
+int HwcSync::apply_row(
+    ConnectorProcess& o_mysql_process,
+    const HwcSyncRow& o_row)
+{
+    DTCTableDefinition* p_dtc_tab_def = TableDefinitionManager::instance()->get_cur_table_def();
+
+    DTCValue astKey[p_dtc_tab_def->key_fields()];// always single key
+    TaskPackedKey::unpack_key(p_dtc_tab_def, o_row.s_key.data(), astKey);
+
+    HwcBinlogCont o_hot_bin;
+    bool b_ret = o_hot_bin.ParseFromString(o_row.s_value.data() , o_row.s_value.size());
+    if (!b_ret) {
+        log4cplus_error("report alarm to manager");
+        return 0;
+    }
+
+    std::string s_sql(o_hot_bin.p_sql , o_hot_bin.i_sql_len);
+    log4cplus_info(" mysql cmd:%s , check flag:%d , row len:%d" ,
+         s_sql.c_str(), o_hot_bin.i_check_flag
+         , o_hot_bin.i_raw_len);
+
+    if (0 == o_hot_bin.i_check_flag) {
+        return o_mysql_process.process_statement_query(astKey, s_sql);
+    } else if (1 != o_hot_bin.i_check_flag) {
+        log4cplus_error("illegal check flag");
+        return 0;
+    }
+
+    log4cplus_info("check: starting...");
+
+    DTCJobOperation o_cold_job(p_dtc_tab_def);
+    query_cold_server(o_mysql_process, &o_cold_job , astKey);
+
+    ResultSet* p_cold_res = o_cold_job.result;
+    if (!p_cold_res) {
+        log4cplus_info("cold res is null");
+        return -1;
+    }
+
+    log4cplus_info("hot row num:%d ,cold row num:%d" , 
+            o_hot_bin.i_raw_nums , p_cold_res->total_rows());
+
+    if (o_hot_bin.i_raw_nums > p_cold_res->total_rows() ||
+        o_hot_bin.i_raw_nums < p_cold_res->total_rows()) {
+        return o_mysql_process.process_statement_query(astKey, s_sql);
+    }
+
+    uint8_t* p_fiedld_list = p_dtc_tab_def->raw_fields_list();
+    DTCFieldSet o_dtc_field_set(p_fiedld_list , p_dtc_tab_def->num_fields() + 1);
+
+    ResultSet p_hot_result(o_dtc_field_set , p_dtc_tab_def);
+    decode_hotbin_result(&p_hot_result , o_hot_bin);
+
+    for (int i = 0; i < p_hot_result.total_rows(); i++) {
+        const RowValue* p_hot_raw = p_hot_result.fetch_row();
+        
+        bool b_check = false;
+        // 冷数据库为base,只要冷数据库中没有热的，就插入
+        for (int j = 0; j < p_cold_res->total_rows(); j++) {
+            const RowValue* p_cold_raw = p_cold_res->fetch_row();
+            if(p_hot_raw->Compare(*p_cold_raw ,
+                    p_fiedld_list , 
+                    p_dtc_tab_def->num_fields() + 1) == 0) {
+                log4cplus_info("check: row data has been in cold table");
+                b_check = true;
+                break;
+            }
+        }
+
+        if (!b_check) {
+            // 对账失败，执行sql语句 ，容错逻辑
+            log4cplus_info("check: need insert in cold table");
+            return o_mysql_process.process_statement_query(astKey, s_sql);
+        }
+        p_cold_res->rewind();
+    }
+    log4cplus_info("check: finish");
+    return 0;
+}
+
 int HwcSync::get_current_time()
 {
     timeval now;
@@ -85,154 +306,182 @@ int HwcSync::get_current_time()
     return now.tv_sec;
 }
 
-int HwcSync::Run()
+void HwcSync::start_workers()
 {
-    /* 先关闭连接，防止fd重路 */
-    p_master_->Close();
-    int i_sec = get_current_time() + 1;
-    while (true) {
-        if (get_current_time() >= i_sec) {
-            if (CComm::registor.CheckMemoryCreateTime()) {
-                log4cplus_error("detect share memory changed");
-            }
-            i_sec += 1;
+    DTCTableDefinition* p_dtc_tab_def = TableDefinitionManager::instance()->get_cur_table_def();
+
+    for (int i = 0; i < CComm::apply_workers; i++) {
+        HwcApplyWorker* p_worker = new HwcApplyWorker(this);
+        // 连接失败时在首次执行sql时重连
+        if (p_worker->Init(p_db_config_, p_dtc_tab_def)) {
+            log4cplus_warning("apply worker %d connect cold db failed" , i);
         }
+        p_worker->Start();
+        o_workers_.push_back(p_worker);
+    }
+    o_shares_.resize(o_workers_.size());
+}
 
-        DTC::SvrAdminRequest request_m(p_master_);
-        request_m.SetAdminCode(DTC::GetUpdateKey);
+void HwcSync::stop_workers()
+{
+    for (size_t i = 0; i < o_workers_.size(); i++) {
+        o_workers_[i]->Stop();
+        DELETE(o_workers_[i]);
+    }
+    o_workers_.clear();
+    o_shares_.clear();
+}
 
-        request_m.Need("type");
-        request_m.Need("flag");
-        request_m.Need("key");
-        request_m.Need("value");
-        request_m.SetHotBackupID((uint64_t)o_journal_id_);
-        request_m.Limit(0, i_limit_);
-        log4cplus_info("begin serial:%d , offset:%d" , o_journal_id_.serial , o_journal_id_.offset);
+/*
+ * return 0 with the rows of the batch and the journal id after it, 1 if
+ * the master has to be asked again, E_HWC_SYNC_DTC_ERROR on bad result.
+ */
+int HwcSync::fetch_batch(
+    const JournalID& o_from,
+    std::vector<HwcSyncRow>& o_rows,
+    JournalID& o_next)
+{
+    DTC::SvrAdminRequest request_m(p_master_);
+    request_m.SetAdminCode(DTC::GetUpdateKey);
+
+    request_m.Need("type");
+    request_m.Need("flag");
+    request_m.Need("key");
+    request_m.Need("value");
+    request_m.SetHotBackupID((uint64_t)o_from);
+    request_m.Limit(0, i_limit_);
+    log4cplus_info("begin serial:%d , offset:%d" , o_from.serial , o_from.offset);
+
+    DTC::Result result_m;
+    int ret = request_m.Execute(result_m);
+    log4cplus_warning("hwc server is aliving....., return:%d", ret);
+
+    if (-DTC::EC_BAD_HOTBACKUP_JID == ret) {
+        log4cplus_error("master report journalID is not match");
+    }
 
-        DTC::Result result_m;
-        int ret = request_m.Execute(result_m);
-        log4cplus_warning("hwc server is aliving....., return:%d", ret);
+    // 重试
+    if (0 != ret) {
+        log4cplus_warning("fetch key-list from master, limit[%d], ret=%d, err=%s",
+        i_limit_, ret, result_m.ErrorMessage());
+        return 1;
+    }
 
-        if (-DTC::EC_BAD_HOTBACKUP_JID == ret) {
-            log4cplus_error("master report journalID is not match");
+    o_rows.clear();
+    for (int i = 0; i < result_m.NumRows(); ++i) {
+        ret = result_m.FetchRow();
+        if (ret < 0) {
+            log4cplus_error("fetch key-list from master failed, limit[%d], ret=%d, err=%s",
+                  i_limit_, ret, result_m.ErrorMessage());
+            // dtc可以运行失败
+            return E_HWC_SYNC_DTC_ERROR;
         }
 
-        // 重试
-        if (0 != ret) {
-            log4cplus_warning("fetch key-list from master, limit[%d], ret=%d, err=%s",
-            i_limit_, ret, result_m.ErrorMessage());
-            usleep(100);
+        int i_type = result_m.IntValue("type");
+        if (i_type != DTCHotBackup::SYNC_NONE) {
+            log4cplus_info("no sync none type , skip");
             continue;
         }
-        // 写请求 插入 冷数据库
-        for (int i = 0; i < result_m.NumRows(); ++i) {
-            ret = result_m.FetchRow();
-            if (ret < 0) {
-                log4cplus_error("fetch key-list from master failed, limit[%d], ret=%d, err=%s",
-                      i_limit_, ret, result_m.ErrorMessage());
-                // dtc可以运行失败
-                return E_HWC_SYNC_DTC_ERROR;
-            }
 
-            int i_type = result_m.IntValue("type");
-            if (i_type != DTCHotBackup::SYNC_NONE) {
-                log4cplus_info("no sync none type , continue");
-                break;
-            }
-            
-            // key parse
-            int i_key_size = 0;
-            const char* p_key = result_m.BinaryValue("key", i_key_size);
+        int i_key_size = 0;
+        const char* p_key = result_m.BinaryValue("key", i_key_size);
+        int i_value_size = 0;
+        const char* p_value = result_m.BinaryValue("value", i_value_size);
 
-            DTCTableDefinition* p_dtc_tab_def = TableDefinitionManager::instance()->get_cur_table_def();
+        o_rows.push_back(HwcSyncRow());
+        o_rows.back().s_key.assign(p_key , i_key_size);
+        o_rows.back().s_value.assign(p_value , i_value_size);
+    }
 
-            DTCValue astKey[p_dtc_tab_def->key_fields()];// always single key
-            TaskPackedKey::unpack_key(p_dtc_tab_def, p_key, astKey);
+    o_next = (uint64_t)result_m.HotBackupID();
+    return 0;
+}
 
-            int i_value_size = 0;
-            char* p_value = (char *)result_m.BinaryValue("value", i_value_size);
+// 按key分区，同一key的行由同一worker顺序执行
+void HwcSync::dispatch_batch(std::vector<HwcSyncRow>& o_rows)
+{
+    std::hash<std::string> o_hash;
+
+    for (size_t i = 0; i < o_rows.size(); i++) {
+        std::vector<HwcSyncRow>& o_share =
+            o_shares_[o_hash(o_rows[i].s_key) % o_shares_.size()];
+        o_share.push_back(HwcSyncRow());
+        o_share.back().s_key.swap(o_rows[i].s_key);
+        o_share.back().s_value.swap(o_rows[i].s_value);
+    }
 
-            HwcBinlogCont o_hot_bin;
-            bool b_ret = o_hot_bin.ParseFromString(p_value , i_value_size);
-            if (!b_ret) {
-                log4cplus_error("report alarm to manager");
-                break;
-            }
+    for (size_t i = 0; i < o_workers_.size(); i++) {
+        if (!o_shares_[i].empty()) {
+            o_workers_[i]->Post(o_shares_[i]);
+        }
+    }
+}
+
+void HwcSync::wait_batch()
+{
+    for (size_t i = 0; i < o_workers_.size(); i++) {
+        o_workers_[i]->Wait();
+    }
+}
 
-            std::string s_sql(o_hot_bin.p_sql , o_hot_bin.i_sql_len);
-            log4cplus_info(" mysql cmd:%s , check flag:%d , row len:%d" ,
-                 s_sql.c_str(), o_hot_bin.i_check_flag
-                 , o_hot_bin.i_raw_len);
+int HwcSync::sync_loop()
+{
+    JournalID o_fetch_id = o_journal_id_;
+    JournalID o_apply_id;
+    bool b_applying = false;
+    std::vector<HwcSyncRow> o_rows;
 
-            if (0 == o_hot_bin.i_check_flag) {
-                sql_statement_query(astKey, s_sql);
-                break;
-            } else if (1 == o_hot_bin.i_check_flag) {
-                log4cplus_info("check: starting...");
-
-                DTCJobOperation o_cold_job(p_dtc_tab_def);
-                query_cold_server(&o_cold_job , astKey);
-
-                ResultSet* p_cold_res = o_cold_job.result;
-                if (!p_cold_res) {
-                    log4cplus_info("cold res is null");
-                    return E_HWC_SYNC_NORMAL_EXIT;
-                }
-
-                log4cplus_info("hot row num:%d ,cold row num:%d" , 
-                        o_hot_bin.i_raw_nums , p_cold_res->total_rows());
-
-                if (o_hot_bin.i_raw_nums > p_cold_res->total_rows() ||
-                    o_hot_bin.i_raw_nums < p_cold_res->total_rows()) {
-                    sql_statement_query(astKey, s_sql);
-                    break;
-                }
-
-                uint8_t* p_fiedld_list = p_dtc_tab_def->raw_fields_list();
-                DTCFieldSet o_dtc_field_set(p_fiedld_list , p_dtc_tab_def->num_fields() + 1);
-
-                ResultSet p_hot_result(o_dtc_field_set , p_dtc_tab_def);
-                decode_hotbin_result(&p_hot_result , o_hot_bin);
-
-                for (int i = 0; i < p_hot_result.total_rows(); i++) {
-                    const RowValue* p_hot_raw = p_hot_result.fetch_row();
-                    
-                    bool b_check = false;
-                    // 冷数据库为base,只要冷数据库中没有热的，就插入
-                    for (int j = 0; j < p_cold_res->total_rows(); j++) {
-                        const RowValue* p_cold_raw = p_cold_res->fetch_row();
-                        if(p_hot_raw->Compare(*p_cold_raw ,
-                                p_fiedld_list , 
-                                p_dtc_tab_def->num_fields() + 1) == 0) {
-                            log4cplus_info("check: row data has been in cold table");
-                            b_check = true;
-                            break;
-                        }
-                    }
-
-                    if (!b_check) {
-                        // 对账失败，执行sql语句 ，容错逻辑
-                        log4cplus_info("check: need insert in cold table");
-                        sql_statement_query(astKey, s_sql);
-                        break;
-                    }
-                    p_cold_res->rewind();
-                }
-                log4cplus_info("check: finish");
-            } else {
-                log4cplus_error("illegal check flag");
-                continue;
+    int i_sec = get_current_time() + 1;
+    while (true) {
+        if (get_current_time() >= i_sec) {
+            if (CComm::registor.CheckMemoryCreateTime()) {
+                log4cplus_error("detect share memory changed");
             }
+            i_sec += 1;
+        }
+
+        // 上一批由worker写入冷数据库时，拉取下一批
+        JournalID o_next_id;
+        int ret = fetch_batch(o_fetch_id, o_rows, o_next_id);
+
+        if (b_applying) {
+            wait_batch();
+            // 所有分区都已提交，才更新控制文件中的journalID
+            o_journal_id_ = o_apply_id;
+            log4cplus_info("end serial:%d , offset:%d" , o_journal_id_.serial , o_journal_id_.offset);
+            CComm::registor.JournalId() = o_journal_id_;
+            b_applying = false;
+        }
+
+        if (ret < 0) {
+            return ret;
+        }
+        if (ret > 0) {
+            usleep(100);
+            continue;
         }
-        // 成功，则更新控制文件中的journalID
-        o_journal_id_ = (uint64_t)result_m.HotBackupID();
-        log4cplus_info("end serial:%d , offset:%d" , o_journal_id_.serial , o_journal_id_.offset);
-        CComm::registor.JournalId() = o_journal_id_;
+
+        dispatch_batch(o_rows);
+        o_apply_id = o_next_id;
+        o_fetch_id = o_next_id;
+        b_applying = true;
     }
 
     return E_HWC_SYNC_NORMAL_EXIT;
 }
 
+int HwcSync::Run()
+{
+    /* 先关闭连接，防止fd重路 */
+    p_master_->Close();
+
+    start_workers();
+    int i_ret = sync_loop();
+    stop_workers();
+
+    return i_ret;
+}
+
 //***************************分割线***************************
 HwcSyncUnit::HwcSyncUnit()
     : p_hwc_sync_(NULL)
@@ -243,12 +492,12 @@ HwcSyncUnit::~HwcSyncUnit()
     DELETE(p_hwc_sync_);
 }
 
-bool HwcSyncUnit::Run(DTC::Server* m , int limit)
+bool HwcSyncUnit::Run(DTC::Server* m , const DbConfig* p_db_config, int limit)
 {
         log4cplus_warning("hwc sync unit is start");
         
         if (NULL == p_hwc_sync_) {
-            p_hwc_sync_ = new HwcSync(m);
+            p_hwc_sync_ = new HwcSync(m, p_db_config);
             if (!p_hwc_sync_) {
                 log4cplus_error("hwcsync is not complete, err: create HwcSync obj failed");
                 return false;
@@ -22,6 +22,11 @@
 #include <sys/types.h>
 #include <unistd.h>
 #include <signal.h>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 // local
 #include "async_file.h"
 // common
@@ -32,6 +37,8 @@
 #include "hwc_binlog_obj.h"
 #include "table/hotbackup_table_def.h"
 #include "table/table_def_manager.h"
+// connector
+#include "mysql_operation.h"
 // libs/api/cc_api/include
 #include "dtcapi.h"
 
@@ -42,29 +49,86 @@ enum E_HWC_SYNC_ERROR_ID
     E_HWC_SYNC_DTC_ERROR
 };
 
+class DbConfig;
+
+// one row of a GetUpdateKey batch, copied out of the master result so that
+// the next batch can be fetched while this one is applied
+struct HwcSyncRow {
+    std::string s_key;
+    std::string s_value;
+};
+
+class HwcSync;
+
+// applies rows of its key partition to the cold db over its own connection
+class HwcApplyWorker
+{
+public:
+    HwcApplyWorker(HwcSync* p_sync);
+    ~HwcApplyWorker();
+
+    int Init(const DbConfig* p_db_config, DTCTableDefinition* p_dtc_tab_def);
+    void Start();
+    void Stop();
+
+    // hand over a share of the batch, rows of a key keep their order
+    void Post(std::vector<HwcSyncRow>& o_rows);
+    // wait until the share is committed
+    void Wait();
+
+private:
+    void Loop();
+    int ApplyShare();
+    int RedoRows(size_t i_begin, size_t i_end);
+
+private:
+    HwcSync* p_sync_;
+    ConnectorProcess o_mysql_process_;
+    std::thread o_thread_;
+    std::mutex o_mutex_;
+    std::condition_variable o_cond_;
+    std::vector<HwcSyncRow> o_rows_;
+    size_t i_done_;     // rows of o_rows_ committed
+    bool b_busy_;
+    bool b_stop_;
+};
+
 class HwcSync
 {
 public:
-    HwcSync(DTC::Server* p_server);
+    HwcSync(DTC::Server* p_server, const DbConfig* p_db_config);
     ~HwcSync();
 
     int Run();
 
     void SetLimit(int iLimit) {
-        // Here we need sync one by one
+        // rows of a key are applied in order by the same worker
         i_limit_ = iLimit;
     }
 
 public:
-    int query_cold_server(DTCJobOperation* p_job , const DTCValue* key);
+    int query_cold_server(ConnectorProcess& o_mysql_process,
+        DTCJobOperation* p_job , const DTCValue* key);
     void decode_hotbin_result(ResultSet* o_hot_res, const HwcBinlogCont& o_hwc_bin);
-    void sql_statement_query(const DTCValue* p_key , std::string& s_sql);
+    int apply_row(ConnectorProcess& o_mysql_process, const HwcSyncRow& o_row);
     int get_current_time();
 
+private:
+    void start_workers();
+    void stop_workers();
+    int fetch_batch(const JournalID& o_from, std::vector<HwcSyncRow>& o_rows,
+        JournalID& o_next);
+    void dispatch_batch(std::vector<HwcSyncRow>& o_rows);
+    void wait_batch();
+    int sync_loop();
+
 private:
     int i_limit_;
     DTC::Server* p_master_;
+    const DbConfig* p_db_config_;
     JournalID o_journal_id_;
+    std::vector<HwcApplyWorker*> o_workers_;
+    std::vector<std::vector<HwcSyncRow> > o_shares_;
 };
 
 class HwcSyncUnit {
@@ -72,7 +136,7 @@ public:
     HwcSyncUnit();
     ~HwcSyncUnit();
 
-    bool Run(DTC::Server* m , int limit = 1);
+    bool Run(DTC::Server* m , const DbConfig* p_db_config, int limit = 1);
 
 private:
     HwcSync* p_hwc_sync_;
@@ -108,6 +108,8 @@ void AgentReply::job_answer_procedure(DTCJobOperation *job)
 		return;
 	}
 
+	/* rows the cache thread left to decode here */
+	job->fill_row_source();
 	packet->encode_result(job);
 	job->detach_result_in_result_writer();
 	job->done_one_agent_sub_request();
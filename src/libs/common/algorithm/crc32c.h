@@ -0,0 +1,28 @@
+/*
+* Copyright [2021] JD.com, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#ifndef _H_CRC32C_H
+#define _H_CRC32C_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * CRC-32C (Castagnoli), used to checksum binlog records.
+ * crc is the value returned by the previous call, 0 for the first one.
+ */
+uint32_t crc32c(uint32_t crc, const void *buf, size_t len);
+
+#endif
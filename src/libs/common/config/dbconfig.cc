@@ -253,6 +253,7 @@ bool DbConfig::Compare(DbConfig *config, bool compareMach)
 
     if (depoly != config->depoly || keyFieldCnt != config->keyFieldCnt ||
         idxFieldCnt != config->idxFieldCnt ||
+        idxEngine != config->idxEngine ||
         fieldCnt != config->fieldCnt ||
         database_max_count != config->database_max_count ||
         dbDiv != config->dbDiv || dbMod != config->dbMod ||
@@ -589,12 +590,41 @@ int DbConfig::get_dtc_config(YAML::Node dtc_config, DTCConfig* raw, int i_server
     }
     log4cplus_info("keyFieldCnt:%d" , keyFieldCnt);
 
+    //optional tree mode, rows of a key are indexed by the field after the key.
     idxFieldCnt = 0;
-    if (keyFieldCnt < 0 || keyFieldCnt + idxFieldCnt > fieldCnt) {
+    idxEngine = INDEX_ENGINE_TTREE;
+    YAML::Node index = dtc_config["primary"]["cache"]["index"];
+    if (index) {
+        idxFieldCnt = index["count"] ? index["count"].as<int>() : 1;
+        if (index["engine"]) {
+            std::string engine = index["engine"].as<std::string>();
+            if (engine == "btree")
+                idxEngine = INDEX_ENGINE_BTREE;
+            else if (engine != "ttree") {
+                log4cplus_error("invalid index engine: %s", engine.c_str());
+                return -1;
+            }
+        }
+    }
+    if (keyFieldCnt < 0 || idxFieldCnt < 0 || idxFieldCnt > 1 ||
+        keyFieldCnt + idxFieldCnt > fieldCnt) {
         log4cplus_error("invalid [TABLE_CONF].IndexFieldCount");
         return -1;
     }
 
+    //nodes record their own row format, so it can be changed at any restart.
+    rowFormat = ROW_FORMAT_PLAIN;
+    if (dtc_config["primary"]["cache"]["row_format"]) {
+        std::string format =
+            dtc_config["primary"]["cache"]["row_format"].as<std::string>();
+        if (format == "packed")
+            rowFormat = ROW_FORMAT_PACKED;
+        else if (format != "plain") {
+            log4cplus_error("invalid row format: %s", format.c_str());
+            return -1;
+        }
+    }
+
     ordIns = 0;
     if (ordIns < 0) {
         log4cplus_error("bad [TABLE_CONF].ServerOrderInsert");
@@ -720,6 +750,7 @@ int DbConfig::get_dtc_config(YAML::Node dtc_config, DTCConfig* raw, int i_server
     lastacc = -1;
     compressflag = -1;
     expireTime = -1;
+    int summaryCnt = 0;
     for (int i = 0; i < fieldCnt; i++) {
         struct FieldConfig *f = &field[i];
 
@@ -762,7 +793,18 @@ int DbConfig::get_dtc_config(YAML::Node dtc_config, DTCConfig* raw, int i_server
                 return -1;
             }
 
-            std::string idx_order = dtc_config["primary"]["cache"]["order"].as<std::string>();
+            //b+tree keys are normalized to 64 bits.
+            if (idxEngine == INDEX_ENGINE_BTREE && f->type != 1 &&
+                f->type != 2) {
+                log4cplus_error(
+                    "index field[%s] must be signed or unsigned for btree",
+                    f->name);
+                return -1;
+            }
+
+            std::string idx_order;
+            if (dtc_config["primary"]["cache"]["order"])
+                idx_order = dtc_config["primary"]["cache"]["order"].as<std::string>();
             if (idx_order == "desc")
                 f->flags |= DB_FIELD_FLAGS_DESC_ORDER;
             else
@@ -1113,6 +1155,56 @@ int DbConfig::get_dtc_config(YAML::Node dtc_config, DTCConfig* raw, int i_server
                 f->flags |= DB_FIELD_FLAGS_NULLABLE;
             }
         }
+
+        if (dtc_config["primary"]["cache"]["field"][i]["summary"] &&
+            dtc_config["primary"]["cache"]["field"][i]["summary"].as<int>() > 0) {
+            //min/max is kept as 64 bits integer in the node header.
+            if (i < keyFieldCnt || (f->type != DField::Signed &&
+                        f->type != DField::Unsigned)) {
+                log4cplus_error(
+                    "field%d: summary field must be non-key signed or unsigned",
+                    i + 1);
+                return -1;
+            }
+            if ((f->flags & DB_FIELD_FLAGS_DISCARD)) {
+                log4cplus_error(
+                    "field%d: discard field can't be summary",
+                    i + 1);
+                return -1;
+            }
+            //lastacc is rewritten in place by reads, the summary never sees it.
+            if (i == lastacc) {
+                log4cplus_error(
+                    "field%d: lastacc field can't be summary",
+                    i + 1);
+                return -1;
+            }
+            if (++summaryCnt > MAX_SUMMARY_FIELDS) {
+                log4cplus_error("at most %d summary fields",
+                        MAX_SUMMARY_FIELDS);
+                return -1;
+            }
+            f->flags |= DB_FIELD_FLAGS_SUMMARY;
+        }
+
+        if (dtc_config["primary"]["cache"]["field"][i]["dict"] &&
+            dtc_config["primary"]["cache"]["field"][i]["dict"].as<int>() > 0) {
+            //values are interned in the shared string dictionary.
+            if (i < keyFieldCnt || (f->type != DField::String &&
+                        f->type != DField::Binary)) {
+                log4cplus_error(
+                    "field%d: dict field must be non-key string or binary",
+                    i + 1);
+                return -1;
+            }
+            if ((f->flags & DB_FIELD_FLAGS_DISCARD)) {
+                log4cplus_error(
+                    "field%d: discard field can't be dict",
+                    i + 1);
+                return -1;
+            }
+            f->flags |= DB_FIELD_FLAGS_DICT;
+        }
     }
 
     if (field[0].type == DField::Float) {
@@ -35,6 +35,8 @@
 #define DB_FIELD_FLAGS_DISCARD 0x10
 #define DB_FIELD_FLAGS_HAS_DEFAULT 0x20
 #define DB_FIELD_FLAGS_NULLABLE 0x40
+#define DB_FIELD_FLAGS_SUMMARY 0x80
+#define DB_FIELD_FLAGS_DICT 0x100
 
 /* 默认key-hash so文件名及路径 */
 #define DEFAULT_KEY_HASH_SO_NAME "../lib/key-hash.so"
@@ -121,6 +123,8 @@ public:
 	int fieldCnt;
 	int keyFieldCnt;
 	int idxFieldCnt;
+	int idxEngine; /* INDEX_ENGINE_* of the index field */
+	int rowFormat; /* ROW_FORMAT_* of new raw-data nodes */
 	int machineCnt;
 	int procs; //all machine procs total
 	int database_max_count; //max db index
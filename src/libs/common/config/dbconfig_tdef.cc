@@ -44,6 +44,10 @@ DTCTableDefinition *DbConfig::build_table_definition(void)
 			tdef->mark_as_discard(i);
 		if ((field[i].flags & DB_FIELD_FLAGS_UNIQ))
 			tdef->mark_uniq_field(i);
+		if ((field[i].flags & DB_FIELD_FLAGS_SUMMARY))
+			tdef->mark_as_summary(i);
+		if ((field[i].flags & DB_FIELD_FLAGS_DICT))
+			tdef->mark_as_dict(i);
 		if ((field[i].flags & DB_FIELD_FLAGS_DESC_ORDER)) {
 			tdef->mark_order_desc(i);
 			if (tdef->is_desc_order(i))
@@ -75,6 +79,8 @@ DTCTableDefinition *DbConfig::build_table_definition(void)
 		return NULL;
 	}
 	tdef->set_index_fields(idxFieldCnt);
+	tdef->set_index_engine(idxEngine);
+	tdef->set_row_format(rowFormat);
 	tdef->build_info_cache();
 	return tdef;
 }
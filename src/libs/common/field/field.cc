@@ -261,6 +261,18 @@ int DTCFieldValue::Update(RowValue &r)
 }
 
 int DTCFieldValue::Compare(const RowValue &r, int iCmpFirstNRows)
+{
+	const DTCTableDefinition *tdef = r.table_definition();
+	if (predicate.is_compiled_for(tdef) ||
+	    predicate.Compile(tdef, *this) == 0)
+		return predicate.Evaluate(r, iCmpFirstNRows);
+
+	/* out of memory compiling, interpret the condition directly */
+	return compare_interpreted(r, iCmpFirstNRows);
+}
+
+int DTCFieldValue::compare_interpreted(const RowValue &r,
+				       int iCmpFirstNRows) const
 {
 	for (int i = 0; i < num_fields(); i++) {
 		const int id = fieldValue[i].id;
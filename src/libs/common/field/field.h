@@ -23,6 +23,8 @@
 #include "../table/table_def.h"
 #include "protocol.h"
 #include "mem_check.h"
+#include "field_predicate.h"
+#include "field_aggregate.h"
 
 class DTCFieldValue;
 class FieldSetByName;
@@ -251,6 +253,8 @@ class DTCFieldValue {
 	//real
 	int numFields;
 	FieldDefinition::fieldflag_t typeMask[2];
+	//compiled form of the condition, rebuilt after any change
+	RowPredicate predicate;
 
     public:
 	DTCFieldValue(int total)
@@ -308,11 +312,13 @@ class DTCFieldValue {
 	inline void Clean()
 	{
 		numFields = 0;
+		predicate.Reset();
 		memset(typeMask, 0, 2 * sizeof(FieldDefinition::fieldflag_t));
 	}
 
 	inline void Realloc(int total)
 	{
+		predicate.Reset();
 		maxFields = total;
 		fieldValue = (struct SFieldValue *)REALLOC(
 			fieldValue, sizeof(struct SFieldValue) * total);
@@ -357,6 +363,7 @@ class DTCFieldValue {
 		fieldValue[numFields].type = t;
 		fieldValue[numFields].val = val;
 		numFields++;
+		predicate.Reset();
 	}
 	DTCValue *next_field_value()
 	{
@@ -372,6 +379,7 @@ class DTCFieldValue {
 		fieldValue[numFields].oper = op;
 		fieldValue[numFields].type = t;
 		numFields++;
+		predicate.Reset();
 	}
 	void update_type_mask(unsigned int flag)
 	{
@@ -415,6 +423,8 @@ class DTCFieldValue {
 
 	int Update(RowValue &);
 	int Compare(const RowValue &, int iCmpFirstNRows = 256);
+	//same result as Compare, condition by condition without compiling
+	int compare_interpreted(const RowValue &, int iCmpFirstNRows = 256) const;
 };
 
 #endif
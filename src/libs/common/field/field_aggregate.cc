@@ -0,0 +1,177 @@
+/*
+* Copyright [2021] JD.com, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <errno.h>
+#include <string.h>
+#include "field_aggregate.h"
+#include "field.h"
+#include "dtc_error_code.h"
+
+/* <0, 0, >0 like strcmp; string is case insensitive, binary is not */
+static int compare_value(int type, const DTCValue &a, const DTCValue &b)
+{
+	int l, r;
+
+	switch (type) {
+	case DField::Signed:
+		return a.s64 < b.s64 ? -1 : a.s64 > b.s64;
+	case DField::Unsigned:
+		return a.u64 < b.u64 ? -1 : a.u64 > b.u64;
+	case DField::Float:
+		return a.flt < b.flt ? -1 : a.flt > b.flt;
+	case DField::String:
+		l = a.str.len < b.str.len ? a.str.len : b.str.len;
+		r = mystrcmp(a.str.ptr, b.str.ptr, l);
+		break;
+	default:
+		l = a.bin.len < b.bin.len ? a.bin.len : b.bin.len;
+		r = memcmp(a.bin.ptr, b.bin.ptr, l);
+		break;
+	}
+	return r ? r : a.bin.len - b.bin.len;
+}
+
+int RowAggregate::Compile(const DTCTableDefinition *t, const DTCFieldSet &fs,
+			  const char *spec, int len)
+{
+	const int n = fs.num_fields();
+
+	Reset();
+	if (len <= 0)
+		return 0;
+	if (len & 1)
+		return -EC_BAD_VALUE_LENGTH;
+
+	if (n > maxSlots) {
+		Slot *p = (Slot *)REALLOC(slots, n * sizeof(Slot));
+		if (p == NULL)
+			return -ENOMEM;
+		memset(p + maxSlots, 0, (n - maxSlots) * sizeof(Slot));
+		slots = p;
+		maxSlots = n;
+	}
+	for (int i = 0; i < n; i++) {
+		slots[i].id = fs.field_id(i);
+		slots[i].func = DField::None;
+		slots[i].type = t->field_type(slots[i].id);
+	}
+
+	for (int i = 0; i < len; i += 2) {
+		const uint8_t id = spec[i];
+		const uint8_t func = spec[i + 1];
+		int j;
+
+		if (func == DField::None || func >= DField::TotalAggregate)
+			return -EC_BAD_OPERATOR;
+		for (j = 0; j < n; j++)
+			if (slots[j].id == id)
+				break;
+		if (j == n)
+			return -EC_BAD_FIELD_ID;
+		/* COUNT comes from the number of rows, the field is untouched */
+		if (func == DField::Count) {
+			if (t->is_nullable(id))
+				return -EC_BAD_OPERATOR;
+			continue;
+		}
+
+		Slot &s = slots[j];
+		if (s.func != DField::None && s.func != func)
+			return -EC_BAD_OPERATOR;
+		if (func == DField::Sum && s.type != DField::Signed &&
+		    s.type != DField::Unsigned && s.type != DField::Float)
+			return -EC_BAD_VALUE_TYPE;
+		s.func = func;
+	}
+
+	tdef = t;
+	numSlots = n;
+	return 0;
+}
+
+void RowAggregate::Start(void)
+{
+	numRows = 0;
+	for (int i = 0; i < numSlots; i++) {
+		Slot &s = slots[i];
+		if (s.type == DField::String || s.type == DField::Binary)
+			s.v.Set("", 0);
+		else
+			s.v.u64 = 0;
+	}
+}
+
+int RowAggregate::save_value(Slot &s, const DTCValue &v)
+{
+	if (s.type != DField::String && s.type != DField::Binary) {
+		s.v = v;
+		return 0;
+	}
+
+	/* row values point into cache memory, keep our own copy */
+	if (v.bin.len + 1 > s.size) {
+		char *p = (char *)REALLOC(s.buf, v.bin.len + 1);
+		if (p == NULL)
+			return -ENOMEM;
+		s.buf = p;
+		s.size = v.bin.len + 1;
+	}
+	if (v.bin.len > 0)
+		memcpy(s.buf, v.bin.ptr, v.bin.len);
+	s.buf[v.bin.len] = '\0';
+	s.v.Set(s.buf, v.bin.len);
+	return 0;
+}
+
+int RowAggregate::Add(const RowValue &r)
+{
+	numRows++;
+	for (int i = 0; i < numSlots; i++) {
+		Slot &s = slots[i];
+		const DTCValue &v = r[s.id];
+
+		if (numRows == 1) {
+			if (save_value(s, v) != 0)
+				return -ENOMEM;
+			continue;
+		}
+
+		switch (s.func) {
+		case DField::Sum:
+			if (s.type == DField::Float)
+				s.v.flt += v.flt;
+			else
+				s.v.u64 += v.u64;
+			break;
+		case DField::Min:
+			if (compare_value(s.type, v, s.v) < 0 &&
+			    save_value(s, v) != 0)
+				return -ENOMEM;
+			break;
+		case DField::Max:
+			if (compare_value(s.type, v, s.v) > 0 &&
+			    save_value(s, v) != 0)
+				return -ENOMEM;
+			break;
+		}
+	}
+	return 0;
+}
+
+void RowAggregate::Output(RowValue &r) const
+{
+	for (int i = 0; i < numSlots; i++)
+		r[slots[i].id] = slots[i].v;
+}
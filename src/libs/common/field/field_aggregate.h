@@ -0,0 +1,110 @@
+/*
+* Copyright [2021] JD.com, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#ifndef __CH_FIELD_AGGREGATE_H__
+#define __CH_FIELD_AGGREGATE_H__
+
+#include <stdint.h>
+#include "value.h"
+#include "protocol.h"
+#include "mem_check.h"
+
+class DTCTableDefinition;
+class RowValue;
+class DTCFieldSet;
+
+/*
+ * aggregate of the rows matched by one request, folded row by row while
+ * the result is written, so only the aggregated row is sent back.
+ * every field of the field set keeps one value: SUM/MIN/MAX when requested,
+ * otherwise the value of the first matched row. COUNT is the number of
+ * matched rows, returned as total rows of the result.
+ * null is not kept in cache, so COUNT(col) is refused on a nullable field.
+ */
+class RowAggregate {
+    public:
+	struct Slot {
+		uint8_t id;
+		uint8_t func;
+		uint8_t type;
+		int size; /* size of buf, for string/binary copies */
+		char *buf;
+		DTCValue v;
+	};
+
+    private:
+	const DTCTableDefinition *tdef;
+	Slot *slots;
+	int numSlots;
+	int maxSlots;
+	unsigned int numRows;
+
+	int save_value(Slot &s, const DTCValue &v);
+
+	RowAggregate(const RowAggregate &);
+	RowAggregate &operator=(const RowAggregate &);
+
+    public:
+	RowAggregate()
+		: tdef(NULL), slots(NULL), numSlots(0), maxSlots(0), numRows(0)
+	{
+	}
+	~RowAggregate()
+	{
+		for (int i = 0; i < maxSlots; i++)
+			FREE_IF(slots[i].buf);
+		FREE_IF(slots);
+	}
+
+	void Reset()
+	{
+		tdef = NULL;
+		numSlots = 0;
+		numRows = 0;
+	}
+	int is_active(void) const
+	{
+		return numSlots > 0;
+	}
+	unsigned int num_rows(void) const
+	{
+		return numRows;
+	}
+	const DTCTableDefinition *table_definition(void) const
+	{
+		return tdef;
+	}
+	/* a column of the aggregated row is NULL if no row matched, but COUNT */
+	static int is_null(uint8_t func, unsigned int rows)
+	{
+		return rows == 0 && func != DField::Count;
+	}
+
+	/*
+	 * spec is pairs of (field id, DField::Count/Sum/Min/Max), every field
+	 * must be in fs, COUNT(*) is COUNT of the key. empty spec leaves the
+	 * aggregate inactive.
+	 * return 0, or -EC_BAD_xxx on invalid spec, -ENOMEM
+	 */
+	int Compile(const DTCTableDefinition *t, const DTCFieldSet &fs,
+		    const char *spec, int len);
+
+	/* clear accumulators, before the first row */
+	void Start(void);
+	int Add(const RowValue &r);
+	void Output(RowValue &r) const;
+};
+
+#endif
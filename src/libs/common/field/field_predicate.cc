@@ -0,0 +1,259 @@
+/*
+* Copyright [2021] JD.com, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <errno.h>
+#include <stdint.h>
+#include "field_predicate.h"
+#include "field.h"
+#include "table/string_dict.h"
+
+#define TP(x, y, z) (((x) << 16) + ((y) << 8) + (z))
+#define TC(x, y, z) ((DField::x << 16) + (DField::y << 8) + DField::z)
+
+/* pick the DTCValue overloads out of value.h */
+static const RowPredicate::cmp_fn_t str_eq = string_equal;
+static const RowPredicate::cmp_fn_t str_gt = string_greater;
+static const RowPredicate::cmp_fn_t str_ge = string_greater_equal;
+static const RowPredicate::cmp_fn_t str_lt = string_less;
+static const RowPredicate::cmp_fn_t str_le = string_less_equal;
+static const RowPredicate::cmp_fn_t bin_eq = binary_equal;
+
+static int str_ne(const DTCValue &a, const DTCValue &b)
+{
+	return !string_equal(a, b);
+}
+
+static int bin_ne(const DTCValue &a, const DTCValue &b)
+{
+	return !binary_equal(a, b);
+}
+
+int RowPredicate::add_term(uint8_t id, uint8_t kind, cmp_fn_t cmp,
+			   const DTCValue *val)
+{
+	Term &t = terms[numTerms++];
+	t.id = id;
+	t.kind = kind;
+	t.lo = INT64_MIN;
+	t.hi = INT64_MAX;
+	t.cmp = cmp;
+	t.val = val;
+	return numTerms - 1;
+}
+
+/*
+ * EQ/NE on a dict field, matched on codes when both sides are interned.
+ * cmp is the equality, ncmp its negation for NE on a plain field.
+ */
+int RowPredicate::add_dict(const DTCTableDefinition *t, uint8_t id,
+			   int flags, cmp_fn_t cmp, cmp_fn_t ncmp,
+			   const DTCValue *val)
+{
+	const StringDict *d = t->string_dict();
+
+	if (d == NULL || !t->is_dict(id))
+		return add_term(id, T_CMP, (flags & DICT_NE) ? ncmp : cmp,
+				val);
+
+	Term &r = terms[add_term(id, T_DICT, cmp, val)];
+	r.lo = (flags & DICT_CLASS) ? d->find_class(val->bin.ptr, val->bin.len) :
+				      d->find(val->bin.ptr, val->bin.len);
+	r.hi = flags;
+	return 0;
+}
+
+/* fold EQ/LT/LE/GT/GE on one field into a single range */
+int RowPredicate::add_int(uint8_t id, int op, int64_t v)
+{
+	int i;
+	for (i = 0; i < numTerms; i++)
+		if (terms[i].id == id &&
+		    (terms[i].kind == T_RANGE || terms[i].kind == T_FALSE))
+			break;
+	if (i == numTerms)
+		i = add_term(id, T_RANGE, NULL, NULL);
+
+	Term &t = terms[i];
+	if (t.kind == T_FALSE)
+		return 0;
+
+	switch (op) {
+	case DField::EQ:
+		if (v > t.lo)
+			t.lo = v;
+		if (v < t.hi)
+			t.hi = v;
+		break;
+	case DField::LT:
+		if (v == INT64_MIN) {
+			t.kind = T_FALSE;
+			return 0;
+		}
+		if (v - 1 < t.hi)
+			t.hi = v - 1;
+		break;
+	case DField::LE:
+		if (v < t.hi)
+			t.hi = v;
+		break;
+	case DField::GT:
+		if (v == INT64_MAX) {
+			t.kind = T_FALSE;
+			return 0;
+		}
+		if (v + 1 > t.lo)
+			t.lo = v + 1;
+		break;
+	case DField::GE:
+		if (v > t.lo)
+			t.lo = v;
+		break;
+	}
+	if (t.lo > t.hi)
+		t.kind = T_FALSE;
+	return 0;
+}
+
+int RowPredicate::Compile(const DTCTableDefinition *t,
+			  const DTCFieldValue &cond)
+{
+	const int n = cond.num_fields();
+
+	Reset();
+	if (n > maxTerms) {
+		Term *p = (Term *)REALLOC(terms, n * sizeof(Term));
+		if (p == NULL)
+			return -ENOMEM;
+		terms = p;
+		maxTerms = n;
+	}
+
+	for (int i = 0; i < n; i++) {
+		const int id = cond.field_id(i);
+		if (id < t->key_fields())
+			continue;
+		const DTCValue *v = cond.field_value(i);
+
+		switch (TP(t->field_type(id), cond.field_type(i),
+			   cond.field_operation(i))) {
+		default:
+			add_term(id, T_FALSE, NULL, NULL);
+			break;
+
+		case TC(Signed, Signed, EQ):
+		case TC(Unsigned, Signed, EQ):
+		case TC(Signed, Signed, LT):
+		case TC(Unsigned, Signed, LT):
+		case TC(Signed, Signed, LE):
+		case TC(Unsigned, Signed, LE):
+		case TC(Signed, Signed, GT):
+		case TC(Unsigned, Signed, GT):
+		case TC(Signed, Signed, GE):
+		case TC(Unsigned, Signed, GE):
+			add_int(id, cond.field_operation(i), v->s64);
+			break;
+
+		case TC(Signed, Signed, NE):
+		case TC(Unsigned, Signed, NE):
+			terms[add_term(id, T_NE, NULL, NULL)].lo = v->s64;
+			break;
+
+		/* case insensitive for string comparison */
+		case TC(String, String, EQ):
+			add_dict(t, id, DICT_CLASS, str_eq, str_ne, v);
+			break;
+		case TC(String, String, NE):
+			add_dict(t, id, DICT_CLASS | DICT_NE, str_eq, str_ne,
+				 v);
+			break;
+		case TC(String, String, GT):
+			add_term(id, T_CMP, str_gt, v);
+			break;
+		case TC(String, String, GE):
+			add_term(id, T_CMP, str_ge, v);
+			break;
+		case TC(String, String, LT):
+			add_term(id, T_CMP, str_lt, v);
+			break;
+		case TC(String, String, LE):
+			add_term(id, T_CMP, str_le, v);
+			break;
+
+		/* case sensitive for binary comparison */
+		case TC(Binary, Binary, EQ):
+		case TC(String, Binary, EQ):
+		case TC(Binary, String, EQ):
+			add_dict(t, id, 0, bin_eq, bin_ne, v);
+			break;
+		case TC(Binary, Binary, NE):
+		case TC(String, Binary, NE):
+		case TC(Binary, String, NE):
+			add_dict(t, id, DICT_NE, bin_eq, bin_ne, v);
+			break;
+		}
+	}
+
+	/* stable sort by kind: unsatisfiable, integer, string/binary */
+	for (int i = 1; i < numTerms; i++) {
+		Term x = terms[i];
+		int j = i - 1;
+		for (; j >= 0 && terms[j].kind > x.kind; j--)
+			terms[j + 1] = terms[j];
+		terms[j + 1] = x;
+	}
+
+	tdef = t;
+	return 0;
+}
+
+int RowPredicate::Evaluate(const RowValue &r, int iCmpFirstNRows) const
+{
+	for (int i = 0; i < numTerms; i++) {
+		const Term &t = terms[i];
+		if (t.id > iCmpFirstNRows - 1)
+			continue;
+		const DTCValue &v = r[t.id];
+		switch (t.kind) {
+		case T_RANGE:
+			if (v.s64 < t.lo || v.s64 > t.hi)
+				return 0;
+			break;
+		case T_NE:
+			if (v.s64 == t.lo)
+				return 0;
+			break;
+		case T_DICT: {
+			uint32_t c = 0;
+			if (t.lo != 0)
+				c = (t.hi & DICT_CLASS) ?
+					    tdef->string_dict()->class_of(
+						    v.bin.ptr) :
+					    tdef->string_dict()->code_of(
+						    v.bin.ptr);
+			int eq = c != 0 ? c == (uint64_t)t.lo : !!t.cmp(v, *t.val);
+			if (eq == (t.hi & DICT_NE))
+				return 0;
+			break;
+		}
+		case T_CMP:
+			if (!t.cmp(v, *t.val))
+				return 0;
+			break;
+		default:
+			return 0;
+		}
+	}
+	return 1;
+}
@@ -0,0 +1,98 @@
+/*
+* Copyright [2021] JD.com, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#ifndef __CH_FIELD_PREDICATE_H__
+#define __CH_FIELD_PREDICATE_H__
+
+#include <stdint.h>
+#include "value.h"
+#include "mem_check.h"
+
+class DTCTableDefinition;
+class RowValue;
+class DTCFieldValue;
+
+/*
+ * where condition compiled against one table definition.
+ * type/operator dispatch is resolved once, integer conditions on the same
+ * field are folded into a single [lo, hi] range, and terms are ordered
+ * cheapest first. result is identical to DTCFieldValue's interpretive loop.
+ */
+class RowPredicate {
+    public:
+	typedef int (*cmp_fn_t)(const DTCValue &, const DTCValue &);
+
+	/*
+	 * T_DICT: EQ/NE on a dict field, lo is the code (class for case
+	 * insensitive string) of the condition value, hi bit0 for NE and
+	 * bit1 for class. rows not coded, or lo 0, fall back to cmp.
+	 */
+	enum { T_FALSE = 0, T_RANGE, T_NE, T_DICT, T_CMP };
+	enum { DICT_NE = 1, DICT_CLASS = 2 };
+
+	struct Term {
+		uint8_t id;
+		uint8_t kind;
+		int64_t lo;
+		int64_t hi;
+		cmp_fn_t cmp;
+		const DTCValue *val;
+	};
+
+    private:
+	const DTCTableDefinition *tdef;
+	Term *terms;
+	int numTerms;
+	int maxTerms;
+
+	int add_int(uint8_t id, int op, int64_t v);
+	int add_term(uint8_t id, uint8_t kind, cmp_fn_t cmp,
+		     const DTCValue *val);
+	int add_dict(const DTCTableDefinition *t, uint8_t id, int flags,
+		     cmp_fn_t cmp, cmp_fn_t ncmp, const DTCValue *val);
+
+	RowPredicate(const RowPredicate &);
+	RowPredicate &operator=(const RowPredicate &);
+
+    public:
+	RowPredicate() : tdef(NULL), terms(NULL), numTerms(0), maxTerms(0)
+	{
+	}
+	~RowPredicate()
+	{
+		FREE_IF(terms);
+	}
+
+	void Reset()
+	{
+		tdef = NULL;
+		numTerms = 0;
+	}
+	bool is_compiled_for(const DTCTableDefinition *t) const
+	{
+		return tdef != NULL && tdef == t;
+	}
+	int num_terms(void) const
+	{
+		return numTerms;
+	}
+
+	/* conditions are referenced, not copied; return -ENOMEM on failure */
+	int Compile(const DTCTableDefinition *t, const DTCFieldValue &cond);
+
+	int Evaluate(const RowValue &r, int iCmpFirstNRows) const;
+};
+
+#endif
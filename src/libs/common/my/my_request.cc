@@ -13,6 +13,8 @@
 * See the License for the specific language governing permissions and
 * limitations under the License.
 */
+#include <strings.h>
+#include <ctype.h>
 #include "../log/log.h"
 #include "my_request.h"
 #include "my_command.h"
@@ -375,13 +377,114 @@ std::vector<std::string> MyRequest::get_need_array()
 	else
 	{
 		for (int i = 0; i < stmt->selectList->size(); i++) {
-			need.push_back(stmt->selectList->at(i)->getName());
+			hsql::Expr *e = stmt->selectList->at(i);
+			// aggregate needs its argument, "*" for COUNT(*)
+			if (e->type == kExprFunctionRef && e->exprList &&
+			    e->exprList->size() == 1) {
+				e = e->exprList->at(0);
+				need.push_back(e->type == kExprStar ? "*" :
+								      e->getName());
+			} else {
+				need.push_back(e->getName());
+			}
 		}
 	}
 
 	return need;
 }
 
+static uint8_t aggregate_func(const char *name)
+{
+	if (name == NULL)
+		return DField::None;
+	if (strcasecmp(name, "count") == 0)
+		return DField::Count;
+	if (strcasecmp(name, "sum") == 0)
+		return DField::Sum;
+	if (strcasecmp(name, "min") == 0)
+		return DField::Min;
+	if (strcasecmp(name, "max") == 0)
+		return DField::Max;
+	return DField::None;
+}
+
+/*
+ * aggregate function of every select item, DField::None for plain columns.
+ * funcs is left empty if no aggregate selected.
+ * return -1 on GROUP BY, or if the select list is not an aggregate dtc
+ * can push down.
+ */
+int MyRequest::get_aggregate_array(std::vector<uint8_t> &funcs)
+{
+	funcs.clear();
+	int t = m_result.getStatement(0)->type();
+	if (t != hsql::StatementType::kStmtSelect)
+		return 0;
+
+	hsql::SelectStatement *stmt = 
+		const_cast<hsql::SelectStatement*>(
+			static_cast<const hsql::SelectStatement*>(get_result()->getStatement(0)));
+	std::vector<hsql::Expr *> *selectList = stmt->selectList;
+	bool found = false;
+
+	/* rows are not grouped, with or without an aggregate */
+	if (stmt->groupBy != NULL) {
+		log4cplus_debug("group by is not supported");
+		return -1;
+	}
+
+	for (int i = 0; i < selectList->size(); i++) {
+		hsql::Expr *e = selectList->at(i);
+		if (e->type != kExprFunctionRef) {
+			funcs.push_back(DField::None);
+			continue;
+		}
+
+		uint8_t f = aggregate_func(e->name);
+		if (f == DField::None || e->distinct || e->exprList == NULL ||
+		    e->exprList->size() != 1) {
+			log4cplus_debug("unsupported function: %s", e->name);
+			return -1;
+		}
+		hsql::Expr *arg = e->exprList->at(0);
+		if (arg->type == kExprStar ? f != DField::Count :
+					     arg->type != kExprColumnRef) {
+			log4cplus_debug("unsupported argument of: %s", e->name);
+			return -1;
+		}
+		funcs.push_back(f);
+		found = true;
+	}
+
+	if (!found)
+		funcs.clear();
+	return 0;
+}
+
+// column name of select item i in the result set
+std::string MyRequest::get_select_label(int i)
+{
+	hsql::SelectStatement *stmt = 
+		const_cast<hsql::SelectStatement*>(
+			static_cast<const hsql::SelectStatement*>(get_result()->getStatement(0)));
+	hsql::Expr *e = stmt->selectList->at(i);
+
+	if (e->hasAlias())
+		return e->alias;
+	if (e->type != kExprFunctionRef || e->exprList == NULL ||
+	    e->exprList->size() != 1)
+		return e->getName();
+
+	std::string label = e->name;
+	hsql::Expr *arg = e->exprList->at(0);
+	for (int j = 0; j < label.size(); j++)
+		label[j] = toupper(label[j]);
+	label += "(";
+	label += arg->type == kExprStar ? "*" : arg->getName();
+	label += ")";
+	return label;
+}
+
 char* MyRequest::get_table_name()
 {
 	if (m_result.size() < 1)
@@ -115,6 +115,8 @@ class MyRequest {
 	uint32_t get_limit_count();
 	uint32_t get_need_num_fields();
 	std::vector<std::string> get_need_array();
+	int get_aggregate_array(std::vector<uint8_t> &funcs);
+	std::string get_select_label(int i);
 
 	uint32_t get_update_num_fields();
 
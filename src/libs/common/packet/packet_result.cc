@@ -27,6 +27,7 @@ ResultWriter::ResultWriter(const DTCFieldSet *fs, unsigned int st,
 	fieldSet = nf ? fs : NULL;
 	totalRows = 0;
 	numRows = 0;
+	aggregate = NULL;
 }
 
 int ResultWriter::set_rows(unsigned int rows)
@@ -130,10 +131,37 @@ static int expand(BufferChain *&bc, int addsize)
 	return -1;
 }
 
+int ResultWriter::finish_aggregate(void)
+{
+	if (aggregate == NULL)
+		return 0;
+
+	RowAggregate *a = aggregate;
+	aggregate = NULL;
+	try {
+		RowValue r(const_cast<DTCTableDefinition *>(
+			a->table_definition()));
+		a->Output(r);
+		int ret = append_row(r);
+		if (ret < 0)
+			return ret;
+	} catch (const std::bad_alloc &) {
+		return -ENOMEM;
+	}
+	/* one row back, total rows is the COUNT */
+	totalRows = a->num_rows();
+	numRows = 1;
+	return 0;
+}
+
 int ResultPacket::append_row(const RowValue &r)
 {
 	log4cplus_debug("append_row entry.");
 	int ret = 0;
+	if (aggregate) {
+		totalRows++;
+		return aggregate->Add(r) < 0 ? -ENOMEM : 1;
+	}
 	totalRows++;
 	if (limitNext > 0) {
 		if (totalRows <= limitStart || totalRows > limitNext)
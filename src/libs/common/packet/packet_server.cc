@@ -859,19 +859,29 @@ BufferChain *encode_field_def(DtcJob *job, BufferChain *bc, uint8_t& pkt_num)
 	BufferChain *nbc = bc;
 	BufferChain *r = NULL;
 	std::vector<std::string> need = job->mr.get_need_array();
+	std::vector<uint8_t> aggr;
+	job->mr.get_aggregate_array(aggr);
 
 	for (int i = 0; i < need.size(); i++) {
 		my_result_set_field sf;
-		sf.type = build_field_type(
-			job->field_type(job->field_id(need[i].c_str())));
+		if (i < aggr.size() && aggr[i] == DField::Count)
+			sf.type = build_field_type(DField::Signed);
+		else
+			sf.type = build_field_type(job->field_type(
+				job->field_id(need[i].c_str())));
 		sf.charset_number = build_charset(sf.type);
 		sf.database = "dtc";
 		sf.length = build_length(sf.type);
 		sf.catalog = "def";
 		sf.table = job->table_name();
 		sf.original_table = job->table_name();
-		sf.name = need[i];
-		sf.original_name = need[i];
+		if (i < aggr.size() && aggr[i] != DField::None) {
+			sf.name = job->mr.get_select_label(i);
+			sf.original_name = sf.name;
+		} else {
+			sf.name = need[i];
+			sf.original_name = need[i];
+		}
 		sf.decimals = 0x00;
 		sf.flags = 0x0;
 		sf.reverse = 0x0000;
@@ -987,6 +997,10 @@ BufferChain *encode_row_data(DtcJob *job, BufferChain *bc, uint8_t &pkt_nr)
 	BufferChain *nbc = bc;
 	std::vector<std::string> result_field = job->mr.get_need_array();
 	const DTCTableDefinition *tdef = job->table_definition();
+	std::vector<uint8_t> aggr;
+	job->mr.get_aggregate_array(aggr);
+	// COUNT() of aggregated result is its total rows
+	DTCValue rows = DTCValue::Make((int64_t)job->resultInfo.total_rows());
 
 	if (pstResultSet == NULL)
 		return NULL;
@@ -1004,12 +1018,21 @@ BufferChain *encode_row_data(DtcJob *job, BufferChain *bc, uint8_t &pkt_nr)
 		for (int j = 0; j < result_field.size(); j++) {
 			int id = tdef->field_id(result_field[j].c_str());
 			DTCValue* v;
-			if (0 == id) {
-				v = const_cast<DTCValue*>(job->request_key());
+			int field_type;
+			if (j < aggr.size() && aggr[j] == DField::Count) {
+				v = &rows;
+				field_type = DField::Signed;
 			} else {
-				v = pstRow->field_value(id);
+				if (0 == id) {
+					v = const_cast<DTCValue*>(job->request_key());
+				} else {
+					v = pstRow->field_value(id);
+				}
+				field_type = pstRow->field_type(id);
 			}
-			int field_type = pstRow->field_type(id);
+			if (j < aggr.size() &&
+			    RowAggregate::is_null(aggr[j], rows.s64))
+				field_type = DField::None;
 			switch (field_type) {
 			case DField::Signed: {
 				row_len++; //first byte for result len
@@ -1037,6 +1060,9 @@ BufferChain *encode_row_data(DtcJob *job, BufferChain *bc, uint8_t &pkt_nr)
 				row_len += v->str.len;
 				break;
 			}
+			case DField::None:
+				row_len++; // 0xfb, NULL
+				break;
 			default:
 				break;
 			}
@@ -1062,12 +1088,21 @@ BufferChain *encode_row_data(DtcJob *job, BufferChain *bc, uint8_t &pkt_nr)
 		for (int j = 0; j < result_field.size(); j++) {
 			int id = tdef->field_id(result_field[j].c_str());
 			DTCValue* v;
-			if (0 == id) {
-				v = const_cast<DTCValue*>(job->request_key());
+			int field_type;
+			if (j < aggr.size() && aggr[j] == DField::Count) {
+				v = &rows;
+				field_type = DField::Signed;
 			} else {
-				v = pstRow->field_value(id);
+				if (0 == id) {
+					v = const_cast<DTCValue*>(job->request_key());
+				} else {
+					v = pstRow->field_value(id);
+				}
+				field_type = pstRow->field_type(id);
 			}
-			int field_type = pstRow->field_type(id);
+			if (j < aggr.size() &&
+			    RowAggregate::is_null(aggr[j], rows.s64))
+				field_type = DField::None;
 			int num_len = 0;
 			switch (field_type) {
 			case DField::Signed: {
@@ -1113,6 +1148,10 @@ BufferChain *encode_row_data(DtcJob *job, BufferChain *bc, uint8_t &pkt_nr)
 				offset += v->bin.len;
 				break;
 			}
+			case DField::None:
+				*(r + offset) = (char)0xfb;
+				offset++;
+				break;
 			default:
 				break;
 			}
@@ -1717,6 +1756,7 @@ int Packet::encode_result_mysql(DtcJob &job, int mtu, uint32_t ts)
 int Packet::encode_result(DTCJobOperation &job, int mtu)
 {
 	log4cplus_debug("encode_result entry.");
+	job.finish_aggregate();
 	if (1 == job.get_pac_version()) {
 		return encode_result((DtcJob &)job, mtu, job.Timestamp());
 	} else if (2 == job.get_pac_version()) {
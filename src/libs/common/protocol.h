@@ -39,6 +39,8 @@ class DField {
 	       GT = 4,
 	       GE = 5,
 	       TotalComparison };
+
+	enum { Count = 1, Sum = 2, Min = 3, Max = 4, TotalAggregate };
 };
 
 class DRequest {
@@ -121,6 +123,7 @@ class DRequest {
 			ColExpandDone = 26,
 			ColExpandKey = 27,
 			Cascade = 28,
+			ScanKeyRange = 29,
 		};
 	};
 };
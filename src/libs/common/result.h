@@ -153,6 +153,8 @@ class ResultWriter {
 	unsigned int limitStart, limitNext;
 	unsigned int totalRows;
 	unsigned int numRows;
+	/* rows are folded into it instead of written, if set */
+	RowAggregate *aggregate;
 
 	ResultWriter(const DTCFieldSet *, unsigned int, unsigned int);
 	virtual ~ResultWriter(void)
@@ -163,6 +165,7 @@ class ResultWriter {
 	{
 		totalRows = 0;
 		numRows = 0;
+		aggregate = NULL;
 	}
 	virtual void detach_result() = 0;
 	inline virtual int Set(const DTCFieldSet *fs, unsigned int st,
@@ -181,6 +184,12 @@ class ResultWriter {
 	virtual int merge_no_limit(const ResultWriter *rp) = 0;
 
 	int set_rows(unsigned int rows);
+	void set_aggregate(RowAggregate *a)
+	{
+		aggregate = a;
+	}
+	// write the aggregated row, the aggregate is detached afterwards
+	int finish_aggregate(void);
 	void set_total_rows(unsigned int totalrows)
 	{
 		totalRows = totalrows;
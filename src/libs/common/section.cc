@@ -53,10 +53,10 @@ const SectionDefinition versionInfoDefinition = {
 
 const SectionDefinition requestInfoDefinition = {
 	DRequest::Section::VersionInfo,
-	8,
+	9,
 	{
-#if MAX_STATIC_SECTION >= 1 && MAX_STATIC_SECTION < 8
-#error MAX_STATIC_SECTION must >= 8
+#if MAX_STATIC_SECTION >= 1 && MAX_STATIC_SECTION < 9
+#error MAX_STATIC_SECTION must >= 9
 #endif
 		// request info:
 		DField::Binary, // 0 -- key
@@ -67,6 +67,7 @@ const SectionDefinition requestInfoDefinition = {
 		DField::Unsigned, // 5 -- Cache ID -- OBSOLETED
 		DField::String, // 6 -- raw config string
 		DField::Unsigned, // 7 -- admin cmd code
+		DField::Binary, // 8 -- aggregate, pairs of field id and function
 	}
 };
 
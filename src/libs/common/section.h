@@ -150,6 +150,14 @@ class SimpleSection {
 		}
 	}
 
+	void clear_tag(uint8_t id)
+	{
+		if (tag_present(id)) {
+			numTags--;
+			FIELD_CLR(id, fieldMask);
+		}
+	}
+
 	/* no check of dumplicate tag */
 	void SetTagMask(uint8_t id)
 	{
@@ -418,6 +426,19 @@ class DTCRequestInfo : public SimpleSection {
 	{
 		set_tag(7, (uint64_t)code);
 	}
+
+	const DTCValue *aggregate(void) const
+	{
+		return get_tag(8);
+	}
+	void set_aggregate(const char *spec, int len)
+	{
+		set_tag(8, spec, len);
+	}
+	void clear_aggregate(void)
+	{
+		clear_tag(8);
+	}
 };
 
 class DTCResultInfo : public SimpleSection {
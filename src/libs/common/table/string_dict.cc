@@ -0,0 +1,115 @@
+/*
+* Copyright [2021] JD.com, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <string.h>
+#include "string_dict.h"
+#include "value.h"
+
+/*
+ * values of one class must share a bucket: case insensitive, and stop at
+ * '\0' like mystrcmp does
+ */
+static uint32_t dict_hash(const char *s, int len)
+{
+	uint32_t h = 2166136261u ^ len;
+	for (int i = 0; i < len && s[i] != '\0'; i++)
+		h = (h ^ (unsigned char)INTERNAL_TO_LOWER(s[i])) * 16777619u;
+	return h % STRING_DICT_BUCKETS;
+}
+
+void StringDict::format(void *region)
+{
+	info_ = (STRING_DICT_INFO_T *)region;
+	memset(info_, 0, offsetof(STRING_DICT_INFO_T, sd_arena));
+	info_->sd_magic = STRING_DICT_MAGIC;
+}
+
+int StringDict::attach(void *region)
+{
+	STRING_DICT_INFO_T *p = (STRING_DICT_INFO_T *)region;
+	if (p == NULL || p->sd_magic != STRING_DICT_MAGIC)
+		return -1;
+	info_ = p;
+	return 0;
+}
+
+/* exact match, or the first value equal ignoring case */
+const STRING_DICT_ENTRY_T *StringDict::search(const char *s, int len,
+					      bool exact,
+					      uint32_t &bucket) const
+{
+	bucket = dict_hash(s, len);
+	for (uint32_t c = info_->sd_bucket[bucket]; c != 0;) {
+		const STRING_DICT_ENTRY_T *e = entry(c);
+		if (e->sd_len == len &&
+		    (exact ? !memcmp(e->sd_str, s, len) :
+			     !mystrcmp(e->sd_str, s, len)))
+			return e;
+		c = e->sd_next;
+	}
+	return NULL;
+}
+
+uint32_t StringDict::find(const char *s, int len) const
+{
+	uint32_t b;
+	if (len < 0 || len > STRING_DICT_MAX_LEN)
+		return 0;
+	const STRING_DICT_ENTRY_T *e = search(s, len, true, b);
+	return e ? e->sd_code : 0;
+}
+
+uint32_t StringDict::find_class(const char *s, int len) const
+{
+	uint32_t b;
+	if (len < 0 || len > STRING_DICT_MAX_LEN)
+		return 0;
+	const STRING_DICT_ENTRY_T *e = search(s, len, false, b);
+	return e ? e->sd_class : 0;
+}
+
+uint32_t StringDict::intern(const char *s, int len)
+{
+	uint32_t b;
+	if (len < 0 || len > STRING_DICT_MAX_LEN)
+		return 0;
+	const STRING_DICT_ENTRY_T *e = search(s, len, true, b);
+	if (e != NULL)
+		return e->sd_code;
+
+	uint32_t size = sizeof(STRING_DICT_ENTRY_T) + len + 1;
+	if (info_->sd_count >= STRING_DICT_MAX_CODES ||
+	    info_->sd_used + size > STRING_DICT_ARENA_SIZE)
+		return 0;
+
+	/* class before linking, a new value is its own class */
+	const STRING_DICT_ENTRY_T *k = search(s, len, false, b);
+	uint32_t code = info_->sd_count + 1;
+	STRING_DICT_ENTRY_T *n =
+		(STRING_DICT_ENTRY_T *)(info_->sd_arena + info_->sd_used);
+	n->sd_next = info_->sd_bucket[b];
+	n->sd_class = k ? k->sd_class : code;
+	n->sd_code = code;
+	n->sd_len = len;
+	memcpy(n->sd_str, s, len);
+	n->sd_str[len] = '\0';
+
+	/* publish after the entry is complete */
+	info_->sd_offset[code] = info_->sd_used;
+	info_->sd_used += size;
+	info_->sd_bucket[b] = code;
+	info_->sd_count = code;
+	return code;
+}
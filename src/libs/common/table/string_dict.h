@@ -0,0 +1,136 @@
+/*
+* Copyright [2021] JD.com, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#ifndef __DTC_STRING_DICT_H__
+#define __DTC_STRING_DICT_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define STRING_DICT_MAGIC 0x44494354 /* "DICT" */
+#define STRING_DICT_MAX_CODES 65535
+#define STRING_DICT_BUCKETS 16384
+#define STRING_DICT_ARENA_SIZE (1024 * 1024)
+#define STRING_DICT_MAX_LEN 255
+
+struct string_dict_entry {
+	uint16_t sd_next; // next code in the same bucket, 0: end
+	uint16_t sd_class; // first code equal to this one ignoring case
+	uint16_t sd_code;
+	uint8_t sd_len;
+	char sd_str[0]; // sd_len bytes and a '\0'
+} __attribute__((packed));
+typedef struct string_dict_entry STRING_DICT_ENTRY_T;
+
+struct string_dict_info {
+	uint32_t sd_magic;
+	uint32_t sd_count; // codes in use, code 0 is never used
+	uint32_t sd_used; // bytes used in arena
+	uint32_t sd_reserve;
+	uint64_t sd_saved; // row bytes saved by storing codes
+	uint16_t sd_bucket[STRING_DICT_BUCKETS];
+	uint32_t sd_offset[STRING_DICT_MAX_CODES + 1];
+	char sd_arena[STRING_DICT_ARENA_SIZE];
+};
+typedef struct string_dict_info STRING_DICT_INFO_T;
+
+/*
+ * append-only dictionary of the values of the dict fields of a table, laid
+ * out in one caller provided region so it can live in shared memory.
+ * codes and the value pointers handed out never move, rows keep the code
+ * and decoding only points into the arena.
+ * every value also has a class, the same for all values equal ignoring
+ * case, so string conditions can be matched on codes too.
+ */
+class StringDict {
+    public:
+	StringDict() : info_(NULL)
+	{
+	}
+
+	static size_t region_size(void)
+	{
+		return sizeof(STRING_DICT_INFO_T);
+	}
+	void format(void *region);
+	/* return -1 if region is not a dictionary */
+	int attach(void *region);
+	void detach(void)
+	{
+		info_ = NULL;
+	}
+
+	/* code of the value, added if missing; 0 if too long or full */
+	uint32_t intern(const char *s, int len);
+	/* 0 if not in dictionary */
+	uint32_t find(const char *s, int len) const;
+	uint32_t find_class(const char *s, int len) const;
+
+	/* NULL if code is invalid */
+	const char *lookup(uint32_t code, int &len) const
+	{
+		if (code == 0 || code > info_->sd_count)
+			return NULL;
+		const STRING_DICT_ENTRY_T *e = entry(code);
+		len = e->sd_len;
+		return e->sd_str;
+	}
+	/* code/class of a value pointer from lookup(), 0 if not from it */
+	uint32_t code_of(const char *p) const
+	{
+		if (p < info_->sd_arena + sizeof(STRING_DICT_ENTRY_T) ||
+		    p >= info_->sd_arena + info_->sd_used)
+			return 0;
+		return ((const STRING_DICT_ENTRY_T *)p - 1)->sd_code;
+	}
+	uint32_t class_of(const char *p) const
+	{
+		if (p < info_->sd_arena + sizeof(STRING_DICT_ENTRY_T) ||
+		    p >= info_->sd_arena + info_->sd_used)
+			return 0;
+		return ((const STRING_DICT_ENTRY_T *)p - 1)->sd_class;
+	}
+
+	uint32_t entries(void) const
+	{
+		return info_->sd_count;
+	}
+	uint32_t bytes(void) const
+	{
+		return info_->sd_used;
+	}
+	uint64_t saved(void) const
+	{
+		return info_->sd_saved;
+	}
+	void add_saved(int64_t n)
+	{
+		info_->sd_saved += n;
+	}
+
+    private:
+	STRING_DICT_ENTRY_T *entry(uint32_t code) const
+	{
+		return (STRING_DICT_ENTRY_T *)(info_->sd_arena +
+					       info_->sd_offset[code]);
+	}
+	const STRING_DICT_ENTRY_T *search(const char *s, int len, bool exact,
+					  uint32_t &bucket) const;
+
+    private:
+	STRING_DICT_INFO_T *info_;
+};
+
+#endif
@@ -74,7 +74,11 @@ DTCTableDefinition::DTCTableDefinition(int m)
 		keyFormat = 0;
 		m_row_size = 0;
 		hasDiscard = 0;
+		hasDict = 0;
+		stringDict = NULL;
 		indexFields = 0; // by TREE_DATA
+		indexEngine = INDEX_ENGINE_TTREE;
+		rowFormat = ROW_FORMAT_PLAIN;
 		maxKeySize = 0;
 	} else {
 		// client side code
@@ -92,6 +96,8 @@ DTCTableDefinition::DTCTableDefinition(int m)
 		//	 keyFormat
 		//	 m_row_size
 		//	 indexFields
+		//	 indexEngine
+		//	 rowFormat
 		// because client side don't use it, and save a lot of CPU cycle
 	}
 }
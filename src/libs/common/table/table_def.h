@@ -28,13 +28,15 @@ struct FieldDefinition {
 	enum { FF_READONLY = 1,
 	       FF_VOLATILE = 2,
 	       FF_DISCARD = 4,
+	       FF_SUMMARY = 8,
 	       FF_DESC = 0x10,
 	       FF_TIMESTAMP = 0x20,
 		   FF_HAS_DEFAULT = 0x40,
-		   FF_NULLABLE = 0x80
+		   FF_NULLABLE = 0x80,
+	       FF_DICT = 0x100
 	};
 
-	typedef uint8_t fieldflag_t;
+	typedef uint16_t fieldflag_t;
 
     public:
 	char *fieldName;
@@ -49,6 +51,8 @@ struct FieldDefinition {
 	uint16_t next;
 };
 
+class StringDict;
+
 extern const SectionDefinition tableAttributeDefinition;
 
 class TableAttribute : public SimpleSection {
@@ -103,6 +107,19 @@ class TableAttribute : public SimpleSection {
 		set_tag(1, get_tag(1) ? (get_tag(1)->u64 & tmp) : tmp);
 	}
 };
+// index engine of TREE_DATA nodes
+enum { INDEX_ENGINE_TTREE = 0,
+       INDEX_ENGINE_BTREE = 1, // integer index field only
+};
+
+// row encoding of new RAW_DATA nodes, old nodes keep their own
+enum { ROW_FORMAT_PLAIN = 0, // integers at declared size
+       ROW_FORMAT_PACKED = 1, // varint integers and lengths
+};
+
+// max integer fields with per-node min/max summary in RAW_DATA nodes
+#define MAX_SUMMARY_FIELDS 4
+
 // dbconfig field statistics
 class DTCTableDefinition {
     private:
@@ -138,7 +155,11 @@ class DTCTableDefinition {
 	int16_t hasExpireTime;
 	uint8_t keyFormat; // 0:varsize, 1-255:fixed, large than 255 is invalid
 	uint8_t hasDiscard;
+	uint8_t hasDict;
+	StringDict *stringDict; // shared dictionary of the dict fields, NULL if none
 	int8_t indexFields; // TREE_DATA, disabled in this release
+	uint8_t indexEngine; // INDEX_ENGINE_*
+	uint8_t rowFormat; // ROW_FORMAT_*
 	uint8_t uniqFieldCnt; //the size of uniqFields member
 	uint8_t keysAsUniqField; /* 0 == NO, 1 == EXACT, 2 == SUBSET */
 
@@ -266,10 +287,18 @@ class DTCTableDefinition {
 	{
 		return fieldList[n].flags & FieldDefinition::FF_DESC;
 	}
+	int is_summary(int n) const
+	{
+		return fieldList[n].flags & FieldDefinition::FF_SUMMARY;
+	}
 	int is_timestamp(int n) const
 	{
 		return fieldList[n].flags & FieldDefinition::FF_TIMESTAMP;
 	}
+	int is_dict(int n) const
+	{
+		return fieldList[n].flags & FieldDefinition::FF_DICT;
+	}
 
 	int is_single_row(void) const
 	{
@@ -388,6 +417,18 @@ class DTCTableDefinition {
 	{
 		return hasDiscard;
 	}
+	int has_dict(void) const
+	{
+		return hasDict;
+	}
+	StringDict *string_dict(void) const
+	{
+		return stringDict;
+	}
+	void set_string_dict(StringDict *d)
+	{
+		stringDict = d;
+	}
 	int has_auto_increment(void) const
 	{
 		return hasAutoInc >= 0;
@@ -435,6 +476,15 @@ class DTCTableDefinition {
 		fieldList[n].flags |= FieldDefinition::FF_DISCARD;
 		hasDiscard = 1;
 	}
+	void mark_as_summary(int n)
+	{
+		fieldList[n].flags |= FieldDefinition::FF_SUMMARY;
+	}
+	void mark_as_dict(int n)
+	{
+		fieldList[n].flags |= FieldDefinition::FF_DICT;
+		hasDict = 1;
+	}
 	void mark_order_desc(int n)
 	{
 		fieldList[n].flags |= FieldDefinition::FF_DESC;
@@ -479,6 +529,22 @@ class DTCTableDefinition {
 	{
 		indexFields = n;
 	}
+	int index_engine() const
+	{
+		return indexEngine;
+	}
+	void set_index_engine(int n)
+	{
+		indexEngine = n;
+	}
+	int row_format() const
+	{
+		return rowFormat;
+	}
+	void set_row_format(int n)
+	{
+		rowFormat = n;
+	}
 
 	int set_key_fields(int n = 1);
 	// 0: string or binary
@@ -29,6 +29,7 @@ TableDefinitionManager::TableDefinitionManager()
 	, _table(NULL)
 	, _dbconfig(NULL)
 	, _save_dbconfig(NULL)
+	, _dict(NULL)
 {
 	_cur = 0;
 	_new = 0;
@@ -48,6 +49,7 @@ bool TableDefinitionManager::set_new_table_def(DTCTableDefinition *t, int idx)
 	DEC_DELETE(_def[_new % 2]);
 	_def[_new % 2] = t;
 	_def[_new % 2]->increase();
+	_def[_new % 2]->set_string_dict(_dict);
 	return true;
 }
 
@@ -57,9 +59,20 @@ bool TableDefinitionManager::set_cur_table_def(DTCTableDefinition *t, int idx)
 	DEC_DELETE(_def[_cur % 2]);
 	_def[_cur % 2] = t;
 	_def[_cur % 2]->increase();
+	_def[_cur % 2]->set_string_dict(_dict);
 	return true;
 }
 
+void TableDefinitionManager::set_string_dict(StringDict *d)
+{
+	_dict = d;
+	for (int i = 0; i < 2; i++)
+		if (_def[i] != NULL)
+			_def[i]->set_string_dict(d);
+	if (_table != NULL)
+		_table->set_string_dict(d);
+}
+
 bool TableDefinitionManager::renew_cur_table_def()
 {
 	_cur = _new;
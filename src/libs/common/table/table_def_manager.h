@@ -37,6 +37,12 @@ class TableDefinitionManager {
 	bool set_new_table_def(DTCTableDefinition *t, int idx);
 	bool set_cur_table_def(DTCTableDefinition *t, int idx);
 	bool renew_cur_table_def();
+	// shared dictionary of dict fields, applied to current and new table defs
+	void set_string_dict(StringDict *d);
+	StringDict *get_string_dict() const
+	{
+		return _dict;
+	}
 	bool save_new_table_conf();
 
 	DTCTableDefinition *get_cur_table_def();
@@ -70,6 +76,7 @@ class TableDefinitionManager {
 	DTCTableDefinition *_table;
 	DbConfig *_dbconfig;
 	DbConfig *_save_dbconfig;
+	StringDict *_dict;
 };
 
 #endif
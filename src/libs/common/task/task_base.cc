@@ -205,6 +205,14 @@ int8_t DtcJob::select_version(const char *packetIn, int packetLen)
 	return -3;
 }
 
+// message of a decode_request_v2() error, sent back to the client
+static const char *decode_error_msg(int ret)
+{
+	if (ret == -5)
+		return "dtc unsupported: GROUP BY or this aggregate.";
+	return "dtc syntax error: unexpected identifier.";
+}
+
 void DtcJob::decode_mysql_packet(const char *packetIn, int packetLen, int type)
 {
 	if(_client_owner == NULL)
@@ -259,7 +267,7 @@ void DtcJob::decode_mysql_packet(const char *packetIn, int packetLen, int type)
 		{
 			log4cplus_error("decode request error: %d", ret);
 			mr.set_mr_invalid();
-			mr.set_mr_msg("dtc syntax error: unexpected identifier.");
+			mr.set_mr_msg(decode_error_msg(ret));
 			stage = DecodeStageDataError;
 			return;
 		}
@@ -326,7 +334,7 @@ void DtcJob::decode_packet_v2(char *packetIn, int packetLen, int type)
 	{
 		log4cplus_error("decode request error: %d", ret);
 		mr.set_mr_invalid();
-		mr.set_mr_msg("dtc syntax error: unexpected identifier.");
+		mr.set_mr_msg(decode_error_msg(ret));
 		stage = DecodeStageDataError;
 		return;
 	}
@@ -654,6 +662,11 @@ int DtcJob::decode_request_v2(MyRequest *mr)
 	}
 
 	//3.fieldList(Need)
+	std::vector<uint8_t> aggr;
+	if (mr->get_aggregate_array(aggr) < 0) {
+		log4cplus_error("unsupported aggregate");
+		return -5;
+	}
 	if (mr->get_need_num_fields() > 0) {
 		FieldSetByName fs;
 		std::vector<std::string> need = mr->get_need_array();
@@ -663,7 +676,11 @@ int DtcJob::decode_request_v2(MyRequest *mr)
 			return -2;
 		}
 		for (int i = 0; i < need.size(); i++) {
-			fs.add_field(need[i].c_str(), i);
+			// COUNT(*) reads no field, the key is always there
+			if (need[i] == "*")
+				fs.add_field(table_definition()->key_name(), i);
+			else
+				fs.add_field(need[i].c_str(), i);
 		}
 		if (!fs.Solved())
 			fs.Resolve(TableDefinitionManager::instance()
@@ -674,6 +691,31 @@ int DtcJob::decode_request_v2(MyRequest *mr)
 		fieldList->Copy(fs); // never failed
 	}
 
+	//aggregate, pairs of field id and function
+	if (aggr.size() > 0) {
+		std::vector<char> spec;
+		std::vector<std::string> need = mr->get_need_array();
+		for (int i = 0; i < aggr.size(); i++) {
+			if (aggr[i] == DField::None)
+				continue;
+			int id = need[i] == "*" ? 0 :
+				table_definition()->field_id(need[i].c_str());
+			if (id < 0) {
+				log4cplus_error("aggregate field error: %s",
+						need[i].c_str());
+				return -2;
+			}
+			spec.push_back(id);
+			spec.push_back(aggr[i]);
+		}
+		requestInfo.set_aggregate(spec.data(), spec.size());
+		int err = decode_aggregate();
+		if (err) {
+			log4cplus_error("decode aggregate error: %d", err);
+			return -5;
+		}
+	}
+
 	//4.conditionInfo(where)
 	std::vector<hsql::Expr *> exprList;
 
@@ -1206,6 +1248,13 @@ void DtcJob::decode_request_v1(DTC_HEADER_V1 &header, char *p)
 				"decode field set error: %d", err);
 	}
 
+	if (role == TaskRoleServer) {
+		err = decode_aggregate();
+		if (err)
+			ERR_RET("decode aggregate error",
+				"decode aggregate error: %d", err);
+	}
+
 	//DTCResultSet
 	p += header.len[id++];
 
@@ -1228,6 +1277,38 @@ error:
 	stage = DecodeStageDataError;
 }
 
+/*
+ * aggregate is evaluated here, against cached rows or rows fetched by
+ * helper, the request sent to helper never carries it.
+ */
+int DtcJob::decode_aggregate(void)
+{
+	const DTCValue *v = requestInfo.aggregate();
+	if (v == NULL)
+		return 0;
+
+	DTCBinary spec = v->bin;
+	requestInfo.clear_aggregate();
+	if (requestCode != DRequest::Get)
+		return -EC_BAD_COMMAND;
+	if (requestFlags & DRequest::Flag::MultiKeyValue)
+		return -EC_BAD_MULTIKEY;
+	if (fieldList == NULL)
+		return -EC_BAD_FIELD_ID;
+
+	int err = aggregate.Compile(table_definition(), *fieldList, spec.ptr,
+				    spec.len);
+	if (err)
+		return err;
+
+	/* LIMIT applies to the single aggregated row */
+	if (requestInfo.limit_count()) {
+		requestInfo.set_limit_start(0);
+		requestInfo.set_limit_count(0);
+	}
+	return 0;
+}
+
 int DtcJob::decode_field_set(char *d, int l)
 {
 	uint8_t mask[32];
@@ -161,6 +161,7 @@ class DtcJob : public TableReference {
 	DTCFieldValue *updateInfo;
 	DTCFieldValue *conditionInfo;
 	DTCFieldSet *fieldList;
+	RowAggregate aggregate;
 
     public:
 	ResultSet *result;
@@ -207,6 +208,7 @@ class DtcJob : public TableReference {
 	int decode_request_v2(MyRequest *mr);
 	int decode_field_value(char *d, int l, int m);
 	int decode_field_set(char *d, int l);
+	int decode_aggregate(void);
 
     private:
 	int8_t select_version(const char *packetIn, int packetLen);
@@ -262,6 +264,7 @@ class DtcJob : public TableReference {
 			conditionInfo->Clean();
 		if (fieldList)
 			fieldList->Clean();
+		aggregate.Reset();
 		if (result)
 			result->Clean();
 		versionInfo.Clean();
@@ -598,6 +601,11 @@ class DtcJob : public TableReference {
 	{
 		return fieldList == NULL;
 	}
+	// rows are aggregated into one result row
+	int has_aggregate(void) const
+	{
+		return aggregate.is_active();
+	}
 	// this is non-contional request
 	void clear_all_rows(void)
 	{
@@ -677,6 +685,8 @@ class DtcJob : public TableReference {
 	int pass_all_result(ResultSet *rs);
 	// Merge all row from sub-job
 	int merge_result(const DtcJob &job);
+	// Write the aggregated row, before encoding the result
+	int finish_aggregate(void);
 	// Get Encoded Result Packet
 	ResultPacket *get_result_packet(void) const
 	{
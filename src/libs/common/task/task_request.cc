@@ -30,6 +30,7 @@
 DTCJobOperation::~DTCJobOperation()
 {
 	free_packed_key();
+	DELETE(row_source);
 
 	if (agent_multi_req) {
 		delete agent_multi_req;
@@ -50,6 +51,7 @@ void DTCJobOperation::Clean()
 	expire_time = 0;
 	keyList = NULL;
 	batch_key = NULL;
+	DELETE(row_source);
 	DtcJob::Clean();
 	TaskOwnerInfo::Clean();
 }
@@ -522,3 +524,16 @@ void DTCJobOperation::copy_reply_for_agent_sub_task()
 {
 	agent_multi_req->copy_reply_for_sub_task();
 }
+
+int DTCJobOperation::fill_row_source(void)
+{
+	if (row_source == NULL)
+		return 0;
+	int ret = result_code() < 0 ? 0 : row_source->fill_result(*this);
+	DELETE(row_source);
+	if (ret != 0) {
+		log4cplus_error("fill result from row source error: %d", ret);
+		set_error(-EIO, "fill_row_source", "decode result rows error");
+	}
+	return ret;
+}
@@ -26,6 +26,19 @@ class NCKeyValueList;
 class NCRequest;
 class AgentMultiRequest;
 class ClientAgent;
+class DTCJobOperation;
+
+/*
+ * rows added to the result by the thread sending the reply instead of the
+ * cache thread, owned by the job and freed once used
+ */
+class JobRowSource {
+    public:
+	virtual ~JobRowSource()
+	{
+	}
+	virtual int fill_result(DTCJobOperation &job) = 0;
+};
 
 class TaskOwnerInfo {
     private:
@@ -83,7 +96,8 @@ class DTCJobOperation : public DtcJob,
 		  multi_key(NULL), keyList(NULL), batch_key(NULL),
 		  agent_multi_req(NULL), owner_client_(NULL), recv_buf(NULL),
 		  recv_len(0), recv_packet_cnt(0), resource_id(0),
-		  packet_version(0), resource_owner(NULL), resource_seq(0){};
+		  packet_version(0), row_source(NULL), resource_owner(NULL),
+		  resource_seq(0){};
 
 	virtual ~DTCJobOperation();
 
@@ -241,6 +255,7 @@ class DTCJobOperation : public DtcJob,
 	int recv_len;
 	int recv_packet_cnt;
 	uint8_t packet_version;
+	JobRowSource *row_source;
 
     public:
 	unsigned int key_val_count() const
@@ -301,6 +316,18 @@ class DTCJobOperation : public DtcJob,
 
 	void link_to_owner_client(ListObject<AgentMultiRequest> &head);
 
+	/* rows not yet in the result, see fill_row_source() */
+	void set_row_source(JobRowSource *s)
+	{
+		DELETE(row_source);
+		row_source = s;
+	}
+	int has_row_source(void) const
+	{
+		return row_source != NULL;
+	}
+	int fill_row_source(void);
+
 	int agent_sub_task_count();
 	void copy_reply_for_agent_sub_task();
 	DTCJobOperation *curr_agent_sub_task(int index);
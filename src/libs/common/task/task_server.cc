@@ -140,7 +140,26 @@ int DtcJob::prepare_result(int st, int ct)
 		}
 	}
 
+	resultWriter->set_aggregate(aggregate.is_active() ? &aggregate : NULL);
+	if (aggregate.is_active())
+		aggregate.Start();
+
 	resultWriterReseted = 1;
 
 	return 0;
 }
+
+int DtcJob::finish_aggregate(void)
+{
+	if (!aggregate.is_active() || result_code() < 0)
+		return 0;
+
+	/* nothing scanned, e.g. empty node, still one row back */
+	int err = prepare_result();
+	if (err < 0)
+		return err;
+	err = resultWriter->finish_aggregate();
+	if (err < 0)
+		set_error(err, "finish_aggregate()", NULL);
+	return err;
+}
@@ -190,6 +190,40 @@ DTCStatDefinition g_stat_definition[] = {
 	  SU_INT },
 	{ DTC_KEY_EXPIRE_DTC_COUNT, "cache - dtc key expire count", SA_COUNT,
 	  SU_INT },
+	{ DTC_KEY_EXPIRE_LAG,
+	  "cache - key expire lag(sec)",
+	  SA_SAMPLE,
+	  SU_INT,
+	  0,
+	  0,
+	  { 1, 2, 3, 5, 10, 30, 60, 120, 300, 600, 1800, 3600, 7200, 21600,
+	    43200, 86400 } },
+	{ DTC_KEY_EXPIRE_INDEX_SIZE, "cache - key expire index entries",
+	  SA_VALUE, SU_INT },
+	{ DTC_KEY_EXPIRE_INDEX_STALE, "cache - key expire index stale",
+	  SA_COUNT, SU_INT },
+
+	/***************** miss coalescing **************************/
+	{ DTC_COALESCED_MISS_COUNT, "cache - coalesced miss reqs", SA_COUNT,
+	  SU_INT },
+	{ DTC_COALESCED_MISS_BYPASS, "cache - coalesced miss bypass", SA_COUNT,
+	  SU_INT },
+	{ DTC_COALESCED_MISS_USEC,
+	  "cache - coalesced miss wait usec",
+	  SA_SAMPLE,
+	  SU_USEC,
+	  0,
+	  0,
+	  { 100, 200, 300, 400, 500, 600, 800, 1200, 2000, 10000, 20000, 100000,
+	    200000, 1000000, 2000000, 10000000 } },
+
+	/***************** string dictionary **************************/
+	{ DTC_STRING_DICT_ENTRIES, "cache - string dict entries", SA_VALUE,
+	  SU_INT },
+	{ DTC_STRING_DICT_BYTES, "cache - string dict bytes", SA_VALUE,
+	  SU_INT },
+	{ DTC_STRING_DICT_SAVED, "cache - string dict saved bytes", SA_VALUE,
+	  SU_INT },
 
 	/************************** bitmapsvr ***********************/
 	{ BTM_INDEX_1, "Mem - index(1)", SA_COUNT, SU_INT },
@@ -204,6 +238,22 @@ DTCStatDefinition g_stat_definition[] = {
 	{ HBP_LRU_SET_COUNT, "hbp - lru set op count", SA_COUNT, SU_INT },
 	{ HBP_LRU_SET_HIT_COUNT, "hbp - lru set hit count", SA_COUNT, SU_INT },
 	{ HBP_LRU_CLR_COUNT, "hbp - lru clr op count", SA_COUNT, SU_INT },
+	{ HBP_WRITE_BYTES, "hbp - binlog write bytes", SA_COUNT, SU_INT },
+	{ HBP_GROUP_RECORDS,
+	  "hbp - binlog records per write",
+	  SA_SAMPLE,
+	  SU_INT,
+	  0,
+	  0,
+	  { 1, 2, 4, 8, 16, 32, 64, 128, 256, 512, 1024, 2048, 4096, 8192 } },
+	{ HBP_GROUP_DELAY_USEC,
+	  "hbp - binlog group queue delay usec",
+	  SA_SAMPLE,
+	  SU_USEC,
+	  0,
+	  0,
+	  { 100, 200, 300, 400, 500, 600, 800, 1200, 2000, 10000, 20000, 100000,
+	    200000, 1000000, 2000000, 10000000 } },
 
 	//      {HBP_INC_SYNC_STEP,          "hbp - inc-sync step",     SA_SAMPLE,   SU_INT, 0, 0,
 	//           { 1, 2, 5, 10, 20, 50, 100, 500, 1000, 2000, 5000, 10000} },
@@ -229,6 +279,39 @@ DTCStatDefinition g_stat_definition[] = {
 	  { 10, 20, 40, 80, 120, 200, 400, 800, 1000, 2000, 4000, 8000 } },
 	{ TRY_PURGE_NODES, "try purge - auto purged nodes", SA_COUNT, SU_INT, 0,
 	  0 },
+	{ HBP_BINLOG_RAW_BYTES, "hbp - binlog raw record bytes", SA_COUNT,
+	  SU_INT },
+	{ HBP_BINLOG_STORED_BYTES, "hbp - binlog stored record bytes", SA_COUNT,
+	  SU_INT },
+	{ HBP_BINLOG_COMPRESS_RATIO,
+	  "hbp - binlog compress ratio",
+	  SA_EXPR,
+	  SU_PERCENT_2,
+	  1,
+	  1,
+	  {
+		  EXPR_IDV(HBP_BINLOG_STORED_BYTES, 0, 10000),
+		  EXPR_IDV(HBP_BINLOG_RAW_BYTES, 0, 1),
+	  } },
+	{ HBP_BINLOG_DECODE_USEC,
+	  "hbp - binlog decode usec",
+	  SA_SAMPLE,
+	  SU_USEC,
+	  0,
+	  0,
+	  { 10, 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000, 20000, 50000,
+	    100000, 1000000 } },
+	{ HBP_BINLOG_CRC_ERRORS, "hbp - binlog crc errors", SA_COUNT, SU_INT },
+	{ HBP_REPL_FOLLOWERS, "hbp - replication followers", SA_VALUE, SU_INT },
+	{ HBP_REPL_SENT_RECORDS, "hbp - replication sent records", SA_COUNT,
+	  SU_INT },
+	{ HBP_REPL_ACK_USEC, "hbp - replication ack usec", SA_SAMPLE, SU_USEC },
+	{ HBP_REPL_APPLIED_RECORDS, "hbp - replication applied records",
+	  SA_COUNT, SU_INT },
+	{ HBP_REPL_APPLY_ERRORS, "hbp - replication apply errors", SA_COUNT,
+	  SU_INT },
+	{ HBP_REPL_STALENESS_USEC, "hbp - replication staleness usec",
+	  SA_SAMPLE, SU_USEC },
 	{ PLUGIN_REQ_USEC_ALL,
 	  "request sb usec - ALL",
 	  SA_SAMPLE,
@@ -128,6 +128,17 @@ enum {
 
 	DTC_KEY_EXPIRE_USER_COUNT,
 	DTC_KEY_EXPIRE_DTC_COUNT,
+	DTC_KEY_EXPIRE_LAG,
+	DTC_KEY_EXPIRE_INDEX_SIZE,
+	DTC_KEY_EXPIRE_INDEX_STALE,
+
+	DTC_COALESCED_MISS_COUNT,
+	DTC_COALESCED_MISS_BYPASS,
+	DTC_COALESCED_MISS_USEC,
+
+	DTC_STRING_DICT_ENTRIES,
+	DTC_STRING_DICT_BYTES,
+	DTC_STRING_DICT_SAVED,
 
 	BTM_INDEX_1 = 2000,
 	BTM_INDEX_2,
@@ -143,6 +154,9 @@ enum {
 	HBP_LRU_SET_HIT_COUNT,
 	HBP_LRU_CLR_COUNT,
 	HBP_INC_SYNC_STEP,
+	HBP_WRITE_BYTES,
+	HBP_GROUP_RECORDS,
+	HBP_GROUP_DELAY_USEC,
 
 	// statistic item for blacklist
 	BLACKLIST_CURRENT_SLOT = 3010,
@@ -151,6 +165,21 @@ enum {
 	// try_purge_size 每次purge的节点个数
 	TRY_PURGE_NODES,
 
+	// statistic item for binlog record format
+	HBP_BINLOG_RAW_BYTES = 3020,
+	HBP_BINLOG_STORED_BYTES,
+	HBP_BINLOG_COMPRESS_RATIO,
+	HBP_BINLOG_DECODE_USEC,
+	HBP_BINLOG_CRC_ERRORS,
+
+	// built-in replication
+	HBP_REPL_FOLLOWERS = 3030,
+	HBP_REPL_SENT_RECORDS,
+	HBP_REPL_ACK_USEC,
+	HBP_REPL_APPLIED_RECORDS,
+	HBP_REPL_APPLY_ERRORS,
+	HBP_REPL_STALENESS_USEC,
+
 	PLUGIN_REQ_USEC_ALL = 10000,
 
 	// thread cpu statistic
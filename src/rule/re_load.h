@@ -7,5 +7,6 @@
 using namespace std;
 
 int get_rule_condition_num(hsql::Expr* rule);
+std::string do_get_rule(std::map<std::string, std::string>* buffer);
 int re_load_rule(std::map<std::string, std::string>* node, hsql::SQLParserResult* rule_ast, vector<vector<hsql::Expr*> >* expr_rules);
 std::string load_dtc_yaml_buffer(int mid);
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include "log.h"
 #include "re_function.h"
 #include "re_cache.h"
+#include "re_shape.h"
 
 using namespace hsql;
 using namespace std;
@@ -692,6 +693,8 @@ bool do_match_expr(hsql::Expr* input, hsql::Expr* rule)
     if(strcasecmp(input->expr->getName(), rule->expr->getName()) != 0)
         return false;
 
+    //result depends on the literal from here on.
+    re_shape_value_used();
     bool result = cmp_expr_value(input->expr2, rule->expr2, input->opType, rule->opType);
     log4cplus_debug("match result: %d, name: %s", result, input->expr->getName());
     return result;
@@ -0,0 +1,230 @@
+#include "re_shape.h"
+#include <string.h>
+#include <ctype.h>
+#include <list>
+#include <unordered_map>
+#include "log.h"
+#include "rule.h"
+
+using namespace std;
+
+typedef struct _shape_entry{
+    int layer;
+    std::string dtckey;
+    int keytype;
+    int key_index;      //ordinal of the key literal, -1 if layer is not L1.
+    std::list<const std::string*>::iterator lru;
+}shape_entry;
+
+//agent event loop threads each own a cache, no locking.
+typedef struct _shape_cache{
+    std::unordered_map<std::string, shape_entry> entries;
+    std::list<const std::string*> lru;      //front is the most recently used.
+    std::string key;
+    std::vector<shape_literal> literals;
+}shape_cache;
+
+static thread_local shape_cache cache;
+static thread_local bool value_free = true;
+
+void re_shape_reset()
+{
+    value_free = true;
+}
+
+void re_shape_value_used()
+{
+    value_free = false;
+}
+
+bool re_shape_value_free()
+{
+    return value_free;
+}
+
+static inline bool is_word_char(char c)
+{
+    return isalnum((unsigned char)c) || c == '_' || c == '$' || c == '@';
+}
+
+bool re_shape_normalize(const char* sql, int len, std::string* shape, std::vector<shape_literal>* literals)
+{
+    bool word = false;
+    int i = 0;
+
+    shape->clear();
+    literals->clear();
+
+    //data-lifecycle requests are force routed by text.
+    if(memmem(sql, len, "WITHOUT@@", 9) != NULL)
+        return false;
+
+    while(i < len)
+    {
+        char c = sql[i];
+        if(c == '\'' || c == '"')
+        {
+            int j = i + 1;
+            while(j < len)
+            {
+                if(sql[j] == '\\' && j + 1 < len)
+                {
+                    j += 2;
+                    continue;
+                }
+                if(sql[j] == c)
+                {
+                    if(j + 1 < len && sql[j + 1] == c)
+                    {
+                        j += 2;
+                        continue;
+                    }
+                    break;
+                }
+                //matching cuts the statement at the first WHERE.
+                if(sql[j] == 'W' && len - j >= 5 && memcmp(sql + j, "WHERE", 5) == 0)
+                    return false;
+                j++;
+            }
+            if(j >= len)
+                return false;
+
+            shape_literal l = {i + 1, j};
+            literals->push_back(l);
+            shape->append("'?'");
+            word = false;
+            i = j + 1;
+        }
+        else if(c == '`')
+        {
+            const char* p = (const char*)memchr(sql + i + 1, '`', len - i - 1);
+            if(p == NULL)
+                return false;
+            shape->append(sql + i, p - sql - i + 1);
+            word = true;
+            i = p - sql + 1;
+        }
+        else if(isdigit((unsigned char)c) && !word)
+        {
+            int j = i;
+            while(j < len && (isalnum((unsigned char)sql[j]) || sql[j] == '.' || sql[j] == '_'))
+                j++;
+
+            shape_literal l = {i, j};
+            literals->push_back(l);
+            shape->push_back('?');
+            i = j;
+        }
+        else if(isspace((unsigned char)c))
+        {
+            if(shape->length() > 0 && (*shape)[shape->length() - 1] != ' ')
+                shape->push_back(' ');
+            word = false;
+            i++;
+        }
+        else
+        {
+            shape->push_back(c);
+            word = is_word_char(c);
+            i++;
+        }
+    }
+
+    return true;
+}
+
+static bool shape_key(const char* szsql, int len, const char* dbsession)
+{
+    std::string* key = &cache.key;
+    if(!re_shape_normalize(szsql, len, key, &cache.literals))
+        return false;
+
+    //the same statement may reach another table under another session db.
+    key->push_back('\n');
+    if(dbsession)
+        key->append(dbsession);
+    return true;
+}
+
+extern "C" int rule_shape_lookup(const char* szsql, int len, const char* dbsession, char* out_dtckey, int* out_keytype, int* start_offset, int* end_offset)
+{
+    if(!szsql || len <= 0)
+        return 0;
+
+    if(!shape_key(szsql, len, dbsession))
+        return 0;
+
+    std::unordered_map<std::string, shape_entry>::iterator it = cache.entries.find(cache.key);
+    if(it == cache.entries.end())
+        return 0;
+
+    shape_entry* e = &it->second;
+    if(e->layer == 1)
+    {
+        if(e->key_index >= cache.literals.size())
+            return 0;
+        *start_offset = cache.literals[e->key_index].start;
+        *end_offset = cache.literals[e->key_index].end;
+    }
+    strcpy(out_dtckey, e->dtckey.c_str());
+    *out_keytype = e->keytype;
+
+    cache.lru.splice(cache.lru.begin(), cache.lru, e->lru);
+    log4cplus_debug("shape hit, layer: %d", e->layer);
+    return e->layer;
+}
+
+//called after rule_sql_match() in the same thread, with the key offsets found for it.
+extern "C" void rule_shape_store(const char* szsql, int len, const char* dbsession, int layer, const char* dtckey, int keytype, int start_offset, int end_offset)
+{
+    int key_index = -1;
+
+    if(!szsql || len <= 0 || layer <= 0 || !re_shape_value_free())
+        return;
+
+    if(!shape_key(szsql, len, dbsession))
+        return;
+
+    if(layer == 1)
+    {
+        for(int i = 0; i < cache.literals.size(); i++)
+        {
+            if(cache.literals[i].start == start_offset && cache.literals[i].end == end_offset)
+            {
+                key_index = i;
+                break;
+            }
+        }
+        //key is not a plain literal, leave it to the full path.
+        if(key_index < 0)
+            return;
+    }
+
+    std::pair<std::unordered_map<std::string, shape_entry>::iterator, bool> r = cache.entries.insert(std::make_pair(cache.key, shape_entry()));
+    shape_entry* e = &r.first->second;
+    if(r.second)
+    {
+        cache.lru.push_front(&r.first->first);
+        e->lru = cache.lru.begin();
+    }
+    e->layer = layer;
+    e->dtckey = dtckey ? dtckey : "";
+    e->keytype = keytype;
+    e->key_index = key_index;
+
+    while(cache.entries.size() > RE_SHAPE_CACHE_SIZE)
+    {
+        std::unordered_map<std::string, shape_entry>::iterator oldest = cache.entries.find(*cache.lru.back());
+        cache.lru.pop_back();
+        cache.entries.erase(oldest);
+    }
+}
+
+//layer of a prepared statement template, 0 if it has to be decided by parameter values.
+extern "C" int rule_stmt_plan(const char* szsql, const char* osql, const char* dbsession, char* out_dtckey, int* out_keytype)
+{
+    int layer = rule_sql_match(szsql, osql, dbsession, out_dtckey, out_keytype);
+    if(layer <= 0 || !re_shape_value_free())
+        return 0;
+    return layer;
+}
@@ -0,0 +1,23 @@
+#ifndef _H_RE_SHAPE_
+#define _H_RE_SHAPE_
+
+#include <string>
+#include <vector>
+
+//cached statement shapes per agent thread.
+#define RE_SHAPE_CACHE_SIZE 1024
+
+typedef struct _shape_literal{
+    int start;      //first byte of literal, quotes excluded.
+    int end;        //one past the last byte.
+}shape_literal;
+
+//normalize sql: literals replaced by '?', blanks collapsed. false if the statement can't be cached.
+bool re_shape_normalize(const char* sql, int len, std::string* shape, std::vector<shape_literal>* literals);
+
+//layer decision of the statement in matching does not depend on literal values.
+void re_shape_reset();
+void re_shape_value_used();
+bool re_shape_value_free();
+
+#endif
@@ -1,5 +1,6 @@
 #include "rule.h"
 #include <stdio.h>
+#include <strings.h>
 #include <iostream>
 #include "../libs/hsql/include/SQLParser.h"
 #include "../libs/hsql/include/util/sqlhelper.h"
@@ -7,6 +8,7 @@
 #include "re_load.h"
 #include "re_match.h"
 #include "re_cache.h"
+#include "re_shape.h"
 #include "log.h"
 #include "mxml.h"
 #include "yaml-cpp/yaml.h"
@@ -463,8 +465,13 @@ extern "C" int re_load_all_rules()
             log4cplus_debug("push %s into map.", Name);
             std::string strname = Name;
             transform(strname.begin(),strname.end(),strname.begin(),::toupper);
-            (g_map_dtc_yaml[strname])[YAML_DTC_BUFFER] = buf;
-            log4cplus_debug("name: %s, buf len: %d", strname.c_str(), (g_map_dtc_yaml[strname])[YAML_DTC_BUFFER].length());
+            std::map<std::string, std::string>* node = &g_map_dtc_yaml[strname];
+            (*node)[YAML_DTC_BUFFER] = buf;
+            log4cplus_debug("name: %s, buf len: %d", strname.c_str(), (*node)[YAML_DTC_BUFFER].length());
+            // fill the lazily cached fields now, agent worker threads only read the map.
+            get_key_info(node);
+            rule_get_key_type(node);
+            do_get_rule(node);
         }
         else
         {
@@ -486,22 +493,28 @@ extern "C" int rule_sql_match(const char* szsql, const char* osql, const char* d
         
     std::string dtc_key = "";
     std::string sql = szsql;
+    // never insert into g_map_dtc_yaml here, it's shared by agent threads.
+    std::map<std::string, std::string> no_yaml;
+    std::map<std::string, std::string>* yaml = &no_yaml;
 
     //init_log4cplus();
 
     log4cplus_debug("input sql: %s", osql);
+    re_shape_reset();
 
     std::string db_dot_name = get_table_with_db(dbsession, szsql);
-    if(db_dot_name.length() > 0 && g_map_dtc_yaml.count(db_dot_name) > 0)
+    std::map<std::string, std::map<std::string, std::string>>::iterator it = g_map_dtc_yaml.find(db_dot_name);
+    if(db_dot_name.length() > 0 && it != g_map_dtc_yaml.end())
     {
-        dtc_key = get_key_info(&(g_map_dtc_yaml[db_dot_name]));
+        yaml = &it->second;
+        dtc_key = get_key_info(yaml);
         if(dtc_key.length() == 0)
         {
             log4cplus_error("get dtc_key from yaml:%s failed.", db_dot_name.c_str());
             return -1;
         }
         strcpy(out_dtckey, dtc_key.c_str());
-        *out_keytype = rule_get_key_type(&(g_map_dtc_yaml[db_dot_name]));
+        *out_keytype = rule_get_key_type(yaml);
     }
     log4cplus_debug("dtc key len: %d, key: %s, dbname len: %d, dbname: %s", dtc_key.length(), dtc_key.c_str(), strlen(dbsession), std::string(dbsession).c_str());
 
@@ -569,7 +582,7 @@ extern "C" int rule_sql_match(const char* szsql, const char* osql, const char* d
     vector<vector<hsql::Expr*> > expr_rules;
     expr_rules.clear();
     hsql::SQLParserResult rule_ast;
-    int ret = re_load_rule(&(g_map_dtc_yaml[db_dot_name]), &rule_ast, &expr_rules);
+    int ret = re_load_rule(yaml, &rule_ast, &expr_rules);
     if(ret != 0)
     {
         log4cplus_error("load rule error:%d", ret);
@@ -680,4 +693,95 @@ extern "C" int sql_parse_table(const char* szsql, char* out)
         strcpy(out, tablename.c_str());
     }
     return tablename.length();
-}
\ No newline at end of file
+}
+
+static int rule_field_type(const std::string& str)
+{
+    if(str == "signed")
+        return 1;
+    else if(str == "unsigned")
+        return 2;
+    else if(str == "float")
+        return 3;
+    else if(str == "string")
+        return 4;
+    else if(str == "binary")
+        return 5;
+    return 0;
+}
+
+static void rule_column_set(rule_column* col, const char* name, int type)
+{
+    snprintf(col->name, sizeof(col->name), "%s", name ? name : "");
+    col->type = type;
+}
+
+//columns of a prepared SELECT: 0 if it returns no resultset, -1 if they can't be known here(* on a table dtc doesn't know).
+extern "C" int rule_stmt_columns(const char* osql, const char* dbsession, rule_column* out, int max)
+{
+    hsql::SQLParserResult sql_ast;
+    if(re_parse_sql(osql, &sql_ast) != 0)
+        return -1;
+    if(sql_ast.getStatement(0)->type() != kStmtSelect)
+        return 0;
+    const SelectStatement* stmt = (const SelectStatement*)(sql_ast.getStatement(0));
+    if(stmt->selectList == NULL)
+        return -1;
+
+    //fields of the dtc table, names and types as in dtc.yaml.
+    YAML::Node fields;
+    std::string db_dot_name = get_table_with_db(dbsession, osql);
+    std::map<std::string, std::map<std::string, std::string>>::iterator it = g_map_dtc_yaml.find(db_dot_name);
+    if(db_dot_name.length() > 0 && it != g_map_dtc_yaml.end())
+    {
+        std::map<std::string, std::string>::iterator b = it->second.find(YAML_DTC_BUFFER);
+        if(b != it->second.end())
+        {
+            try {
+                fields = YAML::Load(b->second)["primary"]["cache"]["field"];
+            } catch (const YAML::Exception &e) {
+                log4cplus_error("config buf load error:%s\n", e.what());
+            }
+        }
+    }
+
+    int n = 0;
+    for(size_t i = 0; i < stmt->selectList->size(); i++)
+    {
+        Expr* expr = stmt->selectList->at(i);
+        if(expr->isType(kExprStar))
+        {
+            if(!fields || !fields.IsSequence())
+                return -1;
+            for(size_t j = 0; j < fields.size(); j++)
+            {
+                if(n == max)
+                    return -1;
+                rule_column_set(&out[n++], fields[j]["name"].as<string>().c_str(),
+                    rule_field_type(fields[j]["type"].as<string>()));
+            }
+            continue;
+        }
+
+        if(n == max)
+            return -1;
+        int type = 0;
+        if(expr->isType(kExprColumnRef) && fields && fields.IsSequence())
+        {
+            for(size_t j = 0; j < fields.size(); j++)
+            {
+                if(strcasecmp(fields[j]["name"].as<string>().c_str(), expr->name) == 0)
+                {
+                    type = rule_field_type(fields[j]["type"].as<string>());
+                    break;
+                }
+            }
+        }
+        else if(expr->isType(kExprFunctionRef) && expr->name && strcasecmp(expr->name, "count") == 0)
+        {
+            type = 1;
+        }
+        rule_column_set(&out[n++], expr->alias ? expr->alias : expr->name, type);
+    }
+    return n;
+}
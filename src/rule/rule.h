@@ -7,6 +7,16 @@ extern "C"{
     int sql_parse_table(const char* szsql, char* out);
     int get_table_with_db(const char* sessiondb, const char* sql, char* result);    
     int re_load_all_rules();
+    int rule_shape_lookup(const char* szsql, int len, const char* dbsession, char* out_dtckey, int* out_keytype, int* start_offset, int* end_offset);
+    void rule_shape_store(const char* szsql, int len, const char* dbsession, int layer, const char* dtckey, int keytype, int start_offset, int end_offset);
+    int rule_stmt_plan(const char* szsql, const char* osql, const char* dbsession, char* out_dtckey, int* out_keytype);
+
+    //one column of a prepared SELECT, type is the dtc field type(1 signed, 2 unsigned, 3 float, 4 string, 5 binary) or 0.
+    typedef struct _rule_column{
+        char name[64];
+        int type;
+    }rule_column;
+    int rule_stmt_columns(const char* osql, const char* dbsession, rule_column* out, int max);
 #ifdef __cplusplus    
 }
 #endif